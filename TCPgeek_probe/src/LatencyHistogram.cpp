@@ -0,0 +1,68 @@
+/*
+ *	LatencyHistogram.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <cmath>
+
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram() : m_previousSum {0} {
+	for (std::size_t i = 0; i < LATENCY_BUCKETS; i++) {
+		m_buckets[i].store(0);
+		m_previousBuckets[i] = 0;
+	}
+	m_sum.store(0);
+	m_intervalMax.store(0);
+}
+
+uint64_t LatencyHistogram::getBucketHighestValue(const std::size_t t_index) {
+	std::size_t magnitude = t_index / LATENCY_SUB_BUCKETS;
+	uint64_t subBucket = t_index % LATENCY_SUB_BUCKETS;
+	if (magnitude == 0) return subBucket;
+	int shift = magnitude - 1;
+	return ((LATENCY_SUB_BUCKETS + subBucket + 1) << shift) - 1;
+}
+
+uint64_t LatencyHistogram::getQuantile(const uint64_t* t_delta, const uint64_t t_count, const double t_quantile, const uint64_t t_max) const {
+	if (t_count == 0) return 0;
+	uint64_t rank = (uint64_t) std::ceil(t_quantile * t_count);
+	if (rank < 1) rank = 1;
+	uint64_t seen = 0;
+	for (std::size_t i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += t_delta[i];
+		if (seen >= rank) {
+			//the exact max is better than the bucket bound when both are in the same bucket
+			return (getBucketIndex(t_max) == i) ? t_max : getBucketHighestValue(i);
+		}
+	}
+	return t_max;
+}
+
+LatencySnapshot LatencyHistogram::takeIntervalSnapshot() {
+	LatencySnapshot snapshot;
+	uint64_t delta[LATENCY_BUCKETS];
+
+	snapshot.count = 0;
+	snapshot.max = m_intervalMax.exchange(0, std::memory_order_relaxed);
+	for (std::size_t i = 0; i < LATENCY_BUCKETS; i++) {
+		uint64_t current = m_buckets[i].load(std::memory_order_relaxed);
+		delta[i] = current - m_previousBuckets[i];
+		m_previousBuckets[i] = current;
+		snapshot.count += delta[i];
+	}
+	uint64_t currentSum = m_sum.load(std::memory_order_relaxed);
+	snapshot.sum = currentSum - m_previousSum;
+	m_previousSum = currentSum;
+	snapshot.p50 = getQuantile(delta, snapshot.count, 0.5, snapshot.max);
+	snapshot.p99 = getQuantile(delta, snapshot.count, 0.99, snapshot.max);
+	snapshot.p999 = getQuantile(delta, snapshot.count, 0.999, snapshot.max);
+	return snapshot;
+}
@@ -0,0 +1,72 @@
+/*
+ *	LatencyHistogram.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : LatencyHistogram - HDR style log-linear histogram of TSC ticks. Every power of two
+ *					is split into 16 linear sub-buckets, so any value is kept with 6% precision
+ *					in 976 fixed buckets and recording is a few instructions without locks.
+ *					There must be a single recording thread per histogram, the control thread
+ *					takes interval snapshots as differences to the previous snapshot.
+ */
+
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#define LATENCY_SUB_BUCKET_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+struct LatencySnapshot {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t p50, p99, p999, max; //in the units of the recorded values
+};
+
+class LatencyHistogram {
+private:
+	std::atomic<uint64_t> m_buckets[LATENCY_BUCKETS];
+	std::atomic<uint64_t> m_sum;
+	std::atomic<uint64_t> m_intervalMax; //reset by every snapshot
+	//****CONTROL THREAD ONLY****
+	uint64_t m_previousBuckets[LATENCY_BUCKETS];
+	uint64_t m_previousSum;
+
+	static void increase(std::atomic<uint64_t>& t_counter, const uint64_t t_value) {
+		//single writer, so a plain load and store is enough and much cheaper than a locked add
+		t_counter.store(t_counter.load(std::memory_order_relaxed) + t_value, std::memory_order_relaxed);
+	}
+	static uint64_t getBucketHighestValue(const std::size_t t_index);
+	uint64_t getQuantile(const uint64_t* t_delta, const uint64_t t_count, const double t_quantile, const uint64_t t_max) const;
+
+public:
+	LatencyHistogram();
+
+	static std::size_t getBucketIndex(const uint64_t t_value) {
+		if (t_value < LATENCY_SUB_BUCKETS) return t_value;
+		int shift = 63 - __builtin_clzll(t_value) - LATENCY_SUB_BUCKET_BITS;
+		return (shift + 1) * LATENCY_SUB_BUCKETS + ((t_value >> shift) & (LATENCY_SUB_BUCKETS - 1));
+	}
+
+	void record(const uint64_t t_value) {
+		increase(m_buckets[getBucketIndex(t_value)], 1);
+		increase(m_sum, t_value);
+		if (t_value > m_intervalMax.load(std::memory_order_relaxed)) {
+			m_intervalMax.store(t_value, std::memory_order_relaxed);
+		}
+	}
+
+	LatencySnapshot takeIntervalSnapshot();
+	//values recorded since the previous snapshot, might be invoked only from the control thread
+	//a value recorded at the very moment of the snapshot might be missed by the max, never by the counts
+};
+
+#endif /* LATENCYHISTOGRAM_H_ */
@@ -0,0 +1,142 @@
+/*
+ *	MetricsServer.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <csignal>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "MetricsServer.h"
+
+#define METRICS_REQUEST_MAX_SIZE 4096
+#define METRICS_IO_TIMEOUT_MS 1000
+
+MetricsServer::MetricsServer(const ProbeMetrics& t_metrics, const std::string& t_address, const unsigned short t_port) :
+								m_metrics (t_metrics) {
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(t_port);
+	if (inet_pton(AF_INET, t_address.c_str(), &address.sin_addr) != 1) {
+		throw std::runtime_error("Invalid metricsAddress " + t_address);
+	}
+	m_listenSocket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (m_listenSocket == -1) {
+		throw std::runtime_error(std::string("Can't create metrics socket: ") + strerror(errno));
+	}
+	int reuse = 1;
+	setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	if (bind(m_listenSocket, (struct sockaddr*) &address, sizeof(address)) != 0 || listen(m_listenSocket, 8) != 0) {
+		std::string error = strerror(errno);
+		close(m_listenSocket);
+		throw std::runtime_error("Can't listen for metrics on " + t_address + ":" + std::to_string(t_port) + ": " + error);
+	}
+	if (pipe2(m_wakeupPipe, O_CLOEXEC) != 0) {
+		close(m_listenSocket);
+		throw std::runtime_error(std::string("Can't create metrics wakeup pipe: ") + strerror(errno));
+	}
+	//signals are handled by the dedicated thread, so the server thread starts with all of them blocked
+	sigset_t sigSet, oldSigSet;
+	sigfillset(&sigSet);
+	pthread_sigmask(SIG_BLOCK, &sigSet, &oldSigSet);
+	m_thread = std::thread(&MetricsServer::serve, this);
+	pthread_sigmask(SIG_SETMASK, &oldSigSet, nullptr);
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.info("Metrics are served at http://%s:%u/metrics", t_address.c_str(), t_port);
+}
+
+MetricsServer::~MetricsServer() {
+	char wakeup = 0;
+	if (write(m_wakeupPipe[1], &wakeup, 1) != 1) {
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.error("Can't wake up metrics server: %s", strerror(errno));
+	}
+	m_thread.join();
+	close(m_wakeupPipe[0]);
+	close(m_wakeupPipe[1]);
+	close(m_listenSocket);
+}
+
+void MetricsServer::serve() {
+	struct pollfd fds[2];
+	fds[0].fd = m_listenSocket;
+	fds[0].events = POLLIN;
+	fds[1].fd = m_wakeupPipe[0];
+	fds[1].events = POLLIN;
+
+	while (true) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		if (fds[1].revents != 0) break;
+		if (fds[0].revents & POLLIN) {
+			int connection = accept4(m_listenSocket, NULL, NULL, SOCK_CLOEXEC);
+			if (connection == -1) continue;
+			handleConnection(connection);
+			close(connection);
+		}
+	}
+}
+
+void MetricsServer::handleConnection(const int t_socket) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	char request[METRICS_REQUEST_MAX_SIZE];
+	std::size_t received = 0;
+	struct timeval timeout = {METRICS_IO_TIMEOUT_MS / 1000, (METRICS_IO_TIMEOUT_MS % 1000) * 1000};
+	//connections are served one by one, a silent client without the timeouts would hold all the others
+	if (setsockopt(t_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) != 0 ||
+			setsockopt(t_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) != 0) {
+		logRoot.warn("Metrics connection is dropped, can't set its timeouts: %s", strerror(errno));
+		return;
+	}
+
+	//reading the request head only, a scrape has no body
+	while (received < sizeof(request) - 1) {
+		ssize_t res = recv(t_socket, request + received, sizeof(request) - 1 - received, 0);
+		if (res <= 0) return;
+		received += res;
+		request[received] = '\0';
+		if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL) break;
+	}
+	request[received] = '\0';
+
+	std::string status, contentType, body;
+	if (strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET /metrics?", 13) == 0) {
+		status = "200 OK";
+		contentType = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+		body = m_metrics.render();
+	} else if (strncmp(request, "GET ", 4) == 0) {
+		status = "404 Not Found";
+		contentType = "text/plain";
+		body = "Try /metrics\n";
+	} else {
+		status = "405 Method Not Allowed";
+		contentType = "text/plain";
+		body = "Only GET is supported\n";
+	}
+	std::string response = "HTTP/1.0 " + status + "\r\nContent-Type: " + contentType +
+							"\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+	std::size_t sent = 0;
+	while (sent < response.size()) {
+		ssize_t res = send(t_socket, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+		if (res <= 0) return;
+		sent += res;
+	}
+}
@@ -0,0 +1,42 @@
+/*
+ *	MetricsServer.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : MetricsServer - minimal HTTP/1.0 server on its own thread answering
+ *					GET /metrics with the OpenMetrics rendering of ProbeMetrics. One connection
+ *					is served at a time with short timeouts, it reads only the atomics of
+ *					ProbeMetrics and never touches the capture or the control thread.
+ */
+
+#ifndef METRICSSERVER_H_
+#define METRICSSERVER_H_
+
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include "ProbeMetrics.h"
+
+class MetricsServer {
+private:
+	const ProbeMetrics& m_metrics;
+	int m_listenSocket;
+	int m_wakeupPipe[2]; //the destructor writes to it to stop poll()
+	std::thread m_thread;
+
+	void serve();
+	void handleConnection(const int t_socket);
+
+public:
+	MetricsServer(const ProbeMetrics& t_metrics, const std::string& t_address, const unsigned short t_port);
+	//throws exceptions if the port can't be bound
+	~MetricsServer();
+};
+
+#endif /* METRICSSERVER_H_ */
@@ -0,0 +1,135 @@
+/*
+ *	PerfEventGroup.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "PerfEventGroup.h"
+
+static const char* eventNames[PERF_EVENTS] = {
+	"cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"
+};
+
+PerfEventGroup::PerfEventGroup() {
+	for (int i = 0; i < PERF_EVENTS; i++) {
+		m_fds[i] = -1;
+		m_readPosition[i] = -1;
+		m_previousValues[i] = 0;
+	}
+	m_openedEvents = 0;
+	m_leaderFd = -1;
+	m_previousEnabled = 0;
+	m_previousRunning = 0;
+}
+
+PerfEventGroup::~PerfEventGroup() {
+	//members first, the leader is the last one
+	for (int i = PERF_EVENTS - 1; i >= 0; i--) {
+		if (m_fds[i] != -1) close(m_fds[i]);
+	}
+}
+
+int PerfEventGroup::openEvent(const int t_event, const pid_t t_tid, const int t_groupFd) {
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	switch ((PerfEvent) t_event) {
+		case PerfEvent::CYCLES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case PerfEvent::INSTRUCTIONS:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case PerfEvent::LLC_MISSES:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		case PerfEvent::BRANCH_MISSES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+			break;
+		case PerfEvent::DTLB_MISSES:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+	}
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	//the group starts counting when its leader is enabled
+	attr.disabled = (t_groupFd == -1) ? 1 : 0;
+	return syscall(SYS_perf_event_open, &attr, t_tid, -1, t_groupFd, PERF_FLAG_FD_CLOEXEC);
+}
+
+bool PerfEventGroup::open(const pid_t t_tid) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	for (int i = 0; i < PERF_EVENTS; i++) {
+		int fd = openEvent(i, t_tid, m_leaderFd);
+		if (fd == -1) {
+			logRoot.warn("Performance counter %s is not available: %s", eventNames[i], strerror(errno));
+			continue;
+		}
+		m_fds[i] = fd;
+		m_readPosition[i] = m_openedEvents++;
+		if (m_leaderFd == -1) m_leaderFd = fd;
+	}
+	if (m_leaderFd == -1) return false;
+	ioctl(m_leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(m_leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return true;
+}
+
+bool PerfEventGroup::readDelta(PerfEventSample& t_delta) {
+	//nr, time_enabled, time_running, values[nr]
+	uint64_t buffer[3 + PERF_EVENTS];
+
+	for (int i = 0; i < PERF_EVENTS; i++) {
+		t_delta.valid[i] = false;
+		t_delta.values[i] = 0;
+	}
+	if (m_leaderFd == -1) return false;
+	if (read(m_leaderFd, buffer, sizeof(buffer)) < (ssize_t) ((3 + m_openedEvents) * sizeof(uint64_t))) {
+		return false;
+	}
+	uint64_t enabled = buffer[1] - m_previousEnabled;
+	uint64_t running = buffer[2] - m_previousRunning;
+	m_previousEnabled = buffer[1];
+	m_previousRunning = buffer[2];
+	for (int i = 0; i < PERF_EVENTS; i++) {
+		if (m_readPosition[i] == -1) continue;
+		uint64_t value = buffer[3 + m_readPosition[i]];
+		uint64_t delta = value - m_previousValues[i];
+		m_previousValues[i] = value;
+		//the group wasn't on the PMU at all during the interval, nothing to extrapolate from
+		if (running == 0) continue;
+		t_delta.valid[i] = true;
+		t_delta.values[i] = (running < enabled) ? (uint64_t) ((double) delta * enabled / running) : delta;
+	}
+	return true;
+}
+
+bool PerfEventGroup::isOpened() const {
+	return m_leaderFd != -1;
+}
+
+const char* PerfEventGroup::getEventName(const int t_event) {
+	return eventNames[t_event];
+}
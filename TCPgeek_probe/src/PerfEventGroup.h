@@ -0,0 +1,61 @@
+/*
+ *	PerfEventGroup.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : PerfEventGroup - hardware performance counters of a single thread opened with
+ *					perf_event_open() as one group, so all of them are scheduled on the PMU together
+ *					and read with one read() call. User space only, as that is all that
+ *					perf_event_paranoid = 2 allows. Events the CPU or the hypervisor doesn't provide
+ *					are skipped, if the PMU is multiplexed the deltas are scaled by enabled/running time.
+ */
+
+#ifndef PERFEVENTGROUP_H_
+#define PERFEVENTGROUP_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+enum class PerfEvent {
+			CYCLES,
+			INSTRUCTIONS,
+			LLC_MISSES,
+			BRANCH_MISSES,
+			DTLB_MISSES
+};
+#define PERF_EVENTS 5
+
+struct PerfEventSample {
+	bool		valid[PERF_EVENTS];		//false if the event is not available
+	uint64_t	values[PERF_EVENTS];	//delta since the previous read
+};
+
+class PerfEventGroup {
+private:
+	int m_fds[PERF_EVENTS];			//-1 if the event is not opened
+	int m_readPosition[PERF_EVENTS];	//position of the event value in the group read buffer
+	int m_openedEvents;
+	int m_leaderFd;
+	uint64_t m_previousValues[PERF_EVENTS];
+	uint64_t m_previousEnabled, m_previousRunning;
+
+	static int openEvent(const int t_event, const pid_t t_tid, const int t_groupFd);
+
+public:
+	PerfEventGroup();
+	~PerfEventGroup();
+
+	bool open(const pid_t t_tid);
+	//opens the counters of thread t_tid, 0 - the calling thread, returns false if none is available
+	bool readDelta(PerfEventSample& t_delta);
+	//might be invoked from any thread of the process, returns false if the group is not opened
+	bool isOpened() const;
+	static const char* getEventName(const int t_event);
+};
+
+#endif /* PERFEVENTGROUP_H_ */
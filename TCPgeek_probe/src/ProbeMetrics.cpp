@@ -0,0 +1,289 @@
+/*
+ *	ProbeMetrics.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "ProbeMetrics.h"
+
+static const char* packetResultNames[PACKET_PROCESSING_RESULTS] = {
+	"good_tcp", "good_udp", "unknown_link_type", "not_ip_packet",
+	"unknown_l3_type", "bad_ip_header_len", "bad_tcp_header_len", "bad_udp_len"
+};
+static const char* tcpResultNames[TCP_SESSION_PROCESSING_RESULTS] = {
+	"good_new", "good_known", "new_gap", "gap_recovery", "retransmit", "keepalive", "duplicate", "void", "sampled_out"
+};
+static const char* udpResultNames[UDP_SESSION_UPDATE_RESULTS] = {
+	"good_new", "good_known", "duplicate", "void", "sampled_out"
+};
+
+ProbeMetrics::ProbeMetrics() {
+	for (int i = 0; i < PACKET_PROCESSING_RESULTS; i++) m_packets[i].store(0);
+	for (int i = 0; i < TCP_SESSION_PROCESSING_RESULTS; i++) m_tcpPackets[i].store(0);
+	for (int i = 0; i < UDP_SESSION_UPDATE_RESULTS; i++) m_udpPackets[i].store(0);
+	m_activeTcpSessions.store(0);
+	m_activeUdpSessions.store(0);
+	m_establishedTcpSessions.store(0);
+	m_halfOpenTcpSessions.store(0);
+	m_closingTcpSessions.store(0);
+	m_sessionsStatQueueDepth.store(0);
+	m_tracedPackets.store(0);
+	m_kernelAggregatedFlows.store(0);
+	m_kernelAggregatedPackets.store(0);
+	m_kernelFilteredFrames.store(0);
+	m_osBufferDrops.store(0);
+	m_interfaceDrops.store(0);
+	m_statFeedOverwrittenBatches.store(0);
+	m_ipfixDroppedMessages.store(0);
+	m_statWrites.store(0);
+	m_statWriteMicrosTotal.store(0);
+	m_lastStatWriteMicros.store(0);
+	m_lastStatRecords.store(0);
+	m_avgPacketCycles.store(0);
+	m_virtualMemoryKb.store(0);
+	m_physicalMemoryKb.store(0);
+	m_cpuUsagePermille.store(0);
+	for (int i = 0; i < LATENCY_STAGES; i++) {
+		for (int j = 0; j < 4; j++) m_stageLatencyNs[i][j].store(0);
+		m_stageSamples[i].store(0);
+	}
+	for (int i = 0; i < PERF_THREADS; i++) {
+		for (int j = 0; j < PERF_EVENTS; j++) {
+			m_perfValid[i][j].store(false);
+			m_perfEvents[i][j].store(0);
+		}
+	}
+	m_perfPackets.store(0);
+	for (int i = 0; i < 6; i++) m_memoryComponents[i].store(0);
+	m_memoryEstimated.store(0);
+	m_memoryBudget.store(0);
+	m_sheddingLevel.store(0);
+	m_evictedSessions.store(0);
+	m_samplingRate.store(1);
+	m_captureBusyPct.store(0);
+	m_captureBacklog.store(0);
+}
+
+void ProbeMetrics::setSessions(const uint64_t t_activeTcpSessions, const uint64_t t_activeUdpSessions) {
+	m_activeTcpSessions.store(t_activeTcpSessions, std::memory_order_relaxed);
+	m_activeUdpSessions.store(t_activeUdpSessions, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setTcpSessionStates(const uint64_t t_established, const uint64_t t_halfOpen, const uint64_t t_closing) {
+	m_establishedTcpSessions.store(t_established, std::memory_order_relaxed);
+	m_halfOpenTcpSessions.store(t_halfOpen, std::memory_order_relaxed);
+	m_closingTcpSessions.store(t_closing, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setQueueDepths(const uint64_t t_sessionsStatQueueDepth) {
+	m_sessionsStatQueueDepth.store(t_sessionsStatQueueDepth, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setTracedPackets(const uint64_t t_tracedPackets) {
+	m_tracedPackets.store(t_tracedPackets, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setKernelAggregation(const uint64_t t_flows, const uint64_t t_packets) {
+	m_kernelAggregatedFlows.store(t_flows, std::memory_order_relaxed);
+	m_kernelAggregatedPackets.store(t_packets, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setKernelFilteredFrames(const uint64_t t_frames) {
+	m_kernelFilteredFrames.store(t_frames, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setCaptureDrops(const uint64_t t_osBufferDrops, const uint64_t t_interfaceDrops) {
+	m_osBufferDrops.store(t_osBufferDrops, std::memory_order_relaxed);
+	m_interfaceDrops.store(t_interfaceDrops, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setOutputDrops(const uint64_t t_statFeedOverwrittenBatches, const uint64_t t_ipfixDroppedMessages) {
+	m_statFeedOverwrittenBatches.store(t_statFeedOverwrittenBatches, std::memory_order_relaxed);
+	m_ipfixDroppedMessages.store(t_ipfixDroppedMessages, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::observeStatWrite(const uint64_t t_micros, const uint64_t t_records) {
+	m_lastStatWriteMicros.store(t_micros, std::memory_order_relaxed);
+	m_lastStatRecords.store(t_records, std::memory_order_relaxed);
+	m_statWriteMicrosTotal.fetch_add(t_micros, std::memory_order_relaxed);
+	m_statWrites.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setSelfUsage(const double t_cpuUsagePercentage, const uint64_t t_virtualMemoryKb,
+								const uint64_t t_physicalMemoryKb, const uint64_t t_avgPacketCycles) {
+	m_cpuUsagePermille.store((uint64_t) (t_cpuUsagePercentage * 10), std::memory_order_relaxed);
+	m_virtualMemoryKb.store(t_virtualMemoryKb, std::memory_order_relaxed);
+	m_physicalMemoryKb.store(t_physicalMemoryKb, std::memory_order_relaxed);
+	m_avgPacketCycles.store(t_avgPacketCycles, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setStageLatency(const int t_stage, const LatencySnapshot& t_snapshotNs) {
+	if (t_stage < 0 || t_stage >= LATENCY_STAGES) return;
+	m_stageLatencyNs[t_stage][0].store(t_snapshotNs.p50, std::memory_order_relaxed);
+	m_stageLatencyNs[t_stage][1].store(t_snapshotNs.p99, std::memory_order_relaxed);
+	m_stageLatencyNs[t_stage][2].store(t_snapshotNs.p999, std::memory_order_relaxed);
+	m_stageLatencyNs[t_stage][3].store(t_snapshotNs.max, std::memory_order_relaxed);
+	m_stageSamples[t_stage].store(t_snapshotNs.count, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setMemoryUsage(const MemoryUsage& t_usage, const uint64_t t_estimatedBytes, const uint64_t t_budgetBytes,
+									const SheddingLevel t_level, const uint64_t t_evictedSessions) {
+	m_memoryComponents[0].store(t_usage.tcpTableBytes, std::memory_order_relaxed);
+	m_memoryComponents[1].store(t_usage.udpTableBytes, std::memory_order_relaxed);
+	m_memoryComponents[2].store(t_usage.gapBytes, std::memory_order_relaxed);
+	m_memoryComponents[3].store(t_usage.dedupBytes, std::memory_order_relaxed);
+	m_memoryComponents[4].store(t_usage.statQueueBytes, std::memory_order_relaxed);
+	m_memoryComponents[5].store(t_usage.packetTraceBytes, std::memory_order_relaxed);
+	m_memoryEstimated.store(t_estimatedBytes, std::memory_order_relaxed);
+	m_memoryBudget.store(t_budgetBytes, std::memory_order_relaxed);
+	m_sheddingLevel.store((uint64_t) t_level, std::memory_order_relaxed);
+	m_evictedSessions.store(t_evictedSessions, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setOverload(const uint32_t t_samplingRate, const uint32_t t_captureBusyPct, const uint64_t t_captureBacklog) {
+	m_samplingRate.store(t_samplingRate, std::memory_order_relaxed);
+	m_captureBusyPct.store(t_captureBusyPct, std::memory_order_relaxed);
+	m_captureBacklog.store(t_captureBacklog, std::memory_order_relaxed);
+}
+
+void ProbeMetrics::setPerfCounters(const PerfThread t_thread, const PerfEventSample& t_delta, const uint64_t t_packets) {
+	for (int i = 0; i < PERF_EVENTS; i++) {
+		m_perfEvents[(int) t_thread][i].store(t_delta.values[i], std::memory_order_relaxed);
+		m_perfValid[(int) t_thread][i].store(t_delta.valid[i], std::memory_order_relaxed);
+	}
+	if (t_thread == PerfThread::CAPTURE) m_perfPackets.store(t_packets, std::memory_order_relaxed);
+}
+
+static void appendFormat(std::string& t_text, const char* t_format, ...) __attribute__((format(printf, 2, 3)));
+static void appendFormat(std::string& t_text, const char* t_format, ...) {
+	va_list args, argsCopy;
+
+	//formatted right into the text, so a family of any length is never cut
+	va_start(args, t_format);
+	va_copy(argsCopy, args);
+	int length = vsnprintf(NULL, 0, t_format, args);
+	va_end(args);
+	if (length > 0) {
+		std::size_t offset = t_text.size();
+		t_text.resize(offset + length + 1);
+		vsnprintf(&t_text[offset], length + 1, t_format, argsCopy);
+		t_text.resize(offset + length);
+	}
+	va_end(argsCopy);
+}
+
+std::string ProbeMetrics::render() const {
+	static const char* quantiles[4] = {"0.5", "0.99", "0.999", "1"};
+	static const char* perfThreadNames[PERF_THREADS] = {"capture", "control"};
+	static const char* memoryComponentNames[6] = {"tcp_sessions", "udp_sessions", "gaps", "dedup", "stat_queue", "packet_trace"};
+	std::string text;
+
+	text.reserve(4096);
+	text += "# TYPE tcpgeek_packets counter\n# HELP tcpgeek_packets Captured packets by parsing result.\n";
+	for (int i = 0; i < PACKET_PROCESSING_RESULTS; i++) {
+		appendFormat(text, "tcpgeek_packets_total{result=\"%s\"} %" PRIu64 "\n",
+					packetResultNames[i], m_packets[i].load(std::memory_order_relaxed));
+	}
+	text += "# TYPE tcpgeek_tcp_packets counter\n# HELP tcpgeek_tcp_packets TCP packets by session update result.\n";
+	for (int i = 0; i < TCP_SESSION_PROCESSING_RESULTS; i++) {
+		appendFormat(text, "tcpgeek_tcp_packets_total{result=\"%s\"} %" PRIu64 "\n",
+					tcpResultNames[i], m_tcpPackets[i].load(std::memory_order_relaxed));
+	}
+	text += "# TYPE tcpgeek_udp_packets counter\n# HELP tcpgeek_udp_packets UDP packets by session update result.\n";
+	for (int i = 0; i < UDP_SESSION_UPDATE_RESULTS; i++) {
+		appendFormat(text, "tcpgeek_udp_packets_total{result=\"%s\"} %" PRIu64 "\n",
+					udpResultNames[i], m_udpPackets[i].load(std::memory_order_relaxed));
+	}
+	appendFormat(text, "# TYPE tcpgeek_active_sessions gauge\n# HELP tcpgeek_active_sessions Tracked sessions at the last aggregation.\n"
+				"tcpgeek_active_sessions{protocol=\"tcp\"} %" PRIu64 "\ntcpgeek_active_sessions{protocol=\"udp\"} %" PRIu64 "\n",
+				m_activeTcpSessions.load(std::memory_order_relaxed), m_activeUdpSessions.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_tcp_sessions gauge\n# HELP tcpgeek_tcp_sessions Tracked TCP sessions by state at the last aggregation.\n"
+				"tcpgeek_tcp_sessions{state=\"established\"} %" PRIu64 "\ntcpgeek_tcp_sessions{state=\"half_open\"} %" PRIu64 "\n"
+				"tcpgeek_tcp_sessions{state=\"closing\"} %" PRIu64 "\n",
+				m_establishedTcpSessions.load(std::memory_order_relaxed), m_halfOpenTcpSessions.load(std::memory_order_relaxed),
+				m_closingTcpSessions.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_queue_depth gauge\n# HELP tcpgeek_queue_depth Records waiting in the queues at the last aggregation.\n"
+				"tcpgeek_queue_depth{queue=\"session_stat\"} %" PRIu64 "\n",
+				m_sessionsStatQueueDepth.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_traced_packets counter\n# HELP tcpgeek_traced_packets Packets written to the packet trace ring.\n"
+				"tcpgeek_traced_packets_total %" PRIu64 "\n", m_tracedPackets.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_kernel_aggregated_flows gauge\n# HELP tcpgeek_kernel_aggregated_flows TCP flows pre-aggregated by the eBPF socket filter.\n"
+				"tcpgeek_kernel_aggregated_flows %" PRIu64 "\n", m_kernelAggregatedFlows.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_kernel_aggregated_packets counter\n# HELP tcpgeek_kernel_aggregated_packets Packets counted in the kernel instead of being captured.\n"
+				"tcpgeek_kernel_aggregated_packets_total %" PRIu64 "\n", m_kernelAggregatedPackets.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_kernel_filtered_frames counter\n# HELP tcpgeek_kernel_filtered_frames Frames of the interface rejected by the kernel prefilter.\n"
+				"tcpgeek_kernel_filtered_frames_total %" PRIu64 "\n", m_kernelFilteredFrames.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_drops counter\n# HELP tcpgeek_drops Lost packets, batches and messages by cause.\n"
+				"tcpgeek_drops_total{cause=\"os_buffer\"} %" PRIu64 "\ntcpgeek_drops_total{cause=\"interface\"} %" PRIu64 "\n",
+				m_osBufferDrops.load(std::memory_order_relaxed), m_interfaceDrops.load(std::memory_order_relaxed));
+	appendFormat(text, "tcpgeek_drops_total{cause=\"stat_feed_overwritten\"} %" PRIu64 "\ntcpgeek_drops_total{cause=\"ipfix_message\"} %" PRIu64 "\n",
+				m_statFeedOverwrittenBatches.load(std::memory_order_relaxed), m_ipfixDroppedMessages.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_stat_write_seconds summary\n# HELP tcpgeek_stat_write_seconds Time to publish and write one interval of statistics.\n"
+				"tcpgeek_stat_write_seconds_sum %.6f\ntcpgeek_stat_write_seconds_count %" PRIu64 "\n",
+				m_statWriteMicrosTotal.load(std::memory_order_relaxed) / 1e6, m_statWrites.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_last_stat_write_seconds gauge\ntcpgeek_last_stat_write_seconds %.6f\n"
+				"# TYPE tcpgeek_last_stat_records gauge\ntcpgeek_last_stat_records %" PRIu64 "\n",
+				m_lastStatWriteMicros.load(std::memory_order_relaxed) / 1e6, m_lastStatRecords.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_packet_processing_cycles gauge\n# HELP tcpgeek_packet_processing_cycles Average CPU cycles per packet during the last interval.\n"
+				"tcpgeek_packet_processing_cycles %" PRIu64 "\n", m_avgPacketCycles.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_cpu_usage_percent gauge\ntcpgeek_cpu_usage_percent %.1f\n"
+				"# TYPE tcpgeek_memory_bytes gauge\ntcpgeek_memory_bytes{type=\"virtual\"} %" PRIu64 "\ntcpgeek_memory_bytes{type=\"resident\"} %" PRIu64 "\n",
+				m_cpuUsagePermille.load(std::memory_order_relaxed) / 10.0,
+				m_virtualMemoryKb.load(std::memory_order_relaxed) * 1024, m_physicalMemoryKb.load(std::memory_order_relaxed) * 1024);
+	text += "# TYPE tcpgeek_memory_component_bytes gauge\n# HELP tcpgeek_memory_component_bytes Estimated heap usage of the probe components.\n";
+	for (int i = 0; i < 6; i++) {
+		appendFormat(text, "tcpgeek_memory_component_bytes{component=\"%s\"} %" PRIu64 "\n",
+					memoryComponentNames[i], m_memoryComponents[i].load(std::memory_order_relaxed));
+	}
+	appendFormat(text, "# TYPE tcpgeek_memory_estimated_bytes gauge\ntcpgeek_memory_estimated_bytes %" PRIu64 "\n"
+				"# TYPE tcpgeek_memory_budget_bytes gauge\ntcpgeek_memory_budget_bytes %" PRIu64 "\n",
+				m_memoryEstimated.load(std::memory_order_relaxed), m_memoryBudget.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_memory_shedding_level gauge\n# HELP tcpgeek_memory_shedding_level 0 - none, 4 - sessions are evicted.\n"
+				"tcpgeek_memory_shedding_level %" PRIu64 "\n# TYPE tcpgeek_evicted_sessions counter\ntcpgeek_evicted_sessions_total %" PRIu64 "\n",
+				m_sheddingLevel.load(std::memory_order_relaxed), m_evictedSessions.load(std::memory_order_relaxed));
+	appendFormat(text, "# TYPE tcpgeek_sampling_rate gauge\n# HELP tcpgeek_sampling_rate New flows are sampled 1:N, 1 - all flows are tracked.\n"
+				"tcpgeek_sampling_rate %" PRIu64 "\n# TYPE tcpgeek_capture_busy_percent gauge\ntcpgeek_capture_busy_percent %" PRIu64 "\n"
+				"# TYPE tcpgeek_capture_backlog_packets gauge\ntcpgeek_capture_backlog_packets %" PRIu64 "\n",
+				m_samplingRate.load(std::memory_order_relaxed), m_captureBusyPct.load(std::memory_order_relaxed),
+				m_captureBacklog.load(std::memory_order_relaxed));
+	text += "# TYPE tcpgeek_stage_latency_nanoseconds gauge\n# HELP tcpgeek_stage_latency_nanoseconds Latency quantiles of the processing stages during the last interval.\n";
+	for (int i = 0; i < LATENCY_STAGES; i++) {
+		for (int j = 0; j < 4; j++) {
+			appendFormat(text, "tcpgeek_stage_latency_nanoseconds{stage=\"%s\",quantile=\"%s\"} %" PRIu64 "\n",
+						StageLatencies::getStageName(i), quantiles[j], m_stageLatencyNs[i][j].load(std::memory_order_relaxed));
+		}
+	}
+	text += "# TYPE tcpgeek_stage_samples gauge\n# HELP tcpgeek_stage_samples Measured executions of the processing stages during the last interval.\n";
+	for (int i = 0; i < LATENCY_STAGES; i++) {
+		appendFormat(text, "tcpgeek_stage_samples{stage=\"%s\"} %" PRIu64 "\n",
+					StageLatencies::getStageName(i), m_stageSamples[i].load(std::memory_order_relaxed));
+	}
+	//unavailable counters are not exposed at all rather than reported as zeros
+	text += "# TYPE tcpgeek_perf_events gauge\n# HELP tcpgeek_perf_events Hardware events of the probe threads during the last interval.\n";
+	for (int i = 0; i < PERF_THREADS; i++) {
+		for (int j = 0; j < PERF_EVENTS; j++) {
+			if (!m_perfValid[i][j].load(std::memory_order_relaxed)) continue;
+			appendFormat(text, "tcpgeek_perf_events{thread=\"%s\",event=\"%s\"} %" PRIu64 "\n",
+						perfThreadNames[i], PerfEventGroup::getEventName(j), m_perfEvents[i][j].load(std::memory_order_relaxed));
+		}
+	}
+	uint64_t perfPackets = m_perfPackets.load(std::memory_order_relaxed);
+	text += "# TYPE tcpgeek_perf_events_per_packet gauge\n# HELP tcpgeek_perf_events_per_packet Hardware events of the capture thread per processed packet.\n";
+	for (int j = 0; j < PERF_EVENTS && perfPackets > 0; j++) {
+		if (!m_perfValid[(int) PerfThread::CAPTURE][j].load(std::memory_order_relaxed)) continue;
+		appendFormat(text, "tcpgeek_perf_events_per_packet{event=\"%s\"} %.3f\n", PerfEventGroup::getEventName(j),
+					(double) m_perfEvents[(int) PerfThread::CAPTURE][j].load(std::memory_order_relaxed) / perfPackets);
+	}
+	text += "# EOF\n";
+	return text;
+}
@@ -0,0 +1,102 @@
+/*
+ *	ProbeMetrics.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : ProbeMetrics - self-metrics of the probe kept in atomics, so MetricsServer can
+ *					render them at any moment without locks and without touching session tables.
+ *					Packet counters are updated by the capture thread only, the rest are snapshots
+ *					published by the control thread once per granularity interval.
+ */
+
+#ifndef PROBEMETRICS_H_
+#define PROBEMETRICS_H_
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+#include "StageLatencies.h"
+#include "SelfMonitor.h"
+#include "layer_1/MemoryBudget.h"
+#include "layer_1/PacketProcessingResultEnum.h"
+#include "layer_1/sessions/TCP/TcpSessionUpdateResult.h"
+#include "layer_1/sessions/UDP/UdpSessionUpdateResultEnum.h"
+
+#define PACKET_PROCESSING_RESULTS 8		//values of PacketProcessingResultEnum
+#define TCP_SESSION_PROCESSING_RESULTS 9	//values of TcpSessionProcessingResultEnum
+#define UDP_SESSION_UPDATE_RESULTS 5		//values of UdpSessionUpdateResultEnum
+
+class ProbeMetrics {
+private:
+	//****CAPTURE THREAD****
+	std::atomic<uint64_t> m_packets[PACKET_PROCESSING_RESULTS];
+	std::atomic<uint64_t> m_tcpPackets[TCP_SESSION_PROCESSING_RESULTS];
+	std::atomic<uint64_t> m_udpPackets[UDP_SESSION_UPDATE_RESULTS];
+
+	//****CONTROL THREAD****
+	std::atomic<uint64_t> m_activeTcpSessions, m_activeUdpSessions;
+	std::atomic<uint64_t> m_establishedTcpSessions, m_halfOpenTcpSessions, m_closingTcpSessions;
+	std::atomic<uint64_t> m_sessionsStatQueueDepth, m_tracedPackets;
+	std::atomic<uint64_t> m_kernelAggregatedFlows, m_kernelAggregatedPackets, m_kernelFilteredFrames;
+	std::atomic<uint64_t> m_osBufferDrops, m_interfaceDrops;
+	std::atomic<uint64_t> m_statFeedOverwrittenBatches, m_ipfixDroppedMessages;
+	std::atomic<uint64_t> m_statWrites, m_statWriteMicrosTotal, m_lastStatWriteMicros, m_lastStatRecords;
+	std::atomic<uint64_t> m_avgPacketCycles;
+	std::atomic<uint64_t> m_virtualMemoryKb, m_physicalMemoryKb;
+	std::atomic<uint64_t> m_cpuUsagePermille; //integer, as std::atomic<double> has no portable guarantees
+	std::atomic<uint64_t> m_stageLatencyNs[LATENCY_STAGES][4]; //p50, p99, p99.9, max of the last interval
+	std::atomic<uint64_t> m_stageSamples[LATENCY_STAGES];
+	std::atomic<bool> m_perfValid[PERF_THREADS][PERF_EVENTS];
+	std::atomic<uint64_t> m_perfEvents[PERF_THREADS][PERF_EVENTS]; //deltas of the last interval
+	std::atomic<uint64_t> m_perfPackets; //packets processed by the capture thread during the same interval
+	std::atomic<uint64_t> m_memoryComponents[6]; //see MemoryUsage
+	std::atomic<uint64_t> m_memoryEstimated, m_memoryBudget;
+	std::atomic<uint64_t> m_sheddingLevel, m_evictedSessions;
+	std::atomic<uint64_t> m_samplingRate, m_captureBusyPct, m_captureBacklog;
+
+	static void increment(std::atomic<uint64_t>& t_counter) {
+		//the only writer, so no need in a locked read-modify-write on the packet path
+		t_counter.store(t_counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+public:
+	ProbeMetrics();
+
+	void countPacket(const PacketProcessingResultEnum t_result) {
+		if ((unsigned int) t_result < PACKET_PROCESSING_RESULTS) increment(m_packets[(int) t_result]);
+	}
+	void countTcpPacket(const TcpSessionProcessingResultEnum t_result) {
+		if ((unsigned int) t_result < TCP_SESSION_PROCESSING_RESULTS) increment(m_tcpPackets[(int) t_result]);
+	}
+	void countUdpPacket(const UdpSessionUpdateResultEnum t_result) {
+		if ((unsigned int) t_result < UDP_SESSION_UPDATE_RESULTS) increment(m_udpPackets[(int) t_result]);
+	}
+
+	void setSessions(const uint64_t t_activeTcpSessions, const uint64_t t_activeUdpSessions);
+	void setTcpSessionStates(const uint64_t t_established, const uint64_t t_halfOpen, const uint64_t t_closing);
+	void setQueueDepths(const uint64_t t_sessionsStatQueueDepth);
+	void setTracedPackets(const uint64_t t_tracedPackets);
+	void setKernelAggregation(const uint64_t t_flows, const uint64_t t_packets);
+	void setKernelFilteredFrames(const uint64_t t_frames);
+	void setCaptureDrops(const uint64_t t_osBufferDrops, const uint64_t t_interfaceDrops);
+	void setOutputDrops(const uint64_t t_statFeedOverwrittenBatches, const uint64_t t_ipfixDroppedMessages);
+	void observeStatWrite(const uint64_t t_micros, const uint64_t t_records);
+	void setSelfUsage(const double t_cpuUsagePercentage, const uint64_t t_virtualMemoryKb,
+						const uint64_t t_physicalMemoryKb, const uint64_t t_avgPacketCycles);
+	void setStageLatency(const int t_stage, const LatencySnapshot& t_snapshotNs);
+	void setMemoryUsage(const MemoryUsage& t_usage, const uint64_t t_estimatedBytes, const uint64_t t_budgetBytes,
+						const SheddingLevel t_level, const uint64_t t_evictedSessions);
+	void setOverload(const uint32_t t_samplingRate, const uint32_t t_captureBusyPct, const uint64_t t_captureBacklog);
+	void setPerfCounters(const PerfThread t_thread, const PerfEventSample& t_delta, const uint64_t t_packets);
+
+	std::string render() const;
+	//OpenMetrics text exposition of all metrics
+};
+
+#endif /* PROBEMETRICS_H_ */
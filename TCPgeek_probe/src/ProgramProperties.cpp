@@ -2,7 +2,7 @@
  *	ProgramProperties.cpp
  *
  *	Created on: Oct 11, 2023
- *	Last modified on: March 22, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -10,6 +10,8 @@
  *
  */
 
+#include <stdexcept>
+
 #include "ProgramProperties.h"
 
 std::string ProgramProperties::m_logConfigFileName;
@@ -22,38 +24,137 @@ bool ProgramProperties::m_promiscuous;
 bool ProgramProperties::m_restartOnDrops;
 unsigned long ProgramProperties::m_pcapBufferTimeout;
 unsigned long ProgramProperties::m_pcapBufferSize;
+unsigned long ProgramProperties::m_kernelPrefilter;
+unsigned long ProgramProperties::m_kernelPreaggregationFlows;
+unsigned long ProgramProperties::m_kernelPreaggregationSampling;
+unsigned long ProgramProperties::m_offlineWorkers;
 std::string ProgramProperties::m_source;
 std::string ProgramProperties::m_bpfExpression;
 std::string ProgramProperties::m_servicePortsStr;
 std::string ProgramProperties::m_localSubnetsStr;
+std::string ProgramProperties::m_localSubnetsFile;
 std::string ProgramProperties::m_statisticsFileNameTemplate;
 std::string ProgramProperties::m_statisticsOwnership;
 unsigned long ProgramProperties::m_statisticsRetentionPeriodH;
+unsigned long ProgramProperties::m_statisticsQuotaMB;
+std::string ProgramProperties::m_statisticsFormat;
+bool ProgramProperties::m_trafficMatrix;
+unsigned long ProgramProperties::m_topTalkers;
+bool ProgramProperties::m_topTalkersSessionsOnly;
+unsigned long ProgramProperties::m_serviceLatencyMaxServices;
+std::string ProgramProperties::m_statFeedFile;
+unsigned long ProgramProperties::m_statFeedCapacity;
+std::string ProgramProperties::m_packetTraceFile;
+unsigned long ProgramProperties::m_packetTraceRecords;
+std::string ProgramProperties::m_traceControlSocket;
+std::string ProgramProperties::m_ipfixCollector;
+unsigned long ProgramProperties::m_ipfixMtu;
+unsigned long ProgramProperties::m_ipfixObservationDomainId;
+unsigned long ProgramProperties::m_ipfixEnterpriseNumber;
+std::string ProgramProperties::m_metricsAddress;
+unsigned long ProgramProperties::m_metricsPort;
+bool ProgramProperties::m_perfCounters;
+unsigned long ProgramProperties::m_maxSamplingRate;
+std::string ProgramProperties::m_sessionSnapshotFile;
+unsigned long ProgramProperties::m_sessionSnapshotInterval;
 unsigned long ProgramProperties::m_maxMemoryUsageKB;
+std::string ProgramProperties::m_configFileName;
 
 ProgramProperties::ProgramProperties(const std::string configFileName) { //throws exceptions
 			ConfigFile cf(configFileName);
 			ProgramProperties::m_logConfigFileName = cf.value("general","loggingConfigurationFile");
 
 			log4cpp::PropertyConfigurator::configure(ProgramProperties::m_logConfigFileName);
-			ProgramProperties::m_granularity = std::stoul(cf.value("general", "granularity"),nullptr,10);
-			ProgramProperties::m_statisticsFileNameTemplate = cf.value("general","statisticsFileNameTemplate");
-			ProgramProperties::m_statisticsRetentionPeriodH = std::stoul(cf.value("general", "statisticsRetentionPeriodH"),nullptr,10);
-			ProgramProperties::m_statisticsOwnership = cf.value("general", "statisticsOwnership");
+			ProgramProperties::m_configFileName = configFileName;
+			readReloadableProperties(cf);
+			ProgramProperties::m_statFeedFile = optionalValue(cf, "general", "statFeedFile", "");
+			ProgramProperties::m_statFeedCapacity = std::stoul(optionalValue(cf, "general", "statFeedCapacity", "65536"),nullptr,10);
+			ProgramProperties::m_packetTraceFile = optionalValue(cf, "general", "packetTraceFile", "");
+			ProgramProperties::m_packetTraceRecords = std::stoul(optionalValue(cf, "general", "packetTraceRecords", "1048576"),nullptr,10);
+			ProgramProperties::m_traceControlSocket = optionalValue(cf, "general", "traceControlSocket", "");
+			ProgramProperties::m_metricsAddress = optionalValue(cf, "general", "metricsAddress", "127.0.0.1");
+			ProgramProperties::m_metricsPort = std::stoul(optionalValue(cf, "general", "metricsPort", "0"),nullptr,10);
+			ProgramProperties::m_perfCounters = std::stoul(optionalValue(cf, "general", "perfCounters", "0"),nullptr,10);
 			ProgramProperties::m_restartOnDrops = std::stoul(cf.value("general", "restartOnDrops"),nullptr,10);
+			ProgramProperties::m_maxSamplingRate = std::stoul(optionalValue(cf, "general", "maxSamplingRate", "64"),nullptr,10);
+			ProgramProperties::m_sessionSnapshotFile = optionalValue(cf, "general", "sessionSnapshotFile", "");
+			ProgramProperties::m_sessionSnapshotInterval = std::stoul(optionalValue(cf, "general", "sessionSnapshotInterval", "0"),nullptr,10);
 			ProgramProperties::m_maxMemoryUsageKB = std::stoul(cf.value("general", "maxMemoryUsageKB"),nullptr,10);
+			ProgramProperties::m_serviceLatencyMaxServices = std::stoul(optionalValue(cf, "general", "serviceLatencyMaxServices", "0"),nullptr,10);
 
-			ProgramProperties::m_idleTcpSessionTimeout = std::stoul(cf.value("networking", "idleTcpSessionTimeout"),nullptr,10);
 			ProgramProperties::m_maxTcpSessions = std::stoul(cf.value("networking", "maxTcpSessions"),nullptr,10);
-			ProgramProperties::m_deduplicationBufferSize = std::stoul(cf.value("networking", "deduplicationBufferSize"),nullptr,10);
-			ProgramProperties::m_deduplicationTimeout = std::stoul(cf.value("networking", "deduplicationTimeout"),nullptr,10);
 			ProgramProperties::m_promiscuous = std::stoul(cf.value("networking", "promiscuous"),nullptr,10);
 			ProgramProperties::m_pcapBufferTimeout = std::stoul(cf.value("networking", "pcap_packet_buffer_timeout"),nullptr,10);
 			ProgramProperties::m_pcapBufferSize = std::stoul(cf.value("networking", "pcap_buffer_size"),nullptr,10);
 			ProgramProperties::m_source = cf.value("networking","source");
 			ProgramProperties::m_bpfExpression = cf.value("networking","bpfExpression");
-			ProgramProperties::m_servicePortsStr  = cf.value("networking","servicePorts");
-			ProgramProperties::m_localSubnetsStr = cf.value("networking","localSubnets");
+			ProgramProperties::m_kernelPrefilter = std::stoul(optionalValue(cf, "networking", "kernelPrefilter", "0"),nullptr,10);
+			ProgramProperties::m_kernelPreaggregationFlows = std::stoul(optionalValue(cf, "networking", "kernelPreaggregationFlows", "0"),nullptr,10);
+			ProgramProperties::m_kernelPreaggregationSampling = std::stoul(optionalValue(cf, "networking", "kernelPreaggregationSampling", "64"),nullptr,10);
+			ProgramProperties::m_offlineWorkers = std::stoul(optionalValue(cf, "networking", "offlineWorkers", "0"),nullptr,10);
+}
+
+void ProgramProperties::readReloadableProperties(const ConfigFile& t_cf) {
+	//everything is parsed first, so a mistake in the file changes nothing
+	unsigned long granularity = std::stoul(t_cf.value("general", "granularity"),nullptr,10);
+	std::string statisticsFileNameTemplate = t_cf.value("general","statisticsFileNameTemplate");
+	unsigned long statisticsRetentionPeriodH = std::stoul(t_cf.value("general", "statisticsRetentionPeriodH"),nullptr,10);
+	unsigned long statisticsQuotaMB = std::stoul(optionalValue(t_cf, "general", "statisticsQuotaMB", "0"),nullptr,10);
+	std::string statisticsFormat = optionalValue(t_cf, "general", "statisticsFormat", "tsv");
+	if (statisticsFormat != "tsv" && statisticsFormat != "segment" && statisticsFormat != "arrow") {
+		throw std::runtime_error("Unknown statisticsFormat " + statisticsFormat + " in the configuration");
+	}
+	std::string statisticsOwnership = t_cf.value("general", "statisticsOwnership");
+	bool trafficMatrix = std::stoul(optionalValue(t_cf, "general", "trafficMatrix", "0"),nullptr,10);
+	unsigned long topTalkers = std::stoul(optionalValue(t_cf, "general", "topTalkers", "0"),nullptr,10);
+	bool topTalkersSessionsOnly = std::stoul(optionalValue(t_cf, "general", "topTalkersSessionsOnly", "0"),nullptr,10);
+	std::string ipfixCollector = optionalValue(t_cf, "general", "ipfixCollector", "");
+	unsigned long ipfixMtu = std::stoul(optionalValue(t_cf, "general", "ipfixMtu", "1500"),nullptr,10);
+	unsigned long ipfixObservationDomainId = std::stoul(optionalValue(t_cf, "general", "ipfixObservationDomainId", "1"),nullptr,10);
+	unsigned long ipfixEnterpriseNumber = std::stoul(optionalValue(t_cf, "general", "ipfixEnterpriseNumber", "32473"),nullptr,10);
+	unsigned long idleTcpSessionTimeout = std::stoul(t_cf.value("networking", "idleTcpSessionTimeout"),nullptr,10);
+	unsigned long deduplicationBufferSize = std::stoul(t_cf.value("networking", "deduplicationBufferSize"),nullptr,10);
+	unsigned long deduplicationTimeout = std::stoul(t_cf.value("networking", "deduplicationTimeout"),nullptr,10);
+	std::string servicePortsStr = t_cf.value("networking","servicePorts");
+	std::string localSubnetsStr = t_cf.value("networking","localSubnets");
+	std::string localSubnetsFile = optionalValue(t_cf, "networking", "localSubnetsFile", "");
+	if (granularity == 0) {
+		throw std::runtime_error("granularity must be at least 1 second");
+	}
+
+	m_granularity = granularity;
+	m_statisticsFileNameTemplate = statisticsFileNameTemplate;
+	m_statisticsRetentionPeriodH = statisticsRetentionPeriodH;
+	m_statisticsQuotaMB = statisticsQuotaMB;
+	m_statisticsFormat = statisticsFormat;
+	m_statisticsOwnership = statisticsOwnership;
+	m_trafficMatrix = trafficMatrix;
+	m_topTalkers = topTalkers;
+	m_topTalkersSessionsOnly = topTalkersSessionsOnly;
+	m_ipfixCollector = ipfixCollector;
+	m_ipfixMtu = ipfixMtu;
+	m_ipfixObservationDomainId = ipfixObservationDomainId;
+	m_ipfixEnterpriseNumber = ipfixEnterpriseNumber;
+	m_idleTcpSessionTimeout = idleTcpSessionTimeout;
+	m_deduplicationBufferSize = deduplicationBufferSize;
+	m_deduplicationTimeout = deduplicationTimeout;
+	m_servicePortsStr = servicePortsStr;
+	m_localSubnetsStr = localSubnetsStr;
+	m_localSubnetsFile = localSubnetsFile;
+}
+
+void ProgramProperties::reload() {
+	ConfigFile cf(m_configFileName);
+	readReloadableProperties(cf);
+}
+
+std::string ProgramProperties::optionalValue(const ConfigFile& t_cf, const std::string& t_section,
+											const std::string& t_entry, const std::string& t_defaultValue) {
+	try {
+		return t_cf.value(t_section, t_entry);
+	} catch (std::runtime_error& e) {
+		return t_defaultValue;
+	}
 }
 
 unsigned long ProgramProperties::getDeduplicationTimeout() {
@@ -80,6 +181,10 @@ const std::string& ProgramProperties::getLocalSubnetsStr() {
 	return ProgramProperties::m_localSubnetsStr;
 }
 
+const std::string& ProgramProperties::getLocalSubnetsFile() {
+	return ProgramProperties::m_localSubnetsFile;
+}
+
 const std::string& ProgramProperties::getLogConfigFileName() {
 	return ProgramProperties::m_logConfigFileName;
 }
@@ -100,6 +205,22 @@ bool ProgramProperties::isPromiscuous() {
 	return ProgramProperties::m_promiscuous;
 }
 
+unsigned long ProgramProperties::getKernelPrefilter() {
+	return ProgramProperties::m_kernelPrefilter;
+}
+
+unsigned long ProgramProperties::getKernelPreaggregationFlows() {
+	return ProgramProperties::m_kernelPreaggregationFlows;
+}
+
+unsigned long ProgramProperties::getKernelPreaggregationSampling() {
+	return ProgramProperties::m_kernelPreaggregationSampling;
+}
+
+unsigned long ProgramProperties::getOfflineWorkers() {
+	return ProgramProperties::m_offlineWorkers;
+}
+
 bool ProgramProperties::doRestartOnDrops() {
 	return ProgramProperties::m_restartOnDrops;
 }
@@ -124,6 +245,90 @@ unsigned long ProgramProperties::getStatisticsRetentionPeriodH() {
 	return m_statisticsRetentionPeriodH;
 }
 
+unsigned long ProgramProperties::getStatisticsQuotaMB() {
+	return m_statisticsQuotaMB;
+}
+
+const std::string& ProgramProperties::getStatisticsFormat() {
+	return m_statisticsFormat;
+}
+
+const std::string& ProgramProperties::getStatFeedFile() {
+	return m_statFeedFile;
+}
+
+unsigned long ProgramProperties::getStatFeedCapacity() {
+	return m_statFeedCapacity;
+}
+
+const std::string& ProgramProperties::getPacketTraceFile() {
+	return m_packetTraceFile;
+}
+
+unsigned long ProgramProperties::getPacketTraceRecords() {
+	return m_packetTraceRecords;
+}
+
+const std::string& ProgramProperties::getTraceControlSocket() {
+	return m_traceControlSocket;
+}
+
+const std::string& ProgramProperties::getIpfixCollector() {
+	return m_ipfixCollector;
+}
+
+unsigned long ProgramProperties::getIpfixMtu() {
+	return m_ipfixMtu;
+}
+
+unsigned long ProgramProperties::getIpfixObservationDomainId() {
+	return m_ipfixObservationDomainId;
+}
+
+unsigned long ProgramProperties::getIpfixEnterpriseNumber() {
+	return m_ipfixEnterpriseNumber;
+}
+
+const std::string& ProgramProperties::getMetricsAddress() {
+	return m_metricsAddress;
+}
+
+unsigned long ProgramProperties::getMetricsPort() {
+	return m_metricsPort;
+}
+
+bool ProgramProperties::doTrafficMatrix() {
+	return m_trafficMatrix;
+}
+
+unsigned long ProgramProperties::getTopTalkers() {
+	return m_topTalkers;
+}
+
+bool ProgramProperties::doTopTalkersSessionsOnly() {
+	return m_topTalkersSessionsOnly;
+}
+
+unsigned long ProgramProperties::getServiceLatencyMaxServices() {
+	return m_serviceLatencyMaxServices;
+}
+
+bool ProgramProperties::doPerfCounters() {
+	return m_perfCounters;
+}
+
+unsigned long ProgramProperties::getMaxSamplingRate() {
+	return m_maxSamplingRate;
+}
+
+const std::string& ProgramProperties::getSessionSnapshotFile() {
+	return m_sessionSnapshotFile;
+}
+
+unsigned long ProgramProperties::getSessionSnapshotInterval() {
+	return m_sessionSnapshotInterval;
+}
+
 const std::string& ProgramProperties::getSource() {
 	return ProgramProperties::m_source;
 }
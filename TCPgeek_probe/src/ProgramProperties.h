@@ -2,7 +2,7 @@
  *	ProgramProperties.h
  *
  *	Created on: Oct 11, 2023
- *	Last modified on: March 22, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -28,34 +28,96 @@ private:
 	static bool m_promiscuous;
 	static unsigned long m_pcapBufferTimeout;
 	static unsigned long m_pcapBufferSize;
+	static unsigned long m_kernelPrefilter;
+	static unsigned long m_kernelPreaggregationFlows;
+	static unsigned long m_kernelPreaggregationSampling;
+	static unsigned long m_offlineWorkers;
 	static std::string m_source;
 	static std::string m_bpfExpression;
 	static std::string m_servicePortsStr;
 	static std::string m_localSubnetsStr;
+	static std::string m_localSubnetsFile;
 	static std::string m_logConfigFileName;
 	static std::string m_statisticsFileNameTemplate;
 	static std::string m_statisticsOwnership;
 	static unsigned long m_statisticsRetentionPeriodH;
+	static unsigned long m_statisticsQuotaMB;
+	static std::string m_statisticsFormat;
+	static bool m_trafficMatrix;
+	static unsigned long m_topTalkers;
+	static bool m_topTalkersSessionsOnly;
+	static unsigned long m_serviceLatencyMaxServices;
+	static std::string m_statFeedFile;
+	static unsigned long m_statFeedCapacity;
+	static std::string m_packetTraceFile;
+	static unsigned long m_packetTraceRecords;
+	static std::string m_traceControlSocket;
+	static std::string m_ipfixCollector;
+	static unsigned long m_ipfixMtu;
+	static unsigned long m_ipfixObservationDomainId;
+	static unsigned long m_ipfixEnterpriseNumber;
+	static std::string m_metricsAddress;
+	static unsigned long m_metricsPort;
+	static bool m_perfCounters;
 	static bool m_restartOnDrops;
+	static unsigned long m_maxSamplingRate;
+	static std::string m_sessionSnapshotFile;
+	static unsigned long m_sessionSnapshotInterval;
 	static unsigned long m_maxMemoryUsageKB;
+	static std::string m_configFileName;
+
+	static std::string optionalValue(const ConfigFile& t_cf, const std::string& t_section,
+									const std::string& t_entry, const std::string& t_defaultValue);
+	//returns t_defaultValue when the entry is absent, so older configuration files keep working
+	static void readReloadableProperties(const ConfigFile& t_cf);
+	//reads the properties that can be changed without a restart, throws exceptions before changing any of them
 public:
 	ProgramProperties(const std::string configFileName);
+	static void reload();
+	//re-reads granularity, statistics output, idle timeout, deduplication, service ports, local subnets and their file
+	//invoked from snifferControl thread on SIGHUP, the packet path sees them through RuntimeSettings only
 	static unsigned long getDeduplicationTimeout();
 	static const std::string& getBpfExpression();
 	static unsigned long getDeduplicationBufferSize();
 	static unsigned long getGranularity();
 	static unsigned long getIdleTcpSessionTimeout();
 	static const std::string& getLocalSubnetsStr();
+	static const std::string& getLocalSubnetsFile();
 	static const std::string& getLogConfigFileName();
 	static unsigned long getMaxTcpSessions();
 	static unsigned long getPcapBufferSize();
 	static unsigned long getPcapBufferTimeout();
 	static bool isPromiscuous();
+	static unsigned long getKernelPrefilter();
+	static unsigned long getKernelPreaggregationFlows();
+	static unsigned long getKernelPreaggregationSampling();
+	static unsigned long getOfflineWorkers();
 	static bool doRestartOnDrops();
 	static const std::string& getServicePortsStr();
 	static const std::string& getSource();
 	static const std::string& getStatisticsLogFile();
 	static unsigned long getStatisticsRetentionPeriodH();
+	static unsigned long getStatisticsQuotaMB();
+	static const std::string& getStatisticsFormat();
+	static bool doTrafficMatrix();
+	static unsigned long getTopTalkers();
+	static bool doTopTalkersSessionsOnly();
+	static unsigned long getServiceLatencyMaxServices();
+	static const std::string& getStatFeedFile();
+	static unsigned long getStatFeedCapacity();
+	static const std::string& getPacketTraceFile();
+	static unsigned long getPacketTraceRecords();
+	static const std::string& getTraceControlSocket();
+	static const std::string& getIpfixCollector();
+	static unsigned long getIpfixMtu();
+	static unsigned long getIpfixObservationDomainId();
+	static unsigned long getIpfixEnterpriseNumber();
+	static const std::string& getMetricsAddress();
+	static unsigned long getMetricsPort();
+	static bool doPerfCounters();
+	static unsigned long getMaxSamplingRate();
+	static const std::string& getSessionSnapshotFile();
+	static unsigned long getSessionSnapshotInterval();
 	static const std::string& getStatisticsOwnership();
 	static const u_int32_t getMaxMemoryUsageKb();
 };
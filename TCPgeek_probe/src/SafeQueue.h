@@ -2,7 +2,7 @@
  *	SafeQueue.h
  *
  *	Created on: Apr 11, 2022
- *	Last modified on: Apr 11, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -57,6 +57,15 @@ public:
 		return false;
 	}
 
+	// Drop all the elements and give the memory back, returns number of dropped elements.
+	uint64_t clear() {
+		std::queue<T> empty;
+		std::unique_lock<std::mutex> lock(m);
+		uint64_t dropped = q.size();
+		std::swap(q, empty);
+		return dropped;
+	}
+
 	const uint64_t size() const {
 		std::unique_lock<std::mutex> lock(m);
 		return q.size();
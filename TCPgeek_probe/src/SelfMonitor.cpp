@@ -135,3 +135,25 @@ timespec SelfMonitor::tsDiff(timespec t_end, timespec t_start)
     }
     return temp;
 }
+
+double SelfMonitor::calibrateTscTicksPerNs() {
+	timespec startTime, endTime, pause = {0, 50000000};
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &startTime);
+	u_int64_t startTicks = getCpuTicksStart();
+	nanosleep(&pause, NULL);
+	clock_gettime(CLOCK_MONOTONIC_RAW, &endTime);
+	u_int64_t endTicks = getCpuTicksEnd();
+	timespec elapsed = tsDiff(endTime, startTime);
+	double elapsedNs = elapsed.tv_sec * 1e9 + elapsed.tv_nsec;
+	if (elapsedNs <= 0 || endTicks <= startTicks) return 1.0;
+	return (endTicks - startTicks) / elapsedNs;
+}
+
+bool SelfMonitor::openPerfCounters(const PerfThread t_thread) {
+	return m_perfGroups[(int) t_thread].open(0);
+}
+
+bool SelfMonitor::readPerfCounters(const PerfThread t_thread, PerfEventSample& t_delta) {
+	return m_perfGroups[(int) t_thread].readDelta(t_delta);
+}
@@ -6,6 +6,15 @@
 #include "string.h"
 #include "sys/times.h"
 #include "sys/vtimes.h"
+#include "time.h"
+
+#include "PerfEventGroup.h"
+
+enum class PerfThread {
+			CAPTURE,
+			CONTROL
+};
+#define PERF_THREADS 2
 
 
 class SelfMonitor {
@@ -15,6 +24,7 @@ private:
 	clock_t m_lastSysCPU;
 	clock_t m_lastUserCPU;
 	int m_numProcessors;
+	PerfEventGroup m_perfGroups[PERF_THREADS]; //hardware counters, opened only if perfCounters = 1
 	int parseLine(char* t_line);
 
 public:
@@ -22,10 +32,13 @@ public:
 	u_int32_t getVirtualMemoryKb();
 	u_int32_t getPhysicalMemoryKb();
 	double getCpuUsagePecentage();
+	bool openPerfCounters(const PerfThread t_thread); //must be invoked from the thread to be measured
+	bool readPerfCounters(const PerfThread t_thread, PerfEventSample& t_delta); //deltas since the previous call
 	static u_int64_t getCpuTicksStart(); //too slow
 	static u_int64_t getCpuTicksEnd(); //too slow
 	static u_int64_t getCpuTicks(); //fast, but not serialized
 	static timespec tsDiff(timespec t_end, timespec t_start);
+	static double calibrateTscTicksPerNs(); //measures TSC against CLOCK_MONOTONIC_RAW, takes 50ms
 };
 
 #endif /* SELFMONITOR_H_ */
@@ -0,0 +1,62 @@
+/*
+ *	StageLatencies.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "StageLatencies.h"
+#include "ProbeMetrics.h"
+#include "SelfMonitor.h"
+
+static const char* stageNames[LATENCY_STAGES] = {
+	"packet", "parse", "session_lookup", "session_update", "gap_handling", "aggregation"
+};
+
+StageLatencies::StageLatencies() {
+	memset(m_snapshots, 0, sizeof(m_snapshots));
+	memset(m_intervalTicksSum, 0, sizeof(m_intervalTicksSum));
+	m_tscTicksPerNs = SelfMonitor::calibrateTscTicksPerNs();
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.info("TSC frequency is calibrated to %.3f GHz", m_tscTicksPerNs);
+}
+
+void StageLatencies::takeIntervalSnapshots(ProbeMetrics& t_metrics) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	for (int i = 0; i < LATENCY_STAGES; i++) {
+		LatencySnapshot ticks = m_histograms[i].takeIntervalSnapshot();
+		LatencySnapshot& ns = m_snapshots[i];
+		m_intervalTicksSum[i] = ticks.sum;
+		ns.count = ticks.count;
+		ns.sum = ticks.sum / m_tscTicksPerNs;
+		ns.p50 = ticks.p50 / m_tscTicksPerNs;
+		ns.p99 = ticks.p99 / m_tscTicksPerNs;
+		ns.p999 = ticks.p999 / m_tscTicksPerNs;
+		ns.max = ticks.max / m_tscTicksPerNs;
+		t_metrics.setStageLatency(i, ns);
+		logRoot.debug("Latency of %s: p50 %" PRIu64 "ns, p99 %" PRIu64 "ns, p99.9 %" PRIu64 "ns, max %" PRIu64 "ns, %" PRIu64 " samples",
+						stageNames[i], ns.p50, ns.p99, ns.p999, ns.max, ns.count);
+	}
+}
+
+const LatencySnapshot& StageLatencies::getSnapshot(const LatencyStage t_stage) const {
+	return m_snapshots[(int) t_stage];
+}
+
+uint64_t StageLatencies::getIntervalTicksSum(const LatencyStage t_stage) const {
+	return m_intervalTicksSum[(int) t_stage];
+}
+
+const char* StageLatencies::getStageName(const int t_stage) {
+	return stageNames[t_stage];
+}
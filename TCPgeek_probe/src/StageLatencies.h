@@ -0,0 +1,56 @@
+/*
+ *	StageLatencies.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : StageLatencies - latency histograms of the processing stages. The packet stages are
+ *					recorded by the capture thread, the aggregation by the control thread, so every
+ *					histogram has its own single writer. Once per interval the control thread takes
+ *					the snapshots and converts TSC ticks to nanoseconds with the calibrated frequency.
+ */
+
+#ifndef STAGELATENCIES_H_
+#define STAGELATENCIES_H_
+
+#include <stdint.h>
+
+#include "LatencyHistogram.h"
+
+class ProbeMetrics;
+
+enum class LatencyStage {
+			PACKET,			//whole gotPacket()
+			PARSE,			//Packet::setPacketFromRaw()
+			SESSION_LOOKUP,	//search of TCP session in the map
+			SESSION_UPDATE,	//update of known TCP session or creation of a new one
+			GAP_HANDLING,	//sequence gap and retransmit analysis, a part of SESSION_UPDATE
+			AGGREGATION		//whole Sniffer::aggregateSessions()
+};
+#define LATENCY_STAGES 6
+
+class StageLatencies {
+private:
+	LatencyHistogram m_histograms[LATENCY_STAGES];
+	LatencySnapshot m_snapshots[LATENCY_STAGES]; //the last interval, in nanoseconds
+	uint64_t m_intervalTicksSum[LATENCY_STAGES]; //the last interval, in TSC ticks
+	double m_tscTicksPerNs;
+
+public:
+	StageLatencies();
+
+	void record(const LatencyStage t_stage, const uint64_t t_ticks) {
+		m_histograms[(int) t_stage].record(t_ticks);
+	}
+	void takeIntervalSnapshots(ProbeMetrics& t_metrics);
+	//might be invoked only from the control thread, logs the stages and publishes them to t_metrics
+	const LatencySnapshot& getSnapshot(const LatencyStage t_stage) const;
+	uint64_t getIntervalTicksSum(const LatencyStage t_stage) const;
+	static const char* getStageName(const int t_stage);
+};
+
+#endif /* STAGELATENCIES_H_ */
@@ -2,7 +2,7 @@
  *	TCPgeek_rt.cpp
  *
  *	Created on: Nov 30, 2021
- *	Last modified on: Nov 30, 2021
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -31,20 +31,29 @@
 
 //#include "thirdpartyCode/ConfigFile.h" //for properties
 #include "ProgramProperties.h"
-#include "layer_1/KnownPorts.h"
 #include "layer_1/Sniffer.h" // connection to Layer 1 functionality
+#include "layer_1/PacketTraceDecoder.h" // for -d
 #include "stdlib.h"
 
 int homebrewShutdownSignalHandler(sigset_t& t_sigSet,
 									std::condition_variable& t_shutdownCondVar,
 									std::atomic<bool>& t_shutdownRequested,
+									std::atomic<bool>& t_reloadRequested,
 									std::mutex& t_shutdownCondVarMutex) {
 	/*PRGORAM TERMINATION HANDLER THREAD FUCNTION*/
 	/*as per https://thomastrapp.com/blog/signal-handler-for-multithreaded-c++/*/
 
 	int signum = 0;
-	// wait until a signal is delivered:
-	sigwait(&t_sigSet, &signum);
+	// wait until a termination signal is delivered, SIGHUP only asks the control thread to reload the configuration
+	while (true) {
+		sigwait(&t_sigSet, &signum);
+		if (signum != SIGHUP) break;
+		{
+			std::unique_lock<std::mutex> lock(t_shutdownCondVarMutex);
+			t_reloadRequested.store(true, std::memory_order_relaxed);
+		}
+		t_shutdownCondVar.notify_all();
+	}
 
 	//command all the threads to shutdown
 	{
@@ -57,6 +66,7 @@ int homebrewShutdownSignalHandler(sigset_t& t_sigSet,
 }
 
 int snifferControl(std::atomic<bool>& t_shutdownRequested,
+				   std::atomic<bool>& t_reloadRequested,
 				   std::mutex& t_shutdownCondVarMutex,
 				   std::condition_variable& t_shutdownCondVar,
 				   Sniffer *t_sniffer) {
@@ -65,12 +75,23 @@ int snifferControl(std::atomic<bool>& t_shutdownRequested,
 
 	//Periodically aggregates TCP sessions and safely breaks pcap_loop() when shutdown_requested == true
 
+	t_sniffer->attachControlThread();
 	while(t_shutdownRequested.load(std::memory_order_relaxed) == false)
 	{
-		std::unique_lock<std::mutex> lock(t_shutdownCondVarMutex);
-		// when the condition variable is woken up and this predicate returns true, the wait is stopped:
-		t_shutdownCondVar.wait_for(lock, std::chrono::seconds(ProgramProperties::getGranularity()),
-								 [&t_shutdownRequested]() { return t_shutdownRequested.load(std::memory_order_relaxed); });
+		std::chrono::steady_clock::time_point intervalEnd = std::chrono::steady_clock::now() + std::chrono::seconds(ProgramProperties::getGranularity());
+		while (true) {
+			std::unique_lock<std::mutex> lock(t_shutdownCondVarMutex);
+			// when the condition variable is woken up and this predicate returns true, the wait is stopped:
+			t_shutdownCondVar.wait_until(lock, intervalEnd,
+									 [&t_shutdownRequested, &t_reloadRequested]() { return t_shutdownRequested.load(std::memory_order_relaxed) ||
+																							t_reloadRequested.load(std::memory_order_relaxed); });
+			if (t_shutdownRequested.load(std::memory_order_relaxed) || !t_reloadRequested.load(std::memory_order_relaxed)) break;
+			t_reloadRequested.store(false, std::memory_order_relaxed);
+			lock.unlock();
+			//the reload doesn't shorten the current interval
+			logRoot.info("SIGHUP received, reloading the configuration");
+			t_sniffer->reloadConfiguration();
+		}
 
 		//STATISTICS AGGREGATION
 		t_sniffer->aggregateSessions();
@@ -82,8 +103,28 @@ int snifferControl(std::atomic<bool>& t_shutdownRequested,
 	return 0;
 }
 
+int decodePacketTrace(const char* t_fileName) {
+	/*PRINTS THE PACKET TRACE RING IN TEXT AND EXITS, NO CONFIGURATION IS NEEDED*/
+	try {
+		PacketTraceDecoder decoder(t_fileName);
+		uint64_t printedRecords = decoder.decode(stdout);
+		fflush(stdout);
+		fprintf(stderr, "%" PRIu64 " packets decoded, %" PRIu64 " records were overwritten while reading, the trace is %s\n",
+				printedRecords, decoder.getSkippedRecords(), decoder.isClosed() ? "closed" : "still open or the writer has crashed");
+		return EXIT_SUCCESS;
+	} catch (std::exception& e) {
+		fprintf(stderr, "Exception when decoding packet trace:\n     %s\nExitting.\n", e.what());
+		return EXIT_FAILURE;
+	}
+}
+
 int main(int argc, char* argv[]) {
 
+	//****DECODE PACKET TRACE****
+	if ((argc == 3) && (strcmp(argv[1],"-d") == 0)) {
+		return decodePacketTrace(argv[2]);
+	}
+
 	//****READ CONFIGURATION****
 	std::string configFileName = "./TCPgeek_rt.conf";
 	//check if configuration file is specified in the command line
@@ -108,29 +149,35 @@ int main(int argc, char* argv[]) {
 		logRoot.info("Pcap buffer size is %" PRIu32 " bytes", ProgramProperties::getPcapBufferSize());
 		logRoot.info("Source: %s", ProgramProperties::getSource().c_str());
 
-		//****INITIALIZING LAYER 1****
-		Sniffer *sniffer = new Sniffer();
-
 		//****PRGORAM TERMINATION HANDLING****
 		//as per https://thomastrapp.com/blog/signal-handler-for-multithreaded-c++/
 
 		std::condition_variable shutdownCondVar;
 		std::atomic<bool> shutdownRequested;
+		std::atomic<bool> reloadRequested;
 		std::mutex shutdownCondVarMutex;
 
+		//blocked before the sniffer starts its helper threads, they inherit the mask
+		//and SIGHUP would terminate the process otherwise
 		sigset_t sigSet;
 		sigemptyset(&sigSet);
 		sigaddset(&sigSet, SIGINT);
 		sigaddset(&sigSet, SIGTERM);
+		sigaddset(&sigSet, SIGHUP);
 		pthread_sigmask(SIG_BLOCK, &sigSet, nullptr);
 
+		//****INITIALIZING LAYER 1****
+		Sniffer *sniffer = new Sniffer();
+
 		shutdownRequested.store(false, std::memory_order_relaxed);
+		reloadRequested.store(false, std::memory_order_relaxed);
 
 		std::future<int> ft_signal_handler = std::async(std::launch::async,
 														homebrewShutdownSignalHandler,
 														std::ref(sigSet),
 														std::ref(shutdownCondVar),
 														std::ref(shutdownRequested),
+														std::ref(reloadRequested),
 														std::ref(shutdownCondVarMutex));
 
 		//****STARTING CONTROL THREAD FOR SNIFFER****
@@ -138,6 +185,7 @@ int main(int argc, char* argv[]) {
 
 		std::future<int> res = std::async(std::launch::async, snifferControl,
 											std::ref(shutdownRequested),
+											std::ref(reloadRequested),
 											std::ref(shutdownCondVarMutex),
 											std::ref(shutdownCondVar),
 											sniffer);
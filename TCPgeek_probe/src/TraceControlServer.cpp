@@ -0,0 +1,218 @@
+/*
+ *	TraceControlServer.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <csignal>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "TraceControlServer.h"
+
+#define TRACE_CONTROL_COMMAND_MAX_SIZE 512
+#define TRACE_CONTROL_IO_TIMEOUT_MS 10000
+
+TraceControlServer::TraceControlServer(const std::string& t_socketPath) :
+										m_socketPath {t_socketPath} {
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (m_socketPath.size() >= sizeof(address.sun_path)) {
+		throw std::runtime_error("traceControlSocket path is too long: " + m_socketPath);
+	}
+	strcpy(address.sun_path, m_socketPath.c_str());
+	for (int i = 0; i < TRACE_SELECTORS_MAX; i++) m_expiresAt[i] = 0;
+
+	m_listenSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (m_listenSocket == -1) {
+		throw std::runtime_error(std::string("Can't create trace control socket: ") + strerror(errno));
+	}
+	//the socket of the previous run is left behind if it has crashed
+	if (unlink(m_socketPath.c_str()) != 0 && errno != ENOENT) {
+		std::string error = strerror(errno);
+		close(m_listenSocket);
+		throw std::runtime_error("Can't remove the old trace control socket " + m_socketPath + ": " + error);
+	}
+	if (bind(m_listenSocket, (struct sockaddr*) &address, sizeof(address)) != 0 ||
+			chmod(m_socketPath.c_str(), 0600) != 0 || listen(m_listenSocket, 4) != 0) {
+		std::string error = strerror(errno);
+		close(m_listenSocket);
+		throw std::runtime_error("Can't listen for trace control on " + m_socketPath + ": " + error);
+	}
+	if (pipe2(m_wakeupPipe, O_CLOEXEC) != 0) {
+		close(m_listenSocket);
+		throw std::runtime_error(std::string("Can't create trace control wakeup pipe: ") + strerror(errno));
+	}
+	//signals are handled by the dedicated thread, so the server thread starts with all of them blocked
+	sigset_t sigSet, oldSigSet;
+	sigfillset(&sigSet);
+	pthread_sigmask(SIG_BLOCK, &sigSet, &oldSigSet);
+	m_thread = std::thread(&TraceControlServer::serve, this);
+	pthread_sigmask(SIG_SETMASK, &oldSigSet, nullptr);
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.info("Packets are traced only when selected through %s", m_socketPath.c_str());
+}
+
+TraceControlServer::~TraceControlServer() {
+	char wakeup = 0;
+	if (write(m_wakeupPipe[1], &wakeup, 1) != 1) {
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.error("Can't wake up trace control server: %s", strerror(errno));
+	}
+	m_thread.join();
+	TraceSelectors::clear();
+	close(m_wakeupPipe[0]);
+	close(m_wakeupPipe[1]);
+	close(m_listenSocket);
+	unlink(m_socketPath.c_str());
+}
+
+time_t TraceControlServer::now() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec;
+}
+
+void TraceControlServer::serve() {
+	struct pollfd fds[2];
+	fds[0].fd = m_listenSocket;
+	fds[0].events = POLLIN;
+	fds[1].fd = m_wakeupPipe[0];
+	fds[1].events = POLLIN;
+
+	while (true) {
+		if (poll(fds, 2, expireSelectors()) < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		if (fds[1].revents != 0) break;
+		if (fds[0].revents & POLLIN) {
+			int connection = accept4(m_listenSocket, NULL, NULL, SOCK_CLOEXEC);
+			if (connection == -1) continue;
+			handleConnection(connection);
+			close(connection);
+		}
+	}
+}
+
+int TraceControlServer::expireSelectors() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	std::string description;
+	time_t currentTime = now();
+	time_t nextExpiration = 0;
+
+	for (int i = 0; i < TRACE_SELECTORS_MAX; i++) {
+		if (m_expiresAt[i] == 0) continue;
+		if (m_expiresAt[i] <= currentTime) {
+			TraceSelectors::describe(i, description);
+			TraceSelectors::remove(i);
+			m_expiresAt[i] = 0;
+			logRoot.info("Trace selector %d has expired: %s", i, description.c_str());
+		} else if (nextExpiration == 0 || m_expiresAt[i] < nextExpiration) {
+			nextExpiration = m_expiresAt[i];
+		}
+	}
+	return nextExpiration == 0 ? -1 : (nextExpiration - currentTime) * 1000;
+}
+
+void TraceControlServer::handleConnection(const int t_socket) {
+	char buffer[TRACE_CONTROL_COMMAND_MAX_SIZE];
+	std::string pending;
+	struct timeval timeout = {TRACE_CONTROL_IO_TIMEOUT_MS / 1000, 0};
+	setsockopt(t_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(t_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	while (true) {
+		ssize_t res = recv(t_socket, buffer, sizeof(buffer), 0);
+		if (res <= 0) return;
+		pending.append(buffer, res);
+		std::size_t lineEnd;
+		while ((lineEnd = pending.find('\n')) != std::string::npos) {
+			std::string command = pending.substr(0, lineEnd);
+			pending.erase(0, lineEnd + 1);
+			if (!command.empty() && command[command.size() - 1] == '\r') command.erase(command.size() - 1);
+			if (command.empty()) continue;
+			std::string response = execute(command);
+			std::size_t sent = 0;
+			while (sent < response.size()) {
+				res = send(t_socket, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+				if (res <= 0) return;
+				sent += res;
+			}
+			//the expirations are not late while the client keeps the connection open
+			expireSelectors();
+		}
+		if (pending.size() > TRACE_CONTROL_COMMAND_MAX_SIZE) return;
+	}
+}
+
+std::string TraceControlServer::execute(const std::string& t_command) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	std::istringstream ss(t_command);
+	std::string verb;
+	ss >> verb;
+
+	if (verb == "add") {
+		std::string selectorStr, word, error;
+		unsigned long ttl = TRACE_SELECTOR_DEFAULT_TTL;
+		while (ss >> word) {
+			if (word == "ttl") {
+				std::string ttlStr;
+				ss >> ttlStr;
+				char* end;
+				ttl = strtoul(ttlStr.c_str(), &end, 10);
+				if (ttlStr.empty() || *end != '\0' || ttl == 0 || ttl > TRACE_SELECTOR_MAX_TTL) {
+					return "error ttl is 1 to " + std::to_string(TRACE_SELECTOR_MAX_TTL) + " seconds\n";
+				}
+			} else {
+				selectorStr += word + " ";
+			}
+		}
+		TraceSelector selector;
+		if (!TraceSelectors::parse(selectorStr, selector, error)) return "error " + error + "\n";
+		int id = TraceSelectors::install(selector);
+		if (id < 0) return "error all " + std::to_string(TRACE_SELECTORS_MAX) + " selectors are in use\n";
+		m_expiresAt[id] = now() + ttl;
+		logRoot.info("Trace selector %d is installed for %lu seconds: %s", id, ttl, selectorStr.c_str());
+		return "ok " + std::to_string(id) + " ttl " + std::to_string(ttl) + "\n";
+	} else if (verb == "del") {
+		int id = -1;
+		ss >> id;
+		if (!TraceSelectors::remove(id)) return "error no selector " + std::to_string(id) + "\n";
+		m_expiresAt[id] = 0;
+		logRoot.info("Trace selector %d is removed", id);
+		return "ok\n";
+	} else if (verb == "clear") {
+		TraceSelectors::clear();
+		for (int i = 0; i < TRACE_SELECTORS_MAX; i++) m_expiresAt[i] = 0;
+		logRoot.info("Trace selectors are cleared");
+		return "ok\n";
+	} else if (verb == "list") {
+		std::string response, description;
+		time_t currentTime = now();
+		for (int i = 0; i < TRACE_SELECTORS_MAX; i++) {
+			if (!TraceSelectors::describe(i, description)) continue;
+			response += std::to_string(i) + " " + description + "; expires in " +
+							std::to_string(m_expiresAt[i] - currentTime) + "\n";
+		}
+		return response + "ok\n";
+	}
+	return "error commands are add, del, clear and list\n";
+}
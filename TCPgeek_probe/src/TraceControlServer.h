@@ -0,0 +1,57 @@
+/*
+ *	TraceControlServer.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : TraceControlServer - line based control of the packet trace selectors on a
+ *					UNIX stream socket (traceControlSocket), served on its own thread, which is
+ *					the only thread changing TraceSelectors. Every selector expires after its TTL.
+ *					One connection is served at a time, e.g. with socat - UNIX-CONNECT:<socket>
+ *
+ *		add <selector> [ttl <seconds>]	- installs a selector, answers 'ok <id> ttl <seconds>'
+ *		del <id>						- removes the selector
+ *		clear							- removes every selector
+ *		list							- '<id> <selector>; matched <packets>; expires in <seconds>' lines and 'ok'
+ *	Selectors are 'flow a.b.c.d:port a.b.c.d:port [tcp|udp]', 'subnet a.b.c.d/len', 'port N'
+ *	and 'error <mask of the session error bits>'. Failed commands are answered with 'error <reason>'.
+ */
+
+#ifndef TRACECONTROLSERVER_H_
+#define TRACECONTROLSERVER_H_
+
+#include <string>
+#include <thread>
+#include <ctime>
+
+#include "layer_1/TraceSelectors.h"
+
+#define TRACE_SELECTOR_DEFAULT_TTL 300 //seconds
+#define TRACE_SELECTOR_MAX_TTL 86400
+
+class TraceControlServer {
+private:
+	std::string m_socketPath;
+	int m_listenSocket;
+	int m_wakeupPipe[2]; //the destructor writes to it to stop poll()
+	std::thread m_thread;
+	time_t m_expiresAt[TRACE_SELECTORS_MAX]; //CLOCK_MONOTONIC seconds, touched by the server thread only
+
+	void serve();
+	void handleConnection(const int t_socket);
+	std::string execute(const std::string& t_command);
+	int expireSelectors();
+	//removes the expired selectors, returns milliseconds till the next expiration or -1 if nothing is installed
+	static time_t now();
+
+public:
+	TraceControlServer(const std::string& t_socketPath);
+	//throws exceptions if the socket can't be bound
+	~TraceControlServer();
+};
+
+#endif /* TRACECONTROLSERVER_H_ */
@@ -0,0 +1,190 @@
+/*
+ *	ArrowStatEncoder.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <arpa/inet.h>
+#include <string.h>
+
+#include "layer_1/ArrowStatEncoder.h"
+#include "layer_1/FlatBufferWriter.h"
+
+//values of org.apache.arrow.flatbuf enums and unions used below, see Schema.fbs and Message.fbs
+#define ARROW_METADATA_V5 4
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_RECORD_BATCH 3
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_UTF8 5
+#define ARROW_TYPE_TIMESTAMP 10
+#define ARROW_TIME_UNIT_MICROSECOND 2
+#define ARROW_CONTINUATION 0xFFFFFFFF
+
+const ArrowStatEncoder::Column ArrowStatEncoder::m_columns[] = {
+	{"timestamp", COLUMN_TIMESTAMP_US, 64, [](const StatRecord& r) -> uint64_t { return r.getTimestampEpoch(); }},
+	{"ip_protocol", COLUMN_UINT, 8, [](const StatRecord& r) -> uint64_t { return r.getIpProtocol(); }},
+	{"client_ip", COLUMN_UINT, 32, [](const StatRecord& r) -> uint64_t { return ntohl(r.getTcpUdpSessionKey().m_clientIpRaw.s_addr); }},
+	{"client_port", COLUMN_UINT, 16, [](const StatRecord& r) -> uint64_t { return r.getTcpUdpSessionKey().m_clientPort; }},
+	{"server_ip", COLUMN_UINT, 32, [](const StatRecord& r) -> uint64_t { return ntohl(r.getTcpUdpSessionKey().m_serverIpRaw.s_addr); }},
+	{"server_port", COLUMN_UINT, 16, [](const StatRecord& r) -> uint64_t { return r.getTcpUdpSessionKey().m_serverPort; }},
+	{"topology", COLUMN_CHAR, 8, [](const StatRecord& r) -> uint64_t { return (uint64_t) r.getTopology(); }},
+	{"client_packets", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientPackets(); }},
+	{"server_packets", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerPackets(); }},
+	{"client_bytes", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientBytes(); }},
+	{"server_bytes", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerBytes(); }},
+	{"client_efficient_bytes", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientEfficientBytes(); }},
+	{"server_efficient_bytes", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerEfficientBytes(); }},
+	{"client_duplicates", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientDuplicatesCounter(); }},
+	{"server_duplicates", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerDuplicatesCounter(); }},
+	{"client_out_of_order", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientOutOfOrderCounter(); }},
+	{"server_out_of_order", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerOutOfOrderCounter(); }},
+	{"client_active_gaps", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientActiveSequenceGaps(); }},
+	{"server_active_gaps", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerActiveSequenceGaps(); }},
+	{"client_retransmits", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientRetransmits(); }},
+	{"server_retransmits", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerRetransmits(); }},
+	{"operations", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getOperations(); }},
+	{"client_idle_time_us", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getClientIdleTime(); }},
+	{"request_time_us", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getRequestTime(); }},
+	{"server_think_time_us", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getServerThinkTime(); }},
+	{"response_time_us", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getResponseTime(); }},
+	{"total_session_idle_time_us", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getTotalSessionIdleTime(); }},
+	{"error_code", COLUMN_UINT, 32, [](const StatRecord& r) -> uint64_t { return r.getSessionErrorCode(); }},
+	{"rtt_us", COLUMN_UINT, 64, [](const StatRecord& r) -> uint64_t { return r.getRtt(); }},
+	{"sampling_rate", COLUMN_UINT, 32, [](const StatRecord& r) -> uint64_t { return r.getSamplingRate(); }},
+	{"client_tag", COLUMN_UINT, 32, [](const StatRecord& r) -> uint64_t { return r.getClientTag(); }},
+	{"server_tag", COLUMN_UINT, 32, [](const StatRecord& r) -> uint64_t { return r.getServerTag(); }},
+	{"interface_id", COLUMN_UINT, 32, [](const StatRecord& r) -> uint64_t { return r.getTcpUdpSessionKey().m_interfaceId; }},
+	{NULL, COLUMN_UINT, 0, NULL}
+};
+
+ArrowStatEncoder::ArrowStatEncoder() {
+	encodeSchema();
+}
+
+void ArrowStatEncoder::appendMessage(std::string& t_stream, const std::string& t_metadata, const std::string& t_body) {
+	//<continuation><metadata size><flatbuffer padded to 8 bytes><body>
+	uint32_t continuation = ARROW_CONTINUATION;
+	int32_t metadataSize = (t_metadata.size() + 7) & ~7;
+	t_stream.append((const char*) &continuation, sizeof(continuation));
+	t_stream.append((const char*) &metadataSize, sizeof(metadataSize));
+	t_stream.append(t_metadata);
+	t_stream.append(metadataSize - t_metadata.size(), '\0');
+	t_stream.append(t_body);
+}
+
+void ArrowStatEncoder::encodeSchema() {
+	FlatBufferWriter fb;
+	FlatBufferWriter::Table message, schema;
+	std::vector<std::size_t> messageSlots, schemaSlots, fieldSlots;
+
+	message.addScalar(0, 2, ARROW_METADATA_V5);		//version
+	message.addScalar(1, 1, ARROW_HEADER_SCHEMA);	//header_type
+	message.addOffset(2);							//header
+	message.addScalar(3, 8, 0);						//bodyLength
+	fb.setRoot(fb.writeTable(message, messageSlots));
+
+	schema.addScalar(0, 2, 0);						//endianness = Little
+	schema.addOffset(1);							//fields
+	fb.patchOffset(messageSlots[0], fb.writeTable(schema, schemaSlots));
+
+	std::size_t columnsCount = 0;
+	while (m_columns[columnsCount].name != NULL) columnsCount++;
+	fb.patchOffset(schemaSlots[0], fb.writeOffsetVector(columnsCount, fieldSlots));
+
+	for (std::size_t i = 0; i < columnsCount; i++) {
+		FlatBufferWriter::Table field, type;
+		std::vector<std::size_t> slots, typeSlots, unused;
+		field.addOffset(0);							//name
+		field.addScalar(1, 1, 0);					//nullable
+		field.addScalar(2, 1, m_columns[i].type == COLUMN_TIMESTAMP_US ? ARROW_TYPE_TIMESTAMP :
+								m_columns[i].type == COLUMN_CHAR ? ARROW_TYPE_UTF8 : ARROW_TYPE_INT);	//type_type
+		field.addOffset(3);							//type
+		field.addOffset(5);							//children, readers insist on the empty vector
+		fb.patchOffset(fieldSlots[i], fb.writeTable(field, slots));
+		fb.patchOffset(slots[0], fb.writeString(m_columns[i].name));
+		switch (m_columns[i].type) {
+		case COLUMN_TIMESTAMP_US:
+			type.addScalar(0, 2, ARROW_TIME_UNIT_MICROSECOND);	//unit
+			type.addOffset(1);									//timezone
+			fb.patchOffset(slots[1], fb.writeTable(type, typeSlots));
+			fb.patchOffset(typeSlots[0], fb.writeString("UTC"));
+			break;
+		case COLUMN_UINT:
+			type.addScalar(0, 4, m_columns[i].bitWidth);		//bitWidth
+			type.addScalar(1, 1, 0);							//is_signed
+			fb.patchOffset(slots[1], fb.writeTable(type, typeSlots));
+			break;
+		case COLUMN_CHAR:
+			fb.patchOffset(slots[1], fb.writeTable(type, typeSlots));
+			break;
+		}
+		fb.patchOffset(slots[2], fb.writeOffsetVector(0, unused));
+	}
+	appendMessage(m_schemaMessage, fb.getBuffer(), "");
+}
+
+void ArrowStatEncoder::appendBodyBuffer(const void* t_data, const std::size_t t_size) {
+	BufferRef bufferRef = {(int64_t) m_body.size(), (int64_t) t_size};
+	m_bufferRefs.push_back(bufferRef);
+	if (t_size > 0) m_body.append((const char*) t_data, t_size);
+	m_body.append(((t_size + 7) & ~7) - t_size, '\0'); //every buffer starts 8 byte aligned
+}
+
+void ArrowStatEncoder::encode(const std::vector<StatRecord>& t_batch, std::string& t_stream) {
+	FlatBufferWriter fb;
+	FlatBufferWriter::Table message, recordBatch;
+	std::vector<std::size_t> messageSlots, recordBatchSlots;
+	std::vector<FieldNode> fieldNodes;
+	std::vector<uint64_t> values(t_batch.size());
+	std::vector<char> bytes(t_batch.size() * sizeof(uint64_t));
+	std::size_t rows = t_batch.size();
+
+	m_body.clear();
+	m_bufferRefs.clear();
+	for (std::size_t c = 0; m_columns[c].name != NULL; c++) {
+		FieldNode fieldNode = {(int64_t) rows, 0};
+		fieldNodes.push_back(fieldNode);
+		for (std::size_t r = 0; r < rows; r++) {
+			values[r] = m_columns[c].getValue(t_batch[r]);
+		}
+		appendBodyBuffer(NULL, 0); //validity bitmap may be omitted when there are no nulls
+		if (m_columns[c].type == COLUMN_CHAR) {
+			std::vector<int32_t> offsets(rows + 1);
+			for (std::size_t r = 0; r <= rows; r++) offsets[r] = r;
+			appendBodyBuffer(offsets.data(), offsets.size() * sizeof(int32_t));
+			for (std::size_t r = 0; r < rows; r++) bytes[r] = (char) values[r];
+			appendBodyBuffer(bytes.data(), rows);
+			continue;
+		}
+		//narrowing to the column width, x86 is little-endian as Arrow requires
+		std::size_t width = m_columns[c].bitWidth / 8;
+		for (std::size_t r = 0; r < rows; r++) {
+			memcpy(&bytes[r * width], &values[r], width);
+		}
+		appendBodyBuffer(bytes.data(), rows * width);
+	}
+
+	message.addScalar(0, 2, ARROW_METADATA_V5);			//version
+	message.addScalar(1, 1, ARROW_HEADER_RECORD_BATCH);	//header_type
+	message.addOffset(2);								//header
+	message.addScalar(3, 8, m_body.size());				//bodyLength
+	fb.setRoot(fb.writeTable(message, messageSlots));
+
+	recordBatch.addScalar(0, 8, rows);					//length
+	recordBatch.addOffset(1);							//nodes
+	recordBatch.addOffset(2);							//buffers
+	fb.patchOffset(messageSlots[0], fb.writeTable(recordBatch, recordBatchSlots));
+	fb.patchOffset(recordBatchSlots[0], fb.writeStructVector(&fieldNodes[0], fieldNodes.size(), sizeof(FieldNode)));
+	fb.patchOffset(recordBatchSlots[1], fb.writeStructVector(&m_bufferRefs[0], m_bufferRefs.size(), sizeof(BufferRef)));
+
+	uint32_t endOfStream[2] = {ARROW_CONTINUATION, 0};
+	t_stream = m_schemaMessage;
+	appendMessage(t_stream, fb.getBuffer(), m_body);
+	t_stream.append((const char*) endOfStream, sizeof(endOfStream));
+}
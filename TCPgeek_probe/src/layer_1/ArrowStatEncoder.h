@@ -0,0 +1,65 @@
+/*
+ *	ArrowStatEncoder.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : ArrowStatEncoder - encodes a batch of StatRecord as an Apache Arrow IPC stream
+ *					(schema message, one record batch, end-of-stream marker, metadata version V5)
+ *					straight from the records, without the text representation. The stream can be
+ *					read with pyarrow.ipc.open_stream, pandas, polars, DuckDB and so on.
+ *					Columns follow the TSV format, but the IP addresses are uint32 in host order,
+ *					the time components and RTT are in microseconds instead of milliseconds.
+ */
+
+#ifndef ARROWSTATENCODER_H_
+#define ARROWSTATENCODER_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "layer_1/StatRecord.h"
+
+class ArrowStatEncoder {
+private:
+	enum ColumnType {
+		COLUMN_TIMESTAMP_US,	//timestamp[us, tz=UTC]
+		COLUMN_UINT,			//unsigned integer of bitWidth bits
+		COLUMN_CHAR				//utf8 string of one character
+	};
+	struct Column {
+		const char* name;
+		ColumnType type;
+		uint8_t bitWidth;
+		uint64_t (*getValue)(const StatRecord& t_statRecord);
+	};
+	struct FieldNode {		//layout of org.apache.arrow.flatbuf.FieldNode
+		int64_t length;
+		int64_t nullCount;
+	};
+	struct BufferRef {		//layout of org.apache.arrow.flatbuf.Buffer
+		int64_t offset;
+		int64_t length;
+	};
+
+	static const Column m_columns[];
+	std::string m_schemaMessage; //the schema never changes, so it is encoded once
+	std::string m_body; //reused between batches
+	std::vector<BufferRef> m_bufferRefs;
+
+	static void appendMessage(std::string& t_stream, const std::string& t_metadata, const std::string& t_body);
+	void encodeSchema();
+	void appendBodyBuffer(const void* t_data, const std::size_t t_size);
+
+public:
+	ArrowStatEncoder();
+	void encode(const std::vector<StatRecord>& t_batch, std::string& t_stream);
+	//replaces the content of t_stream with the complete IPC stream of the batch
+};
+
+#endif /* ARROWSTATENCODER_H_ */
@@ -0,0 +1,98 @@
+/*
+ *	CapturePrefilter.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <arpa/inet.h>
+
+#include "layer_1/CapturePrefilter.h"
+#include "layer_1/KnownPorts.h"
+#include "layer_1/LocalSubnets.h"
+#include "ProgramProperties.h"
+
+CapturePrefilter::CapturePrefilter(const unsigned long t_level, const std::string& t_bpfExpression, const bool t_isVlanPossible) :
+									m_lastInterfaceFrames {0} {
+	if (t_level != CAPTURE_PREFILTER_IP && t_level != CAPTURE_PREFILTER_SERVICES) {
+		throw std::runtime_error("kernelPrefilter must be 0, 1 or 2");
+	}
+	std::string conditions = buildConditions(t_level);
+	//the conditions are repeated after 'vlan', where the offsets are those of the tagged frames
+	std::string prefilter = "(" + conditions + ")";
+	if (t_isVlanPossible) prefilter += " or (vlan and " + conditions + ")";
+	m_expression = t_bpfExpression.empty() ? prefilter : "(" + t_bpfExpression + ") and (" + prefilter + ")";
+}
+
+std::string CapturePrefilter::buildConditions(const unsigned long t_level) {
+	std::string conditions = "ip and (tcp or udp)";
+	if (t_level < CAPTURE_PREFILTER_SERVICES) return conditions;
+
+	KnownPorts knownPorts(ProgramProperties::getServicePortsStr());
+	std::vector<unsigned int> ports(knownPorts.getPorts().begin(), knownPorts.getPorts().end());
+	std::sort(ports.begin(), ports.end());
+	if (ports.empty()) {
+		throw std::runtime_error("kernelPrefilter 2 needs servicePorts");
+	}
+	std::string portConditions;
+	for (std::size_t i = 0; i < ports.size(); i++) {
+		portConditions += (i == 0 ? "port " : " or port ") + std::to_string(ports[i]);
+	}
+	conditions += " and (" + portConditions + ")";
+
+	//an empty list of local subnets doesn't restrict the addresses
+	LocalSubnets localSubnets(ProgramProperties::getLocalSubnetsStr(), ProgramProperties::getLocalSubnetsFile());
+	std::string subnetConditions;
+	for (uint32_t id = 1; id <= localSubnets.size(); id++) {
+		in_addr prefix;
+		char prefixStr[INET_ADDRSTRLEN];
+		prefix.s_addr = htonl(localSubnets.getSubnet(id)->getPrefix());
+		inet_ntop(AF_INET, &prefix, prefixStr, INET_ADDRSTRLEN);
+		subnetConditions += (id == 1 ? "net " : " or net ") + std::string(prefixStr) + "/" +
+								std::to_string(localSubnets.getSubnet(id)->getPrefixLength());
+	}
+	if (!subnetConditions.empty()) conditions += " and (" + subnetConditions + ")";
+	return conditions;
+}
+
+void CapturePrefilter::attachInterface(const std::string& t_device) {
+	std::string statisticsDir = "/sys/class/net/" + t_device + "/statistics/";
+	if (t_device.find('/') != std::string::npos || access((statisticsDir + "rx_packets").c_str(), R_OK) != 0) return;
+	m_rxPacketsFile = statisticsDir + "rx_packets";
+	m_txPacketsFile = statisticsDir + "tx_packets";
+	if (!readInterfaceFrames(m_lastInterfaceFrames)) m_rxPacketsFile.clear();
+}
+
+bool CapturePrefilter::readInterfaceFrames(uint64_t& t_frames) const {
+	uint64_t rxPackets = 0, txPackets = 0;
+	if (m_rxPacketsFile.empty()) return false;
+	std::ifstream rxFile(m_rxPacketsFile), txFile(m_txPacketsFile);
+	//the capture sees both directions
+	if (!(rxFile >> rxPackets) || !(txFile >> txPackets)) return false;
+	t_frames = rxPackets + txPackets;
+	return true;
+}
+
+const std::string& CapturePrefilter::getExpression() const {
+	return m_expression;
+}
+
+bool CapturePrefilter::takeInterfaceFrames(uint64_t& t_frames) {
+	uint64_t interfaceFrames;
+	if (!readInterfaceFrames(interfaceFrames)) return false;
+	//the counters of a driver might be reset
+	t_frames = interfaceFrames >= m_lastInterfaceFrames ? interfaceFrames - m_lastInterfaceFrames : interfaceFrames;
+	m_lastInterfaceFrames = interfaceFrames;
+	return true;
+}
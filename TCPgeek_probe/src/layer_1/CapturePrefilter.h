@@ -0,0 +1,54 @@
+/*
+ *	CapturePrefilter.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : CapturePrefilter - the filter expression the capture is compiled with when
+ *					kernelPrefilter is configured. It admits only IPv4 TCP and UDP, plain or
+ *					802.1Q tagged on Ethernet, so ARP, IPv6, ICMP and the rest are dropped by the
+ *					kernel instead of being discarded by Packet::setPacketFromRaw(). Level 2 also
+ *					requires a service port and a local subnet on either side. bpfExpression,
+ *					if any, is kept in front of it, as the 'vlan' keyword shifts the offsets of
+ *					everything that follows it.
+ *
+ *	The frames of a live interface are counted in /sys/class/net/<device>/statistics, what
+ *	is missing in pcap_stats() was rejected by the filter. Service ports and local subnets
+ *	are taken at the start, a reload doesn't change the kernel filter.
+ */
+
+#ifndef CAPTUREPREFILTER_H_
+#define CAPTUREPREFILTER_H_
+
+#include <string>
+#include <stdint.h>
+
+#define CAPTURE_PREFILTER_OFF 0
+#define CAPTURE_PREFILTER_IP 1 //IPv4 TCP and UDP
+#define CAPTURE_PREFILTER_SERVICES 2 //and a service port and a local subnet on either side
+
+class CapturePrefilter {
+private:
+	std::string m_expression;
+	std::string m_rxPacketsFile, m_txPacketsFile; //empty if the source has no counters, e.g. 'any'
+	uint64_t m_lastInterfaceFrames;
+
+	bool readInterfaceFrames(uint64_t& t_frames) const;
+	static std::string buildConditions(const unsigned long t_level);
+	//throws exceptions if servicePorts or localSubnets can't be used
+
+public:
+	CapturePrefilter(const unsigned long t_level, const std::string& t_bpfExpression, const bool t_isVlanPossible);
+	//throws exceptions if the level is unknown, t_isVlanPossible is true for the Ethernet link type only
+	void attachInterface(const std::string& t_device);
+	//starts counting the frames of a live interface
+	const std::string& getExpression() const;
+	bool takeInterfaceFrames(uint64_t& t_frames);
+	//frames seen by the interface since the previous call, false if they are unknown
+};
+
+#endif /* CAPTUREPREFILTER_H_ */
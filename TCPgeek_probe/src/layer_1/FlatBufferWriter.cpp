@@ -0,0 +1,126 @@
+/*
+ *	FlatBufferWriter.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <algorithm>
+#include <string.h>
+
+#include "layer_1/FlatBufferWriter.h"
+
+void FlatBufferWriter::Table::addScalar(const uint16_t t_id, const uint8_t t_size, const uint64_t t_value) {
+	Slot slot = {t_id, t_size, false, t_value};
+	m_slots.push_back(slot);
+}
+
+void FlatBufferWriter::Table::addOffset(const uint16_t t_id) {
+	Slot slot = {t_id, 4, true, 0};
+	m_slots.push_back(slot);
+}
+
+FlatBufferWriter::FlatBufferWriter() {
+	m_buffer.assign(4, '\0'); //root offset, set by setRoot
+}
+
+void FlatBufferWriter::appendRaw(const void* t_data, const std::size_t t_size) {
+	m_buffer.append((const char*) t_data, t_size);
+}
+
+void FlatBufferWriter::pad(const std::size_t t_alignment, const std::size_t t_remainder) {
+	while (m_buffer.size() % t_alignment != t_remainder) {
+		m_buffer.push_back('\0');
+	}
+}
+
+std::size_t FlatBufferWriter::writeTable(const Table& t_table, std::vector<std::size_t>& t_offsetSlots) {
+	std::vector<Table::Slot> slots = t_table.m_slots;
+	uint16_t fieldsCount = 0;
+	bool hasLongFields = false;
+
+	//the largest fields first, so every field is naturally aligned without padding inside the table
+	std::stable_sort(slots.begin(), slots.end(),
+			[](const Table::Slot& a, const Table::Slot& b) { return a.size > b.size; });
+	for (std::size_t i = 0; i < slots.size(); i++) {
+		fieldsCount = std::max<uint16_t>(fieldsCount, slots[i].id + 1);
+		if (slots[i].size == 8) hasLongFields = true;
+	}
+	std::vector<uint16_t> vtable(2 + fieldsCount, 0);
+	uint16_t tableSize = 4; //soffset_t to the vtable
+	for (std::size_t i = 0; i < slots.size(); i++) {
+		vtable[2 + slots[i].id] = tableSize;
+		tableSize += slots[i].size;
+	}
+	vtable[0] = vtable.size() * sizeof(uint16_t);
+	vtable[1] = tableSize;
+
+	pad(2);
+	std::size_t vtablePos = m_buffer.size();
+	appendRaw(&vtable[0], vtable.size() * sizeof(uint16_t));
+	//8 byte fields start right after the 4 byte soffset_t
+	if (hasLongFields) pad(8, 4); else pad(4);
+	std::size_t tablePos = m_buffer.size();
+	int32_t vtableOffset = (int32_t) (tablePos - vtablePos);
+	appendRaw(&vtableOffset, sizeof(vtableOffset));
+	for (std::size_t i = 0; i < slots.size(); i++) {
+		appendRaw(&slots[i].value, slots[i].size); //little-endian host, the low bytes go first
+	}
+	t_offsetSlots.clear();
+	std::vector<Table::Slot> byId = t_table.m_slots;
+	std::sort(byId.begin(), byId.end(), [](const Table::Slot& a, const Table::Slot& b) { return a.id < b.id; });
+	for (std::size_t i = 0; i < byId.size(); i++) {
+		if (byId[i].isOffset) t_offsetSlots.push_back(tablePos + vtable[2 + byId[i].id]);
+	}
+	return tablePos;
+}
+
+std::size_t FlatBufferWriter::writeString(const std::string& t_string) {
+	pad(4);
+	std::size_t stringPos = m_buffer.size();
+	uint32_t length = t_string.size();
+	appendRaw(&length, sizeof(length));
+	m_buffer.append(t_string);
+	m_buffer.push_back('\0');
+	return stringPos;
+}
+
+std::size_t FlatBufferWriter::writeOffsetVector(const std::size_t t_count, std::vector<std::size_t>& t_offsetSlots) {
+	pad(4);
+	std::size_t vectorPos = m_buffer.size();
+	uint32_t length = t_count;
+	appendRaw(&length, sizeof(length));
+	t_offsetSlots.clear();
+	for (std::size_t i = 0; i < t_count; i++) {
+		t_offsetSlots.push_back(m_buffer.size());
+		m_buffer.append(4, '\0');
+	}
+	return vectorPos;
+}
+
+std::size_t FlatBufferWriter::writeStructVector(const void* t_data, const std::size_t t_count, const std::size_t t_structSize) {
+	pad(8, 4);
+	std::size_t vectorPos = m_buffer.size();
+	uint32_t length = t_count;
+	appendRaw(&length, sizeof(length));
+	appendRaw(t_data, t_count * t_structSize);
+	return vectorPos;
+}
+
+void FlatBufferWriter::patchOffset(const std::size_t t_slot, const std::size_t t_target) {
+	uint32_t offset = t_target - t_slot;
+	memcpy(&m_buffer[t_slot], &offset, sizeof(offset));
+}
+
+void FlatBufferWriter::setRoot(const std::size_t t_table) {
+	patchOffset(0, t_table);
+}
+
+const std::string& FlatBufferWriter::getBuffer() const {
+	return m_buffer;
+}
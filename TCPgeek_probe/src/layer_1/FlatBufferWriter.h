@@ -0,0 +1,65 @@
+/*
+ *	FlatBufferWriter.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : FlatBufferWriter - the minimal subset of the FlatBuffers wire format needed
+ *					for Arrow IPC metadata, so the probe doesn't depend on flatbuffers or arrow
+ *					libraries. Unlike the reference builder it writes front to back: a parent
+ *					table reserves offset slots for its children, which are written after it
+ *					and then patched in, so all uoffset_t values point forward as required.
+ */
+
+#ifndef FLATBUFFERWRITER_H_
+#define FLATBUFFERWRITER_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class FlatBufferWriter {
+public:
+	class Table {
+	private:
+		struct Slot {
+			uint16_t id;
+			uint8_t size; //1, 2, 4 or 8 bytes, the offset slots are 4 bytes
+			bool isOffset;
+			uint64_t value;
+		};
+		std::vector<Slot> m_slots;
+		friend class FlatBufferWriter;
+	public:
+		void addScalar(const uint16_t t_id, const uint8_t t_size, const uint64_t t_value);
+		void addOffset(const uint16_t t_id);
+		//the child object is written later and linked with FlatBufferWriter::patchOffset
+	};
+
+private:
+	std::string m_buffer;
+
+	void appendRaw(const void* t_data, const std::size_t t_size);
+	void pad(const std::size_t t_alignment, const std::size_t t_remainder = 0);
+	//pads the buffer until its size % t_alignment == t_remainder
+
+public:
+	FlatBufferWriter();
+
+	std::size_t writeTable(const Table& t_table, std::vector<std::size_t>& t_offsetSlots);
+	//returns position of the table, t_offsetSlots receives positions of offset slots in id order
+	std::size_t writeString(const std::string& t_string);
+	std::size_t writeOffsetVector(const std::size_t t_count, std::vector<std::size_t>& t_offsetSlots);
+	//vector of t_count offsets to tables to be patched later
+	std::size_t writeStructVector(const void* t_data, const std::size_t t_count, const std::size_t t_structSize);
+	//vector of structs with 8 byte alignment, t_data is already in little-endian layout
+	void patchOffset(const std::size_t t_slot, const std::size_t t_target);
+	void setRoot(const std::size_t t_table);
+	const std::string& getBuffer() const;
+};
+
+#endif /* FLATBUFFERWRITER_H_ */
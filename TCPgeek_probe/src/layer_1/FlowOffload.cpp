@@ -0,0 +1,303 @@
+/*
+ *	FlowOffload.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+//pcap.h has its own struct bpf_insn of the classic filters
+#define bpf_insn ebpf_insn
+#include <linux/bpf.h>
+#undef bpf_insn
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+
+#include "layer_1/FlowOffload.h"
+
+#ifndef SO_ATTACH_BPF
+#define SO_ATTACH_BPF 50
+#endif
+
+#define FLOW_OFFLOAD_LOG_SIZE 65536
+#define FLOW_OFFLOAD_ACCEPT 0x7fffffff //the whole packet, the snap length is applied by pcap
+#define LINUX_SLL_HEADER_LEN 16 //pcap adds it to the length of the cooked packets
+
+//a tiny assembler of the filter, the jumps are resolved once the labels are known
+enum FlowOffloadLabel {ACCEPT, LO_SRC, HI_SRC, LOOKUP, LABELS};
+
+struct FlowOffloadAssembler {
+	std::vector<struct ebpf_insn> program;
+	std::vector<std::pair<std::size_t, FlowOffloadLabel>> jumps;
+	int labels[LABELS];
+
+	void emit(const uint8_t t_code, const uint8_t t_dst, const uint8_t t_src, const int16_t t_off, const int32_t t_imm) {
+		struct ebpf_insn insn;
+		memset(&insn, 0, sizeof(insn));
+		insn.code = t_code;
+		insn.dst_reg = t_dst;
+		insn.src_reg = t_src;
+		insn.off = t_off;
+		insn.imm = t_imm;
+		program.push_back(insn);
+	}
+	void jump(const uint8_t t_code, const uint8_t t_dst, const uint8_t t_src, const int32_t t_imm, const FlowOffloadLabel t_label) {
+		jumps.push_back(std::make_pair(program.size(), t_label));
+		emit(BPF_JMP | t_code, t_dst, t_src, 0, t_imm);
+	}
+	void label(const FlowOffloadLabel t_label) {
+		labels[t_label] = program.size();
+	}
+	void resolve() {
+		for (std::size_t i = 0; i < jumps.size(); i++) {
+			program[jumps[i].first].off = labels[jumps[i].second] - (jumps[i].first + 1);
+		}
+	}
+};
+
+static long bpf(const int t_cmd, union bpf_attr* t_attr) {
+	return syscall(__NR_bpf, t_cmd, t_attr, sizeof(*t_attr));
+}
+
+FlowOffload::FlowOffload(pcap_t* t_handle, const int t_linkType, const std::string& t_bpfExpression,
+							const uint32_t t_capacity, const uint32_t t_sampling) :
+							m_socket {pcap_fileno(t_handle)},
+							m_mapFd {-1},
+							m_programFd {-1},
+							m_capacity {t_capacity},
+							m_insertFailures {0} {
+	if (t_sampling < 2 || t_sampling > 65536 || (t_sampling & (t_sampling - 1)) != 0) {
+		throw std::runtime_error("kernelPreaggregationSampling must be a power of two from 2 to 65536");
+	}
+	if (m_socket == -1) {
+		throw std::runtime_error("the capture has no socket");
+	}
+	//attaching the offload replaces the kernel filter of pcap, so the expression is applied here from then on
+	if (pcap_compile(t_handle, &m_filter, t_bpfExpression.c_str(), 1, PCAP_NETMASK_UNKNOWN) == PCAP_ERROR) {
+		throw std::runtime_error(std::string("can't compile the filter: ") + pcap_geterr(t_handle));
+	}
+
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_HASH;
+	attr.key_size = sizeof(FlowOffloadKey);
+	attr.value_size = sizeof(FlowOffloadValue);
+	attr.max_entries = m_capacity;
+	m_mapFd = bpf(BPF_MAP_CREATE, &attr);
+	if (m_mapFd < 0) {
+		std::string error = strerror(errno);
+		pcap_freecode(&m_filter);
+		throw std::runtime_error("can't create the flow map: " + error);
+	}
+	try {
+		loadProgram(t_sampling - 1, t_linkType == DLT_LINUX_SLL ? LINUX_SLL_HEADER_LEN : 0);
+	} catch (std::exception& e) {
+		close(m_mapFd);
+		pcap_freecode(&m_filter);
+		throw;
+	}
+	if (setsockopt(m_socket, SOL_SOCKET, SO_ATTACH_BPF, &m_programFd, sizeof(m_programFd)) != 0) {
+		std::string error = strerror(errno);
+		close(m_programFd);
+		close(m_mapFd);
+		pcap_freecode(&m_filter);
+		throw std::runtime_error("can't attach the filter: " + error);
+	}
+}
+
+FlowOffload::~FlowOffload() {
+	//the socket keeps the program and the map while it is open
+	close(m_programFd);
+	close(m_mapFd);
+	pcap_freecode(&m_filter);
+}
+
+void FlowOffload::loadProgram(const uint32_t t_samplingMask, const uint32_t t_linkHeaderLen) {
+	FlowOffloadAssembler a;
+	//R6 - context, R7 - IP header length and then the direction, R8 - IP total length, R9 - acknowledged number
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_0, BPF_REG_6, offsetof(struct __sk_buff, protocol), 0);
+	a.jump(BPF_JNE | BPF_K, BPF_REG_0, 0, htons(ETH_P_IP), ACCEPT);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_0, BPF_REG_6, offsetof(struct __sk_buff, len), 0);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_0, -20, 0);
+	//IPv4 without options or fragments, TCP with ACK only and no payload
+	a.emit(BPF_LD | BPF_B | BPF_ABS, 0, 0, 0, SKF_NET_OFF + 0);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0);
+	a.emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_7, 0, 0, 0x0f);
+	a.emit(BPF_ALU64 | BPF_LSH | BPF_K, BPF_REG_7, 0, 0, 2);
+	a.emit(BPF_ALU64 | BPF_RSH | BPF_K, BPF_REG_0, 0, 0, 4);
+	a.jump(BPF_JNE | BPF_K, BPF_REG_0, 0, 4, ACCEPT);
+	a.emit(BPF_LD | BPF_B | BPF_ABS, 0, 0, 0, SKF_NET_OFF + 9);
+	a.jump(BPF_JNE | BPF_K, BPF_REG_0, 0, IPPROTO_TCP, ACCEPT);
+	a.emit(BPF_LD | BPF_H | BPF_ABS, 0, 0, 0, SKF_NET_OFF + 6);
+	a.emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_0, 0, 0, 0x3fff);
+	a.jump(BPF_JNE | BPF_K, BPF_REG_0, 0, 0, ACCEPT);
+	a.emit(BPF_LD | BPF_H | BPF_ABS, 0, 0, 0, SKF_NET_OFF + 2);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0);
+	a.emit(BPF_LD | BPF_B | BPF_IND, 0, BPF_REG_7, 0, SKF_NET_OFF + 13);
+	a.jump(BPF_JNE | BPF_K, BPF_REG_0, 0, 0x10, ACCEPT);
+	a.emit(BPF_LD | BPF_B | BPF_IND, 0, BPF_REG_7, 0, SKF_NET_OFF + 12);
+	a.emit(BPF_ALU64 | BPF_RSH | BPF_K, BPF_REG_0, 0, 0, 4);
+	a.emit(BPF_ALU64 | BPF_LSH | BPF_K, BPF_REG_0, 0, 0, 2);
+	a.emit(BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_0, BPF_REG_7, 0, 0);
+	a.jump(BPF_JNE | BPF_X, BPF_REG_0, BPF_REG_8, 0, ACCEPT);
+	a.emit(BPF_LD | BPF_W | BPF_IND, 0, BPF_REG_7, 0, SKF_NET_OFF + 8);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_9, BPF_REG_0, 0, 0);
+	//the endpoints go to the stack, the loads scratch R1-R5
+	a.emit(BPF_LD | BPF_W | BPF_ABS, 0, 0, 0, SKF_NET_OFF + 12);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_0, -24, 0);
+	a.emit(BPF_LD | BPF_W | BPF_ABS, 0, 0, 0, SKF_NET_OFF + 16);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_0, -28, 0);
+	a.emit(BPF_LD | BPF_H | BPF_IND, 0, BPF_REG_7, 0, SKF_NET_OFF + 0);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_0, -32, 0);
+	a.emit(BPF_LD | BPF_H | BPF_IND, 0, BPF_REG_7, 0, SKF_NET_OFF + 2);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_0, -36, 0);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_1, BPF_REG_10, -24, 0);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_10, -28, 0);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_3, BPF_REG_10, -32, 0);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_4, BPF_REG_10, -36, 0);
+	//the key at fp-16 is FlowOffloadKey, the same as makeKey() builds
+	a.emit(BPF_ST | BPF_W | BPF_MEM, BPF_REG_10, 0, -4, 0);
+	a.jump(BPF_JGT | BPF_X, BPF_REG_2, BPF_REG_1, 0, LO_SRC);
+	a.jump(BPF_JGT | BPF_X, BPF_REG_1, BPF_REG_2, 0, HI_SRC);
+	a.jump(BPF_JGT | BPF_X, BPF_REG_4, BPF_REG_3, 0, LO_SRC);
+	a.label(HI_SRC);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_7, 0, 0, 1);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_2, -16, 0);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_1, -12, 0);
+	a.emit(BPF_STX | BPF_H | BPF_MEM, BPF_REG_10, BPF_REG_4, -8, 0);
+	a.emit(BPF_STX | BPF_H | BPF_MEM, BPF_REG_10, BPF_REG_3, -6, 0);
+	a.jump(BPF_JA, 0, 0, 0, LOOKUP);
+	a.label(LO_SRC);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_7, 0, 0, 0);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_1, -16, 0);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_2, -12, 0);
+	a.emit(BPF_STX | BPF_H | BPF_MEM, BPF_REG_10, BPF_REG_3, -8, 0);
+	a.emit(BPF_STX | BPF_H | BPF_MEM, BPF_REG_10, BPF_REG_4, -6, 0);
+	a.label(LOOKUP);
+	a.emit(BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, m_mapFd);
+	a.emit(0, 0, 0, 0, 0);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0);
+	a.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -16);
+	a.emit(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem);
+	a.jump(BPF_JEQ | BPF_K, BPF_REG_0, 0, 0, ACCEPT);
+	//a repeated acknowledged number is a duplicate ACK, a window update or a keepalive, all of them are analyzed
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_0, 0, 0);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_1, BPF_REG_6, 0, 0);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_7, 0, 0);
+	a.emit(BPF_ALU64 | BPF_LSH | BPF_K, BPF_REG_2, 0, 0, 2);
+	a.emit(BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_1, BPF_REG_2, 0, 0);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_1, offsetof(FlowOffloadValue, lastAck), 0);
+	a.jump(BPF_JEQ | BPF_X, BPF_REG_2, BPF_REG_9, 0, ACCEPT);
+	a.emit(BPF_STX | BPF_W | BPF_MEM, BPF_REG_1, BPF_REG_9, offsetof(FlowOffloadValue, lastAck), 0);
+	a.emit(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_get_prandom_u32);
+	a.emit(BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_0, 0, 0, t_samplingMask);
+	a.jump(BPF_JEQ | BPF_K, BPF_REG_0, 0, 0, ACCEPT);
+	//absorbed
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_1, BPF_REG_6, 0, 0);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_7, 0, 0);
+	a.emit(BPF_ALU64 | BPF_LSH | BPF_K, BPF_REG_2, 0, 0, 3);
+	a.emit(BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_1, BPF_REG_2, 0, 0);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_2, 0, 0, 1);
+	a.emit(BPF_STX | BPF_DW | BPF_XADD, BPF_REG_1, BPF_REG_2, offsetof(FlowOffloadValue, packets), 0);
+	a.emit(BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_10, -20, 0);
+	a.emit(BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, t_linkHeaderLen);
+	a.emit(BPF_STX | BPF_DW | BPF_XADD, BPF_REG_1, BPF_REG_2, offsetof(FlowOffloadValue, bytes), 0);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, 0);
+	a.emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+	a.label(ACCEPT);
+	a.emit(BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, FLOW_OFFLOAD_ACCEPT);
+	a.emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+	a.resolve();
+
+	std::vector<char> log(FLOW_OFFLOAD_LOG_SIZE, '\0');
+	char license[] = "GPL";
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+	attr.insns = (uint64_t) (uintptr_t) a.program.data();
+	attr.insn_cnt = a.program.size();
+	attr.license = (uint64_t) (uintptr_t) license;
+	attr.log_buf = (uint64_t) (uintptr_t) log.data();
+	attr.log_size = log.size();
+	attr.log_level = 1;
+	m_programFd = bpf(BPF_PROG_LOAD, &attr);
+	if (m_programFd < 0) {
+		throw std::runtime_error(std::string("the kernel has refused the filter: ") + strerror(errno) + "\n" + log.data());
+	}
+}
+
+void FlowOffload::readEntries(std::vector<FlowOffloadEntry>& t_entries) const {
+	FlowOffloadEntry entry;
+	FlowOffloadKey previousKey;
+	union bpf_attr attr;
+	t_entries.clear();
+
+	memset(&attr, 0, sizeof(attr));
+	attr.map_fd = m_mapFd;
+	attr.key = 0; //the first key
+	attr.next_key = (uint64_t) (uintptr_t) &entry.key;
+	while (bpf(BPF_MAP_GET_NEXT_KEY, &attr) == 0) {
+		union bpf_attr lookupAttr;
+		memset(&lookupAttr, 0, sizeof(lookupAttr));
+		lookupAttr.map_fd = m_mapFd;
+		lookupAttr.key = (uint64_t) (uintptr_t) &entry.key;
+		lookupAttr.value = (uint64_t) (uintptr_t) &entry.value;
+		if (bpf(BPF_MAP_LOOKUP_ELEM, &lookupAttr) == 0) t_entries.push_back(entry);
+		previousKey = entry.key;
+		attr.key = (uint64_t) (uintptr_t) &previousKey;
+	}
+}
+
+void FlowOffload::updateEntries(const std::vector<FlowOffloadKey>& t_staleKeys, const std::vector<FlowOffloadKey>& t_newKeys) {
+	union bpf_attr attr;
+	FlowOffloadValue value;
+	memset(&value, 0, sizeof(value));
+
+	for (std::size_t i = 0; i < t_staleKeys.size(); i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.map_fd = m_mapFd;
+		attr.key = (uint64_t) (uintptr_t) &t_staleKeys[i];
+		bpf(BPF_MAP_DELETE_ELEM, &attr);
+	}
+	for (std::size_t i = 0; i < t_newKeys.size(); i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.map_fd = m_mapFd;
+		attr.key = (uint64_t) (uintptr_t) &t_newKeys[i];
+		attr.value = (uint64_t) (uintptr_t) &value;
+		attr.flags = BPF_NOEXIST;
+		if (bpf(BPF_MAP_UPDATE_ELEM, &attr) != 0) m_insertFailures++;
+	}
+}
+
+uint32_t FlowOffload::getCapacity() const {
+	return m_capacity;
+}
+
+uint64_t FlowOffload::getInsertFailures() const {
+	return m_insertFailures;
+}
+
+FlowOffloadKey FlowOffload::makeKey(const uint32_t t_ipA, const uint16_t t_portA, const uint32_t t_ipB, const uint16_t t_portB,
+									bool& t_isALo) {
+	FlowOffloadKey key;
+	t_isALo = t_ipA < t_ipB || (t_ipA == t_ipB && t_portA < t_portB);
+	key.ipLo = t_isALo ? t_ipA : t_ipB;
+	key.ipHi = t_isALo ? t_ipB : t_ipA;
+	key.portLo = t_isALo ? t_portA : t_portB;
+	key.portHi = t_isALo ? t_portB : t_portA;
+	key.reserved = 0;
+	return key;
+}
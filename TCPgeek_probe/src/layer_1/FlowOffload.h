@@ -0,0 +1,90 @@
+/*
+ *	FlowOffload.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : FlowOffload - kernel side pre-aggregation of the long TCP flows of a live capture.
+ *					An eBPF socket filter replaces the classic filter of the pcap socket. For the
+ *					flows put into its hash map it counts the in-order pure ACKs (no payload, no
+ *					other flags, the acknowledged number has moved) instead of passing them to the
+ *					ring, every kernelPreaggregationSampling-th of them is still passed to keep the
+ *					timing of the flow. Everything else, including every packet of the other flows,
+ *					is passed, and the userland applies bpfExpression to it with pcap_offline_filter().
+ *					The control thread merges the map into the sessions once per interval and
+ *					chooses the flows to offload, see TcpSessions::mergeOffloadedFlows().
+ *
+ *	The program is assembled here instruction by instruction and loaded with bpf(2), so no
+ *	compiler or library of eBPF is needed at build time. It needs CAP_BPF (or root) and a kernel
+ *	of 4.14 or newer.
+ */
+
+#ifndef FLOWOFFLOAD_H_
+#define FLOWOFFLOAD_H_
+
+#include <pcap.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define FLOW_OFFLOAD_MIN_PACKETS 64 //packets of a session in one interval to be worth offloading
+
+//the key and the value of the kernel map, the endpoint with the lower (IP, port) is 'lo'
+struct FlowOffloadKey {
+	uint32_t ipLo, ipHi;		//host byte order
+	uint16_t portLo, portHi;
+	uint32_t reserved;			//0, keeps the key free of padding
+};
+
+struct FlowOffloadValue {
+	uint64_t packets[2];		//absorbed packets sent by lo [0] and by hi [1]
+	uint64_t bytes[2];			//their captured length including the link header
+	uint32_t lastAck[2];		//the last acknowledged number sent by lo and by hi
+};
+
+struct FlowOffloadEntry {
+	FlowOffloadKey key;
+	FlowOffloadValue value;
+};
+
+class FlowOffload {
+private:
+	int m_socket; //the pcap socket, the filter is attached to it
+	int m_mapFd;
+	int m_programFd;
+	uint32_t m_capacity;
+	struct bpf_program m_filter; //bpfExpression, applied in the userland while the offload is attached
+	uint64_t m_insertFailures;
+
+	void loadProgram(const uint32_t t_samplingMask, const uint32_t t_linkHeaderLen);
+	//throws exceptions with the verifier log if the kernel refuses the program
+
+public:
+	FlowOffload(pcap_t* t_handle, const int t_linkType, const std::string& t_bpfExpression,
+				const uint32_t t_capacity, const uint32_t t_sampling);
+	//must be constructed after pcap_activate(), throws exceptions if the filter can't be attached
+	~FlowOffload();
+
+	bool isAccepted(const struct pcap_pkthdr* t_header, const u_char* t_packet) const {
+		//invoked from the main thread of capturing for every packet
+		return pcap_offline_filter(&m_filter, t_header, t_packet) != 0;
+	}
+
+	//the rest is invoked from the control thread
+	void readEntries(std::vector<FlowOffloadEntry>& t_entries) const;
+	//replaces t_entries with the current content of the kernel map
+	void updateEntries(const std::vector<FlowOffloadKey>& t_staleKeys, const std::vector<FlowOffloadKey>& t_newKeys);
+	//removes the flows that are gone and starts counting the new ones from zero
+	uint32_t getCapacity() const;
+	uint64_t getInsertFailures() const;
+
+	static FlowOffloadKey makeKey(const uint32_t t_ipA, const uint16_t t_portA, const uint32_t t_ipB, const uint16_t t_portB,
+									bool& t_isALo);
+	//IPs are in host byte order, t_isALo is set if the endpoint A is 'lo' of the key
+};
+
+#endif /* FLOWOFFLOAD_H_ */
@@ -0,0 +1,232 @@
+/*
+ *	IpfixExporter.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <inttypes.h>
+#include <ctime>
+#include <algorithm>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "layer_1/IpfixExporter.h"
+
+#define IPFIX_MESSAGE_HEADER_SIZE 16
+#define IPFIX_SET_HEADER_SIZE 4
+#define IPV4_UDP_HEADERS_SIZE 28
+#define IPV6_UDP_HEADERS_SIZE 48
+#define SENDMMSG_MAX_MESSAGES 1024 //UIO_MAXIOV
+
+const IpfixExporter::Field IpfixExporter::m_fields[] = {
+	{153, 8, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getTimestampEpoch()/1000; }}, //flowEndMilliseconds
+	{4, 1, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getIpProtocol(); }}, //protocolIdentifier
+	{8, 4, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return ntohl(r.getTcpUdpSessionKey().m_clientIpRaw.s_addr); }}, //sourceIPv4Address
+	{7, 2, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getTcpUdpSessionKey().m_clientPort; }}, //sourceTransportPort
+	{12, 4, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return ntohl(r.getTcpUdpSessionKey().m_serverIpRaw.s_addr); }}, //destinationIPv4Address
+	{11, 2, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getTcpUdpSessionKey().m_serverPort; }}, //destinationTransportPort
+	{10, 4, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getTcpUdpSessionKey().m_interfaceId; }}, //ingressInterface
+	{2, 8, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getClientPackets(); }}, //packetDeltaCount
+	{2, 8, FIELD_REVERSE, [](const StatRecord& r) -> uint64_t { return r.getServerPackets(); }},
+	{1, 8, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getClientBytes(); }}, //octetDeltaCount
+	{1, 8, FIELD_REVERSE, [](const StatRecord& r) -> uint64_t { return r.getServerBytes(); }},
+	{401, 8, FIELD_IANA, [](const StatRecord& r) -> uint64_t { return r.getClientEfficientBytes(); }}, //transportOctetDeltaCount
+	{401, 8, FIELD_REVERSE, [](const StatRecord& r) -> uint64_t { return r.getServerEfficientBytes(); }},
+	{1, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getClientIdleTime(); }},
+	{2, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getRequestTime(); }},
+	{3, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getServerThinkTime(); }},
+	{4, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getResponseTime(); }},
+	{5, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getTotalSessionIdleTime(); }},
+	{6, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getRtt(); }},
+	{7, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getClientRetransmits(); }},
+	{8, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getServerRetransmits(); }},
+	{9, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getClientDuplicatesCounter(); }},
+	{10, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getServerDuplicatesCounter(); }},
+	{11, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getClientOutOfOrderCounter(); }},
+	{12, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getServerOutOfOrderCounter(); }},
+	{13, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getClientActiveSequenceGaps(); }},
+	{14, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getServerActiveSequenceGaps(); }},
+	{15, 8, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getOperations(); }},
+	{16, 4, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getSessionErrorCode(); }},
+	{17, 1, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return (uint64_t) r.getTopology(); }},
+	{18, 4, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getSamplingRate(); }},
+	{19, 4, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getClientTag(); }},
+	{20, 4, FIELD_TCPGEEK, [](const StatRecord& r) -> uint64_t { return r.getServerTag(); }},
+	{0, 0, FIELD_IANA, NULL}
+};
+
+IpfixExporter::IpfixExporter(const std::string& t_collector, const std::size_t t_mtu,
+								const uint32_t t_observationDomainId, const uint32_t t_enterpriseNumber) :
+								m_socket {-1},
+								m_collector {t_collector},
+								m_observationDomainId {t_observationDomainId},
+								m_enterpriseNumber {t_enterpriseNumber},
+								m_maxMessageSize {0},
+								m_recordSize {0},
+								m_sequenceNumber {0},
+								m_droppedMessages {0} {
+	//host:port or [IPv6 address]:port
+	std::size_t portPos = t_collector.find_last_of(':');
+	if (portPos == std::string::npos) {
+		throw std::runtime_error("ipfixCollector must be host:port");
+	}
+	std::string host = t_collector.substr(0, portPos);
+	std::string port = t_collector.substr(portPos + 1);
+	if (host.size() > 1 && host[0] == '[' && host[host.size() - 1] == ']') {
+		host = host.substr(1, host.size() - 2);
+	}
+	struct addrinfo hints, *addresses;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	int res = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+	if (res != 0) {
+		throw std::runtime_error("Can't resolve IPFIX collector " + t_collector + ": " + gai_strerror(res));
+	}
+	m_socket = socket(addresses->ai_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	//connected socket lets sendmmsg go without per message addresses
+	if (m_socket == -1 || connect(m_socket, addresses->ai_addr, addresses->ai_addrlen) != 0) {
+		std::string error = strerror(errno);
+		freeaddrinfo(addresses);
+		if (m_socket != -1) close(m_socket);
+		throw std::runtime_error("Can't connect to IPFIX collector " + t_collector + ": " + error);
+	}
+	std::size_t headersSize = (addresses->ai_family == AF_INET6) ? IPV6_UDP_HEADERS_SIZE : IPV4_UDP_HEADERS_SIZE;
+	freeaddrinfo(addresses);
+	if (t_mtu > headersSize) m_maxMessageSize = t_mtu - headersSize;
+	int sendBufferSize = 4*1024*1024;
+	setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize));
+
+	if (m_maxMessageSize > UINT16_MAX) m_maxMessageSize = UINT16_MAX; //the length field of IPFIX message is 16 bits
+	buildTemplateSet();
+	for (std::size_t i = 0; m_fields[i].getValue != NULL; i++) {
+		m_recordSize += m_fields[i].length;
+	}
+	if (m_maxMessageSize < IPFIX_MESSAGE_HEADER_SIZE + m_templateSet.size() + IPFIX_SET_HEADER_SIZE + m_recordSize) {
+		close(m_socket);
+		throw std::runtime_error("ipfixMtu is too small for the IPFIX template");
+	}
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.info("Statistics are exported to IPFIX collector %s, observation domain %" PRIu32 ", %zu bytes per record",
+					m_collector.c_str(), m_observationDomainId, m_recordSize);
+}
+
+IpfixExporter::~IpfixExporter() {
+	if (m_socket != -1) close(m_socket);
+}
+
+void IpfixExporter::appendUint(const uint64_t t_value, const uint16_t t_length) {
+	//network byte order of the t_length low bytes
+	for (int shift = (t_length - 1) * 8; shift >= 0; shift -= 8) {
+		m_messages.push_back((char) ((t_value >> shift) & 0xFF));
+	}
+}
+
+void IpfixExporter::buildTemplateSet() {
+	std::string fieldSpecifiers;
+	uint16_t fieldsCount = 0;
+
+	for (std::size_t i = 0; m_fields[i].getValue != NULL; i++) {
+		uint16_t id = m_fields[i].id;
+		uint32_t enterpriseNumber = (m_fields[i].enterprise == FIELD_REVERSE) ? IPFIX_REVERSE_PEN : m_enterpriseNumber;
+		if (m_fields[i].enterprise != FIELD_IANA) id |= 0x8000;
+		uint16_t idBE = htons(id), lengthBE = htons(m_fields[i].length);
+		uint32_t enterpriseNumberBE = htonl(enterpriseNumber);
+		fieldSpecifiers.append((const char*) &idBE, sizeof(idBE));
+		fieldSpecifiers.append((const char*) &lengthBE, sizeof(lengthBE));
+		if (m_fields[i].enterprise != FIELD_IANA) {
+			fieldSpecifiers.append((const char*) &enterpriseNumberBE, sizeof(enterpriseNumberBE));
+		}
+		fieldsCount++;
+	}
+	uint16_t header[4] = {htons(IPFIX_TEMPLATE_SET_ID),
+						  htons(IPFIX_SET_HEADER_SIZE + 4 + fieldSpecifiers.size()),
+						  htons(IPFIX_TEMPLATE_ID),
+						  htons(fieldsCount)};
+	m_templateSet.assign((const char*) header, sizeof(header));
+	m_templateSet.append(fieldSpecifiers);
+}
+
+void IpfixExporter::appendRecord(const StatRecord& t_statRecord) {
+	for (std::size_t i = 0; m_fields[i].getValue != NULL; i++) {
+		appendUint(m_fields[i].getValue(t_statRecord), m_fields[i].length);
+	}
+}
+
+void IpfixExporter::exportBatch(const std::vector<StatRecord>& t_batch) {
+	uint32_t exportTime = std::time(nullptr);
+	std::size_t recordIdx = 0;
+
+	m_messages.clear();
+	m_messageOffsets.clear();
+	//the template is sent even for an empty interval, it keeps the collector's template alive
+	do {
+		std::size_t messageStart = m_messages.size();
+		m_messageOffsets.push_back(messageStart);
+		appendUint(IPFIX_VERSION, 2);
+		appendUint(0, 2); //length, set below
+		appendUint(exportTime, 4);
+		appendUint(m_sequenceNumber, 4);
+		appendUint(m_observationDomainId, 4);
+		if (messageStart == 0) m_messages.append(m_templateSet);
+
+		std::size_t spaceLeft = m_maxMessageSize - (m_messages.size() - messageStart) - IPFIX_SET_HEADER_SIZE;
+		std::size_t recordsCount = std::min(spaceLeft / m_recordSize, t_batch.size() - recordIdx);
+		if (recordsCount > 0) {
+			appendUint(IPFIX_TEMPLATE_ID, 2);
+			appendUint(IPFIX_SET_HEADER_SIZE + recordsCount * m_recordSize, 2);
+			for (std::size_t i = 0; i < recordsCount; i++) {
+				appendRecord(t_batch[recordIdx++]);
+			}
+			m_sequenceNumber += recordsCount;
+		}
+		uint16_t messageLength = htons(m_messages.size() - messageStart);
+		memcpy(&m_messages[messageStart + 2], &messageLength, sizeof(messageLength));
+	} while (recordIdx < t_batch.size());
+	sendMessages();
+}
+
+void IpfixExporter::sendMessages() {
+	std::size_t messagesCount = m_messageOffsets.size();
+
+	//pointers are taken only now, as m_messages might have been reallocated while growing
+	m_iovecs.resize(messagesCount);
+	m_msgHeaders.resize(messagesCount);
+	for (std::size_t i = 0; i < messagesCount; i++) {
+		std::size_t messageEnd = (i + 1 < messagesCount) ? m_messageOffsets[i + 1] : m_messages.size();
+		m_iovecs[i].iov_base = &m_messages[m_messageOffsets[i]];
+		m_iovecs[i].iov_len = messageEnd - m_messageOffsets[i];
+		memset(&m_msgHeaders[i], 0, sizeof(struct mmsghdr));
+		m_msgHeaders[i].msg_hdr.msg_iov = &m_iovecs[i];
+		m_msgHeaders[i].msg_hdr.msg_iovlen = 1;
+	}
+	std::size_t sent = 0;
+	while (sent < messagesCount) {
+		unsigned int chunk = std::min<std::size_t>(messagesCount - sent, SENDMMSG_MAX_MESSAGES);
+		//never blocking the control thread on a slow collector, what doesn't fit the socket buffer is dropped
+		int res = sendmmsg(m_socket, &m_msgHeaders[sent], chunk, MSG_DONTWAIT);
+		if (res < 0) {
+			if (errno == EINTR) continue;
+			log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+			logRoot.warn("%zu IPFIX messages to %s were dropped: %s", messagesCount - sent, m_collector.c_str(), strerror(errno));
+			m_droppedMessages += messagesCount - sent;
+			return;
+		}
+		sent += res;
+	}
+}
+
+uint64_t IpfixExporter::getDroppedMessages() const {
+	return m_droppedMessages;
+}
@@ -0,0 +1,85 @@
+/*
+ *	IpfixExporter.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : IpfixExporter - sends every interval's session records to an IPFIX (RFC 7011)
+ *					collector over UDP. The client is the source and the server is the destination,
+ *					server side counters go to RFC 5103 reverse elements (PEN 29305). TCPgeek
+ *					specific metrics are enterprise elements under ipfixEnterpriseNumber:
+ *					 1 clientIdleTimeUs, 2 requestTimeUs, 3 serverThinkTimeUs, 4 responseTimeUs,
+ *					 5 totalSessionIdleTimeUs, 6 rttUs, 7 clientRetransmits, 8 serverRetransmits,
+ *					 9 clientDuplicates, 10 serverDuplicates, 11 clientOutOfOrder, 12 serverOutOfOrder,
+ *					13 clientActiveGaps, 14 serverActiveGaps, 15 operations, 16 sessionErrorCode,
+ *					17 connectionTopology (ASCII 'i', 'o', 'n' or 'b'), 18 samplingRate (1:N of new flows),
+ *					19 clientSubnetTag, 20 serverSubnetTag (tags of the local subnets, 0 - outside).
+ *					The interface of a pcapng file goes to ingressInterface, 0 for other sources.
+ *					The messages are filled up to the MTU and sent with one sendmmsg per chunk,
+ *					the template goes first in every interval as UDP transport requires its refresh.
+ */
+
+#ifndef IPFIXEXPORTER_H_
+#define IPFIXEXPORTER_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "layer_1/StatRecord.h"
+
+#define IPFIX_VERSION 10
+#define IPFIX_TEMPLATE_SET_ID 2
+#define IPFIX_TEMPLATE_ID 256
+#define IPFIX_REVERSE_PEN 29305 //RFC 5103 reverse information elements
+
+class IpfixExporter {
+private:
+	enum FieldEnterprise {
+		FIELD_IANA,
+		FIELD_REVERSE,
+		FIELD_TCPGEEK
+	};
+	struct Field {
+		uint16_t id;
+		uint16_t length;
+		FieldEnterprise enterprise;
+		uint64_t (*getValue)(const StatRecord& t_statRecord);
+	};
+
+	static const Field m_fields[];
+	int m_socket;
+	std::string m_collector;
+	uint32_t m_observationDomainId;
+	uint32_t m_enterpriseNumber;
+	std::size_t m_maxMessageSize;
+	std::size_t m_recordSize;
+	uint32_t m_sequenceNumber; //data records exported so far, as defined by RFC 7011
+	uint64_t m_droppedMessages;
+	std::string m_templateSet; //never changes, so it is encoded once
+	std::string m_messages; //all messages of the interval back to back, reused between intervals
+	std::vector<std::size_t> m_messageOffsets;
+	std::vector<struct mmsghdr> m_msgHeaders;
+	std::vector<struct iovec> m_iovecs;
+
+	void buildTemplateSet();
+	void appendUint(const uint64_t t_value, const uint16_t t_length);
+	void appendRecord(const StatRecord& t_statRecord);
+	void sendMessages();
+
+public:
+	IpfixExporter(const std::string& t_collector, const std::size_t t_mtu,
+					const uint32_t t_observationDomainId, const uint32_t t_enterpriseNumber);
+	//throws exceptions if the collector can't be resolved or the MTU is too small
+	~IpfixExporter();
+
+	void exportBatch(const std::vector<StatRecord>& t_batch);
+	uint64_t getDroppedMessages() const;
+};
+
+#endif /* IPFIXEXPORTER_H_ */
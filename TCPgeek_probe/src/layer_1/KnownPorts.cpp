@@ -2,7 +2,7 @@
  *	KnownPorts.cpp
  *
  *	Created on: Apr 27, 2023
- *	Last modified on: Apr 27, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -12,10 +12,8 @@
 
 #include "layer_1/KnownPorts.h"
 
-std::unordered_set<unsigned int> KnownPorts::m_knownPorts;
-
-KnownPorts::KnownPorts() {
-	std::stringstream s_stream(ProgramProperties::getServicePortsStr());
+KnownPorts::KnownPorts(const std::string& t_servicePortsStr) {
+	std::stringstream s_stream(t_servicePortsStr);
 	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 
 	while(s_stream.good()) {
@@ -26,7 +24,7 @@ KnownPorts::KnownPorts() {
 	    try {
 	    	iresult = stoi(substr, 0, 10);
 	    	if (iresult > 0 && iresult < 65536) {
-	    		KnownPorts::m_knownPorts.insert(iresult);
+	    		m_knownPorts.insert(iresult);
 	    	}
 	    } catch (...) {
 	    	logRoot.warn("Can't interpret '%s' TCP port in 'servicePorts' property", substr.c_str());
@@ -34,9 +32,13 @@ KnownPorts::KnownPorts() {
 	}
 }
 
-bool KnownPorts::isKnownPort(unsigned int t_port) {
-	if (KnownPorts::m_knownPorts.find(t_port) != KnownPorts::m_knownPorts.end()) {
+bool KnownPorts::isKnownPort(const unsigned int t_port) const {
+	if (m_knownPorts.find(t_port) != m_knownPorts.end()) {
 		return true;
 	}
 	return false;
 }
+
+const std::unordered_set<unsigned int>& KnownPorts::getPorts() const {
+	return m_knownPorts;
+}
@@ -2,7 +2,7 @@
  *	KnownPorts.h
  *
  *	Created on: Apr 27, 2023
- *	Last modified on: Apr 27, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -17,14 +17,14 @@
 #include <sstream>
 #include <log4cpp/Category.hh> // for logging capabilities
 
-#include "ProgramProperties.h"
-
 class KnownPorts {
 private:
-	static std::unordered_set<unsigned int> m_knownPorts;
+	std::unordered_set<unsigned int> m_knownPorts;
 public:
-	KnownPorts();
-	static bool isKnownPort(unsigned int t_port);
+	KnownPorts(const std::string& t_servicePortsStr);
+	//t_servicePortsStr is a comma separated list like servicePorts property
+	bool isKnownPort(const unsigned int t_port) const;
+	const std::unordered_set<unsigned int>& getPorts() const;
 };
 
 
@@ -2,7 +2,7 @@
  *	LocalSubnets.cpp
  *
  *	Created on: Oct 12, 2023
- *	Last modified on: Oct 12, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -12,41 +12,104 @@
 
 #include "layer_1/LocalSubnets.h"
 
-std::vector<Subnet> LocalSubnets::m_localSubnets;
-
-LocalSubnets::LocalSubnets() {
-	std::stringstream s_stream(ProgramProperties::getLocalSubnetsStr());
-	while(s_stream.good()) {
-		std::string substr;
-		getline(s_stream, substr, ',');
-		Subnet* subnet = new Subnet(substr.c_str());
-	    if (subnet->getPrefix() > 0 && subnet->getMask() > 0) {
-	    	m_localSubnets.push_back(*subnet);
-	    } else {
-	    	throw std::runtime_error("Can't interpret a subnet in 'localSubnets' property");
-	    }
-	    delete(subnet);
+LocalSubnets::LocalSubnets(const std::string& t_localSubnetsStr, const std::string& t_localSubnetsFile) :
+							m_level16(1 << 16, 0) {
+	std::stringstream s_stream(t_localSubnetsStr);
+	parseSubnets(s_stream, ',', "'localSubnets' property");
+	if (!t_localSubnetsFile.empty()) {
+		std::ifstream subnetsFile(t_localSubnetsFile.c_str());
+		if (!subnetsFile.is_open()) {
+			throw std::runtime_error("Can't open local subnets file " + t_localSubnetsFile);
+		}
+		parseSubnets(subnetsFile, '\n', t_localSubnetsFile);
 	}
+	//shorter prefixes go first, so every longer one overwrites the part of them it covers
+	std::vector<uint32_t> subnetIds(m_localSubnets.size());
+	for (std::size_t i = 0; i < subnetIds.size(); i++) subnetIds[i] = i + 1;
+	std::stable_sort(subnetIds.begin(), subnetIds.end(), [this](const uint32_t a, const uint32_t b) {
+		return m_localSubnets[a - 1].getPrefixLength() < m_localSubnets[b - 1].getPrefixLength();
+	});
+	for (std::size_t i = 0; i < subnetIds.size(); i++) {
+		insert(subnetIds[i]);
+	}
+}
+
+void LocalSubnets::parseSubnets(std::istream& t_stream, const char t_delimiter, const std::string& t_source) {
+	std::string substr;
+	while (getline(t_stream, substr, t_delimiter)) {
+		std::size_t commentPos = substr.find('#');
+		if (commentPos != std::string::npos) substr.erase(commentPos);
+		if (substr.find_first_not_of(" \t\r\n") == std::string::npos) continue;
+		Subnet subnet(substr.c_str());
+		if (subnet.isValid()) {
+			m_localSubnets.push_back(subnet);
+		} else {
+			throw std::runtime_error("Can't interpret '" + substr + "' subnet in " + t_source);
+		}
+	}
+}
+
+uint32_t LocalSubnets::addChunk(std::vector<uint32_t>& t_level, const uint32_t t_entry) {
+	uint32_t chunk = t_level.size() / LOCAL_SUBNETS_CHUNK_SIZE;
+	t_level.resize(t_level.size() + LOCAL_SUBNETS_CHUNK_SIZE, t_entry);
+	return chunk | LOCAL_SUBNETS_CHUNK_FLAG;
 }
 
-char LocalSubnets::getConnectionTopology(const in_addr s_addr, const in_addr c_addr) {
+void LocalSubnets::insert(const uint32_t t_subnetId) {
+	const Subnet& subnet = m_localSubnets[t_subnetId - 1];
+	uint32_t prefix = subnet.getPrefix();
+	uint32_t prefixLength = subnet.getPrefixLength();
+
+	if (prefixLength <= 16) {
+		std::fill_n(m_level16.begin() + (prefix >> 16), 1 << (16 - prefixLength), t_subnetId);
+		return;
+	}
+	uint32_t* entry = &m_level16[prefix >> 16];
+	if (!(*entry & LOCAL_SUBNETS_CHUNK_FLAG)) *entry = addChunk(m_level24, *entry);
+	uint32_t index = ((*entry & ~LOCAL_SUBNETS_CHUNK_FLAG) << LOCAL_SUBNETS_CHUNK_BITS) | ((prefix >> 8) & 0xFF);
+	if (prefixLength <= 24) {
+		std::fill_n(m_level24.begin() + index, 1 << (24 - prefixLength), t_subnetId);
+		return;
+	}
+	//only m_level32 grows below, so the pointer into m_level24 stays valid
+	entry = &m_level24[index];
+	if (!(*entry & LOCAL_SUBNETS_CHUNK_FLAG)) *entry = addChunk(m_level32, *entry);
+	index = ((*entry & ~LOCAL_SUBNETS_CHUNK_FLAG) << LOCAL_SUBNETS_CHUNK_BITS) | (prefix & 0xFF);
+	std::fill_n(m_level32.begin() + index, 1 << (32 - prefixLength), t_subnetId);
+}
+
+uint32_t LocalSubnets::getTag(const uint32_t t_subnetId) const {
+	if (t_subnetId == 0 || t_subnetId > m_localSubnets.size()) return 0;
+	return m_localSubnets[t_subnetId - 1].getTag();
+}
+
+const Subnet* LocalSubnets::getSubnet(const uint32_t t_subnetId) const {
+	if (t_subnetId == 0 || t_subnetId > m_localSubnets.size()) return NULL;
+	return &m_localSubnets[t_subnetId - 1];
+}
+
+std::size_t LocalSubnets::size() const {
+	return m_localSubnets.size();
+}
+
+SessionLocation LocalSubnets::locateSession(const in_addr s_addr, const in_addr c_addr) const {
+	SessionLocation location;
+	location.serverSubnetId = lookup(s_addr);
+	location.clientSubnetId = lookup(c_addr);
+	location.serverTag = getTag(location.serverSubnetId);
+	location.clientTag = getTag(location.clientSubnetId);
+	location.topology = getConnectionTopology(location.serverSubnetId != 0, location.clientSubnetId != 0);
+	location.generation = 0;
+	return location;
+}
+
+char LocalSubnets::getConnectionTopology(const bool t_isServerInside, const bool t_isClientInside) {
 	// 'i' - Server is inside, client is outside
 	// 'o' - Server is outside, client is inside
 	// 'n' - Both neither inside, nor outside (when the traffic traverse the location with SPAN port)
 	// 'b' - Server and client are inside
-	bool isServerInside = isIpLocal(s_addr);
-	bool isClientInside = isIpLocal(c_addr);
-	if (isServerInside && !isClientInside) return 'i';
-	if (!isServerInside && isClientInside) return 'o';
-	if (!isServerInside && !isClientInside) return 'n';
+	if (t_isServerInside && !t_isClientInside) return 'i';
+	if (!t_isServerInside && t_isClientInside) return 'o';
+	if (!t_isServerInside && !t_isClientInside) return 'n';
 	return 'b';
 }
-
-
-bool LocalSubnets::isIpLocal(const in_addr t_addr) {
-	uint32_t size = m_localSubnets.size();
-	for(unsigned int i = 0; i < size; i++) {
-		if (m_localSubnets[i].isIpInSubnet(t_addr)) return true;
-	}
-	return false;
-}
@@ -2,12 +2,18 @@
  *	LocalSubnets.h
  *
  *	Created on: Oct 12, 2023
- *	Last modified on: Oct 12, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
  *	See the COPYING file for the terms of usage and distribution.
  *
+ *	Description : LocalSubnets - longest prefix match of IPv4 addresses against the local subnets
+ *					with a 16-8-8 multibit trie. The first 16 bits of an address index a flat table,
+ *					an entry either holds the id of the longest matching subnet or points to a chunk
+ *					of 256 entries for the next 8 bits, and so on, so a lookup takes at most three
+ *					memory reads whatever the number of subnets is. The first table is 256Kb, every
+ *					prefix longer than /16 adds a chunk of 1Kb unless it shares one with another.
  */
 
 #ifndef LOCALSUBNETS_H_
@@ -15,18 +21,60 @@
 
 #include <vector>
 #include <string>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include <algorithm>
+#include <stdint.h>
 
-#include "ProgramProperties.h"
 #include "layer_1/Subnet.h"
 
+#define LOCAL_SUBNETS_CHUNK_BITS 8
+#define LOCAL_SUBNETS_CHUNK_SIZE (1 << LOCAL_SUBNETS_CHUNK_BITS)
+#define LOCAL_SUBNETS_CHUNK_FLAG 0x80000000 //the entry is a chunk number, not a subnet id
+
+struct SessionLocation {
+	uint32_t clientSubnetId, serverSubnetId; //1 based number of the longest matching local subnet, 0 - outside
+	uint32_t clientTag, serverTag; //tags of those subnets, 0 - outside or no tag
+	char topology; //'i', 'o', 'n' or 'b', see getConnectionTopology()
+	uint32_t generation; //the settings snapshot the ids belong to, 0 - not located
+};
+
 class LocalSubnets {
 private:
-	static std::vector<Subnet> m_localSubnets;
-	static bool isIpLocal(const in_addr t_addr);
+	std::vector<Subnet> m_localSubnets; //subnet id is the index + 1
+	std::vector<uint32_t> m_level16; //indexed by the first 16 bits of an address
+	std::vector<uint32_t> m_level24; //chunks indexed by the third octet
+	std::vector<uint32_t> m_level32; //chunks indexed by the last octet
+
+	void parseSubnets(std::istream& t_stream, const char t_delimiter, const std::string& t_source);
+	uint32_t addChunk(std::vector<uint32_t>& t_level, const uint32_t t_entry);
+	//returns the entry pointing to a new chunk filled with t_entry
+	void insert(const uint32_t t_subnetId);
 
 public:
-	LocalSubnets();
-	static char getConnectionTopology(const in_addr s_addr, const in_addr c_addr);
+	LocalSubnets(const std::string& t_localSubnetsStr, const std::string& t_localSubnetsFile);
+	//t_localSubnetsStr is a comma separated list like localSubnets property, t_localSubnetsFile has a subnet per line
+	//and might be empty, throws exceptions if a subnet can't be parsed or the file can't be read
+
+	uint32_t lookup(const in_addr t_addr) const {
+		uint32_t addr = ntohl(t_addr.s_addr);
+		uint32_t entry = m_level16[addr >> 16];
+		if (entry & LOCAL_SUBNETS_CHUNK_FLAG) {
+			entry = m_level24[((entry & ~LOCAL_SUBNETS_CHUNK_FLAG) << LOCAL_SUBNETS_CHUNK_BITS) | ((addr >> 8) & 0xFF)];
+			if (entry & LOCAL_SUBNETS_CHUNK_FLAG) {
+				entry = m_level32[((entry & ~LOCAL_SUBNETS_CHUNK_FLAG) << LOCAL_SUBNETS_CHUNK_BITS) | (addr & 0xFF)];
+			}
+		}
+		return entry;
+	}
+	//returns the id of the longest matching subnet, 0 if the address is not local
+	uint32_t getTag(const uint32_t t_subnetId) const;
+	const Subnet* getSubnet(const uint32_t t_subnetId) const;
+	//NULL for 0 (outside) or an unknown id
+	std::size_t size() const;
+	SessionLocation locateSession(const in_addr s_addr, const in_addr c_addr) const;
+	static char getConnectionTopology(const bool t_isServerInside, const bool t_isClientInside);
 };
 
 #endif /* LOCALSUBNETS_H_ */
@@ -0,0 +1,83 @@
+/*
+ *	MemoryBudget.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <algorithm>
+
+#include "layer_1/MemoryBudget.h"
+
+std::atomic<int> MemoryBudget::s_level {0};
+
+static const char* levelNames[] = {
+	"none", "packet_trace_stopped", "dedup_disabled", "gaps_capped", "sessions_evicted"
+};
+static const uint32_t levelThresholdsPct[] = {
+	0, MEMORY_PACKET_TRACE_STOP_PCT, MEMORY_DEDUP_OFF_PCT, MEMORY_GAPS_CAP_PCT, MEMORY_EVICTION_PCT
+};
+#define SHEDDING_LEVELS 5
+
+MemoryBudget::MemoryBudget(const uint64_t t_budgetKb, const uint64_t t_baselineKb) :
+							m_budgetBytes {t_budgetKb * 1024},
+							m_baselineBytes {t_baselineKb * 1024},
+							m_exhaustedIntervals {0} {
+	s_level.store((int) SheddingLevel::NONE);
+}
+
+uint64_t MemoryBudget::getThresholdBytes(const uint32_t t_pct) const {
+	return m_budgetBytes / 100 * t_pct;
+}
+
+SheddingLevel MemoryBudget::evaluate(const MemoryUsage& t_usage, const uint64_t t_physicalMemoryKb) {
+	uint64_t estimated = getEstimatedBytes(t_usage);
+	int level = s_level.load(std::memory_order_relaxed);
+
+	//going up as far as needed at once, but going down one level per interval
+	while (level < SHEDDING_LEVELS - 1 && estimated >= getThresholdBytes(levelThresholdsPct[level + 1])) {
+		level++;
+	}
+	if (level > 0 && estimated < getThresholdBytes(levelThresholdsPct[level] - MEMORY_HYSTERESIS_PCT)) {
+		level--;
+	}
+	//the estimate misses fragmentation and whatever isn't accounted, RSS is the final judge
+	if (t_physicalMemoryKb * 1024 >= m_budgetBytes) {
+		level = SHEDDING_LEVELS - 1;
+	}
+	s_level.store(level, std::memory_order_relaxed);
+	return (SheddingLevel) level;
+}
+
+uint64_t MemoryBudget::getEvictionBytes(const MemoryUsage& t_usage, const uint64_t t_physicalMemoryKb) const {
+	uint64_t estimated = std::max(getEstimatedBytes(t_usage), t_physicalMemoryKb * 1024);
+	uint64_t target = getThresholdBytes(MEMORY_EVICTION_PCT - MEMORY_HYSTERESIS_PCT);
+	if (estimated <= target) return 0;
+	return estimated - target;
+}
+
+bool MemoryBudget::isExhausted(const uint64_t t_physicalMemoryKb) {
+	if (getLevel() == SheddingLevel::SESSIONS_EVICTED && t_physicalMemoryKb * 1024 >= m_budgetBytes) {
+		m_exhaustedIntervals++;
+	} else {
+		m_exhaustedIntervals = 0;
+	}
+	return m_exhaustedIntervals >= MEMORY_EXHAUSTED_INTERVALS;
+}
+
+uint64_t MemoryBudget::getEstimatedBytes(const MemoryUsage& t_usage) const {
+	return m_baselineBytes + t_usage.getTotalBytes();
+}
+
+uint64_t MemoryBudget::getBudgetBytes() const {
+	return m_budgetBytes;
+}
+
+const char* MemoryBudget::getLevelName(const SheddingLevel t_level) {
+	return levelNames[(int) t_level];
+}
@@ -0,0 +1,94 @@
+/*
+ *	MemoryBudget.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : MemoryBudget - keeps the probe within maxMemoryUsageKB by graduated shedding.
+ *					The control thread estimates the memory of every component once per interval
+ *					from the sizes of its containers, adds the baseline measured at start up and
+ *					selects the shedding level. The capture thread only reads the level, which is
+ *					a static atomic like the rest of the program-wide settings.
+ *
+ *	Levels are cumulative, each of them keeps the measures of the previous ones:
+ *		PACKET_TRACE_STOPPED	- packets are not traced, so the trace ring doesn't touch new pages
+ *		DEDUP_DISABLED		- sessions stop duplicate detection and release their dedup buffers
+ *		GAPS_CAPPED			- sequence gap lists are cut to MEMORY_MAX_GAPS_PER_DIRECTION, the oldest
+ *							  gaps are forgotten, so their late recovery is counted as a retransmit
+ *		SESSIONS_EVICTED	- the least recently active sessions are aggregated and erased
+ *	A level is left only when the estimate is MEMORY_HYSTERESIS_PCT below its threshold. RSS above
+ *	the budget jumps straight to the last level whatever the estimate says, and the probe restarts
+ *	(exit code 167) only if RSS is still above the budget after an interval of eviction.
+ */
+
+#ifndef MEMORYBUDGET_H_
+#define MEMORYBUDGET_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#define MEMORY_PACKET_TRACE_STOP_PCT 70
+#define MEMORY_DEDUP_OFF_PCT 75
+#define MEMORY_GAPS_CAP_PCT 85
+#define MEMORY_EVICTION_PCT 95
+#define MEMORY_HYSTERESIS_PCT 5
+#define MEMORY_MAX_GAPS_PER_DIRECTION 32
+#define MEMORY_EXHAUSTED_INTERVALS 2 //intervals above the budget at the last level before the restart
+
+enum class SheddingLevel {
+			NONE,
+			PACKET_TRACE_STOPPED,
+			DEDUP_DISABLED,
+			GAPS_CAPPED,
+			SESSIONS_EVICTED
+};
+
+struct MemoryUsage {
+	uint64_t tcpSessions, udpSessions;	//number of sessions in the tables
+	uint64_t tcpTableBytes;				//TCP session map: nodes and buckets
+	uint64_t udpTableBytes;				//UDP session map: nodes and buckets
+	uint64_t gapBytes;					//TCP sequence gap lists
+	uint64_t dedupBytes;				//duplicate detection buffers of TCP and UDP sessions
+	uint64_t statQueueBytes;			//statistics records waiting for the control thread
+	uint64_t packetTraceBytes;			//touched pages of the packet trace ring
+
+	uint64_t getSessionsBytes() const {
+		return tcpTableBytes + udpTableBytes + gapBytes + dedupBytes;
+	}
+	uint64_t getTotalBytes() const {
+		return getSessionsBytes() + statQueueBytes + packetTraceBytes;
+	}
+};
+
+class MemoryBudget {
+private:
+	static std::atomic<int> s_level;
+	uint64_t m_budgetBytes;
+	uint64_t m_baselineBytes; //everything that isn't accounted: code, libraries, pcap buffer
+	uint32_t m_exhaustedIntervals;
+
+	uint64_t getThresholdBytes(const uint32_t t_pct) const;
+
+public:
+	MemoryBudget(const uint64_t t_budgetKb, const uint64_t t_baselineKb);
+
+	static SheddingLevel getLevel() {
+		return (SheddingLevel) s_level.load(std::memory_order_relaxed);
+	}
+	SheddingLevel evaluate(const MemoryUsage& t_usage, const uint64_t t_physicalMemoryKb);
+	//invoked from the control thread once per interval, publishes and returns the new level
+	uint64_t getEvictionBytes(const MemoryUsage& t_usage, const uint64_t t_physicalMemoryKb) const;
+	//how much session memory must be freed to get MEMORY_HYSTERESIS_PCT below the eviction threshold
+	//by the estimate or by RSS, whichever is higher
+	bool isExhausted(const uint64_t t_physicalMemoryKb);
+	//true if RSS stays above the budget for MEMORY_EXHAUSTED_INTERVALS while the sessions are being evicted
+	uint64_t getEstimatedBytes(const MemoryUsage& t_usage) const;
+	uint64_t getBudgetBytes() const;
+	static const char* getLevelName(const SheddingLevel t_level);
+};
+
+#endif /* MEMORYBUDGET_H_ */
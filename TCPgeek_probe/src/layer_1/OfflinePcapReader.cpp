@@ -0,0 +1,558 @@
+/*
+ *	OfflinePcapReader.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <algorithm>
+
+#include "layer_1/OfflinePcapReader.h"
+
+#define PCAP_MAGIC_USEC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+#define PCAP_MAX_CAPLEN 262144 //libpcap refuses longer records as well
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB 1
+#define PCAPNG_BLOCK_PB 2 //obsolete packet block
+#define PCAPNG_BLOCK_SPB 3
+#define PCAPNG_BLOCK_EPB 6
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_OPTION_END 0
+#define PCAPNG_OPTION_TSRESOL 9
+#define PCAPNG_OPTION_TSOFFSET 14
+#define PCAPNG_DEFAULT_TSRESOL 6 //microseconds
+
+struct PcapFileHeader {
+	uint32_t magic;
+	uint16_t versionMajor, versionMinor;
+	int32_t thisZone;
+	uint32_t sigFigs;
+	uint32_t snapLen;
+	uint32_t linkType;
+};
+
+struct PcapRecordHeader {
+	uint32_t tsSec;
+	uint32_t tsFraction;	//microseconds or nanoseconds
+	uint32_t capLen;
+	uint32_t len;
+};
+
+struct PcapngBlockHeader {
+	uint32_t type;
+	uint32_t length;		//of the whole block, repeated at its end
+};
+
+struct PcapngSectionHeader {
+	PcapngBlockHeader block;
+	uint32_t byteOrderMagic;
+	uint16_t versionMajor, versionMinor;
+	uint64_t sectionLength;
+};
+
+struct PcapngInterfaceHeader {
+	PcapngBlockHeader block;
+	uint16_t linkType;
+	uint16_t reserved;
+	uint32_t snapLen;
+};
+
+struct PcapngPacketHeader {
+	PcapngBlockHeader block;
+	uint32_t interfaceId;	//of the obsolete packet block: 16 bits of the id and 16 bits of drops
+	uint32_t tsHigh, tsLow;
+	uint32_t capLen;
+	uint32_t len;
+};
+
+struct PcapngSimplePacketHeader {
+	PcapngBlockHeader block;
+	uint32_t len;
+};
+
+struct PcapngOptionHeader {
+	uint16_t code;
+	uint16_t length;		//of the value, which is padded to 32 bits
+};
+
+static uint32_t getInterfaceId(const uint32_t t_blockType, const PcapngPacketHeader& t_packetHeader, const bool t_isSwapped) {
+	if (t_blockType == PCAPNG_BLOCK_EPB) {
+		return t_isSwapped ? __builtin_bswap32(t_packetHeader.interfaceId) : t_packetHeader.interfaceId;
+	}
+	//the obsolete packet block has a 16 bit id followed by the drops counter
+	uint16_t interfaceId;
+	memcpy(&interfaceId, &t_packetHeader.interfaceId, sizeof(interfaceId));
+	return t_isSwapped ? __builtin_bswap16(interfaceId) : interfaceId;
+}
+
+static const uint64_t s_powersOf10[] = {1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+										100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+										10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+										100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL};
+
+OfflinePcapReader::OfflinePcapReader(const std::string& t_fileName) : m_data {NULL}, m_size {0}, m_stream {NULL}, m_isPcapng {false},
+																		m_linkType {0}, m_isSwapped {false}, m_isNanosecond {false},
+																		m_scanOffset {sizeof(PcapFileHeader)},
+																		m_isTruncated {false}, m_releasedOffset {0},
+																		m_interfacesCount {0}, m_sectionsCount {0},
+																		m_hasFilter {false} {
+	struct stat fileStat;
+	PcapFileHeader fileHeader;
+	u_char head[PCAP_INPUT_STREAM_MAGIC_LEN];
+	ssize_t headLength = 0;
+
+	//a FIFO waits for its writer here
+	int fd = (t_fileName == OFFLINE_PCAP_STDIN) ? dup(STDIN_FILENO) : open(t_fileName.c_str(), O_RDONLY);
+	if (fd < 0 || fstat(fd, &fileStat) != 0) {
+		std::string error = strerror(errno);
+		if (fd >= 0) close(fd);
+		throw std::runtime_error("Can't open " + t_fileName + ": " + error);
+	}
+	//the bytes of a pipe can't be read twice, the stream tells the compression itself
+	if (S_ISREG(fileStat.st_mode)) headLength = pread(fd, head, sizeof(head), 0);
+	if (!S_ISREG(fileStat.st_mode) || (headLength > 0 && PcapInputStream::isCompressed(head, headLength))) {
+		//the stream takes the descriptor over
+		m_stream = new PcapInputStream(fd, (t_fileName == OFFLINE_PCAP_STDIN) ? "stdin" : t_fileName);
+		if (getAvailable(sizeof(PcapFileHeader)) < sizeof(PcapFileHeader)) {
+			unmap();
+			throw std::runtime_error(t_fileName + " ends before the header of a pcap file");
+		}
+	} else {
+		//a Section Header Block is even longer than the header of a pcap file
+		if ((uint64_t) fileStat.st_size < sizeof(PcapFileHeader)) {
+			close(fd);
+			throw std::runtime_error(t_fileName + " is too short for a pcap file");
+		}
+		m_size = fileStat.st_size;
+		void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		//the mapping keeps the file, so hundreds of files of a directory don't hold descriptors
+		close(fd);
+		if (data == MAP_FAILED) {
+			throw std::runtime_error("Can't map " + t_fileName + ": " + strerror(errno));
+		}
+		m_data = (const u_char*) data;
+		//the workers follow the pre-scan closely, so the kernel may read ahead aggressively
+		madvise(data, m_size, MADV_SEQUENTIAL);
+	}
+
+	memcpy(&fileHeader, at(0), sizeof(fileHeader));
+	if (fileHeader.magic == PCAPNG_BLOCK_SHB) {
+		m_isPcapng = true;
+		m_scanOffset = 0;
+		//the link type of the file is the one of the first interface, it is described before any packet of it
+		uint64_t offset;
+		bool isRecord = false;
+		while (m_interfacesCount == 0 && !isRecord && nextPcapngBlock(offset, isRecord));
+		if (m_interfacesCount == 0) {
+			unmap();
+			throw std::runtime_error(t_fileName + " has no interfaces described before its packets");
+		}
+		m_linkType = m_interfaces[0].linkType;
+		return;
+	}
+	if (fileHeader.magic == PCAP_MAGIC_USEC || fileHeader.magic == PCAP_MAGIC_NSEC) {
+		m_isSwapped = false;
+	} else if (fileHeader.magic == __builtin_bswap32(PCAP_MAGIC_USEC) || fileHeader.magic == __builtin_bswap32(PCAP_MAGIC_NSEC)) {
+		m_isSwapped = true;
+	} else {
+		unmap();
+		throw std::runtime_error(t_fileName + " isn't a pcap or pcapng file");
+	}
+	m_isNanosecond = (toHost(fileHeader.magic) == PCAP_MAGIC_NSEC);
+	//the upper bits carry the FCS length
+	m_linkType = toHost(fileHeader.linkType) & 0x03FFFFFF;
+}
+
+OfflinePcapReader::~OfflinePcapReader() {
+	if (m_hasFilter) {
+		pcap_freecode(&m_filters[0]);
+		pcap_freecode(&m_filters[1]);
+	}
+	unmap();
+}
+
+void OfflinePcapReader::unmap() {
+	if (m_stream != NULL) {
+		delete m_stream;
+		m_stream = NULL;
+	} else {
+		munmap((void*) m_data, m_size);
+	}
+}
+
+uint64_t OfflinePcapReader::getAvailable(const uint64_t t_end) {
+	return (m_stream == NULL) ? m_size : m_stream->waitFor(t_end);
+}
+
+bool OfflinePcapReader::isPipe(const std::string& t_fileName) {
+	struct stat fileStat;
+
+	if (t_fileName == OFFLINE_PCAP_STDIN) return true;
+	return stat(t_fileName.c_str(), &fileStat) == 0 && S_ISFIFO(fileStat.st_mode);
+}
+
+bool OfflinePcapReader::isPcapng(const std::string& t_fileName) {
+	uint32_t magic = 0;
+
+	int fd = open(t_fileName.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	bool isRead = (read(fd, &magic, sizeof(magic)) == sizeof(magic));
+	close(fd);
+	return isRead && magic == PCAPNG_BLOCK_SHB;
+}
+
+void OfflinePcapReader::setFilter(const std::string& t_expression) {
+	const int linkTypes[2] = {DLT_EN10MB, DLT_LINUX_SLL};
+
+	for (int i = 0; i < 2; i++) {
+		pcap_t* handle = pcap_open_dead(linkTypes[i], PCAP_MAX_CAPLEN);
+		if (handle == NULL) {
+			if (i > 0) pcap_freecode(&m_filters[0]);
+			throw std::runtime_error("Can't compile the filter: out of memory");
+		}
+		if (pcap_compile(handle, &m_filters[i], t_expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) == PCAP_ERROR) {
+			std::string error = pcap_geterr(handle);
+			pcap_close(handle);
+			if (i > 0) pcap_freecode(&m_filters[0]);
+			throw std::runtime_error("Can't compile " + t_expression + ": " + error);
+		}
+		pcap_close(handle);
+	}
+	m_hasFilter = true;
+}
+
+bool OfflinePcapReader::isAccepted(const struct pcap_pkthdr* t_header, const u_char* t_packet, const int t_linkType) const {
+	if (!m_hasFilter) return true;
+	if (t_linkType == DLT_EN10MB) return pcap_offline_filter(&m_filters[0], t_header, t_packet) != 0;
+	if (t_linkType == DLT_LINUX_SLL) return pcap_offline_filter(&m_filters[1], t_header, t_packet) != 0;
+	return false;
+}
+
+bool OfflinePcapReader::nextRecord(uint64_t& t_offset) {
+	if (!m_isPcapng) return nextPcapRecord(t_offset);
+
+	bool isRecord = false;
+	while (nextPcapngBlock(t_offset, isRecord)) {
+		if (isRecord) return true;
+	}
+	return false;
+}
+
+bool OfflinePcapReader::nextPcapRecord(uint64_t& t_offset) {
+	PcapRecordHeader recordHeader;
+
+	if (m_isTruncated) return false;
+	uint64_t size = getAvailable(m_scanOffset + sizeof(recordHeader));
+	if (size == m_scanOffset) {
+		//a compressed file may break right between the records
+		m_isTruncated = (m_stream != NULL && m_stream->isBroken());
+		return false;
+	}
+	if (size - m_scanOffset < sizeof(recordHeader)) {
+		m_isTruncated = true;
+		return false;
+	}
+	memcpy(&recordHeader, at(m_scanOffset), sizeof(recordHeader));
+	uint32_t capLen = toHost(recordHeader.capLen);
+	if (capLen <= PCAP_MAX_CAPLEN) size = getAvailable(m_scanOffset + sizeof(recordHeader) + capLen);
+	if (capLen > PCAP_MAX_CAPLEN || size - m_scanOffset - sizeof(recordHeader) < capLen) {
+		m_isTruncated = true;
+		return false;
+	}
+	t_offset = m_scanOffset;
+	m_scanOffset += sizeof(recordHeader) + capLen;
+	return true;
+}
+
+bool OfflinePcapReader::nextPcapngBlock(uint64_t& t_offset, bool& t_isRecord) {
+	PcapngBlockHeader blockHeader;
+	bool isSwapped;
+
+	t_isRecord = false;
+	if (m_isTruncated) return false;
+	uint64_t size = getAvailable(m_scanOffset + sizeof(blockHeader));
+	if (size == m_scanOffset) {
+		m_isTruncated = (m_stream != NULL && m_stream->isBroken());
+		return false;
+	}
+	if (size - m_scanOffset < sizeof(blockHeader)) {
+		m_isTruncated = true;
+		return false;
+	}
+	memcpy(&blockHeader, at(m_scanOffset), sizeof(blockHeader));
+	if (blockHeader.type == PCAPNG_BLOCK_SHB) {
+		//the type reads the same in both byte orders, the magic that follows tells the order of the section
+		PcapngSectionHeader sectionHeader;
+		uint32_t sectionsCount = m_sectionsCount.load(std::memory_order_relaxed);
+		size = getAvailable(m_scanOffset + sizeof(sectionHeader));
+		if (size - m_scanOffset < sizeof(sectionHeader) || sectionsCount == OFFLINE_PCAP_MAX_SECTIONS) {
+			m_isTruncated = true;
+			return false;
+		}
+		memcpy(&sectionHeader, at(m_scanOffset), sizeof(sectionHeader));
+		if (sectionHeader.byteOrderMagic == PCAPNG_BYTE_ORDER_MAGIC) {
+			isSwapped = false;
+		} else if (sectionHeader.byteOrderMagic == __builtin_bswap32(PCAPNG_BYTE_ORDER_MAGIC)) {
+			isSwapped = true;
+		} else {
+			m_isTruncated = true;
+			return false;
+		}
+		Section& section = m_sections[sectionsCount];
+		section.offset = m_scanOffset;
+		section.firstInterface = m_interfacesCount;
+		section.interfacesCount = 0;
+		section.isSwapped = isSwapped;
+		m_sectionsCount.store(sectionsCount + 1, std::memory_order_release);
+	} else if (m_sectionsCount.load(std::memory_order_relaxed) == 0) {
+		m_isTruncated = true;
+		return false;
+	}
+	Section& section = m_sections[m_sectionsCount.load(std::memory_order_relaxed) - 1];
+	isSwapped = section.isSwapped;
+	uint32_t blockType = toHost(blockHeader.type, isSwapped);
+	uint32_t blockLen = toHost(blockHeader.length, isSwapped);
+	if (blockLen < sizeof(blockHeader) + sizeof(uint32_t) || blockLen % 4 != 0) {
+		m_isTruncated = true;
+		return false;
+	}
+	size = getAvailable(m_scanOffset + blockLen);
+	if (blockLen > size - m_scanOffset) {
+		m_isTruncated = true;
+		return false;
+	}
+
+	switch (blockType) {
+		case PCAPNG_BLOCK_IDB:
+			if (!readInterface(m_scanOffset, blockLen, isSwapped)) {
+				m_isTruncated = true;
+				return false;
+			}
+			section.interfacesCount++;
+			break;
+		case PCAPNG_BLOCK_EPB:
+		case PCAPNG_BLOCK_PB: {
+			PcapngPacketHeader packetHeader;
+			if (blockLen < sizeof(packetHeader) + sizeof(uint32_t)) {
+				m_isTruncated = true;
+				return false;
+			}
+			memcpy(&packetHeader, at(m_scanOffset), sizeof(packetHeader));
+			uint32_t interfaceId = getInterfaceId(blockType, packetHeader, isSwapped);
+			uint32_t capLen = toHost(packetHeader.capLen, isSwapped);
+			if (interfaceId >= section.interfacesCount || capLen > PCAP_MAX_CAPLEN ||
+					capLen > blockLen - sizeof(packetHeader) - sizeof(uint32_t)) {
+				m_isTruncated = true;
+				return false;
+			}
+			t_isRecord = true;
+			break;
+		}
+		case PCAPNG_BLOCK_SPB:
+			//the packets of a simple packet block belong to the first interface of the section
+			if (section.interfacesCount == 0 || blockLen < sizeof(PcapngSimplePacketHeader) + sizeof(uint32_t)) {
+				m_isTruncated = true;
+				return false;
+			}
+			t_isRecord = true;
+			break;
+		default:
+			//name resolution, interface statistics, decryption secrets, custom blocks
+			break;
+	}
+	t_offset = m_scanOffset;
+	m_scanOffset += blockLen;
+	return true;
+}
+
+bool OfflinePcapReader::readInterface(const uint64_t t_offset, const uint32_t t_blockLen, const bool t_isSwapped) {
+	PcapngInterfaceHeader interfaceHeader;
+	PcapngOptionHeader optionHeader;
+
+	if (m_interfacesCount == OFFLINE_PCAP_MAX_INTERFACES || t_blockLen < sizeof(interfaceHeader) + sizeof(uint32_t)) return false;
+	memcpy(&interfaceHeader, at(t_offset), sizeof(interfaceHeader));
+	Interface& interface = m_interfaces[m_interfacesCount];
+	interface.linkType = toHost(interfaceHeader.linkType, t_isSwapped);
+	interface.snapLen = toHost(interfaceHeader.snapLen, t_isSwapped);
+	interface.isBinaryResolution = false;
+	interface.resolution = PCAPNG_DEFAULT_TSRESOL;
+	interface.tsOffset = 0;
+
+	uint64_t optionOffset = t_offset + sizeof(interfaceHeader);
+	uint64_t optionsEnd = t_offset + t_blockLen - sizeof(uint32_t);
+	while (optionsEnd - optionOffset >= sizeof(optionHeader)) {
+		memcpy(&optionHeader, at(optionOffset), sizeof(optionHeader));
+		uint16_t code = toHost(optionHeader.code, t_isSwapped);
+		uint16_t length = toHost(optionHeader.length, t_isSwapped);
+		if (code == PCAPNG_OPTION_END) break;
+		optionOffset += sizeof(optionHeader);
+		if (optionsEnd - optionOffset < length) return false;
+		if (code == PCAPNG_OPTION_TSRESOL && length == 1) {
+			uint8_t tsResol = *at(optionOffset);
+			interface.isBinaryResolution = (tsResol & 0x80) != 0;
+			interface.resolution = tsResol & 0x7F;
+			//finer resolutions don't fit the 64 bit timestamp anyway
+			if (interface.resolution > (interface.isBinaryResolution ? 63 : 19)) return false;
+		} else if (code == PCAPNG_OPTION_TSOFFSET && length == 8) {
+			uint64_t tsOffset;
+			memcpy(&tsOffset, at(optionOffset), sizeof(tsOffset));
+			interface.tsOffset = (int64_t) (t_isSwapped ? __builtin_bswap64(tsOffset) : tsOffset);
+		}
+		optionOffset += (length + 3) & ~3;
+		if (optionOffset > optionsEnd) return false;
+	}
+	m_interfacesCount++;
+	return true;
+}
+
+const OfflinePcapReader::Section& OfflinePcapReader::findSection(const uint64_t t_offset) const {
+	//the last section that starts before the record, there is rarely more than one
+	uint32_t low = 0;
+	uint32_t high = m_sectionsCount.load(std::memory_order_acquire);
+	while (high - low > 1) {
+		uint32_t middle = (low + high) / 2;
+		if (m_sections[middle].offset <= t_offset) low = middle;
+		else high = middle;
+	}
+	return m_sections[low];
+}
+
+void OfflinePcapReader::getRecord(const uint64_t t_offset, struct pcap_pkthdr& t_header, const u_char*& t_packet,
+									int& t_linkType, uint32_t& t_interfaceId) const {
+	PcapRecordHeader recordHeader;
+
+	if (m_isPcapng) {
+		getPcapngRecord(t_offset, t_header, t_packet, t_linkType, t_interfaceId);
+		return;
+	}
+	memcpy(&recordHeader, at(t_offset), sizeof(recordHeader));
+	t_header.ts.tv_sec = toHost(recordHeader.tsSec);
+	//libpcap scales nanoseconds down the same way
+	t_header.ts.tv_usec = m_isNanosecond ? toHost(recordHeader.tsFraction) / 1000 : toHost(recordHeader.tsFraction);
+	t_header.caplen = toHost(recordHeader.capLen);
+	t_header.len = toHost(recordHeader.len);
+	t_packet = at(t_offset) + sizeof(recordHeader);
+	t_linkType = m_linkType;
+	t_interfaceId = 0;
+}
+
+void OfflinePcapReader::getPcapngRecord(const uint64_t t_offset, struct pcap_pkthdr& t_header, const u_char*& t_packet,
+											int& t_linkType, uint32_t& t_interfaceId) const {
+	PcapngPacketHeader packetHeader;
+
+	const Section& section = findSection(t_offset);
+	memcpy(&packetHeader, at(t_offset), sizeof(packetHeader.block));
+	if (toHost(packetHeader.block.type, section.isSwapped) == PCAPNG_BLOCK_SPB) {
+		PcapngSimplePacketHeader simpleHeader;
+		memcpy(&simpleHeader, at(t_offset), sizeof(simpleHeader));
+		const Interface& interface = m_interfaces[section.firstInterface];
+		//the block has no capture length, the data is padded up to the block end
+		uint32_t capLen = toHost(simpleHeader.block.length, section.isSwapped) - sizeof(simpleHeader) - sizeof(uint32_t);
+		t_header.len = toHost(simpleHeader.len, section.isSwapped);
+		t_header.caplen = std::min(t_header.len, capLen);
+		if (interface.snapLen != 0) t_header.caplen = std::min(t_header.caplen, interface.snapLen);
+		t_header.caplen = std::min<uint32_t>(t_header.caplen, PCAP_MAX_CAPLEN);
+		//nor timestamp
+		t_header.ts.tv_sec = 0;
+		t_header.ts.tv_usec = 0;
+		t_packet = at(t_offset) + sizeof(simpleHeader);
+		t_linkType = interface.linkType;
+		t_interfaceId = section.firstInterface;
+		return;
+	}
+	memcpy(&packetHeader, at(t_offset), sizeof(packetHeader));
+	uint32_t localId = getInterfaceId(toHost(packetHeader.block.type, section.isSwapped), packetHeader, section.isSwapped);
+	const Interface& interface = m_interfaces[section.firstInterface + localId];
+	setTimestamp(interface, ((uint64_t) toHost(packetHeader.tsHigh, section.isSwapped) << 32) | toHost(packetHeader.tsLow, section.isSwapped),
+					t_header.ts);
+	t_header.caplen = toHost(packetHeader.capLen, section.isSwapped);
+	t_header.len = toHost(packetHeader.len, section.isSwapped);
+	t_packet = at(t_offset) + sizeof(packetHeader);
+	t_linkType = interface.linkType;
+	t_interfaceId = section.firstInterface + localId;
+}
+
+void OfflinePcapReader::setTimestamp(const Interface& t_interface, const uint64_t t_units, struct timeval& t_ts) {
+	uint64_t seconds, fraction;
+
+	if (t_interface.isBinaryResolution) {
+		seconds = t_units >> t_interface.resolution;
+		fraction = t_units & ((1ULL << t_interface.resolution) - 1);
+		t_ts.tv_usec = (uint64_t) (((unsigned __int128) fraction * 1000000) >> t_interface.resolution);
+	} else {
+		seconds = t_units / s_powersOf10[t_interface.resolution];
+		fraction = t_units % s_powersOf10[t_interface.resolution];
+		//libpcap truncates the finer resolutions to microseconds as well
+		t_ts.tv_usec = (t_interface.resolution >= 6) ? fraction / s_powersOf10[t_interface.resolution - 6] :
+							fraction * s_powersOf10[6 - t_interface.resolution];
+	}
+	t_ts.tv_sec = seconds + t_interface.tsOffset;
+}
+
+void OfflinePcapReader::releaseBefore(const uint64_t t_offset) {
+	if (m_stream != NULL) {
+		m_stream->release(t_offset);
+		return;
+	}
+	uint64_t pageSize = sysconf(_SC_PAGESIZE);
+	uint64_t releasedOffset = m_releasedOffset.load(std::memory_order_relaxed);
+	uint64_t releaseEnd = (t_offset >= m_size) ? m_size : t_offset & ~(pageSize - 1);
+	if (releaseEnd <= releasedOffset) return;
+	//a step per call keeps a loop that releases after every packet from doing a system call per page
+	if (releaseEnd < m_size && releaseEnd - releasedOffset < OFFLINE_PCAP_RELEASE_STEP) return;
+	//the pages stay in the page cache, only the mapping of the process forgets them
+	m_releasedOffset.store(releaseEnd, std::memory_order_relaxed);
+	madvise((void*) (m_data + releasedOffset), releaseEnd - releasedOffset, MADV_DONTNEED);
+}
+
+void OfflinePcapReader::prefetch(const uint64_t t_offset, const uint64_t t_length) const {
+	uint64_t pageSize = sysconf(_SC_PAGESIZE);
+	uint64_t start = t_offset & ~(pageSize - 1);
+	uint64_t end = std::min(t_offset + t_length, m_size);
+	volatile u_char touched;
+
+	//the ring of a compressed file is filled by its own thread
+	if (m_stream != NULL || start >= end) return;
+	madvise((void*) (m_data + start), end - start, MADV_WILLNEED);
+	//the read ahead only fills the page cache, a touch maps the page, so the owner thread doesn't fault on it
+	for (uint64_t offset = start; offset < end; offset += pageSize) {
+		//the owner has moved on, the pages would stay mapped for nothing
+		if (offset < m_releasedOffset.load(std::memory_order_relaxed)) continue;
+		touched = m_data[offset];
+	}
+	(void) touched;
+}
+
+uint64_t OfflinePcapReader::getScanOffset() const {
+	return m_scanOffset;
+}
+
+int OfflinePcapReader::getLinkType() const {
+	return m_linkType;
+}
+
+bool OfflinePcapReader::isTruncated() const {
+	//the pre-scan of an interrupted stream ends at whatever it has got
+	return m_isTruncated && (m_stream == NULL || !m_stream->isInterrupted());
+}
+
+bool OfflinePcapReader::isStreamed() const {
+	return m_stream != NULL;
+}
+
+void OfflinePcapReader::interrupt() {
+	if (m_stream != NULL) m_stream->interrupt();
+}
@@ -0,0 +1,138 @@
+/*
+ *	OfflinePcapReader.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : OfflinePcapReader - a pcap or pcapng file mapped into memory. The thread that
+ *					owns it walks the record headers one by one (the pre-scan) and hands the offsets
+ *					of the records out, any thread may then read a record by its offset, as the
+ *					mapping never changes. The records are given in the same form as pcap_loop()
+ *					gives them: microsecond timestamps in the host byte order, the packet data
+ *					points into the mapping.
+ *
+ *	The classic format is read, microsecond or nanosecond, of either byte order. In a pcapng file
+ *	the enhanced, simple and obsolete packet blocks are the records, every one carries the link type
+ *	and the interface of its Interface Description Block, the timestamps follow if_tsresol and
+ *	if_tsoffset of that interface. The interfaces are numbered through all sections of the file, so
+ *	in a file of one section the number is the interface id of the packet blocks. Other blocks
+ *	(name resolution, statistics, comments, custom) are skipped. A truncated header is refused
+ *	with an exception.
+ *
+ *	A compressed file or a pipe can't be mapped, it is read by PcapInputStream into a ring, and the
+ *	offsets address the bytes of the stream then. The pre-scan waits for them, and a record stays
+ *	readable only until releaseBefore() passes it, so such a file is read by the owner thread alone.
+ */
+
+#ifndef OFFLINEPCAPREADER_H_
+#define OFFLINEPCAPREADER_H_
+
+#include <pcap.h>
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+#include "layer_1/PcapInputStream.h"
+
+#define OFFLINE_PCAP_MAX_INTERFACES 1024 //of all sections of a pcapng file
+#define OFFLINE_PCAP_MAX_SECTIONS 256
+#define OFFLINE_PCAP_RELEASE_STEP (16ULL * 1024 * 1024) //pages are given back in steps of this size
+#define OFFLINE_PCAP_STDIN "-" //the file name of stdin, as tcpdump -r takes it
+
+class OfflinePcapReader {
+private:
+	struct Interface {
+		int linkType;
+		uint32_t snapLen; //0 - not limited
+		bool isBinaryResolution; //if_tsresol is a power of 2, otherwise a power of 10
+		uint8_t resolution; //the exponent of if_tsresol
+		int64_t tsOffset; //if_tsoffset, seconds
+	};
+	struct Section {
+		uint64_t offset; //of the Section Header Block
+		uint32_t firstInterface; //the number of the interfaces of the previous sections
+		uint32_t interfacesCount; //touched by the owner thread only, the interfaces may follow the packets
+		bool isSwapped;
+	};
+
+	const u_char* m_data; //NULL if m_stream is used
+	uint64_t m_size;
+	PcapInputStream* m_stream; //NULL unless the file is compressed or a pipe
+	bool m_isPcapng;
+	int m_linkType; //of the file or of the first interface of a pcapng file
+	bool m_isSwapped; //the file was written on a host of the other byte order
+	bool m_isNanosecond;
+	uint64_t m_scanOffset; //the first record that isn't scanned yet
+	bool m_isTruncated; //the last record is cut or broken
+	std::atomic<uint64_t> m_releasedOffset; //the pages before it are given back
+	Interface m_interfaces[OFFLINE_PCAP_MAX_INTERFACES];
+	uint32_t m_interfacesCount;
+	Section m_sections[OFFLINE_PCAP_MAX_SECTIONS];
+	std::atomic<uint32_t> m_sectionsCount; //the owner thread publishes a section before the records of it
+	struct bpf_program m_filters[2]; //bpfExpression compiled for DLT_EN10MB and DLT_LINUX_SLL
+	bool m_hasFilter;
+
+	static uint16_t toHost(const uint16_t t_value, const bool t_isSwapped) {
+		return t_isSwapped ? __builtin_bswap16(t_value) : t_value;
+	}
+	static uint32_t toHost(const uint32_t t_value, const bool t_isSwapped) {
+		return t_isSwapped ? __builtin_bswap32(t_value) : t_value;
+	}
+	uint32_t toHost(const uint32_t t_value) const {
+		return toHost(t_value, m_isSwapped);
+	}
+	const u_char* at(const uint64_t t_offset) const {
+		return (m_stream == NULL) ? m_data + t_offset : m_stream->at(t_offset);
+	}
+	uint64_t getAvailable(const uint64_t t_end);
+	//the end of the bytes the pre-scan may read, less than t_end at the end of the file
+	void unmap();
+	bool nextPcapRecord(uint64_t& t_offset);
+	bool nextPcapngBlock(uint64_t& t_offset, bool& t_isRecord);
+	//returns false at the end of the file or at a broken block, t_isRecord is set if the block is a packet
+	bool readInterface(const uint64_t t_offset, const uint32_t t_blockLen, const bool t_isSwapped);
+	const Section& findSection(const uint64_t t_offset) const;
+	void getPcapngRecord(const uint64_t t_offset, struct pcap_pkthdr& t_header, const u_char*& t_packet,
+							int& t_linkType, uint32_t& t_interfaceId) const;
+	static void setTimestamp(const Interface& t_interface, const uint64_t t_units, struct timeval& t_ts);
+
+public:
+	OfflinePcapReader(const std::string& t_fileName);
+	//throws exceptions if the file can't be mapped, isn't a pcap or pcapng file or has no interfaces;
+	//a pipe blocks it until the header is written
+	~OfflinePcapReader();
+
+	static bool isPipe(const std::string& t_fileName);
+	//stdin or a FIFO, whose bytes can be read only once
+	static bool isPcapng(const std::string& t_fileName);
+	//true if the file starts with a Section Header Block
+
+	void setFilter(const std::string& t_expression);
+	//compiles the filter for every link type Packet can parse, throws an exception if it can't be compiled
+	bool isAccepted(const struct pcap_pkthdr* t_header, const u_char* t_packet, const int t_linkType) const;
+	//thread safe, the packets of other link types are accepted only without a filter
+
+	bool nextRecord(uint64_t& t_offset);
+	//invoked from the owner thread, gives the offset of the next complete record, false at the end of the file
+	void getRecord(const uint64_t t_offset, struct pcap_pkthdr& t_header, const u_char*& t_packet,
+					int& t_linkType, uint32_t& t_interfaceId) const;
+	//thread safe, t_offset must come from nextRecord()
+	void releaseBefore(const uint64_t t_offset);
+	//invoked from the owner thread, the records before t_offset won't be read anymore, their pages leave RSS
+	//or are decompressed over; at the end of the file or past it the whole mapping is given back
+	void prefetch(const uint64_t t_offset, const uint64_t t_length) const;
+	//thread safe, brings the pages of the range into the mapping ahead of the owner thread
+	uint64_t getScanOffset() const;
+	int getLinkType() const;
+	bool isTruncated() const;
+	bool isStreamed() const;
+	//the file is compressed or a pipe, the records before the offset given to releaseBefore() are gone
+	void interrupt();
+	//thread safe, the pre-scan of a stream doesn't wait for more bytes anymore
+};
+
+#endif /* OFFLINEPCAPREADER_H_ */
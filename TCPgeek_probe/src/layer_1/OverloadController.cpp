@@ -0,0 +1,54 @@
+/*
+ *	OverloadController.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include "layer_1/OverloadController.h"
+
+std::atomic<uint32_t> OverloadController::s_samplingRate {1};
+
+OverloadController::OverloadController(const uint32_t t_maxSamplingRate) : m_calmIntervals {0} {
+	//rounding down to a power of two, the sampled sets of flows must be nested
+	m_maxSamplingRate = 1;
+	while (m_maxSamplingRate * 2 <= t_maxSamplingRate && m_maxSamplingRate < (1U << 30)) {
+		m_maxSamplingRate *= 2;
+	}
+	s_samplingRate.store(1);
+}
+
+uint32_t OverloadController::evaluate(const uint64_t t_receivedPackets, const uint64_t t_processedPackets,
+										const uint64_t t_droppedPackets, const uint32_t t_busyPct) {
+	uint32_t samplingRate = getSamplingRate();
+	uint64_t backlog = (t_receivedPackets > t_processedPackets + t_droppedPackets) ?
+						t_receivedPackets - t_processedPackets - t_droppedPackets : 0;
+	bool overloaded = t_droppedPackets > 0 || t_busyPct >= OVERLOAD_BUSY_PCT ||
+						backlog * 100 > t_receivedPackets * OVERLOAD_BACKLOG_PCT;
+	bool calm = t_droppedPackets == 0 && t_busyPct < OVERLOAD_CALM_BUSY_PCT &&
+						backlog * 100 <= t_receivedPackets * OVERLOAD_BACKLOG_PCT;
+
+	if (overloaded) {
+		m_calmIntervals = 0;
+		if (samplingRate < m_maxSamplingRate) samplingRate *= 2;
+	} else if (calm && samplingRate > 1) {
+		if (++m_calmIntervals >= OVERLOAD_CALM_INTERVALS) {
+			m_calmIntervals = 0;
+			samplingRate /= 2;
+		}
+	} else {
+		//neither overloaded nor calm, staying where we are
+		m_calmIntervals = 0;
+	}
+	s_samplingRate.store(samplingRate, std::memory_order_relaxed);
+	return samplingRate;
+}
+
+bool OverloadController::isSaturated() const {
+	return getSamplingRate() >= m_maxSamplingRate;
+}
@@ -0,0 +1,78 @@
+/*
+ *	OverloadController.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : OverloadController - adaptive 1:N sampling of new flows when the capture thread
+ *					can't keep up. Once per interval the control thread looks at the kernel drops,
+ *					at the packets the kernel has handed to the ring but the capture thread hasn't
+ *					processed yet and at the share of the interval the capture thread was busy. N is
+ *					doubled while the probe is overloaded and halved after OVERLOAD_CALM_INTERVALS
+ *					calm intervals in a row.
+ *
+ *	A flow is kept if the symmetric hash of its endpoints is 0 modulo N. N is a power of two, so
+ *	every flow kept at 1:2N is kept at 1:N too and relaxing the rate never loses tracked sessions.
+ *	The verdict is the same for both directions and for every packet of the flow, so the sessions
+ *	that are tracked are complete. Each session remembers N it was admitted with in StatRecord,
+ *	multiplying by it gives an unbiased estimate of the whole traffic.
+ */
+
+#ifndef OVERLOADCONTROLLER_H_
+#define OVERLOADCONTROLLER_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "layer_1/Packet.h"
+
+#define OVERLOAD_BUSY_PCT 90		//the capture thread was busy for this share of the interval
+#define OVERLOAD_BACKLOG_PCT 10		//received but not processed packets, percent of the received ones
+#define OVERLOAD_CALM_BUSY_PCT 50	//below this and without drops the interval is calm
+#define OVERLOAD_CALM_INTERVALS 3
+
+class OverloadController {
+private:
+	static std::atomic<uint32_t> s_samplingRate;
+	uint32_t m_maxSamplingRate;
+	uint32_t m_calmIntervals;
+
+public:
+	OverloadController(const uint32_t t_maxSamplingRate);
+
+	static uint32_t getFlowHash(const Packet* t_packet) {
+		//ParallelIngest spreads the flows over its shards with it as well
+		//endpoints are ordered, so both directions of the flow give the same hash
+		uint64_t a = ((uint64_t) ntohl(t_packet->getSrcIpRaw().s_addr) << 16) | t_packet->getSrcPort();
+		uint64_t b = ((uint64_t) ntohl(t_packet->getDstIpRaw().s_addr) << 16) | t_packet->getDstPort();
+		uint64_t h = (a < b) ? (a * 0x9E3779B97F4A7C15ULL) ^ b : (b * 0x9E3779B97F4A7C15ULL) ^ a;
+		//murmur3 finalizer
+		h ^= h >> 33;
+		h *= 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 33;
+		h *= 0xC4CEB9FE1A85EC53ULL;
+		h ^= h >> 33;
+		return (uint32_t) h;
+	}
+
+	static uint32_t getSamplingRate() {
+		return s_samplingRate.load(std::memory_order_relaxed);
+	}
+	static bool isFlowSampled(const Packet* t_packet) {
+		//invoked from the main thread of capturing for the packets of unknown flows only
+		uint32_t samplingRate = getSamplingRate();
+		return samplingRate == 1 || (getFlowHash(t_packet) & (samplingRate - 1)) == 0;
+	}
+	uint32_t evaluate(const uint64_t t_receivedPackets, const uint64_t t_processedPackets,
+						const uint64_t t_droppedPackets, const uint32_t t_busyPct);
+	//invoked from the control thread once per interval with the deltas of the interval
+	//publishes and returns the new sampling rate
+	bool isSaturated() const;
+	//true if the sampling rate reached the maximum
+};
+
+#endif /* OVERLOADCONTROLLER_H_ */
@@ -2,7 +2,7 @@
  *	TCPgeek_rt.cpp
  *
  *	Created on: Mar 28, 2022
- *	Last modified on: Mar 28, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -21,6 +21,7 @@
 Packet::Packet() : m_timestamp_usec_full {0},
 						m_totalLen {0},
 						m_payloadLen {0},
+						m_interfaceId {0},
 						m_ipProtocol {0},
 						m_dupId {0},
 						m_srcPort {0},
@@ -56,6 +57,7 @@ Packet::Packet(const Packet &t_tcpPacket) {
     this->m_ackNumber = t_tcpPacket.m_ackNumber;
     this->m_totalLen = t_tcpPacket.m_totalLen;
     this->m_payloadLen = t_tcpPacket.m_payloadLen;
+    this->m_interfaceId = t_tcpPacket.m_interfaceId;
     this->m_dupId = t_tcpPacket.m_dupId;
     this->m_ipProtocol = t_tcpPacket.m_ipProtocol;
 }
@@ -65,7 +67,8 @@ Packet::~Packet() {
 	//std::cout << "TCP packet: " << _sessionKey << " destroyed" << std::endl;
 }
 
-PacketProcessingResultEnum Packet::setPacketFromRaw(const struct pcap_pkthdr *t_header, const u_char *t_packet, const int t_linkType) {
+PacketProcessingResultEnum Packet::setPacketFromRaw(const struct pcap_pkthdr *t_header, const u_char *t_packet, const int t_linkType,
+														const u_int32_t t_interfaceId) {
 
 	//EthernetHeader* ethernetHeader;
 	u_char etherHeaderLen;
@@ -76,6 +79,7 @@ PacketProcessingResultEnum Packet::setPacketFromRaw(const struct pcap_pkthdr *t_
 	m_ts = t_header->ts;
 	m_timestamp_usec_full = (uint64_t) t_header->ts.tv_sec * 1000000L + t_header->ts.tv_usec;
 	m_totalLen = t_header->len;
+	m_interfaceId = t_interfaceId;
 
 	//PARSING ETHERNET HEADER
 
@@ -301,3 +305,45 @@ u_char Packet::getIpProtocol() const {
 	return m_ipProtocol;
 }
 
+u_int32_t Packet::getInterfaceId() const {
+	return m_interfaceId;
+}
+
+void Packet::saveState(SessionSnapshotWriter& t_writer) const {
+	uint8_t flags = (m_synFlag ? 1 : 0) | (m_pshFlag ? 2 : 0) | (m_finFlag ? 4 : 0) | (m_rstFlag ? 8 : 0) | (m_ackFlag ? 16 : 0);
+	t_writer.put((int64_t) m_ts.tv_sec);
+	t_writer.put((int64_t) m_ts.tv_usec);
+	t_writer.put(m_timestamp_usec_full);
+	t_writer.put(m_totalLen);
+	t_writer.put(m_payloadLen);
+	t_writer.put(m_ipProtocol);
+	t_writer.put(m_srcIpRaw.s_addr);
+	t_writer.put(m_dstIpRaw.s_addr);
+	t_writer.put(m_dupId);
+	t_writer.put(m_srcPort);
+	t_writer.put(m_dstPort);
+	t_writer.put(flags);
+	t_writer.put(m_sequenceNumber);
+	t_writer.put(m_nextSequenceNumber);
+	t_writer.put(m_ackNumber);
+}
+
+bool Packet::loadState(SessionSnapshotReader& t_reader) {
+	int64_t tsSec, tsUsec;
+	uint8_t flags;
+	if (!(t_reader.get(tsSec) && t_reader.get(tsUsec) && t_reader.get(m_timestamp_usec_full) &&
+			t_reader.get(m_totalLen) && t_reader.get(m_payloadLen) && t_reader.get(m_ipProtocol) &&
+			t_reader.get(m_srcIpRaw.s_addr) && t_reader.get(m_dstIpRaw.s_addr) && t_reader.get(m_dupId) &&
+			t_reader.get(m_srcPort) && t_reader.get(m_dstPort) && t_reader.get(flags) &&
+			t_reader.get(m_sequenceNumber) && t_reader.get(m_nextSequenceNumber) && t_reader.get(m_ackNumber))) {
+		return false;
+	}
+	m_ts.tv_sec = tsSec;
+	m_ts.tv_usec = tsUsec;
+	m_synFlag = flags & 1;
+	m_pshFlag = flags & 2;
+	m_finFlag = flags & 4;
+	m_rstFlag = flags & 8;
+	m_ackFlag = flags & 16;
+	return true;
+}
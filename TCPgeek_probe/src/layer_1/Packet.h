@@ -2,7 +2,7 @@
  *	TCPgeek_rt.h
  *
  *	Created on: Mar 28, 2022
- *	Last modified on: Mar 28, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -25,11 +25,12 @@
 #include <log4cpp/Category.hh> // for logging capabilities
 #include "layer_1/PacketProcessingResultEnum.h"
 #include "layer_1/networkHeaders.h"
+#include "layer_1/SessionSnapshotWriter.h"
+#include "layer_1/SessionSnapshotReader.h"
 
 
 
 
-class PacketStatRecord;
 class Packet {
 
 private:
@@ -38,6 +39,7 @@ private:
 	u_int64_t	 		m_timestamp_usec_full; //full timestamp in microseconds
 	u_int32_t			m_totalLen;
 	u_int32_t	 		m_payloadLen;
+	u_int32_t			m_interfaceId; //interface of a pcapng file, 0 for other sources
 	//IP specific fields
 	u_char				m_ipProtocol;
 	in_addr				m_srcIpRaw, m_dstIpRaw; //32 bits or u_int32
@@ -63,6 +65,7 @@ public:
 		m_timestamp_usec_full = other.m_timestamp_usec_full;
 		m_totalLen = other.m_totalLen;
 		m_payloadLen = other.m_payloadLen;
+		m_interfaceId = other.m_interfaceId;
 		m_ipProtocol = other.m_ipProtocol;
 		m_srcIpRaw = other.m_srcIpRaw;
 		m_dstIpRaw = other.m_dstIpRaw;
@@ -82,9 +85,12 @@ public:
 
 	//fills TcpPacket object fields with data extracted from raw packet
 	//returns status of execution
-	PacketProcessingResultEnum setPacketFromRaw(const struct pcap_pkthdr *t_header, const u_char *t_packet, const int t_linkType);
+	PacketProcessingResultEnum setPacketFromRaw(const struct pcap_pkthdr *t_header, const u_char *t_packet, const int t_linkType,
+												const u_int32_t t_interfaceId = 0);
 
-	PacketStatRecord getDebugPacketInfo();
+	void saveState(SessionSnapshotWriter& t_writer) const;
+	bool loadState(SessionSnapshotReader& t_reader);
+	//the last packets of a session are a part of its state in the session snapshot
 
 	//two non-trivial getters
 	int getTcpHeaderLength(const TcpHeader* t_tcpHeader) const;
@@ -112,6 +118,7 @@ public:
 	bool isAckFlag() const;
 	u_int32_t getTotalLen() const;
 	u_char getIpProtocol() const;
+	u_int32_t getInterfaceId() const;
 };
 
 #endif /* PACKET_H_ */
@@ -2,7 +2,7 @@
  *	PacketDedupRingQueue.cpp
  *
  *	Created on: Apr 11, 2022
- *	Last modified on: Apr 11, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -33,3 +33,16 @@ bool PacketDedupRingQueue::isDuplicatePacket(uint64_t t_dupId) {
 void PacketDedupRingQueue::setMaxSize(unsigned int t_maxSize) {
 	m_maxSize = t_maxSize;
 }
+
+void PacketDedupRingQueue::release() {
+	std::deque<uint64_t>().swap(m_dq);
+	std::unordered_set<uint64_t>().swap(m_dupIdsSet);
+}
+
+uint64_t PacketDedupRingQueue::getMemoryBytes() const {
+	//std::deque allocates its elements in 512 byte chunks, every set node is the id, the next pointer
+	//and the cached hash, plus the bucket array; malloc overhead is taken as 16 bytes per allocation
+	return ((m_dq.size() * sizeof(uint64_t)) / 512 + 1) * (512 + 16) +
+			m_dupIdsSet.size() * (sizeof(uint64_t) + sizeof(void*) + sizeof(std::size_t) + 16) +
+			m_dupIdsSet.bucket_count() * sizeof(void*);
+}
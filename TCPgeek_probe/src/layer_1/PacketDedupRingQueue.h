@@ -2,7 +2,7 @@
  * PacketDedupRingQueue.h
  *
  *  Created on: Apr 11, 2022
- *	Last modified on: Apr 11, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -26,6 +26,10 @@ public:
 	PacketDedupRingQueue();
 	bool isDuplicatePacket(uint64_t t_dupId);
 	void setMaxSize(unsigned int t_maxSize);
+	void release();
+	//forgets all the ids and gives the memory back, invoked when dedup is disabled by MemoryBudget
+	uint64_t getMemoryBytes() const;
+	//approximate heap usage of the queue
 };
 
 #endif /* PACKETDEDUPRINGQUEUE_H_ */
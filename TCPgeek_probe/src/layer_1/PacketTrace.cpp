@@ -0,0 +1,91 @@
+/*
+ *	PacketTrace.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdexcept>
+#include <ctime>
+#include <algorithm>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "layer_1/PacketTrace.h"
+
+PacketTrace::PacketTrace(const std::string& t_fileName, const uint64_t t_capacity) :
+							m_fileName {t_fileName},
+							m_fd {-1},
+							m_mappedSize {0},
+							m_header {NULL},
+							m_records {NULL},
+							m_capacity {t_capacity},
+							m_writeSeq {0} {
+	if (t_capacity == 0) {
+		throw std::runtime_error("packetTraceRecords must be greater than 0");
+	}
+	//the trace of the previous run is what explains its crash, so it is kept
+	std::string previousFileName = m_fileName + ".prev";
+	if (rename(m_fileName.c_str(), previousFileName.c_str()) != 0 && errno != ENOENT) {
+		throw std::runtime_error("Can't rename the old packet trace " + m_fileName + ": " + strerror(errno));
+	}
+	m_fd = open(m_fileName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0640);
+	if (m_fd == -1) {
+		throw std::runtime_error("Can't create the packet trace " + m_fileName + ": " + strerror(errno));
+	}
+	m_mappedSize = sizeof(PacketTraceHeader) + t_capacity * sizeof(PacketTraceRecord);
+	if (ftruncate(m_fd, m_mappedSize) != 0) {
+		close(m_fd);
+		throw std::runtime_error("Can't allocate the packet trace " + m_fileName + ": " + strerror(errno));
+	}
+	void* mapping = mmap(NULL, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (mapping == MAP_FAILED) {
+		close(m_fd);
+		throw std::runtime_error("Can't map the packet trace " + m_fileName + ": " + strerror(errno));
+	}
+
+	//ftruncate has zeroed everything, so all slots have seq == 0
+	m_header = (PacketTraceHeader*) mapping;
+	m_records = (PacketTraceRecord*) ((char*) mapping + sizeof(PacketTraceHeader));
+	m_header->version = PACKET_TRACE_VERSION;
+	m_header->headerSize = sizeof(PacketTraceHeader);
+	m_header->recordSize = sizeof(PacketTraceRecord);
+	m_header->capacity = t_capacity;
+	m_header->startEpoch = std::time(nullptr);
+	m_header->pid = getpid();
+	m_header->tid = syscall(SYS_gettid);
+	memcpy(m_header->magic, PACKET_TRACE_MAGIC, sizeof(m_header->magic));
+	__atomic_store_n(&m_header->state, PACKET_TRACE_STATE_ACTIVE, __ATOMIC_RELEASE);
+
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.info("Packets are traced to %s, %" PRIu64 " records of %zu bytes, decode it with -d %s",
+					m_fileName.c_str(), t_capacity, sizeof(PacketTraceRecord), m_fileName.c_str());
+}
+
+PacketTrace::~PacketTrace() {
+	if (m_header != NULL) {
+		__atomic_store_n(&m_header->state, PACKET_TRACE_STATE_CLOSED, __ATOMIC_RELEASE);
+		munmap(m_header, m_mappedSize);
+	}
+	if (m_fd != -1) close(m_fd);
+}
+
+uint64_t PacketTrace::getWrittenRecords() const {
+	return __atomic_load_n(&m_header->writeSeq, __ATOMIC_RELAXED);
+}
+
+uint64_t PacketTrace::getResidentBytes() const {
+	return sizeof(PacketTraceHeader) + std::min(getWrittenRecords(), m_capacity) * sizeof(PacketTraceRecord);
+}
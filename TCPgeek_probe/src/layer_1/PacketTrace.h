@@ -0,0 +1,88 @@
+/*
+ *	PacketTrace.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : PacketTrace - flight recorder of the packet path. Every traced packet is one
+ *					fixed size PacketTraceRecord written into a file backed ring (see
+ *					PacketTraceLayout.h) by the thread that owns the ring, without locks, queues
+ *					or formatting. The text is produced offline by PacketTraceDecoder.
+ */
+
+#ifndef PACKETTRACE_H_
+#define PACKETTRACE_H_
+
+#include <string>
+#include <stdint.h>
+
+#include "layer_1/PacketTraceLayout.h"
+#include "layer_1/Packet.h"
+#include "layer_1/PacketProcessingResultEnum.h"
+#include "layer_1/sessions/TCP/TcpSessionUpdateResult.h"
+#include "layer_1/sessions/UDP/UdpSessionUpdateResultEnum.h"
+
+class PacketTrace {
+private:
+	std::string m_fileName;
+	int m_fd;
+	std::size_t m_mappedSize;
+	PacketTraceHeader* m_header;
+	PacketTraceRecord* m_records;
+	uint64_t m_capacity;
+	uint64_t m_writeSeq; //the writer's copy of m_header->writeSeq
+
+public:
+	PacketTrace(const std::string& t_fileName, const uint64_t t_capacity);
+	//must be constructed on the thread that writes the ring, throws exceptions if the file can't be created or mapped
+	~PacketTrace();
+
+	void trace(const Packet& t_packet, const PacketProcessingResultEnum t_packetProcessingResult,
+				const TcpSessionUpdateResult& t_tcpSessionUpdateResult,
+				const UdpSessionUpdateResultEnum t_udpSessionUpdateResult) {
+		PacketTraceRecord* slot = m_records + m_writeSeq % m_capacity;
+		__atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		slot->tsSec = t_packet.getTs().tv_sec;
+		slot->tsUsec = t_packet.getTs().tv_usec;
+		slot->srcIp = t_packet.getSrcIpRaw().s_addr;
+		slot->dstIp = t_packet.getDstIpRaw().s_addr;
+		slot->srcPort = t_packet.getSrcPort();
+		slot->dstPort = t_packet.getDstPort();
+		slot->sequenceNumber = t_packet.getSequenceNumber();
+		slot->nextSequenceNumber = t_packet.getNextSequenceNumber();
+		slot->ackNumber = t_packet.getAckNumber();
+		slot->payloadLen = t_packet.getPayloadlen();
+		slot->totalLen = t_packet.getTotalLen();
+		slot->tcpFlags = (t_packet.isFinFlag() ? PACKET_TRACE_FIN : 0) | (t_packet.isSynFlag() ? PACKET_TRACE_SYN : 0) |
+							(t_packet.isRstFlag() ? PACKET_TRACE_RST : 0) | (t_packet.isPshFlag() ? PACKET_TRACE_PSH : 0) |
+							(t_packet.isAckFlag() ? PACKET_TRACE_ACK : 0);
+		slot->packetResult = (uint8_t) t_packetProcessingResult;
+		if (t_packetProcessingResult == PacketProcessingResultEnum::GOOD_UDP) {
+			slot->sessionResult = (uint8_t) t_udpSessionUpdateResult;
+			slot->operationStatus = 0;
+			slot->seqGapStart = 0;
+			slot->seqGapEnd = 0;
+		} else {
+			slot->sessionResult = (uint8_t) t_tcpSessionUpdateResult.tcpSessionProcessingResultEnum;
+			slot->operationStatus = (uint8_t) t_tcpSessionUpdateResult.operationStatus;
+			slot->seqGapStart = t_tcpSessionUpdateResult.seqGapStart;
+			slot->seqGapEnd = t_tcpSessionUpdateResult.seqGapEnd;
+		}
+		m_writeSeq++;
+		__atomic_store_n(&slot->seq, m_writeSeq, __ATOMIC_RELEASE);
+		__atomic_store_n(&m_header->writeSeq, m_writeSeq, __ATOMIC_RELEASE);
+	}
+	//might be invoked only from the thread that has constructed the ring
+
+	uint64_t getWrittenRecords() const;
+	//number of records written so far, might be read from the other threads
+	uint64_t getResidentBytes() const;
+	//bytes of the ring touched so far, they stay resident until the ring is closed
+};
+
+#endif /* PACKETTRACE_H_ */
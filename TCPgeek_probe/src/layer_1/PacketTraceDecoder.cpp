@@ -0,0 +1,239 @@
+/*
+ *	PacketTraceDecoder.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <ctime>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "layer_1/PacketTraceDecoder.h"
+#include "layer_1/PacketProcessingResultEnum.h"
+#include "layer_1/OperationStatusEnum.h"
+#include "layer_1/sessions/TCP/TcpSessionUpdateResult.h"
+#include "layer_1/sessions/UDP/UdpSessionUpdateResultEnum.h"
+
+PacketTraceDecoder::PacketTraceDecoder(const std::string& t_fileName) :
+										m_fileName {t_fileName},
+										m_fd {-1},
+										m_mappedSize {0},
+										m_header {NULL},
+										m_records {NULL},
+										m_skippedRecords {0} {
+	struct stat fileStat;
+
+	m_fd = open(m_fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (m_fd == -1) {
+		throw std::runtime_error("Can't open the packet trace " + m_fileName + ": " + strerror(errno));
+	}
+	if (fstat(m_fd, &fileStat) != 0 || (std::size_t) fileStat.st_size < sizeof(PacketTraceHeader)) {
+		close(m_fd);
+		throw std::runtime_error(m_fileName + " is too short for a packet trace");
+	}
+	m_mappedSize = fileStat.st_size;
+	void* mapping = mmap(NULL, m_mappedSize, PROT_READ, MAP_SHARED, m_fd, 0);
+	if (mapping == MAP_FAILED) {
+		close(m_fd);
+		throw std::runtime_error("Can't map the packet trace " + m_fileName + ": " + strerror(errno));
+	}
+	m_header = (const PacketTraceHeader*) mapping;
+	if (memcmp(m_header->magic, PACKET_TRACE_MAGIC, sizeof(m_header->magic)) != 0 ||
+			m_header->version != PACKET_TRACE_VERSION || m_header->headerSize != sizeof(PacketTraceHeader) ||
+			m_header->recordSize != sizeof(PacketTraceRecord) || m_header->capacity == 0 ||
+			m_header->capacity > (m_mappedSize - sizeof(PacketTraceHeader)) / sizeof(PacketTraceRecord)) {
+		munmap(mapping, m_mappedSize);
+		close(m_fd);
+		throw std::runtime_error(m_fileName + " is not a packet trace of version " + std::to_string(PACKET_TRACE_VERSION));
+	}
+	m_records = (const PacketTraceRecord*) ((const char*) mapping + sizeof(PacketTraceHeader));
+}
+
+PacketTraceDecoder::~PacketTraceDecoder() {
+	if (m_header != NULL) munmap((void*) m_header, m_mappedSize);
+	if (m_fd != -1) close(m_fd);
+}
+
+uint64_t PacketTraceDecoder::decode(FILE* t_out) {
+	char timestampStr[TRACE_TIMESTAMP_STR_MAX_SIZE];
+	char outStr[TRACE_OUT_STRING_MAX_LEN];
+	uint64_t capacity = m_header->capacity;
+	uint64_t printedRecords = 0;
+
+	uint64_t writeSeq = __atomic_load_n(&m_header->writeSeq, __ATOMIC_ACQUIRE);
+	//the writer may have died after the slot was written but before writeSeq was
+	for (uint64_t i = 0; i < capacity; i++) {
+		if (__atomic_load_n(&m_records[writeSeq % capacity].seq, __ATOMIC_ACQUIRE) != writeSeq + 1) break;
+		writeSeq++;
+	}
+	uint64_t firstSeq = writeSeq > capacity ? writeSeq - capacity : 0;
+	for (uint64_t n = firstSeq; n < writeSeq; n++) {
+		const PacketTraceRecord* slot = m_records + n % capacity;
+		uint64_t seqBefore = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		memcpy(&m_record, slot, sizeof(m_record));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (seqBefore != n + 1 || __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != n + 1) {
+			m_skippedRecords++;
+			continue;
+		}
+
+		getTimestampString(timestampStr);
+		switch((PacketProcessingResultEnum) m_record.packetResult) {
+			case PacketProcessingResultEnum::GOOD_TCP:
+				getTcpLogString(outStr);
+				fprintf(t_out, "%s; %s\n", timestampStr, outStr);
+				break;
+			case PacketProcessingResultEnum::GOOD_UDP:
+				getUdpLogString(outStr);
+				fprintf(t_out, "%s; %s\n", timestampStr, outStr);
+				break;
+			case PacketProcessingResultEnum::UNKNOWN_LINK_TYPE:
+				fprintf(t_out, "%s; Unknown link type\n", timestampStr);
+				break;
+			case PacketProcessingResultEnum::NOT_IP_PACKET:
+				fprintf(t_out, "%s; Not IP packet\n", timestampStr);
+				break;
+			case PacketProcessingResultEnum::UNKNOWN_L3_TYPE:
+				fprintf(t_out, "%s; Unknown layer 3\n", timestampStr);
+				break;
+			case PacketProcessingResultEnum::BAD_IP_HEADER_LEN:
+				fprintf(t_out, "%s; Invalid IP header length\n", timestampStr);
+				break;
+			case PacketProcessingResultEnum::BAD_TCP_HEADER_LEN:
+				fprintf(t_out, "%s; Invalid TCP header length\n", timestampStr);
+				break;
+			case PacketProcessingResultEnum::BAD_UDP_LEN:
+				fprintf(t_out, "%s; Invalid UDP packet length\n", timestampStr);
+				break;
+			default:
+				fprintf(t_out, "%s; Really strange packet\n", timestampStr);
+				break;
+		}
+		printedRecords++;
+	}
+	return printedRecords;
+}
+
+void PacketTraceDecoder::getTimestampString(char* t_timestampStr) {
+	struct tm timestampTm;
+	time_t tsSec = m_record.tsSec;
+
+	gmtime_r(&tsSec, &timestampTm);
+	std::size_t len = strftime(t_timestampStr, TRACE_TIMESTAMP_STR_MAX_SIZE, "%Y-%m-%d %H:%M:%S.", &timestampTm);
+	snprintf(t_timestampStr + len, TRACE_TIMESTAMP_STR_MAX_SIZE - len, "%06u", m_record.tsUsec % 1000000);
+}
+
+void PacketTraceDecoder::getTcpLogString(char* t_logString) {
+	char tcpFlagsStr[16];
+	char sourceIpStr[INET_ADDRSTRLEN];
+	char destinationIpStr[INET_ADDRSTRLEN];
+	char gapDescriptionString[100];
+
+	inet_ntop(AF_INET, &m_record.srcIp, sourceIpStr, INET_ADDRSTRLEN);
+	inet_ntop(AF_INET, &m_record.dstIp, destinationIpStr, INET_ADDRSTRLEN);
+
+	strcpy(tcpFlagsStr,"[.......]");
+	if (m_record.tcpFlags & PACKET_TRACE_FIN) tcpFlagsStr[1]='F';
+	if (m_record.tcpFlags & PACKET_TRACE_SYN) tcpFlagsStr[2]='S';
+	if (m_record.tcpFlags & PACKET_TRACE_RST) tcpFlagsStr[3]='R';
+	if (m_record.tcpFlags & PACKET_TRACE_PSH) tcpFlagsStr[4]='P';
+	if (m_record.tcpFlags & PACKET_TRACE_ACK) tcpFlagsStr[5]='A';
+
+	snprintf(t_logString, TRACE_OUT_STRING_MAX_LEN, "TCP; %s.%d > %s.%d; %s; seq %lu -> %lu; ack %lu; length %d (%d)",
+			sourceIpStr, m_record.srcPort, destinationIpStr, m_record.dstPort, tcpFlagsStr,
+			(unsigned long) m_record.sequenceNumber,
+			(unsigned long) m_record.nextSequenceNumber,
+			(unsigned long) m_record.ackNumber,
+			m_record.payloadLen, m_record.totalLen);
+	if ((OperationStatusEnum) m_record.operationStatus == OperationStatusEnum::REQUEST_STARTED) {
+		strcat(t_logString, "; Request Started");
+	}
+	if ((OperationStatusEnum) m_record.operationStatus == OperationStatusEnum::RESPONSE_STARTED) {
+		strcat(t_logString, "; Response Started");
+	}
+	switch((TcpSessionProcessingResultEnum) m_record.sessionResult) {
+		case TcpSessionProcessingResultEnum::GOOD_KNOWN:
+		break;
+		case TcpSessionProcessingResultEnum::VOID:
+			strcat(t_logString, "; Ignored");
+			break;
+		case TcpSessionProcessingResultEnum::GOOD_NEW:
+			strcat(t_logString, "; New session");
+			break;
+		case TcpSessionProcessingResultEnum::RETRANSMIT:
+			if (m_record.seqGapStart == 0) {
+				strcat(t_logString, "; Retransmit");
+			} else {
+				snprintf(gapDescriptionString, sizeof gapDescriptionString, "; Retransmit with %u - %u gap recovery",
+							m_record.seqGapStart, m_record.seqGapEnd);
+				strcat(t_logString, gapDescriptionString);
+			}
+			break;
+		case TcpSessionProcessingResultEnum::DUPLICATE:
+			strcat(t_logString, "; Duplicate");
+			break;
+		case TcpSessionProcessingResultEnum::NEW_GAP:
+			snprintf(gapDescriptionString, sizeof gapDescriptionString, "; Out-of-order - new TCP sequence gap %u - %u",
+						m_record.seqGapStart, m_record.seqGapEnd);
+			strcat(t_logString, gapDescriptionString);
+			break;
+		case TcpSessionProcessingResultEnum::GAP_RECOVERY:
+			snprintf(gapDescriptionString, sizeof gapDescriptionString, "; Out-of-order - recovers TCP sequence gap %u - %u",
+						m_record.seqGapStart, m_record.seqGapEnd);
+			strcat(t_logString, gapDescriptionString);
+			break;
+		case TcpSessionProcessingResultEnum::KEEPALIVE:
+			strcat(t_logString, "; Keepalive");
+			break;
+		case TcpSessionProcessingResultEnum::SAMPLED_OUT:
+			strcat(t_logString, "; Not sampled");
+			break;
+	}
+}
+
+void PacketTraceDecoder::getUdpLogString(char* t_logString) {
+	char sourceIpStr[INET_ADDRSTRLEN];
+	char destinationIpStr[INET_ADDRSTRLEN];
+
+	inet_ntop(AF_INET, &m_record.srcIp, sourceIpStr, INET_ADDRSTRLEN);
+	inet_ntop(AF_INET, &m_record.dstIp, destinationIpStr, INET_ADDRSTRLEN);
+
+	snprintf(t_logString, TRACE_OUT_STRING_MAX_LEN, "UDP; %s.%d > %s.%d; payload length %d",
+			sourceIpStr, m_record.srcPort, destinationIpStr, m_record.dstPort, m_record.payloadLen);
+	switch((UdpSessionUpdateResultEnum) m_record.sessionResult) {
+		case UdpSessionUpdateResultEnum::GOOD_KNOWN:
+		break;
+		case UdpSessionUpdateResultEnum::VOID:
+			strcat(t_logString, "; Ignored");
+			break;
+		case UdpSessionUpdateResultEnum::GOOD_NEW:
+			strcat(t_logString, "; New session");
+			break;
+		case UdpSessionUpdateResultEnum::DUPLICATE:
+			strcat(t_logString, "; Duplicate");
+			break;
+		case UdpSessionUpdateResultEnum::SAMPLED_OUT:
+			strcat(t_logString, "; Not sampled");
+			break;
+	}
+}
+
+uint64_t PacketTraceDecoder::getSkippedRecords() const {
+	return m_skippedRecords;
+}
+
+bool PacketTraceDecoder::isClosed() const {
+	return __atomic_load_n(&m_header->state, __ATOMIC_ACQUIRE) == PACKET_TRACE_STATE_CLOSED;
+}
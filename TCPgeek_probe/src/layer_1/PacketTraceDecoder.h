@@ -0,0 +1,56 @@
+/*
+ *	PacketTraceDecoder.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : PacketTraceDecoder - reads a packet trace ring file (see PacketTraceLayout.h)
+ *					and prints its records, the oldest first, in the text format of the former
+ *					packetLog. Used offline with the -d command line option, it doesn't need the
+ *					configuration file and may read the ring of a running probe as well.
+ */
+
+#ifndef PACKETTRACEDECODER_H_
+#define PACKETTRACEDECODER_H_
+
+#define TRACE_TIMESTAMP_STR_MAX_SIZE 64
+#define TRACE_OUT_STRING_MAX_LEN 256
+
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "layer_1/PacketTraceLayout.h"
+
+class PacketTraceDecoder {
+private:
+	std::string m_fileName;
+	int m_fd;
+	std::size_t m_mappedSize;
+	const PacketTraceHeader* m_header;
+	const PacketTraceRecord* m_records;
+	PacketTraceRecord m_record; //the copy of the slot being formatted
+	uint64_t m_skippedRecords;
+
+	void getTimestampString(char* t_timestampStr);
+	void getTcpLogString(char* t_logString);
+	void getUdpLogString(char* t_logString);
+
+public:
+	PacketTraceDecoder(const std::string& t_fileName);
+	//throws exceptions if the file can't be mapped or isn't a packet trace
+	~PacketTraceDecoder();
+
+	uint64_t decode(FILE* t_out);
+	//prints every consistent record, returns the number of printed records
+	uint64_t getSkippedRecords() const;
+	//records overwritten by a running writer while they were read
+	bool isClosed() const;
+	//true if the writer has stopped gracefully
+};
+
+#endif /* PACKETTRACEDECODER_H_ */
@@ -0,0 +1,84 @@
+/*
+ *	PacketTraceLayout.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : Binary layout of the packet trace ring file (packetTraceFile). The header is
+ *					followed by PacketTraceHeader::capacity slots of PacketTraceRecord. Integers
+ *					are in host byte order except IP addresses, which stay in network byte order
+ *					as in in_addr. Every ring has a single writer thread, which never waits.
+ *
+ *	Writer, for every packet n = writeSeq:
+ *		slot = n % capacity
+ *		slot.seq = 0; release fence; fill the slot; slot.seq = n + 1 (release store)
+ *		writeSeq = n + 1 (release store)
+ *	Reader, for record n where writeSeq - capacity <= n < writeSeq:
+ *		the slot is valid if slot.seq == n + 1 before and after it has been copied.
+ *	If the writer died between the two stores, the slot at writeSeq already has seq == writeSeq + 1,
+ *	so the reader follows the slots beyond writeSeq while their seq continues the sequence.
+ *
+ *	The previous file is renamed to <packetTraceFile>.prev on start, so the trace of a crashed run
+ *	survives the restart. The state becomes PACKET_TRACE_STATE_CLOSED on a graceful stop.
+ */
+
+#ifndef PACKETTRACELAYOUT_H_
+#define PACKETTRACELAYOUT_H_
+
+#include <stdint.h>
+
+#define PACKET_TRACE_MAGIC "TGTRACE1"
+#define PACKET_TRACE_VERSION 1
+#define PACKET_TRACE_STATE_ACTIVE 1
+#define PACKET_TRACE_STATE_CLOSED 2
+
+//PacketTraceRecord::tcpFlags bits
+#define PACKET_TRACE_FIN 0x01
+#define PACKET_TRACE_SYN 0x02
+#define PACKET_TRACE_RST 0x04
+#define PACKET_TRACE_PSH 0x08
+#define PACKET_TRACE_ACK 0x10
+
+struct PacketTraceHeader {
+	char		magic[8];				//PACKET_TRACE_MAGIC
+	uint32_t	version;				//PACKET_TRACE_VERSION
+	uint32_t	headerSize;				//sizeof(PacketTraceHeader), the first slot starts here
+	uint32_t	recordSize;				//sizeof(PacketTraceRecord)
+	uint32_t	state;					//PACKET_TRACE_STATE_ACTIVE or PACKET_TRACE_STATE_CLOSED
+	uint64_t	capacity;				//number of record slots
+	int64_t		startEpoch;				//when the writer created the ring, seconds
+	uint64_t	writeSeq;				//records written so far
+	uint32_t	pid;					//process and thread of the writer
+	uint32_t	tid;
+	uint8_t		reserved[8];
+};
+
+struct PacketTraceRecord {
+	uint64_t	seq;					//record number + 1 when the slot is consistent, 0 while it is written
+	int64_t		tsSec;					//packet timestamp from libpcap
+	uint32_t	tsUsec;
+	uint32_t	srcIp;					//network byte order
+	uint32_t	dstIp;					//network byte order
+	uint16_t	srcPort;
+	uint16_t	dstPort;
+	uint32_t	sequenceNumber;
+	uint32_t	nextSequenceNumber;
+	uint32_t	ackNumber;
+	uint32_t	payloadLen;
+	uint32_t	totalLen;
+	uint32_t	seqGapStart;			//sequence gap of NEW_GAP, GAP_RECOVERY and RETRANSMIT results
+	uint32_t	seqGapEnd;
+	uint8_t		tcpFlags;				//PACKET_TRACE_* bits
+	uint8_t		packetResult;			//PacketProcessingResultEnum
+	uint8_t		sessionResult;			//TcpSessionProcessingResultEnum or UdpSessionUpdateResultEnum
+	uint8_t		operationStatus;		//OperationStatusEnum, TCP only
+};
+
+static_assert(sizeof(PacketTraceHeader) == 64, "PacketTraceHeader layout changed");
+static_assert(sizeof(PacketTraceRecord) == 64, "PacketTraceRecord layout changed");
+
+#endif /* PACKETTRACELAYOUT_H_ */
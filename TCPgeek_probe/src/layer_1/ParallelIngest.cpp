@@ -0,0 +1,432 @@
+/*
+ *	ParallelIngest.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <inttypes.h>
+#include <log4cpp/Category.hh>
+
+#include "layer_1/ParallelIngest.h"
+#include "layer_1/OverloadController.h"
+#include "layer_1/PacketProcessingResultEnum.h"
+
+ParallelIngest::ParallelIngest(const std::string& t_fileName, const std::string& t_filterExpression, const int t_linkType,
+								const uint32_t t_workers, SafeQueue<StatRecord>* t_statQueue) :
+								m_reader(t_fileName), m_statQueue {t_statQueue},
+								m_scannedRecords {0}, m_reportedPackets {0}, m_isDrained {false}, m_isStopRequested {false},
+								m_isFinished {false} {
+	if (t_workers < 2 || t_workers > PARALLEL_INGEST_MAX_WORKERS) {
+		throw std::runtime_error("offlineWorkers must be from 2 to " + std::to_string(PARALLEL_INGEST_MAX_WORKERS));
+	}
+	//the records of a compressed file or a pipe don't stay in memory until the workers get to them
+	if (m_reader.isStreamed()) {
+		throw std::runtime_error(t_fileName + " is compressed or a pipe");
+	}
+	if (m_reader.getLinkType() != t_linkType) {
+		throw std::runtime_error("link type " + std::to_string(m_reader.getLinkType()) + " of the file isn't the one libpcap has read");
+	}
+	m_reader.setFilter(t_filterExpression);
+	for (uint32_t i = 0; i < t_workers; i++) {
+		m_shards.push_back(new Shard());
+	}
+}
+
+ParallelIngest::~ParallelIngest() {
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		if (m_shards[i]->worker.joinable()) m_shards[i]->worker.join();
+		for (std::size_t j = 0; j < m_shards[i]->blocks.size(); j++) {
+			delete m_shards[i]->blocks[j];
+		}
+		delete m_shards[i];
+	}
+}
+
+void ParallelIngest::runWorker(Shard* t_shard, const uint32_t t_reader) {
+	while (!m_isStopRequested.load(std::memory_order_relaxed)) {
+		const std::vector<uint64_t>* block;
+		{
+			std::unique_lock<std::mutex> lock(t_shard->mutex);
+			t_shard->inputCondVar.wait(lock, [this, t_shard]() { return !t_shard->input.empty() || t_shard->isInputClosed ||
+																		m_isStopRequested.load(std::memory_order_relaxed); });
+			if (t_shard->input.empty()) break;
+			block = t_shard->input.front();
+			t_shard->input.pop_front();
+		}
+		//the capture thread frees the block as soon as its last packet is counted, so it isn't touched after that
+		const uint64_t* offsets = block->data();
+		std::size_t blockSize = block->size();
+		for (std::size_t i = 0; i < blockSize && !m_isStopRequested.load(std::memory_order_relaxed); i++) {
+			processPacket(t_shard, t_reader, offsets[i]);
+		}
+		notifyProgress();
+	}
+	t_shard->isWorkerDone.store(true);
+	notifyProgress();
+}
+
+void ParallelIngest::processPacket(Shard* t_shard, const uint32_t t_reader, const uint64_t t_offset) {
+	struct pcap_pkthdr header;
+	const u_char* packet;
+	int linkType;
+	uint32_t interfaceId;
+	StatRecord statRecord;
+
+	m_reader.getRecord(t_offset, header, packet, linkType, interfaceId);
+	//libpcap applies the filter of a pcap file in the userland too
+	if (m_reader.isAccepted(&header, packet, linkType)) {
+		RuntimeSettings::enterPacket(t_reader);
+		if (header.ts.tv_sec > t_shard->newestPacketSec) t_shard->newestPacketSec = header.ts.tv_sec;
+		if (t_shard->newestPacketSec >= t_shard->nextIdleCheckSec) {
+			//their records go out with this packet's offset
+			t_shard->tcpSessions.cleanIdleSessions(t_shard->newestPacketSec);
+			t_shard->udpSessions.cleanIdleSessions(t_shard->newestPacketSec);
+			t_shard->nextIdleCheckSec = t_shard->newestPacketSec + RuntimeSettings::get()->getGranularity();
+		}
+		switch (t_shard->packet.setPacketFromRaw(&header, packet, linkType, interfaceId)) {
+			case PacketProcessingResultEnum::GOOD_TCP:
+				t_shard->tcpSessions.update(&t_shard->packet);
+				break;
+			case PacketProcessingResultEnum::GOOD_UDP:
+				t_shard->udpSessions.update(&t_shard->packet);
+				break;
+			default:
+				break;
+		}
+		RuntimeSettings::exitPacket(t_reader);
+	}
+	//the records of this packet and those of the sessions the control thread has evicted meanwhile
+	if (t_shard->statQueue.dequeue(statRecord)) {
+		std::unique_lock<std::mutex> lock(t_shard->mutex);
+		if (t_shard->output.size() >= PARALLEL_INGEST_MAX_OUTPUT) {
+			notifyProgress();
+			t_shard->outputCondVar.wait(lock, [this, t_shard]() { return t_shard->output.size() < PARALLEL_INGEST_MAX_OUTPUT ||
+																		m_isStopRequested.load(std::memory_order_relaxed); });
+		}
+		do {
+			t_shard->output.emplace_back(t_offset, statRecord);
+		} while (t_shard->statQueue.dequeue(statRecord));
+	}
+	t_shard->processedPackets.store(t_shard->processedPackets.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool ParallelIngest::canScan(const uint64_t t_pendingOffset) const {
+	//the pages between the slowest worker and the pre-scan are resident
+	if (m_reader.getScanOffset() - t_pendingOffset >= PARALLEL_INGEST_WINDOW_BYTES) return false;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		if (m_shards[i]->blocks.size() >= PARALLEL_INGEST_MAX_BLOCKS) return false;
+	}
+	return true;
+}
+
+bool ParallelIngest::scanChunk() {
+	std::vector<std::vector<uint64_t>*> chunk(m_shards.size(), NULL);
+	struct pcap_pkthdr header;
+	const u_char* packet;
+	int linkType;
+	uint32_t interfaceId;
+	uint64_t offset;
+	std::size_t shardIndex;
+	bool isScanning = true;
+
+	for (uint32_t i = 0; i < PARALLEL_INGEST_CHUNK_RECORDS; i++) {
+		if (!m_reader.nextRecord(offset)) {
+			isScanning = false;
+			break;
+		}
+		m_reader.getRecord(offset, header, packet, linkType, interfaceId);
+		switch (m_scanPacket.setPacketFromRaw(&header, packet, linkType, interfaceId)) {
+			case PacketProcessingResultEnum::GOOD_TCP:
+			case PacketProcessingResultEnum::GOOD_UDP:
+				//both directions of the flow get the same shard
+				shardIndex = OverloadController::getFlowHash(&m_scanPacket) % m_shards.size();
+				break;
+			default:
+				//such packets don't touch the sessions, any shard will do
+				shardIndex = m_scannedRecords % m_shards.size();
+				break;
+		}
+		m_scannedRecords++;
+		if (chunk[shardIndex] == NULL) {
+			chunk[shardIndex] = new std::vector<uint64_t>();
+			chunk[shardIndex]->reserve(PARALLEL_INGEST_CHUNK_RECORDS / m_shards.size() * 2);
+		}
+		chunk[shardIndex]->push_back(offset);
+	}
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		if (chunk[i] == NULL) continue;
+		Shard* shard = m_shards[i];
+		shard->blocks.push_back(chunk[i]);
+		shard->assignedPackets += chunk[i]->size();
+		{
+			std::lock_guard<std::mutex> guard(shard->mutex);
+			shard->input.push_back(chunk[i]);
+		}
+		shard->inputCondVar.notify_one();
+	}
+	if (!isScanning) closeInputs();
+	return isScanning;
+}
+
+void ParallelIngest::closeInputs() {
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		{
+			std::lock_guard<std::mutex> guard(m_shards[i]->mutex);
+			m_shards[i]->isInputClosed = true;
+		}
+		m_shards[i]->inputCondVar.notify_one();
+	}
+}
+
+uint64_t ParallelIngest::getPendingOffset(const Shard* t_shard) const {
+	if (m_isDrained) return UINT64_MAX;
+	uint64_t index = t_shard->mergedPackets - t_shard->blocksBase;
+	if (!t_shard->blocks.empty() && index < t_shard->blocks.front()->size()) {
+		return (*t_shard->blocks.front())[index];
+	}
+	//every packet given to the shard is processed, the next one can't come before the pre-scan
+	return m_reader.getScanOffset();
+}
+
+bool ParallelIngest::takeOutput(Shard* t_shard) {
+	//the records of the packets counted here are in the output already
+	uint64_t processedPackets = t_shard->processedPackets.load(std::memory_order_acquire);
+	bool isMovedOn = (processedPackets != t_shard->mergedPackets);
+	t_shard->mergedPackets = processedPackets;
+	while (!t_shard->blocks.empty() && t_shard->mergedPackets - t_shard->blocksBase >= t_shard->blocks.front()->size()) {
+		t_shard->blocksBase += t_shard->blocks.front()->size();
+		delete t_shard->blocks.front();
+		t_shard->blocks.pop_front();
+	}
+	{
+		std::lock_guard<std::mutex> guard(t_shard->mutex);
+		if (!t_shard->output.empty()) {
+			if (t_shard->merging.empty()) {
+				t_shard->merging.swap(t_shard->output);
+			} else {
+				t_shard->merging.insert(t_shard->merging.end(), t_shard->output.begin(), t_shard->output.end());
+				t_shard->output.clear();
+			}
+			isMovedOn = true;
+		}
+	}
+	t_shard->outputCondVar.notify_one();
+	return isMovedOn;
+}
+
+uint64_t ParallelIngest::merge() {
+	uint64_t mergedRecords = 0;
+
+	if (m_isDrained) {
+		for (std::size_t i = 0; i < m_shards.size(); i++) {
+			takeOutput(m_shards[i]);
+		}
+	}
+	while (true) {
+		//the shard with the earliest record it has or might still produce
+		Shard* next = NULL;
+		uint64_t nextOffset = 0;
+		for (std::size_t i = 0; i < m_shards.size(); i++) {
+			uint64_t offset = m_shards[i]->merging.empty() ? getPendingOffset(m_shards[i]) : m_shards[i]->merging.front().first;
+			if (next == NULL || offset < nextOffset) {
+				next = m_shards[i];
+				nextOffset = offset;
+			}
+		}
+		if (!next->merging.empty()) {
+			m_statQueue->enqueue(next->merging.front().second);
+			next->merging.pop_front();
+			mergedRecords++;
+		} else if (!takeOutput(next)) {
+			//the slowest worker holds the merge back
+			break;
+		}
+	}
+	return mergedRecords;
+}
+
+void ParallelIngest::enqueueSorted(std::vector<StatRecord>& t_records) {
+	TcpUdpSessionKeyLess isLess;
+	std::sort(t_records.begin(), t_records.end(), [&isLess](const StatRecord& a, const StatRecord& b) {
+		return isLess(a.getTcpUdpSessionKey(), b.getTcpUdpSessionKey());
+	});
+	for (std::size_t i = 0; i < t_records.size(); i++) {
+		m_statQueue->enqueue(t_records[i]);
+	}
+	t_records.clear();
+}
+
+void ParallelIngest::notifyProgress() {
+	//the capture thread doesn't sleep longer than a millisecond anyway, so a missed wake up costs little
+	m_progressCondVar.notify_all();
+}
+
+int ParallelIngest::run() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	bool isScanning = true;
+	uint64_t releasedOffset = 0;
+	timespec startTime, endTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		m_shards[i]->worker = std::thread(&ParallelIngest::runWorker, this, m_shards[i], i + 1);
+	}
+	while (!m_isStopRequested.load(std::memory_order_relaxed)) {
+		bool isBusy = false;
+		bool isDone = !isScanning;
+		uint64_t pendingOffset = UINT64_MAX;
+		for (std::size_t i = 0; i < m_shards.size(); i++) {
+			pendingOffset = std::min(pendingOffset, getPendingOffset(m_shards[i]));
+			isDone = isDone && m_shards[i]->isWorkerDone.load();
+		}
+		if (isDone) break;
+		//no worker reads before the pending offset anymore
+		if (pendingOffset >= releasedOffset + PARALLEL_INGEST_WINDOW_BYTES / 16) {
+			m_reader.releaseBefore(pendingOffset);
+			releasedOffset = pendingOffset;
+		}
+		if (isScanning && canScan(pendingOffset)) {
+			isScanning = scanChunk();
+			isBusy = true;
+		}
+		if (merge() > 0) isBusy = true;
+		if (!isBusy) {
+			std::unique_lock<std::mutex> lock(m_progressMutex);
+			m_progressCondVar.wait_for(lock, std::chrono::milliseconds(1));
+		}
+	}
+	closeInputs();
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		m_shards[i]->worker.join();
+	}
+	m_isDrained = true;
+	merge();
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	uint64_t runMs = (endTime.tv_sec - startTime.tv_sec) * 1000 + (endTime.tv_nsec - startTime.tv_nsec) / 1000000;
+	logRoot.info("%" PRIu64 " records of the pcap file were scanned and analyzed by %zu workers in %" PRIu64 "ms",
+					m_scannedRecords, m_shards.size(), runMs);
+	{
+		std::lock_guard<std::mutex> guard(m_progressMutex);
+		m_isFinished = true;
+	}
+	m_progressCondVar.notify_all();
+
+	if (m_isStopRequested.load()) return PCAP_ERROR_BREAK;
+	if (m_reader.isTruncated()) {
+		logRoot.error("The pcap file is truncated or broken at offset %" PRIu64, m_reader.getScanOffset());
+		return PCAP_ERROR;
+	}
+	return 0;
+}
+
+void ParallelIngest::stop() {
+	m_isStopRequested.store(true);
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		{
+			//a worker checks the flag under the mutex before it waits
+			std::lock_guard<std::mutex> guard(m_shards[i]->mutex);
+		}
+		m_shards[i]->inputCondVar.notify_all();
+		m_shards[i]->outputCondVar.notify_all();
+	}
+	std::unique_lock<std::mutex> lock(m_progressMutex);
+	m_progressCondVar.wait(lock, [this]() { return m_isFinished; });
+}
+
+std::size_t ParallelIngest::getTcpSessionsCount() const {
+	std::size_t sessions = 0;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		sessions += m_shards[i]->tcpSessions.size();
+	}
+	return sessions;
+}
+
+std::size_t ParallelIngest::getUdpSessionsCount() const {
+	std::size_t sessions = 0;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		sessions += m_shards[i]->udpSessions.size();
+	}
+	return sessions;
+}
+
+void ParallelIngest::countTcpSessionStates(TcpSessionStates& t_states) const {
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		m_shards[i]->tcpSessions.countStates(t_states);
+	}
+}
+
+uint64_t ParallelIngest::takeProcessedPackets() {
+	uint64_t processedPackets = 0;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		processedPackets += m_shards[i]->processedPackets.load(std::memory_order_relaxed);
+	}
+	uint64_t intervalPackets = processedPackets - m_reportedPackets;
+	m_reportedPackets = processedPackets;
+	return intervalPackets;
+}
+
+void ParallelIngest::accountMemory(MemoryUsage& t_usage) const {
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		Shard* shard = m_shards[i];
+		shard->tcpSessions.accountMemory(t_usage);
+		shard->udpSessions.accountMemory(t_usage);
+		std::lock_guard<std::mutex> guard(shard->mutex);
+		t_usage.statQueueBytes += shard->statQueue.size() * sizeof(StatRecord) +
+									shard->output.size() * sizeof(std::pair<uint64_t, StatRecord>);
+	}
+}
+
+void ParallelIngest::shedMemory() {
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		m_shards[i]->tcpSessions.shedMemory();
+	}
+}
+
+uint32_t ParallelIngest::evictOldestTcpSessions(const uint32_t t_sessions) {
+	//the shards are about equal, the flows are spread by a hash
+	uint32_t evictedSessions = 0;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		evictedSessions += m_shards[i]->tcpSessions.evictOldestSessions(t_sessions / m_shards.size() + (i < t_sessions % m_shards.size()));
+	}
+	return evictedSessions;
+}
+
+uint32_t ParallelIngest::evictOldestUdpSessions(const uint32_t t_sessions) {
+	uint32_t evictedSessions = 0;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		evictedSessions += m_shards[i]->udpSessions.evictOldestSessions(t_sessions / m_shards.size() + (i < t_sessions % m_shards.size()));
+	}
+	return evictedSessions;
+}
+
+void ParallelIngest::finalStatCalculation(uint32_t& t_tcpSessions, uint32_t& t_udpSessions) {
+	StatRecord statRecord;
+	std::vector<StatRecord> records;
+
+	//sessions evicted after the last packet of their shard
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		while (m_shards[i]->statQueue.dequeue(statRecord)) m_statQueue->enqueue(statRecord);
+	}
+	t_tcpSessions = 0;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		t_tcpSessions += m_shards[i]->tcpSessions.finalStatCalculation();
+		while (m_shards[i]->statQueue.dequeue(statRecord)) records.push_back(statRecord);
+	}
+	//every shard is sorted already, a session is in one shard only
+	enqueueSorted(records);
+	t_udpSessions = 0;
+	for (std::size_t i = 0; i < m_shards.size(); i++) {
+		t_udpSessions += m_shards[i]->udpSessions.finalStatCalculation();
+		while (m_shards[i]->statQueue.dequeue(statRecord)) records.push_back(statRecord);
+	}
+	enqueueSorted(records);
+}
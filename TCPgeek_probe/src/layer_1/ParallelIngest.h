@@ -0,0 +1,136 @@
+/*
+ *	ParallelIngest.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : ParallelIngest - analysis of a pcap or pcapng file on several threads, used instead of
+ *					pcap_loop() when offlineWorkers is configured. The capture thread pre-scans the
+ *					mapped file in chunks and spreads the record offsets over the shards by the hash
+ *					of the flow, so every session lives in one shard. Every shard has its own worker,
+ *					TCP and UDP sessions and statistics queue. The records of a shard are tagged with
+ *					the file offset of the packet that produced them, and the capture thread merges
+ *					the shards by that offset into the statistics queue of the Sniffer. A record is
+ *					merged only when no other shard can produce an earlier one anymore, so the queue
+ *					gets the records in the same order as from a single thread.
+ *
+ *	maxTcpSessions applies to every shard. Every shard looks for its idle sessions by the time of
+ *	its own packets, so a session idle in the middle of the file may be reported a few packets
+ *	earlier or later than a single thread would. The order is exact otherwise, as long as the
+ *	sessions aren't evicted by the memory budget: the eviction isn't tied to packets.
+ */
+
+#ifndef PARALLELINGEST_H_
+#define PARALLELINGEST_H_
+
+#include <pcap.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "SafeQueue.h"
+#include "layer_1/OfflinePcapReader.h"
+#include "layer_1/Packet.h"
+#include "layer_1/StatRecord.h"
+#include "layer_1/RuntimeSettings.h"
+#include "layer_1/MemoryBudget.h"
+#include "layer_1/sessions/TCP/TcpSessions.h"
+#include "layer_1/sessions/UDP/UdpSessions.h"
+
+#define PARALLEL_INGEST_MAX_WORKERS (RUNTIME_SETTINGS_MAX_READERS - 1) //reader 0 is the capture thread
+#define PARALLEL_INGEST_WINDOW_BYTES (256ULL * 1024 * 1024) //of the file between the slowest worker and the pre-scan
+#define PARALLEL_INGEST_CHUNK_RECORDS 16384 //records pre-scanned at once
+#define PARALLEL_INGEST_MAX_BLOCKS 4 //chunks of offsets waiting for a worker
+#define PARALLEL_INGEST_MAX_OUTPUT 65536 //records of a shard waiting for the merge
+
+class ParallelIngest {
+private:
+	struct Shard {
+		SafeQueue<StatRecord> statQueue;
+		TcpSessions tcpSessions;
+		UdpSessions udpSessions;
+		Packet packet;
+		std::thread worker;
+
+		std::mutex mutex; //protects input, isInputClosed and output
+		std::condition_variable inputCondVar, outputCondVar;
+		std::deque<const std::vector<uint64_t>*> input;
+		bool isInputClosed;
+		std::deque<std::pair<uint64_t, StatRecord>> output; //records with the offset of their packet
+		std::atomic<uint64_t> processedPackets; //published after the records of the packet are in output
+		std::atomic<bool> isWorkerDone;
+		int64_t newestPacketSec, nextIdleCheckSec; //touched by the worker only, as Sniffer does for a single thread
+
+		//touched by the capture thread only
+		std::deque<std::vector<uint64_t>*> blocks; //offsets given to the worker and not processed yet
+		uint64_t blocksBase; //the number of packets before the first block
+		uint64_t assignedPackets;
+		uint64_t mergedPackets; //processedPackets when the output was taken the last time
+		std::deque<std::pair<uint64_t, StatRecord>> merging;
+
+		Shard() : statQueue(), tcpSessions(&statQueue), udpSessions(&statQueue), isInputClosed {false},
+					processedPackets {0}, isWorkerDone {false}, newestPacketSec {0}, nextIdleCheckSec {0}, blocksBase {0}, assignedPackets {0}, mergedPackets {0} {}
+	};
+
+	OfflinePcapReader m_reader; //applies bpfExpression to the packets by itself
+	SafeQueue<StatRecord>* m_statQueue;
+	std::vector<Shard*> m_shards;
+	Packet m_scanPacket; //the pre-scan parses the packets only to find their flow
+	uint64_t m_scannedRecords;
+	uint64_t m_reportedPackets;
+	bool m_isDrained; //the workers are gone, nothing limits the merge
+	std::atomic<bool> m_isStopRequested;
+	std::mutex m_progressMutex;
+	std::condition_variable m_progressCondVar; //the workers wake the capture thread up
+	bool m_isFinished; //run() is over, protected by m_progressMutex
+
+	void runWorker(Shard* t_shard, const uint32_t t_reader);
+	void processPacket(Shard* t_shard, const uint32_t t_reader, const uint64_t t_offset);
+	bool canScan(const uint64_t t_pendingOffset) const;
+	bool scanChunk();
+	//returns false at the end of the file
+	void closeInputs();
+	uint64_t getPendingOffset(const Shard* t_shard) const;
+	//the first packet of the shard that isn't known to be processed, every later record of the shard comes from it or after it
+	bool takeOutput(Shard* t_shard);
+	//returns false if the shard hasn't moved on since the last time
+	uint64_t merge();
+	void enqueueSorted(std::vector<StatRecord>& t_records);
+	void notifyProgress();
+
+public:
+	ParallelIngest(const std::string& t_fileName, const std::string& t_filterExpression, const int t_linkType,
+					const uint32_t t_workers, SafeQueue<StatRecord>* t_statQueue);
+	//throws exceptions if the file can't be mapped, isn't a pcap or pcapng file or has another link type
+	~ParallelIngest();
+
+	int run();
+	//invoked from the capture thread instead of pcap_loop(), returns what pcap_loop() would
+	void stop();
+	//invoked from the control thread, returns when run() is over
+
+	//the rest is invoked from the control thread
+	std::size_t getTcpSessionsCount() const;
+	std::size_t getUdpSessionsCount() const;
+	void countTcpSessionStates(TcpSessionStates& t_states) const;
+	uint64_t takeProcessedPackets();
+	//packets processed by the workers since the previous call
+	void accountMemory(MemoryUsage& t_usage) const;
+	void shedMemory();
+	uint32_t evictOldestTcpSessions(const uint32_t t_sessions);
+	uint32_t evictOldestUdpSessions(const uint32_t t_sessions);
+	void finalStatCalculation(uint32_t& t_tcpSessions, uint32_t& t_udpSessions);
+	//must be invoked after stop(), the records are sorted by the session key like those of a single thread
+};
+
+#endif /* PARALLELINGEST_H_ */
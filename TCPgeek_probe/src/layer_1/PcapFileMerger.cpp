@@ -0,0 +1,304 @@
+/*
+ *	PcapFileMerger.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <stdexcept>
+#include <inttypes.h>
+#include <log4cpp/Category.hh>
+
+#include "layer_1/PcapFileMerger.h"
+
+bool PcapFileMerger::CursorLater::operator()(const uint32_t a, const uint32_t b) const {
+	const struct timeval& aTs = (*m_cursors)[a].header.ts;
+	const struct timeval& bTs = (*m_cursors)[b].header.ts;
+	if (aTs.tv_sec != bTs.tv_sec) return aTs.tv_sec > bTs.tv_sec;
+	if (aTs.tv_usec != bTs.tv_usec) return aTs.tv_usec > bTs.tv_usec;
+	return a > b;
+}
+
+PcapFileMerger::PcapFileMerger(const std::vector<std::string>& t_fileNames) : m_current {0}, m_hasCurrent {false}, m_isStarted {false},
+																				m_truncatedFiles {0}, m_activeStreams {0}, m_maxActiveStreams {0}, m_hasFilter {false},
+																				m_isInterrupted {false}, m_isPrefetchStopped {false} {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	m_lastTs.tv_sec = 0;
+	m_lastTs.tv_usec = 0;
+	for (std::size_t i = 0; i < t_fileNames.size(); i++) {
+		Cursor cursor;
+		cursor.reader = NULL;
+		cursor.fileName = t_fileNames[i];
+		cursor.offset = 0;
+		cursor.packet = NULL;
+		cursor.linkType = 0;
+		cursor.interfaceId = 0;
+		cursor.prefetchedOffset = 0;
+		//a pipe is the only source, it is never peeked at
+		if (m_activeStreams >= PCAP_FILE_MERGER_MAX_STREAMS && !OfflinePcapReader::isPipe(t_fileNames[i]) &&
+				PcapInputStream::isCompressed(t_fileNames[i])) {
+			m_pendingStreams.push_back(m_cursors.size());
+			m_cursors.push_back(cursor);
+			continue;
+		}
+		try {
+			cursor.reader = new OfflinePcapReader(t_fileNames[i]);
+		} catch (std::exception& e) {
+			logRoot.warn("%s is skipped: %s", t_fileNames[i].c_str(), e.what());
+			continue;
+		}
+		cursor.linkType = cursor.reader->getLinkType();
+		if (cursor.reader->isStreamed()) m_activeStreams++;
+		m_cursors.push_back(cursor);
+	}
+	if (m_cursors.empty()) {
+		throw std::runtime_error("none of " + std::to_string(t_fileNames.size()) + " files is a pcap or pcapng file");
+	}
+	if (!m_pendingStreams.empty()) {
+		logRoot.info("%zu compressed files are decompressed %d at once", m_pendingStreams.size() + m_activeStreams,
+						PCAP_FILE_MERGER_MAX_STREAMS);
+	}
+	//the files opened later only take the place of those that are over
+	m_maxActiveStreams = m_pendingStreams.empty() ? m_activeStreams : PCAP_FILE_MERGER_MAX_STREAMS;
+	m_heap.reserve(m_cursors.size());
+	m_prefetchThread = std::thread(&PcapFileMerger::runPrefetch, this);
+}
+
+PcapFileMerger::~PcapFileMerger() {
+	{
+		std::lock_guard<std::mutex> lock(m_prefetchMutex);
+		m_isPrefetchStopped = true;
+	}
+	m_prefetchCondVar.notify_one();
+	m_prefetchThread.join();
+	for (std::size_t i = 0; i < m_cursors.size(); i++) {
+		delete m_cursors[i].reader;
+	}
+}
+
+std::vector<std::string> PcapFileMerger::expandSource(const std::string& t_source) {
+	std::vector<std::string> fileNames;
+	struct stat fileStat;
+
+	if (stat(t_source.c_str(), &fileStat) == 0) {
+		if (!S_ISDIR(fileStat.st_mode)) return fileNames;
+		DIR* dir = opendir(t_source.c_str());
+		if (dir == NULL) return fileNames;
+		struct dirent* entry;
+		while ((entry = readdir(dir)) != NULL) {
+			//hidden files are left out, as well as . and ..
+			if (entry->d_name[0] == '.') continue;
+			std::string fileName = t_source + "/" + entry->d_name;
+			if (stat(fileName.c_str(), &fileStat) == 0 && S_ISREG(fileStat.st_mode)) fileNames.push_back(fileName);
+		}
+		closedir(dir);
+		std::sort(fileNames.begin(), fileNames.end());
+	} else if (t_source.find_first_of("*?[") != std::string::npos) {
+		glob_t globResult;
+		//the matches come sorted
+		if (glob(t_source.c_str(), 0, NULL, &globResult) == 0) {
+			for (std::size_t i = 0; i < globResult.gl_pathc; i++) {
+				if (stat(globResult.gl_pathv[i], &fileStat) == 0 && S_ISREG(fileStat.st_mode)) {
+					fileNames.push_back(globResult.gl_pathv[i]);
+				}
+			}
+		}
+		globfree(&globResult);
+	}
+	return fileNames;
+}
+
+void PcapFileMerger::setFilter(const std::string& t_expression) {
+	for (std::size_t i = 0; i < m_cursors.size(); i++) {
+		if (m_cursors[i].reader != NULL) m_cursors[i].reader->setFilter(t_expression);
+	}
+	m_filterExpression = t_expression;
+	m_hasFilter = true;
+}
+
+bool PcapFileMerger::advance(Cursor& t_cursor) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	while (t_cursor.reader->nextRecord(t_cursor.offset)) {
+		//the ring of a compressed file is freed by the filtered out records as well
+		t_cursor.reader->releaseBefore(t_cursor.offset);
+		t_cursor.reader->getRecord(t_cursor.offset, t_cursor.header, t_cursor.packet, t_cursor.linkType, t_cursor.interfaceId);
+		if (t_cursor.reader->isAccepted(&t_cursor.header, t_cursor.packet, t_cursor.linkType)) return true;
+	}
+	if (t_cursor.reader->isTruncated()) {
+		logRoot.warn("%s is truncated or broken at offset %" PRIu64 ", the rest of it is skipped",
+						t_cursor.fileName.c_str(), t_cursor.reader->getScanOffset());
+		m_truncatedFiles++;
+	}
+	//the file is over, its whole mapping leaves RSS
+	t_cursor.reader->releaseBefore(UINT64_MAX);
+	return false;
+}
+
+void PcapFileMerger::closeStream(Cursor& t_cursor) {
+	OfflinePcapReader* reader = t_cursor.reader;
+	{
+		std::lock_guard<std::mutex> lock(m_streamsMutex);
+		t_cursor.reader = NULL;
+	}
+	//a stream never has prefetch requests, so nothing else refers to it
+	delete reader;
+	m_activeStreams--;
+}
+
+bool PcapFileMerger::openStream(Cursor& t_cursor) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	OfflinePcapReader* reader;
+
+	try {
+		reader = new OfflinePcapReader(t_cursor.fileName);
+	} catch (std::exception& e) {
+		logRoot.warn("%s is skipped: %s", t_cursor.fileName.c_str(), e.what());
+		return false;
+	}
+	try {
+		//the same filter has been compiled for the other files already
+		if (m_hasFilter) reader->setFilter(m_filterExpression);
+	} catch (std::exception& e) {
+		logRoot.warn("%s is skipped: %s", t_cursor.fileName.c_str(), e.what());
+		delete reader;
+		return false;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_streamsMutex);
+		if (m_isInterrupted) reader->interrupt();
+		t_cursor.reader = reader;
+	}
+	t_cursor.linkType = reader->getLinkType();
+	m_activeStreams++;
+	return true;
+}
+
+void PcapFileMerger::openPendingStreams() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	CursorLater isLater(&m_cursors);
+
+	while (m_activeStreams < PCAP_FILE_MERGER_MAX_STREAMS && !m_pendingStreams.empty()) {
+		uint32_t index = m_pendingStreams.front();
+		m_pendingStreams.pop_front();
+		Cursor& cursor = m_cursors[index];
+		if (!openStream(cursor)) continue;
+		if (!advance(cursor)) {
+			closeStream(cursor);
+			continue;
+		}
+		if (cursor.header.ts.tv_sec < m_lastTs.tv_sec ||
+				(cursor.header.ts.tv_sec == m_lastTs.tv_sec && cursor.header.ts.tv_usec < m_lastTs.tv_usec)) {
+			logRoot.warn("%s starts before the packets already replayed, its first packets are out of the time order",
+							cursor.fileName.c_str());
+		}
+		m_heap.push_back(index);
+		std::push_heap(m_heap.begin(), m_heap.end(), isLater);
+	}
+}
+
+bool PcapFileMerger::next(struct pcap_pkthdr& t_header, const u_char*& t_packet, int& t_linkType, uint32_t& t_interfaceId) {
+	CursorLater isLater(&m_cursors);
+
+	if (m_hasCurrent) {
+		//the packet given last time isn't used anymore, the file moves on
+		Cursor& cursor = m_cursors[m_current];
+		if (advance(cursor)) {
+			m_heap.push_back(m_current);
+			std::push_heap(m_heap.begin(), m_heap.end(), isLater);
+		} else if (cursor.reader->isStreamed()) {
+			closeStream(cursor);
+			openPendingStreams();
+		}
+	} else if (!m_isStarted) {
+		//the first call, the filter is known by now
+		m_isStarted = true;
+		for (uint32_t i = 0; i < m_cursors.size(); i++) {
+			if (m_cursors[i].reader == NULL) continue;
+			if (advance(m_cursors[i])) {
+				m_heap.push_back(i);
+			} else if (m_cursors[i].reader->isStreamed()) {
+				closeStream(m_cursors[i]);
+			}
+		}
+		std::make_heap(m_heap.begin(), m_heap.end(), isLater);
+		openPendingStreams();
+	}
+	m_hasCurrent = false;
+	if (m_heap.empty()) return false;
+
+	std::pop_heap(m_heap.begin(), m_heap.end(), isLater);
+	m_current = m_heap.back();
+	m_heap.pop_back();
+	m_hasCurrent = true;
+
+	Cursor& cursor = m_cursors[m_current];
+	//the ring of a compressed file is filled by its own thread
+	if (!cursor.reader->isStreamed()) requestPrefetch(cursor);
+	m_lastTs = cursor.header.ts;
+	t_header = cursor.header;
+	t_packet = cursor.packet;
+	t_linkType = cursor.linkType;
+	t_interfaceId = cursor.interfaceId;
+	return true;
+}
+
+void PcapFileMerger::requestPrefetch(Cursor& t_cursor) {
+	//keeps the next PCAP_FILE_MERGER_PREFETCH_BYTES to PCAP_FILE_MERGER_PREFETCH_BYTES * 2 of the file requested
+	if (t_cursor.offset + PCAP_FILE_MERGER_PREFETCH_BYTES < t_cursor.prefetchedOffset) return;
+	{
+		std::lock_guard<std::mutex> lock(m_prefetchMutex);
+		m_prefetchRequests.emplace_back(t_cursor.reader, t_cursor.prefetchedOffset);
+	}
+	m_prefetchCondVar.notify_one();
+	t_cursor.prefetchedOffset += PCAP_FILE_MERGER_PREFETCH_BYTES;
+}
+
+void PcapFileMerger::runPrefetch() {
+	std::unique_lock<std::mutex> lock(m_prefetchMutex);
+
+	while (true) {
+		m_prefetchCondVar.wait(lock, [this]() { return !m_prefetchRequests.empty() || m_isPrefetchStopped; });
+		if (m_isPrefetchStopped) return;
+		std::pair<const OfflinePcapReader*, uint64_t> request = m_prefetchRequests.front();
+		m_prefetchRequests.pop_front();
+		lock.unlock();
+		request.first->prefetch(request.second, PCAP_FILE_MERGER_PREFETCH_BYTES);
+		lock.lock();
+	}
+}
+
+void PcapFileMerger::interrupt() {
+	std::lock_guard<std::mutex> lock(m_streamsMutex);
+	m_isInterrupted = true;
+	for (std::size_t i = 0; i < m_cursors.size(); i++) {
+		if (m_cursors[i].reader != NULL) m_cursors[i].reader->interrupt();
+	}
+}
+
+int PcapFileMerger::getLinkType() const {
+	//the first file is never waiting, but it may be over and closed already
+	return m_cursors[0].linkType;
+}
+
+std::size_t PcapFileMerger::getFilesCount() const {
+	return m_cursors.size();
+}
+
+uint64_t PcapFileMerger::getTruncatedFiles() const {
+	return m_truncatedFiles;
+}
+
+std::size_t PcapFileMerger::getMaxActiveStreams() const {
+	return m_maxActiveStreams;
+}
@@ -0,0 +1,124 @@
+/*
+ *	PcapFileMerger.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : PcapFileMerger - several pcap or pcapng files replayed as one stream, used instead
+ *					of pcap_loop() when the source is a directory, a glob pattern or a pcapng file.
+ *					Every file is mapped by its own OfflinePcapReader, the heads of the files are
+ *					kept in a binary heap by the packet timestamp, so the capture thread gets the
+ *					packets of all files in the time order. The packets of the same time are taken
+ *					in the order of the file names. A prefetch thread maps the pages of the files
+ *					ahead of the capture thread, the pages behind it are given back. A compressed
+ *					file is decompressed on a thread of its own instead, and only a few of them are
+ *					open at once: the rest wait in the order of their names and the next one is opened
+ *					when a decompressed file is over, as rotated files hardly overlap in time.
+ *
+ *	Every file is expected to be in the time order itself, as tcpdump writes it. A file that can't
+ *	be opened is skipped, a truncated one ends where it is cut, both with a warning. A compressed file
+ *	opened late that starts before the packets already given is replayed out of the time order, with
+ *	a warning too.
+ */
+
+#ifndef PCAPFILEMERGER_H_
+#define PCAPFILEMERGER_H_
+
+#include <pcap.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "layer_1/OfflinePcapReader.h"
+
+#define PCAP_FILE_MERGER_PREFETCH_BYTES OFFLINE_PCAP_RELEASE_STEP //mapped ahead of the capture thread in every file it reads
+#define PCAP_FILE_MERGER_MAX_STREAMS 4 //compressed files decompressed at once, each has a ring of PCAP_INPUT_STREAM_RING_SIZE
+
+class PcapFileMerger {
+private:
+	struct Cursor {
+		OfflinePcapReader* reader; //NULL while a compressed file waits to be opened and after it is over
+		std::string fileName;
+		uint64_t offset; //of the head record
+		struct pcap_pkthdr header;
+		const u_char* packet;
+		int linkType;
+		uint32_t interfaceId;
+		uint64_t prefetchedOffset; //the pages before it are requested from the prefetch thread
+	};
+
+	class CursorLater {
+	private:
+		const std::vector<Cursor>* m_cursors;
+	public:
+		CursorLater(const std::vector<Cursor>* t_cursors) : m_cursors {t_cursors} {}
+		bool operator()(const uint32_t a, const uint32_t b) const;
+		//std::push_heap() keeps the greatest on top, so the later packet is the lesser one
+	};
+
+	std::vector<Cursor> m_cursors;
+	std::vector<uint32_t> m_heap; //indexes of the cursors that still have packets
+	uint32_t m_current; //the cursor whose packet was given last, it is back in the heap on the next call
+	bool m_hasCurrent;
+	bool m_isStarted; //the heads of the files are read on the first call
+	uint64_t m_truncatedFiles;
+	std::deque<uint32_t> m_pendingStreams; //the cursors of the compressed files not opened yet
+	std::size_t m_activeStreams; //opened compressed files or a pipe, PCAP_FILE_MERGER_MAX_STREAMS at most
+	std::size_t m_maxActiveStreams;
+	std::string m_filterExpression; //for the files opened later
+	bool m_hasFilter;
+	struct timeval m_lastTs; //of the packet given last
+	std::mutex m_streamsMutex; //protects the readers of the streams and m_isInterrupted against interrupt()
+	bool m_isInterrupted;
+
+	std::mutex m_prefetchMutex;
+	std::condition_variable m_prefetchCondVar;
+	std::deque<std::pair<const OfflinePcapReader*, uint64_t>> m_prefetchRequests;
+	bool m_isPrefetchStopped; //protected by m_prefetchMutex
+	std::thread m_prefetchThread;
+
+	bool advance(Cursor& t_cursor);
+	//reads the next accepted record of the file, returns false at its end
+	void closeStream(Cursor& t_cursor);
+	//gives the thread, the descriptor and the ring of a compressed file that is over back
+	bool openStream(Cursor& t_cursor);
+	//returns false if the file can't be opened, it is skipped then
+	void openPendingStreams();
+	//opens the next compressed files while fewer than PCAP_FILE_MERGER_MAX_STREAMS are open, their heads join the heap
+	void requestPrefetch(Cursor& t_cursor);
+	void runPrefetch();
+
+public:
+	PcapFileMerger(const std::vector<std::string>& t_fileNames);
+	//throws an exception if none of the files can be read
+	~PcapFileMerger();
+
+	static std::vector<std::string> expandSource(const std::string& t_source);
+	//the regular files of a directory or those matching a glob pattern, sorted by name
+	//empty if the source is neither
+
+	void setFilter(const std::string& t_expression);
+	//throws an exception if the filter can't be compiled
+	bool next(struct pcap_pkthdr& t_header, const u_char*& t_packet, int& t_linkType, uint32_t& t_interfaceId);
+	//invoked from the capture thread, gives the earliest packet of all files that passes the filter,
+	//false when all files are over; the packet data stays valid until the next call
+	int getLinkType() const;
+	//of the first file
+	std::size_t getFilesCount() const;
+	void interrupt();
+	//thread safe, next() doesn't wait for a pipe or a decompressing thread anymore
+	uint64_t getTruncatedFiles() const;
+	std::size_t getMaxActiveStreams() const;
+	//compressed files or a pipe open at once at most, each has a ring of PCAP_INPUT_STREAM_RING_SIZE
+};
+
+#endif /* PCAPFILEMERGER_H_ */
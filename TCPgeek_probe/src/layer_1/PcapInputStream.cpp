@@ -0,0 +1,401 @@
+/*
+ *	PcapInputStream.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <algorithm>
+#include <stdexcept>
+#include <inttypes.h>
+#include <zlib.h>
+#include <lzma.h>
+#include <zstd.h>
+#include <log4cpp/Category.hh>
+
+#include "layer_1/PcapInputStream.h"
+
+PcapInputStream::PcapInputStream(const int t_fd, const std::string& t_name) : m_fd {t_fd}, m_isPipe {false}, m_stopFd {-1},
+																				m_name {t_name}, m_ring {NULL},
+																				m_input {NULL}, m_inputOffset {0}, m_inputLength {0},
+																				m_written {0}, m_released {0}, m_isFinished {false},
+																				m_isBroken {false}, m_isStopped {false},
+																				m_isRingRemoved {false} {
+	std::string error;
+	void* area = MAP_FAILED;
+	struct stat fileStat;
+
+	if (fstat(m_fd, &fileStat) == 0 && !S_ISREG(fileStat.st_mode)) {
+		m_isPipe = true;
+		//the writer may run ahead by more than the default 64Kb, the reads get larger then; the limit
+		//of pipe-max-size may refuse it, which is harmless
+		if (S_ISFIFO(fileStat.st_mode)) fcntl(m_fd, F_SETPIPE_SZ, PCAP_INPUT_STREAM_READ_SIZE);
+	}
+	//the pages of the ring are shared by both of its mappings
+	int ringFd = memfd_create("pcap_input_stream", MFD_CLOEXEC);
+	if (ringFd < 0 || ftruncate(ringFd, PCAP_INPUT_STREAM_RING_SIZE) != 0) {
+		error = strerror(errno);
+	} else if ((area = mmap(NULL, PCAP_INPUT_STREAM_RING_SIZE * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+		error = strerror(errno);
+	} else if (mmap(area, PCAP_INPUT_STREAM_RING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, ringFd, 0) == MAP_FAILED ||
+				mmap((u_char*) area + PCAP_INPUT_STREAM_RING_SIZE, PCAP_INPUT_STREAM_RING_SIZE, PROT_READ | PROT_WRITE,
+						MAP_SHARED | MAP_FIXED, ringFd, 0) == MAP_FAILED) {
+		error = strerror(errno);
+		munmap(area, PCAP_INPUT_STREAM_RING_SIZE * 2);
+	}
+	if (ringFd >= 0) close(ringFd);
+	if (error.empty() && (m_stopFd = eventfd(0, EFD_CLOEXEC)) < 0) {
+		error = strerror(errno);
+		munmap(area, PCAP_INPUT_STREAM_RING_SIZE * 2);
+	}
+	if (!error.empty()) {
+		close(m_fd);
+		throw std::runtime_error("Can't map the ring of " + t_name + ": " + error);
+	}
+	m_ring = (u_char*) area;
+	m_input = new u_char[PCAP_INPUT_STREAM_READ_SIZE];
+	m_thread = std::thread(&PcapInputStream::run, this);
+}
+
+PcapInputStream::~PcapInputStream() {
+	interrupt();
+	m_thread.join();
+	munmap(m_ring, PCAP_INPUT_STREAM_RING_SIZE * 2);
+	delete[] m_input;
+	close(m_stopFd);
+	close(m_fd);
+}
+
+PcapInputStream::Compression PcapInputStream::detect(const u_char* t_head, const std::size_t t_length) {
+	static const u_char gzipMagic[] = {0x1F, 0x8B};
+	static const u_char xzMagic[] = {0xFD, '7', 'z', 'X', 'Z', 0x00};
+	static const u_char zstdMagic[] = {0x28, 0xB5, 0x2F, 0xFD};
+
+	if (t_length >= sizeof(gzipMagic) && memcmp(t_head, gzipMagic, sizeof(gzipMagic)) == 0) return Compression::GZIP;
+	if (t_length >= sizeof(xzMagic) && memcmp(t_head, xzMagic, sizeof(xzMagic)) == 0) return Compression::XZ;
+	if (t_length >= sizeof(zstdMagic) && memcmp(t_head, zstdMagic, sizeof(zstdMagic)) == 0) return Compression::ZSTD;
+	return Compression::NONE;
+}
+
+bool PcapInputStream::isCompressed(const u_char* t_head, const std::size_t t_length) {
+	return detect(t_head, t_length) != Compression::NONE;
+}
+
+bool PcapInputStream::isCompressed(const std::string& t_fileName) {
+	u_char head[PCAP_INPUT_STREAM_MAGIC_LEN];
+
+	int fd = open(t_fileName.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	ssize_t length = read(fd, head, sizeof(head));
+	close(fd);
+	return length > 0 && isCompressed(head, length);
+}
+
+void PcapInputStream::run() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	//a pipe may give the magic number in several reads
+	while (m_inputLength < PCAP_INPUT_STREAM_MAGIC_LEN && readInput());
+	if (!m_readError.empty()) {
+		finish(m_readError);
+		return;
+	}
+	switch (detect(m_input, m_inputLength)) {
+		case Compression::GZIP:
+			logRoot.info("%s is decompressed from gzip on a separate thread", m_name.c_str());
+			runGzip();
+			break;
+		case Compression::XZ:
+			logRoot.info("%s is decompressed from xz on a separate thread", m_name.c_str());
+			runXz();
+			break;
+		case Compression::ZSTD:
+			logRoot.info("%s is decompressed from zstd on a separate thread", m_name.c_str());
+			runZstd();
+			break;
+		default:
+			runPlain();
+			break;
+	}
+}
+
+void PcapInputStream::runPlain() {
+	u_char* buffer;
+	std::size_t length;
+
+	//the bytes read for the magic number go first
+	while (m_inputOffset < m_inputLength) {
+		if ((length = reserve(buffer)) == 0) return;
+		length = std::min(length, m_inputLength - m_inputOffset);
+		memcpy(buffer, m_input + m_inputOffset, length);
+		m_inputOffset += length;
+		commit(length);
+	}
+	//a pipe gives as much as the writer has written, a part of the buffer is committed right away
+	while ((length = reserve(buffer)) != 0) {
+		ssize_t res = readFd(buffer, length);
+		if (res > 0) {
+			commit(res);
+		} else {
+			finish(res == 0 ? "" : strerror(errno));
+			return;
+		}
+	}
+}
+
+void PcapInputStream::runGzip() {
+	z_stream stream;
+	u_char* buffer;
+	std::size_t length;
+	bool isMemberOver = false;
+	bool isOutputFull = false; //the decompressor may hold more output even without input
+
+	memset(&stream, 0, sizeof(stream));
+	//a gzip header is expected, the window is the largest one
+	if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+		finish("zlib can't be initialized");
+		return;
+	}
+	while (true) {
+		if (m_inputOffset == m_inputLength && !isOutputFull && !readInput()) {
+			if (!m_readError.empty()) finish(m_readError);
+			else finish(isMemberOver ? "" : "the compressed data is cut");
+			break;
+		}
+		if (isMemberOver) {
+			//the members written one after another are a single stream, as pigz and cat write them;
+			//gzip ignores anything else that trails, so does this
+			if (m_input[m_inputOffset] != 0x1F) {
+				finish("");
+				break;
+			}
+			inflateReset(&stream);
+			isMemberOver = false;
+		}
+		if ((length = reserve(buffer)) == 0) break;
+		stream.next_in = m_input + m_inputOffset;
+		stream.avail_in = m_inputLength - m_inputOffset;
+		stream.next_out = buffer;
+		stream.avail_out = length;
+		int res = inflate(&stream, Z_NO_FLUSH);
+		m_inputOffset = m_inputLength - stream.avail_in;
+		isOutputFull = (stream.avail_out == 0);
+		commit(length - stream.avail_out);
+		if (res == Z_STREAM_END) {
+			isMemberOver = true;
+			isOutputFull = false;
+		} else if (res != Z_OK && res != Z_BUF_ERROR) {
+			finish(stream.msg != NULL ? stream.msg : "the compressed data is broken");
+			break;
+		}
+	}
+	inflateEnd(&stream);
+}
+
+void PcapInputStream::runXz() {
+	lzma_stream stream = LZMA_STREAM_INIT;
+	u_char* buffer;
+	std::size_t length;
+	bool isInputOver = false;
+
+	//the streams written one after another are a single one as well
+	if (lzma_stream_decoder(&stream, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK) {
+		finish("liblzma can't be initialized");
+		return;
+	}
+	while (true) {
+		if (!isInputOver && m_inputOffset == m_inputLength && !readInput()) {
+			if (!m_readError.empty()) {
+				finish(m_readError);
+				break;
+			}
+			isInputOver = true;
+		}
+		if ((length = reserve(buffer)) == 0) break;
+		stream.next_in = m_input + m_inputOffset;
+		stream.avail_in = m_inputLength - m_inputOffset;
+		stream.next_out = buffer;
+		stream.avail_out = length;
+		lzma_ret res = lzma_code(&stream, isInputOver ? LZMA_FINISH : LZMA_RUN);
+		m_inputOffset = m_inputLength - stream.avail_in;
+		commit(length - stream.avail_out);
+		if (res == LZMA_STREAM_END) {
+			finish("");
+			break;
+		} else if (res == LZMA_BUF_ERROR) {
+			finish("the compressed data is cut");
+			break;
+		} else if (res != LZMA_OK) {
+			finish("the compressed data is broken, liblzma error " + std::to_string(res));
+			break;
+		}
+	}
+	lzma_end(&stream);
+}
+
+void PcapInputStream::runZstd() {
+	u_char* buffer;
+	std::size_t length;
+	std::size_t hint = 1; //0 once a frame is complete and flushed
+	bool isOutputFull = false;
+
+	ZSTD_DStream* stream = ZSTD_createDStream();
+	if (stream == NULL) {
+		finish("libzstd can't be initialized");
+		return;
+	}
+	ZSTD_initDStream(stream);
+	while (true) {
+		//the frames written one after another are decompressed as a single stream
+		if (m_inputOffset == m_inputLength && !isOutputFull && !readInput()) {
+			if (!m_readError.empty()) finish(m_readError);
+			else finish(hint == 0 ? "" : "the compressed data is cut");
+			break;
+		}
+		if ((length = reserve(buffer)) == 0) break;
+		ZSTD_inBuffer input = {m_input, m_inputLength, m_inputOffset};
+		ZSTD_outBuffer output = {buffer, length, 0};
+		hint = ZSTD_decompressStream(stream, &output, &input);
+		m_inputOffset = input.pos;
+		isOutputFull = (output.pos == output.size);
+		commit(output.pos);
+		if (ZSTD_isError(hint)) {
+			finish(ZSTD_getErrorName(hint));
+			break;
+		}
+	}
+	ZSTD_freeDStream(stream);
+}
+
+bool PcapInputStream::readInput() {
+	//the bytes left undecompressed move to the start, there are few of them if any
+	if (m_inputOffset > 0) {
+		memmove(m_input, m_input + m_inputOffset, m_inputLength - m_inputOffset);
+		m_inputLength -= m_inputOffset;
+		m_inputOffset = 0;
+	}
+	ssize_t res = readFd(m_input + m_inputLength, PCAP_INPUT_STREAM_READ_SIZE - m_inputLength);
+	if (res > 0) {
+		m_inputLength += res;
+		return true;
+	}
+	if (res < 0) m_readError = strerror(errno);
+	return false;
+}
+
+ssize_t PcapInputStream::readFd(u_char* t_buffer, const std::size_t t_length) {
+	struct pollfd fds[2] = {{m_fd, POLLIN, 0}, {m_stopFd, POLLIN, 0}};
+
+	while (true) {
+		//the writer of a pipe may stay silent for long, interrupt() wakes the wait
+		if (m_isPipe) {
+			int res = poll(fds, 2, -1);
+			if (res < 0 && errno == EINTR) continue;
+			if (res < 0) return -1;
+			if (fds[1].revents != 0) return 0;
+		}
+		ssize_t res = read(m_fd, t_buffer, t_length);
+		if (res >= 0 || errno != EINTR) return res;
+	}
+}
+
+std::size_t PcapInputStream::reserve(u_char*& t_buffer) {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	uint64_t written = m_written.load(std::memory_order_relaxed);
+
+	m_condVar.wait(lock, [&]() { return m_isStopped || written - m_released < PCAP_INPUT_STREAM_RING_SIZE; });
+	if (m_isStopped) return 0;
+	t_buffer = m_ring + (written & (PCAP_INPUT_STREAM_RING_SIZE - 1));
+	//the rest of the current buffer, so the owner gets the bytes as soon as it is full
+	return std::min(PCAP_INPUT_STREAM_RING_SIZE - (written - m_released),
+					PCAP_INPUT_STREAM_BUFFER_SIZE - (written & (PCAP_INPUT_STREAM_BUFFER_SIZE - 1)));
+}
+
+void PcapInputStream::commit(const std::size_t t_length) {
+	if (t_length == 0) return;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_written.store(m_written.load(std::memory_order_relaxed) + t_length, std::memory_order_release);
+	}
+	m_condVar.notify_all();
+}
+
+void PcapInputStream::finish(const std::string& t_error) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	bool isStopped;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isFinished = true;
+		m_isBroken = !t_error.empty();
+		isStopped = m_isStopped;
+	}
+	m_condVar.notify_all();
+	//a stopped pipe reads as the end of the input, the data cut by that isn't an error
+	if (!t_error.empty() && !isStopped) {
+		logRoot.warn("%s can't be read to its end after %" PRIu64 " bytes: %s", m_name.c_str(),
+						m_written.load(std::memory_order_relaxed), t_error.c_str());
+	}
+}
+
+uint64_t PcapInputStream::waitFor(const uint64_t t_end) {
+	uint64_t written = m_written.load(std::memory_order_acquire);
+
+	if (written >= t_end) return written;
+	//the filling thread would wait for the owner to release more
+	if (t_end - m_released > PCAP_INPUT_STREAM_RING_SIZE) return written;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condVar.wait(lock, [&]() { return m_isFinished || m_isStopped || m_written.load(std::memory_order_relaxed) >= t_end; });
+	return m_written.load(std::memory_order_relaxed);
+}
+
+void PcapInputStream::release(const uint64_t t_offset) {
+	uint64_t written = m_written.load(std::memory_order_acquire);
+	uint64_t offset = std::min(t_offset, written);
+
+	//a buffer at a time, the filling thread fills no less anyway
+	if (offset < written && offset - m_released < PCAP_INPUT_STREAM_BUFFER_SIZE) return;
+	if (offset == m_released) return;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_released = offset;
+		if (m_isFinished && offset == m_written.load(std::memory_order_relaxed) && !m_isRingRemoved) {
+			m_isRingRemoved = true;
+			madvise(m_ring, PCAP_INPUT_STREAM_RING_SIZE, MADV_REMOVE);
+		}
+	}
+	m_condVar.notify_all();
+}
+
+bool PcapInputStream::isBroken() const {
+	return m_isBroken;
+}
+
+void PcapInputStream::interrupt() {
+	uint64_t value = 1;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopped = true;
+	}
+	m_condVar.notify_all();
+	while (write(m_stopFd, &value, sizeof(value)) < 0 && errno == EINTR);
+}
+
+bool PcapInputStream::isInterrupted() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_isStopped;
+}
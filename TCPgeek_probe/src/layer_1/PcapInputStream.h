@@ -0,0 +1,106 @@
+/*
+ *	PcapInputStream.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : PcapInputStream - the bytes of a pcap or pcapng file that can't be mapped, filled
+ *					by its own thread into a ring of large buffers. The compression is told by the
+ *					magic number of the input: gzip, xz and zstd are decompressed right into the
+ *					ring, a plain input is read into it. The ring is mapped twice in a row, so any
+ *					record that fits the ring is contiguous in memory and is parsed in place. The
+ *					input may be a pipe as well, stdin or a FIFO: the reads take whatever part of
+ *					a buffer the writer has given, and a full ring leaves the pipe to fill up, which
+ *					holds the writer back.
+ *
+ *	The owner thread addresses the bytes by their offsets from the start of the stream, as in a
+ *	mapped file, waits for the ones that aren't decompressed yet and releases the ones it has done
+ *	with. The filling thread waits for a free part of the ring, so a slow owner holds it back.
+ */
+
+#ifndef PCAPINPUTSTREAM_H_
+#define PCAPINPUTSTREAM_H_
+
+#include <pcap.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdint.h>
+
+#define PCAP_INPUT_STREAM_BUFFER_SIZE (4ULL * 1024 * 1024) //the filling thread publishes a buffer at most at once
+#define PCAP_INPUT_STREAM_BUFFERS 4
+#define PCAP_INPUT_STREAM_RING_SIZE (PCAP_INPUT_STREAM_BUFFER_SIZE * PCAP_INPUT_STREAM_BUFFERS) //a power of 2
+#define PCAP_INPUT_STREAM_READ_SIZE (1024 * 1024) //of the compressed input at once
+#define PCAP_INPUT_STREAM_MAGIC_LEN 6 //the longest magic number, the one of xz
+
+class PcapInputStream {
+private:
+	enum class Compression {NONE, GZIP, XZ, ZSTD};
+
+	int m_fd;
+	bool m_isPipe; //m_fd isn't a regular file, it may have nothing to read for long
+	int m_stopFd; //an eventfd, cuts a wait for the pipe short
+	std::string m_name;
+	u_char* m_ring; //PCAP_INPUT_STREAM_RING_SIZE bytes mapped twice in a row
+	u_char* m_input; //the compressed bytes read from m_fd
+	std::size_t m_inputOffset; //the first one not decompressed yet
+	std::size_t m_inputLength;
+	std::string m_readError; //empty unless reading m_fd has failed
+
+	std::mutex m_mutex;
+	std::condition_variable m_condVar; //both threads wait on it
+	std::atomic<uint64_t> m_written; //the end of the bytes the owner may read
+	uint64_t m_released; //protected by m_mutex, the bytes before it may be overwritten
+	bool m_isFinished; //protected by m_mutex, the input is over or broken
+	bool m_isBroken;
+	bool m_isStopped; //protected by m_mutex
+	bool m_isRingRemoved; //the pages of the ring are given back once the owner has read all of the stream
+	std::thread m_thread;
+
+	static Compression detect(const u_char* t_head, const std::size_t t_length);
+	void run();
+	void runPlain();
+	void runGzip();
+	void runXz();
+	void runZstd();
+	ssize_t readFd(u_char* t_buffer, const std::size_t t_length);
+	//read() that gives 0 once the stream is stopped
+	bool readInput();
+	//appends to m_input what m_fd gives, false at the end of the input or at an error
+	std::size_t reserve(u_char*& t_buffer);
+	//waits for a free part of the ring, 0 if the stream is stopped
+	void commit(const std::size_t t_length);
+	void finish(const std::string& t_error);
+	//t_error is empty at the regular end of the input
+
+public:
+	PcapInputStream(const int t_fd, const std::string& t_name);
+	//takes t_fd over and starts the filling thread, throws an exception if the ring can't be mapped
+	~PcapInputStream();
+
+	static bool isCompressed(const std::string& t_fileName);
+	static bool isCompressed(const u_char* t_head, const std::size_t t_length);
+
+	const u_char* at(const uint64_t t_offset) const {
+		return m_ring + (t_offset & (PCAP_INPUT_STREAM_RING_SIZE - 1));
+	}
+	//the bytes from t_offset to the ring size are contiguous
+	uint64_t waitFor(const uint64_t t_end);
+	//invoked from the owner thread, returns the end of the bytes it may read, less than t_end at the end
+	//of the stream or if t_end is farther from the released bytes than the ring holds
+	void release(const uint64_t t_offset);
+	//invoked from the owner thread, the bytes before t_offset won't be read anymore
+	bool isBroken() const;
+	//the input can't be decompressed or read to its end, valid once waitFor() gives less than asked
+	void interrupt();
+	//thread safe, stops the filling thread, waitFor() doesn't wait anymore
+	bool isInterrupted();
+};
+
+#endif /* PCAPINPUTSTREAM_H_ */
@@ -0,0 +1,106 @@
+/*
+ *	RuntimeSettings.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <algorithm>
+
+#include "layer_1/RuntimeSettings.h"
+
+std::atomic<const RuntimeSettings*> RuntimeSettings::s_current {nullptr};
+std::atomic<uint64_t> RuntimeSettings::s_epoch {1};
+RuntimeSettings::ReaderEpoch RuntimeSettings::s_readerEpochs[RUNTIME_SETTINGS_MAX_READERS];
+std::vector<std::pair<uint64_t, const RuntimeSettings*>> RuntimeSettings::s_retired;
+uint32_t RuntimeSettings::s_generations {0};
+
+LocalSubnets RuntimeSettings::parseLocalSubnets(const RuntimeSettings* t_previous) {
+	try {
+		return LocalSubnets(ProgramProperties::getLocalSubnetsStr(), ProgramProperties::getLocalSubnetsFile());
+	} catch (std::exception& e) {
+		if (t_previous == NULL) throw;
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.error("%s, the previous local subnets are kept", e.what());
+		return t_previous->m_localSubnets;
+	}
+}
+
+RuntimeSettings::RuntimeSettings(const RuntimeSettings* t_previous) :
+									m_knownPorts(ProgramProperties::getServicePortsStr()),
+									m_localSubnets(parseLocalSubnets(t_previous)),
+									m_granularity {ProgramProperties::getGranularity()},
+									m_deduplicationBufferSize {ProgramProperties::getDeduplicationBufferSize()},
+									m_deduplicationTimeout {ProgramProperties::getDeduplicationTimeout()},
+									m_generation {++s_generations} {
+}
+
+void RuntimeSettings::publish(const RuntimeSettings* t_settings) {
+	const RuntimeSettings* previous = s_current.exchange(t_settings);
+	//a packet that has seen this epoch or a later one reads t_settings or a newer snapshot
+	uint64_t epoch = s_epoch.fetch_add(1) + 1;
+	if (previous != NULL) s_retired.push_back(std::make_pair(epoch, previous));
+	reclaim();
+}
+
+uint32_t RuntimeSettings::reclaim() {
+	//the oldest epoch a reader is still inside of
+	uint64_t oldestEpoch = UINT64_MAX;
+	for (uint32_t reader = 0; reader < RUNTIME_SETTINGS_MAX_READERS; reader++) {
+		uint64_t readerEpoch = s_readerEpochs[reader].epoch.load();
+		if (readerEpoch != 0) oldestEpoch = std::min(oldestEpoch, readerEpoch);
+	}
+	std::vector<std::pair<uint64_t, const RuntimeSettings*>>::iterator retiredIterator = s_retired.begin();
+	while (retiredIterator != s_retired.end()) {
+		if (oldestEpoch >= retiredIterator->first) {
+			delete retiredIterator->second;
+			retiredIterator = s_retired.erase(retiredIterator);
+		} else {
+			retiredIterator++;
+		}
+	}
+	return s_retired.size();
+}
+
+void RuntimeSettings::release() {
+	for (std::size_t i = 0; i < s_retired.size(); i++) {
+		delete s_retired[i].second;
+	}
+	s_retired.clear();
+	delete s_current.exchange(nullptr);
+}
+
+SessionLocation RuntimeSettings::locateSession(const in_addr s_addr, const in_addr c_addr) const {
+	SessionLocation location = m_localSubnets.locateSession(s_addr, c_addr);
+	location.generation = m_generation;
+	return location;
+}
+
+std::size_t RuntimeSettings::getLocalSubnetsCount() const {
+	return m_localSubnets.size();
+}
+
+const Subnet* RuntimeSettings::getLocalSubnet(const uint32_t t_subnetId) const {
+	return m_localSubnets.getSubnet(t_subnetId);
+}
+
+uint32_t RuntimeSettings::getGeneration() const {
+	return m_generation;
+}
+
+unsigned long RuntimeSettings::getGranularity() const {
+	return m_granularity;
+}
+
+unsigned long RuntimeSettings::getDeduplicationBufferSize() const {
+	return m_deduplicationBufferSize;
+}
+
+unsigned long RuntimeSettings::getDeduplicationTimeout() const {
+	return m_deduplicationTimeout;
+}
@@ -0,0 +1,97 @@
+/*
+ *	RuntimeSettings.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : RuntimeSettings - immutable snapshot of the settings that the packet path reads
+ *					and that can be reloaded with SIGHUP: service ports, local subnets, granularity
+ *					and deduplication. The control thread builds a new snapshot and publishes it with
+ *					an atomic pointer swap, the capture thread never takes a lock to read it.
+ *
+ *	The old snapshot is freed with epoch based reclamation. Every publication increments the
+ *	global epoch, a reader announces the epoch it has seen when a packet starts and clears it
+ *	when the packet is done. A retired snapshot is freed once every reader is outside of a
+ *	packet or has entered one after the snapshot was replaced. Reader 0 is the capture thread,
+ *	the workers of ParallelIngest take the next ones. The control thread is the only writer,
+ *	so it may read the snapshot at any time without announcing itself.
+ */
+
+#ifndef RUNTIMESETTINGS_H_
+#define RUNTIMESETTINGS_H_
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "ProgramProperties.h"
+#include "layer_1/KnownPorts.h"
+#include "layer_1/LocalSubnets.h"
+
+#define RUNTIME_SETTINGS_MAX_READERS 64 //threads reading the snapshot on the packet path
+
+class RuntimeSettings {
+private:
+	struct alignas(64) ReaderEpoch {
+		std::atomic<uint64_t> epoch; //the epoch the reader has entered, 0 - it is between packets
+	};
+	//a cache line per reader, they are written for every packet
+
+	static std::atomic<const RuntimeSettings*> s_current;
+	static std::atomic<uint64_t> s_epoch; //incremented with every publication, starts from 1
+	static ReaderEpoch s_readerEpochs[RUNTIME_SETTINGS_MAX_READERS];
+	static std::vector<std::pair<uint64_t, const RuntimeSettings*>> s_retired;
+	//replaced snapshots with the epoch of their replacement, touched by the control thread only
+	static uint32_t s_generations; //number of snapshots built so far, touched by the control thread only
+
+	KnownPorts m_knownPorts;
+	LocalSubnets m_localSubnets;
+	unsigned long m_granularity;
+	unsigned long m_deduplicationBufferSize;
+	unsigned long m_deduplicationTimeout;
+	uint32_t m_generation; //subnet ids of SessionLocation are valid only with the snapshot of the same generation
+
+	static LocalSubnets parseLocalSubnets(const RuntimeSettings* t_previous);
+
+public:
+	RuntimeSettings(const RuntimeSettings* t_previous);
+	//takes the values from ProgramProperties, if localSubnets can't be parsed it throws exceptions
+	//when t_previous is NULL and keeps the subnets of t_previous otherwise
+
+	static const RuntimeSettings* get() {
+		return s_current.load();
+	}
+	//a reader must call it between enterPacket() and exitPacket() only
+	static void enterPacket(const uint32_t t_reader = 0) {
+		s_readerEpochs[t_reader].epoch.store(s_epoch.load(std::memory_order_relaxed));
+	}
+	static void exitPacket(const uint32_t t_reader = 0) {
+		s_readerEpochs[t_reader].epoch.store(0, std::memory_order_release);
+	}
+	static void publish(const RuntimeSettings* t_settings);
+	//invoked from the control thread, the previous snapshot is retired
+	static uint32_t reclaim();
+	//invoked from the control thread, frees the retired snapshots no reader can see anymore
+	//returns the number of snapshots that are still waiting
+	static void release();
+	//frees every snapshot when the readers are stopped
+
+	bool isKnownPort(const unsigned int t_port) const {
+		return m_knownPorts.isKnownPort(t_port);
+	}
+	SessionLocation locateSession(const in_addr s_addr, const in_addr c_addr) const;
+	std::size_t getLocalSubnetsCount() const;
+	const Subnet* getLocalSubnet(const uint32_t t_subnetId) const;
+	uint32_t getGeneration() const;
+	unsigned long getGranularity() const;
+	unsigned long getDeduplicationBufferSize() const;
+	unsigned long getDeduplicationTimeout() const;
+};
+
+#endif /* RUNTIMESETTINGS_H_ */
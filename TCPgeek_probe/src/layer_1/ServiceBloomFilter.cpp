@@ -0,0 +1,73 @@
+/*
+ *	ServiceBloomFilter.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include "layer_1/ServiceBloomFilter.h"
+
+ServiceBloomFilter::ServiceBloomFilter() : m_hashes {0} {
+}
+
+ServiceBloomFilter::ServiceBloomFilter(const std::unordered_set<uint64_t>& t_serviceKeys) : m_hashes {7} {
+	//10 bits per key with 7 hashes gives about 1% of false positives
+	std::size_t bytes = (t_serviceKeys.size() * 10 + 7) / 8;
+	if (bytes < 64) bytes = 64;
+	m_bits.assign(bytes, 0);
+	for (std::unordered_set<uint64_t>::const_iterator it = t_serviceKeys.begin(); it != t_serviceKeys.end(); ++it) {
+		add(*it);
+	}
+}
+
+ServiceBloomFilter::ServiceBloomFilter(const std::vector<uint8_t>& t_bits, const uint32_t t_hashes) :
+										m_bits {t_bits}, m_hashes {t_hashes} {
+}
+
+uint64_t ServiceBloomFilter::mix(uint64_t t_key) {
+	//splitmix64 finalizer
+	t_key += 0x9e3779b97f4a7c15ULL;
+	t_key = (t_key ^ (t_key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	t_key = (t_key ^ (t_key >> 27)) * 0x94d049bb133111ebULL;
+	return t_key ^ (t_key >> 31);
+}
+
+uint64_t ServiceBloomFilter::serviceKey(const in_addr t_serverIpRaw, const u_short t_serverPort) {
+	return ((uint64_t) ntohl(t_serverIpRaw.s_addr) << 16) | t_serverPort;
+}
+
+void ServiceBloomFilter::add(const uint64_t t_serviceKey) {
+	if (m_bits.empty()) return;
+	uint64_t hash = mix(t_serviceKey);
+	uint64_t h1 = hash & 0xffffffff, h2 = hash >> 32;
+	uint64_t bitsCount = m_bits.size() * 8;
+	for (uint32_t i = 0; i < m_hashes; i++) {
+		uint64_t bit = (h1 + i * h2) % bitsCount;
+		m_bits[bit >> 3] |= (uint8_t) (1 << (bit & 7));
+	}
+}
+
+bool ServiceBloomFilter::mayContain(const uint64_t t_serviceKey) const {
+	if (m_bits.empty()) return true; //no filter means no knowledge
+	uint64_t hash = mix(t_serviceKey);
+	uint64_t h1 = hash & 0xffffffff, h2 = hash >> 32;
+	uint64_t bitsCount = m_bits.size() * 8;
+	for (uint32_t i = 0; i < m_hashes; i++) {
+		uint64_t bit = (h1 + i * h2) % bitsCount;
+		if ((m_bits[bit >> 3] & (1 << (bit & 7))) == 0) return false;
+	}
+	return true;
+}
+
+const std::vector<uint8_t>& ServiceBloomFilter::getBits() const {
+	return m_bits;
+}
+
+uint32_t ServiceBloomFilter::getHashes() const {
+	return m_hashes;
+}
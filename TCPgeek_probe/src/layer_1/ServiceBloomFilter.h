@@ -0,0 +1,44 @@
+/*
+ *	ServiceBloomFilter.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : ServiceBloomFilter - bloom filter over server IP/port pairs stored in the footer
+ *					of the statistics segment. Tells the reader that a segment surely has no
+ *					records of the service, so the segment doesn't have to be read at all.
+ */
+
+#ifndef SERVICEBLOOMFILTER_H_
+#define SERVICEBLOOMFILTER_H_
+
+#include <vector>
+#include <unordered_set>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+class ServiceBloomFilter {
+private:
+	std::vector<uint8_t> m_bits;
+	uint32_t m_hashes;
+
+	static uint64_t mix(uint64_t t_key);
+public:
+	ServiceBloomFilter();
+	ServiceBloomFilter(const std::unordered_set<uint64_t>& t_serviceKeys);
+	//sizes the filter for ~1% false positives over the given set of keys and fills it
+	ServiceBloomFilter(const std::vector<uint8_t>& t_bits, const uint32_t t_hashes);
+	//restores the filter read from a segment footer
+
+	static uint64_t serviceKey(const in_addr t_serverIpRaw, const u_short t_serverPort);
+	void add(const uint64_t t_serviceKey);
+	bool mayContain(const uint64_t t_serviceKey) const;
+	const std::vector<uint8_t>& getBits() const;
+	uint32_t getHashes() const;
+};
+
+#endif /* SERVICEBLOOMFILTER_H_ */
@@ -0,0 +1,76 @@
+/*
+ *	ServiceHistogram.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <inttypes.h>
+
+#include "layer_1/ServiceHistogram.h"
+
+ServiceHistogram::ServiceHistogram() : m_count {0}, m_sum {0}, m_max {0} {
+	memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+uint64_t ServiceHistogram::getBucketHighestValue(const std::size_t t_index) {
+	std::size_t magnitude = t_index / SERVICE_HISTOGRAM_SUB_BUCKETS;
+	uint64_t subBucket = t_index % SERVICE_HISTOGRAM_SUB_BUCKETS;
+	if (magnitude == 0) return subBucket;
+	int shift = magnitude - 1;
+	return ((SERVICE_HISTOGRAM_SUB_BUCKETS + subBucket + 1) << shift) - 1;
+}
+
+void ServiceHistogram::merge(const ServiceHistogram& t_other) {
+	for (std::size_t i = 0; i < SERVICE_HISTOGRAM_BUCKETS; i++) {
+		m_buckets[i] += t_other.m_buckets[i];
+	}
+	m_count += t_other.m_count;
+	m_sum += t_other.m_sum;
+	if (t_other.m_max > m_max) m_max = t_other.m_max;
+}
+
+uint64_t ServiceHistogram::getQuantile(const double t_quantile) const {
+	if (m_count == 0) return 0;
+	uint64_t rank = (uint64_t) std::ceil(t_quantile * m_count);
+	if (rank < 1) rank = 1;
+	uint64_t seen = 0;
+	for (std::size_t i = 0; i < SERVICE_HISTOGRAM_BUCKETS; i++) {
+		seen += m_buckets[i];
+		if (seen >= rank) {
+			return (getBucketIndex(m_max) == i) ? m_max : getBucketHighestValue(i);
+		}
+	}
+	return m_max;
+}
+
+void ServiceHistogram::appendBuckets(std::string& t_str) const {
+	char bucketStr[32];
+	bool isFirst = true;
+	for (std::size_t i = 0; i < SERVICE_HISTOGRAM_BUCKETS; i++) {
+		if (m_buckets[i] == 0) continue;
+		sprintf(bucketStr, isFirst ? "%zu:%" PRIu32 : ",%zu:%" PRIu32, i, m_buckets[i]);
+		t_str.append(bucketStr);
+		isFirst = false;
+	}
+}
+
+uint64_t ServiceHistogram::getCount() const {
+	return m_count;
+}
+
+uint64_t ServiceHistogram::getSum() const {
+	return m_sum;
+}
+
+uint64_t ServiceHistogram::getMax() const {
+	return m_max;
+}
@@ -0,0 +1,66 @@
+/*
+ *	ServiceHistogram.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : ServiceHistogram - compact log-linear histogram of microseconds for the per service
+ *					latencies. Every power of two is split into 8 linear sub-buckets, so a value is kept
+ *					with 12.5% precision in 240 fixed buckets (values from 71 minutes up share the last
+ *					one). The bucket bounds never change, so histograms of different probes and
+ *					intervals are merged by adding the counts of the same bucket index:
+ *					index = value for values below 8, otherwise with m = the highest set bit of value
+ *					index = (m - 2) * 8 + ((value >> (m - 3)) & 7)
+ */
+
+#ifndef SERVICEHISTOGRAM_H_
+#define SERVICEHISTOGRAM_H_
+
+#include <string>
+#include <stdint.h>
+
+#define SERVICE_HISTOGRAM_SUB_BUCKET_BITS 3
+#define SERVICE_HISTOGRAM_SUB_BUCKETS (1 << SERVICE_HISTOGRAM_SUB_BUCKET_BITS)
+#define SERVICE_HISTOGRAM_VALUE_BITS 32
+#define SERVICE_HISTOGRAM_BUCKETS ((SERVICE_HISTOGRAM_VALUE_BITS - SERVICE_HISTOGRAM_SUB_BUCKET_BITS + 1) * SERVICE_HISTOGRAM_SUB_BUCKETS)
+
+class ServiceHistogram {
+private:
+	uint32_t m_buckets[SERVICE_HISTOGRAM_BUCKETS];
+	uint64_t m_count;
+	uint64_t m_sum;
+	uint64_t m_max;
+
+	static uint64_t getBucketHighestValue(const std::size_t t_index);
+
+public:
+	ServiceHistogram();
+
+	static std::size_t getBucketIndex(uint64_t t_value) {
+		if (t_value < SERVICE_HISTOGRAM_SUB_BUCKETS) return t_value;
+		if (t_value >> SERVICE_HISTOGRAM_VALUE_BITS) t_value = (1ULL << SERVICE_HISTOGRAM_VALUE_BITS) - 1;
+		int shift = 63 - __builtin_clzll(t_value) - SERVICE_HISTOGRAM_SUB_BUCKET_BITS;
+		return (shift + 1) * SERVICE_HISTOGRAM_SUB_BUCKETS + ((t_value >> shift) & (SERVICE_HISTOGRAM_SUB_BUCKETS - 1));
+	}
+
+	void record(const uint64_t t_value) {
+		m_buckets[getBucketIndex(t_value)]++;
+		m_count++;
+		m_sum += t_value;
+		if (t_value > m_max) m_max = t_value;
+	}
+	void merge(const ServiceHistogram& t_other);
+	uint64_t getQuantile(const double t_quantile) const;
+	//the highest value of the bucket the quantile falls in, the exact max if it is the same bucket
+	void appendBuckets(std::string& t_str) const;
+	//appends non-empty buckets as 'index:count,index:count'
+	uint64_t getCount() const;
+	uint64_t getSum() const;
+	uint64_t getMax() const;
+};
+
+#endif /* SERVICEHISTOGRAM_H_ */
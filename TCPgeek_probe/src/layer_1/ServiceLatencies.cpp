@@ -0,0 +1,104 @@
+/*
+ *	ServiceLatencies.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <inttypes.h>
+
+#include "layer_1/ServiceLatencies.h"
+
+ServiceLatencies* ServiceLatencies::s_recording {NULL};
+
+ServiceLatencies::ServiceLatencies(const std::size_t t_maxServices) : m_maxServices {t_maxServices} {
+	m_overflow.serverIp.s_addr = 0;
+	m_overflow.serverPort = 0;
+}
+
+ServiceLatencyEntry& ServiceLatencies::getEntry(const TcpUdpSessionKey& t_sessionKey) {
+	uint64_t serviceKey = ((uint64_t) t_sessionKey.m_serverIpRaw.s_addr << 16) | t_sessionKey.m_serverPort;
+	std::unordered_map<uint64_t, ServiceLatencyEntry>::iterator serviceIterator = m_services.find(serviceKey);
+	if (serviceIterator != m_services.end()) return serviceIterator->second;
+	if (m_services.size() >= m_maxServices) return m_overflow;
+	ServiceLatencyEntry& entry = m_services[serviceKey];
+	entry.serverIp = t_sessionKey.m_serverIpRaw;
+	entry.serverPort = t_sessionKey.m_serverPort;
+	return entry;
+}
+
+ServiceLatencies* ServiceLatencies::swapRecording(ServiceLatencies* t_next) {
+	ServiceLatencies* previous = s_recording;
+	s_recording = t_next;
+	return previous;
+}
+
+const char* ServiceLatencies::getMetricName(const int t_metric) {
+	switch ((ServiceMetric) t_metric) {
+		case ServiceMetric::OPERATION: return "operation";
+		case ServiceMetric::SERVER_THINK_TIME: return "think";
+		case ServiceMetric::RTT: return "rtt";
+		case ServiceMetric::CONNECT_TIME: return "connect";
+		default: return "unknown";
+	}
+}
+
+void ServiceLatencies::format(const time_t t_intervalEpoch, std::string& t_payload) const {
+	char timestampStr[64];
+	char serverIpStr[INET_ADDRSTRLEN];
+	char rowStr[SERVICE_LATENCIES_ROW_MAX_SIZE];
+	struct tm timestamp_tm;
+
+	gmtime_r(&t_intervalEpoch, &timestamp_tm);
+	strftime(timestampStr, sizeof timestampStr, "%Y-%m-%d %H:%M:%S", &timestamp_tm);
+	std::vector<const ServiceLatencyEntry*> entries;
+	entries.reserve(m_services.size() + 1);
+	for (std::unordered_map<uint64_t, ServiceLatencyEntry>::const_iterator it = m_services.begin(); it != m_services.end(); it++) {
+		entries.push_back(&it->second);
+	}
+	std::sort(entries.begin(), entries.end(), [](const ServiceLatencyEntry* a, const ServiceLatencyEntry* b) {
+		if (a->serverIp.s_addr != b->serverIp.s_addr) return ntohl(a->serverIp.s_addr) < ntohl(b->serverIp.s_addr);
+		return a->serverPort < b->serverPort;
+	});
+	entries.push_back(&m_overflow);
+	for (std::size_t i = 0; i < entries.size(); i++) {
+		const ServiceLatencyEntry& entry = *entries[i];
+		if (&entry == &m_overflow) {
+			strcpy(serverIpStr, "*");
+		} else {
+			inet_ntop(AF_INET, &entry.serverIp, serverIpStr, INET_ADDRSTRLEN);
+		}
+		for (int metric = 0; metric < (int) ServiceMetric::COUNT; metric++) {
+			const ServiceHistogram& histogram = entry.histograms[metric];
+			if (histogram.getCount() == 0) continue;
+			snprintf(rowStr, sizeof rowStr, "%s	%s	%" PRIu16 "	%s" // Timestamp, Server IP, server port, metric
+					"	%" PRIu64 "	%" PRIu64			// Samples, sum of the values
+					"	%" PRIu64 "	%" PRIu64 "	%" PRIu64 "	%" PRIu64 "	%" PRIu64 "	", // p50, p90, p95, p99, max in microseconds
+					timestampStr, serverIpStr, entry.serverPort, getMetricName(metric),
+					histogram.getCount(), histogram.getSum(),
+					histogram.getQuantile(0.5), histogram.getQuantile(0.9), histogram.getQuantile(0.95),
+					histogram.getQuantile(0.99), histogram.getMax());
+			t_payload.append(rowStr);
+			histogram.appendBuckets(t_payload); // Buckets to merge intervals and probes
+			t_payload.push_back('\n');
+		}
+	}
+}
+
+void ServiceLatencies::clear() {
+	m_services.clear();
+	m_overflow = ServiceLatencyEntry();
+}
+
+std::size_t ServiceLatencies::size() const {
+	return m_services.size();
+}
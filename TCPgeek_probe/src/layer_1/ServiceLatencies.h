@@ -0,0 +1,75 @@
+/*
+ *	ServiceLatencies.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : ServiceLatencies - latency histograms of every service (server IP, server port) seen
+ *					in the interval: operation time (from the request start to the response end), server
+ *					think time, handshake RTT and connect time (from the first SYN to SYN/ACK, including
+ *					SYN retransmissions). The TCP sessions record into the instance published with
+ *					swapRecording(), which is guarded by the mutex of TcpSessions, the control thread
+ *					swaps in an empty instance at the end of the interval and writes the full one out.
+ *					Services above the limit share the '*' entry, so no sample is lost.
+ */
+
+#ifndef SERVICELATENCIES_H_
+#define SERVICELATENCIES_H_
+
+#define SERVICE_LATENCIES_EXT "latency"
+#define SERVICE_LATENCIES_ROW_MAX_SIZE 256
+
+#include <unordered_map>
+#include <string>
+#include <ctime>
+#include <stdint.h>
+
+#include "layer_1/ServiceHistogram.h"
+#include "layer_1/sessions/TcpUdpSessionKey.h"
+
+enum class ServiceMetric : uint8_t {
+	OPERATION = 0,
+	SERVER_THINK_TIME,
+	RTT,
+	CONNECT_TIME,
+	COUNT
+};
+
+struct ServiceLatencyEntry {
+	in_addr serverIp;
+	u_short serverPort;
+	ServiceHistogram histograms[(int) ServiceMetric::COUNT];
+};
+
+class ServiceLatencies {
+private:
+	static ServiceLatencies* s_recording; //guarded by the mutex of TcpSessions, NULL - nothing is recorded
+	std::unordered_map<uint64_t, ServiceLatencyEntry> m_services;
+	ServiceLatencyEntry m_overflow; //services above m_maxServices
+	std::size_t m_maxServices;
+
+	ServiceLatencyEntry& getEntry(const TcpUdpSessionKey& t_sessionKey);
+	static const char* getMetricName(const int t_metric);
+
+public:
+	ServiceLatencies(const std::size_t t_maxServices);
+
+	static void record(const TcpUdpSessionKey& t_sessionKey, const ServiceMetric t_metric, const uint64_t t_valueUsec) {
+		//might be invoked only with the mutex of TcpSessions locked
+		if (s_recording != NULL) {
+			s_recording->getEntry(t_sessionKey).histograms[(int) t_metric].record(t_valueUsec);
+		}
+	}
+	static ServiceLatencies* swapRecording(ServiceLatencies* t_next);
+	//might be invoked only with the mutex of TcpSessions locked, returns the previous instance
+	void format(const time_t t_intervalEpoch, std::string& t_payload) const;
+	//appends a TSV line per service and metric with samples to t_payload
+	void clear();
+	std::size_t size() const;
+};
+
+#endif /* SERVICELATENCIES_H_ */
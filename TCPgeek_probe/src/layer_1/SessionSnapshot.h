@@ -0,0 +1,62 @@
+/*
+ *	SessionSnapshot.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : On-disk layout of the session table snapshot that lets a restarted probe continue
+ *					the sessions of the previous instance. All integers are in host byte order, the file
+ *					is only meant to be read on the same host by the same build of the probe.
+ *
+ *	+------------------------------+
+ *	| SessionSnapshotHeader        |  at offset 0, complete = 1 only after everything else is written
+ *	+------------------------------+
+ *	| SessionSnapshotRecordHeader  |  one record per session
+ *	| state of the session         |  TcpSession::saveState() or UdpSession::saveState()
+ *	+------------------------------+
+ *	| ...                          |
+ *	+------------------------------+
+ *
+ *	The snapshot is written to <file>.tmp and renamed over <file>, so the file is either the previous
+ *	snapshot or the new one. The state is serialized field by field, any change of the serialized
+ *	fields of a session class must increase SESSION_SNAPSHOT_VERSION, snapshots of other versions
+ *	are ignored and the probe starts cold.
+ */
+
+#ifndef SESSIONSNAPSHOT_H_
+#define SESSIONSNAPSHOT_H_
+
+#include <stdint.h>
+
+#define SESSION_SNAPSHOT_MAGIC "TGSNAP01"
+#define SESSION_SNAPSHOT_VERSION 1
+#define SESSION_SNAPSHOT_SHUTDOWN 0	//taken at shutdown, the interval counters were not reported yet
+#define SESSION_SNAPSHOT_PERIODIC 1	//taken on the run, the interval counters might be reported after it
+
+struct SessionSnapshotHeader {
+	char		magic[8];			//SESSION_SNAPSHOT_MAGIC
+	uint32_t	version;			//SESSION_SNAPSHOT_VERSION
+	uint32_t	headerSize;			//sizeof(SessionSnapshotHeader)
+	int64_t		createdEpoch;		//UTC epoch seconds when the snapshot was taken
+	uint64_t	dataSize;			//bytes of records after the header
+	uint64_t	tcpSessions;
+	uint64_t	udpSessions;
+	uint32_t	kind;				//SESSION_SNAPSHOT_SHUTDOWN or SESSION_SNAPSHOT_PERIODIC
+	uint32_t	complete;			//1 when the snapshot is written entirely
+	uint64_t	reserved;
+};
+
+struct SessionSnapshotRecordHeader {
+	uint32_t	size;				//bytes of the session state after this header
+	uint8_t		ipProtocol;			//IPPROTO_TCP or IPPROTO_UDP
+	uint8_t		reserved[3];
+};
+
+static_assert(sizeof(SessionSnapshotHeader) == 64, "SessionSnapshotHeader layout changed");
+static_assert(sizeof(SessionSnapshotRecordHeader) == 8, "SessionSnapshotRecordHeader layout changed");
+
+#endif /* SESSIONSNAPSHOT_H_ */
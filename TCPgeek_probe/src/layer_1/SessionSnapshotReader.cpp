@@ -0,0 +1,90 @@
+/*
+ *	SessionSnapshotReader.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "layer_1/SessionSnapshotReader.h"
+
+SessionSnapshotReader::SessionSnapshotReader() : m_data {NULL}, m_size {0}, m_offset {0}, m_recordEnd {0} {
+	memset(&m_header, 0, sizeof(m_header));
+}
+
+SessionSnapshotReader::~SessionSnapshotReader() {
+	close();
+}
+
+void SessionSnapshotReader::close() {
+	if (m_data != NULL) munmap((void*) m_data, m_size);
+	m_data = NULL;
+	m_size = 0;
+	m_offset = 0;
+	m_recordEnd = 0;
+}
+
+bool SessionSnapshotReader::open(const std::string& t_fileName) {
+	struct stat fileStat;
+
+	close();
+	int fd = ::open(t_fileName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) return false;
+	if (fstat(fd, &fileStat) != 0 || (uint64_t) fileStat.st_size < sizeof(SessionSnapshotHeader)) {
+		::close(fd);
+		return false;
+	}
+	void* data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); //the mapping keeps the file
+	if (data == MAP_FAILED) return false;
+	m_data = (const char*) data;
+	m_size = fileStat.st_size;
+	//the records are read once from the start to the end
+	madvise((void*) m_data, m_size, MADV_SEQUENTIAL);
+
+	memcpy(&m_header, m_data, sizeof(m_header));
+	if (memcmp(m_header.magic, SESSION_SNAPSHOT_MAGIC, sizeof(m_header.magic)) != 0 ||
+			m_header.version != SESSION_SNAPSHOT_VERSION || m_header.headerSize != sizeof(m_header) ||
+			m_header.complete != 1 || m_header.dataSize != m_size - sizeof(m_header)) {
+		close();
+		return false;
+	}
+	m_offset = sizeof(m_header);
+	m_recordEnd = m_offset;
+	return true;
+}
+
+const SessionSnapshotHeader& SessionSnapshotReader::getHeader() const {
+	return m_header;
+}
+
+bool SessionSnapshotReader::nextRecord(uint8_t& t_ipProtocol) {
+	SessionSnapshotRecordHeader recordHeader;
+
+	//whatever is left of the previous record is skipped
+	m_offset = m_recordEnd;
+	if (m_data == NULL || m_offset + sizeof(recordHeader) > m_size) return false;
+	memcpy(&recordHeader, m_data + m_offset, sizeof(recordHeader));
+	m_offset += sizeof(recordHeader);
+	if (m_offset + recordHeader.size > m_size) return false;
+	m_recordEnd = m_offset + recordHeader.size;
+	t_ipProtocol = recordHeader.ipProtocol;
+	return true;
+}
+
+bool SessionSnapshotReader::getBytes(void* t_data, const uint64_t t_size) {
+	if (m_offset + t_size > m_recordEnd) return false;
+	memcpy(t_data, m_data + m_offset, t_size);
+	m_offset += t_size;
+	return true;
+}
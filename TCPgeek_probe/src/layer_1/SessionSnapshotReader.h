@@ -0,0 +1,48 @@
+/*
+ *	SessionSnapshotReader.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : SessionSnapshotReader - maps the session table snapshot read-only and walks its
+ *					records. Reads never cross the end of the current record, so a damaged record
+ *					makes get() fail instead of reading the next one.
+ */
+
+#ifndef SESSIONSNAPSHOTREADER_H_
+#define SESSIONSNAPSHOTREADER_H_
+
+#include <string>
+#include <stdint.h>
+
+#include "layer_1/SessionSnapshot.h"
+
+class SessionSnapshotReader {
+private:
+	const char* m_data;
+	uint64_t m_size;
+	uint64_t m_offset;
+	uint64_t m_recordEnd; //offset right after the current record
+	SessionSnapshotHeader m_header;
+
+public:
+	SessionSnapshotReader();
+	~SessionSnapshotReader();
+
+	bool open(const std::string& t_fileName);
+	//returns false if there is no file or it is not a complete snapshot of this version
+	void close();
+	const SessionSnapshotHeader& getHeader() const;
+	bool nextRecord(uint8_t& t_ipProtocol);
+	//moves to the next record, returns false after the last one
+	bool getBytes(void* t_data, const uint64_t t_size);
+	template <typename T> bool get(T& t_value) {
+		return getBytes(&t_value, sizeof(T));
+	}
+};
+
+#endif /* SESSIONSNAPSHOTREADER_H_ */
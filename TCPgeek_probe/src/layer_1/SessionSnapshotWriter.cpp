@@ -0,0 +1,142 @@
+/*
+ *	SessionSnapshotWriter.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <cstddef>
+#include <ctime>
+#include <inttypes.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "layer_1/SessionSnapshotWriter.h"
+
+SessionSnapshotWriter::SessionSnapshotWriter(const std::string& t_fileName) :
+												m_fileName {t_fileName},
+												m_tempFileName {t_fileName + ".tmp"},
+												m_data {NULL},
+												m_mappedSize {0},
+												m_offset {sizeof(SessionSnapshotHeader)},
+												m_recordOffset {0},
+												m_failed {false} {
+	m_fd = open(m_tempFileName.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (m_fd == -1) {
+		throw std::runtime_error("Can't create session snapshot " + m_tempFileName + ": " + strerror(errno));
+	}
+	if (!reserve(0)) {
+		std::string error = "Can't map session snapshot " + m_tempFileName + ": " + strerror(errno);
+		close(m_fd);
+		unlink(m_tempFileName.c_str());
+		throw std::runtime_error(error);
+	}
+}
+
+SessionSnapshotWriter::~SessionSnapshotWriter() {
+	if (m_data != NULL) munmap(m_data, m_mappedSize);
+	if (m_fd != -1) {
+		close(m_fd);
+		unlink(m_tempFileName.c_str());
+	}
+}
+
+bool SessionSnapshotWriter::reserve(const uint64_t t_bytes) {
+	if (m_failed) return false;
+	if (m_offset + t_bytes <= m_mappedSize) return true;
+
+	uint64_t newSize = m_mappedSize;
+	while (newSize < m_offset + t_bytes) newSize += SESSION_SNAPSHOT_GROW_BYTES;
+	//ftruncate doesn't allocate the blocks, a full disk shows up as SIGBUS on the first touch,
+	//so the space is allocated explicitly
+	int res = posix_fallocate(m_fd, m_mappedSize, newSize - m_mappedSize);
+	if (res != 0) {
+		errno = res;
+		m_failed = true;
+		return false;
+	}
+	void* data;
+	if (m_data == NULL) {
+		data = mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	} else {
+		data = mremap(m_data, m_mappedSize, newSize, MREMAP_MAYMOVE);
+	}
+	if (data == MAP_FAILED) {
+		m_failed = true;
+		return false;
+	}
+	m_data = (char*) data;
+	m_mappedSize = newSize;
+	return true;
+}
+
+void SessionSnapshotWriter::putBytes(const void* t_data, const uint64_t t_size) {
+	if (!reserve(t_size)) return;
+	memcpy(m_data + m_offset, t_data, t_size);
+	m_offset += t_size;
+}
+
+void SessionSnapshotWriter::beginRecord(const uint8_t t_ipProtocol) {
+	SessionSnapshotRecordHeader recordHeader;
+	memset(&recordHeader, 0, sizeof(recordHeader));
+	recordHeader.ipProtocol = t_ipProtocol;
+	m_recordOffset = m_offset;
+	put(recordHeader);
+}
+
+void SessionSnapshotWriter::endRecord() {
+	if (m_failed) return;
+	uint32_t recordSize = m_offset - m_recordOffset - sizeof(SessionSnapshotRecordHeader);
+	memcpy(m_data + m_recordOffset + offsetof(SessionSnapshotRecordHeader, size), &recordSize, sizeof(recordSize));
+}
+
+bool SessionSnapshotWriter::commit(const uint32_t t_kind, const uint64_t t_tcpSessions, const uint64_t t_udpSessions) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	SessionSnapshotHeader header;
+
+	if (m_failed) {
+		logRoot.error("Session snapshot %s is incomplete, the file couldn't grow beyond %" PRIu64 " bytes",
+						m_tempFileName.c_str(), m_mappedSize);
+		return false;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SESSION_SNAPSHOT_MAGIC, sizeof(header.magic));
+	header.version = SESSION_SNAPSHOT_VERSION;
+	header.headerSize = sizeof(header);
+	header.createdEpoch = std::time(nullptr);
+	header.dataSize = m_offset - sizeof(header);
+	header.tcpSessions = t_tcpSessions;
+	header.udpSessions = t_udpSessions;
+	header.kind = t_kind;
+	header.complete = 1;
+	memcpy(m_data, &header, sizeof(header));
+
+	munmap(m_data, m_mappedSize);
+	m_data = NULL;
+	//the file must be durable before it replaces the previous snapshot
+	if (ftruncate(m_fd, m_offset) != 0 || fdatasync(m_fd) != 0) {
+		logRoot.error("Can't sync session snapshot %s: %s", m_tempFileName.c_str(), strerror(errno));
+		return false;
+	}
+	if (rename(m_tempFileName.c_str(), m_fileName.c_str()) != 0) {
+		logRoot.error("Can't rename session snapshot to %s: %s", m_fileName.c_str(), strerror(errno));
+		return false;
+	}
+	close(m_fd);
+	m_fd = -1;
+	return true;
+}
+
+uint64_t SessionSnapshotWriter::getSize() const {
+	return m_offset;
+}
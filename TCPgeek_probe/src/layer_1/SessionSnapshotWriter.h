@@ -0,0 +1,56 @@
+/*
+ *	SessionSnapshotWriter.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : SessionSnapshotWriter - writes the session table snapshot into a memory mapped
+ *					temporary file that grows by SESSION_SNAPSHOT_GROW_BYTES, so serializing a
+ *					session is a memcpy to the page cache without a system call.
+ *					commit() publishes the file with a rename, otherwise it is removed.
+ */
+
+#ifndef SESSIONSNAPSHOTWRITER_H_
+#define SESSIONSNAPSHOTWRITER_H_
+
+#include <string>
+#include <stdint.h>
+
+#include "layer_1/SessionSnapshot.h"
+
+#define SESSION_SNAPSHOT_GROW_BYTES (16 * 1024 * 1024)
+
+class SessionSnapshotWriter {
+private:
+	int m_fd;
+	std::string m_fileName, m_tempFileName;
+	char* m_data;
+	uint64_t m_mappedSize;
+	uint64_t m_offset;
+	uint64_t m_recordOffset; //offset of the header of the record being written
+	bool m_failed; //the file couldn't grow, everything written after that is ignored
+
+	bool reserve(const uint64_t t_bytes);
+
+public:
+	SessionSnapshotWriter(const std::string& t_fileName);
+	//throws exceptions if the temporary file can't be created
+	~SessionSnapshotWriter();
+	//removes the temporary file unless the snapshot was committed
+
+	void putBytes(const void* t_data, const uint64_t t_size);
+	template <typename T> void put(const T& t_value) {
+		putBytes(&t_value, sizeof(T));
+	}
+	void beginRecord(const uint8_t t_ipProtocol);
+	void endRecord();
+	bool commit(const uint32_t t_kind, const uint64_t t_tcpSessions, const uint64_t t_udpSessions);
+	//writes the header, syncs the file and renames it over the previous snapshot
+	uint64_t getSize() const;
+};
+
+#endif /* SESSIONSNAPSHOTWRITER_H_ */
@@ -2,7 +2,7 @@
  *	Sniffer.cpp
  *
  *  Created on: Mar 28, 2022
- *	Last modified on: June 19, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -28,13 +28,64 @@ Sniffer::Sniffer() {
 		logRoot.fatal("Exception when initializing statistics writer:\n     %s\nExitting.", e.what());
 		exit(EXIT_FAILURE);
 	}
+	m_statFeed = NULL;
+	if (!ProgramProperties::getStatFeedFile().empty()) {
+		try {
+			m_statFeed = new StatFeed(ProgramProperties::getStatFeedFile(), ProgramProperties::getStatFeedCapacity(),
+										ProgramProperties::getStatisticsOwnership());
+		} catch (std::exception& e) {
+			logRoot.fatal("Exception when initializing statistics feed:\n     %s\nExitting.", e.what());
+			exit(EXIT_FAILURE);
+		}
+	}
+	m_metricsServer = NULL;
+	if (ProgramProperties::getMetricsPort() != 0) {
+		try {
+			m_metricsServer = new MetricsServer(m_metrics, ProgramProperties::getMetricsAddress(), ProgramProperties::getMetricsPort());
+		} catch (std::exception& e) {
+			logRoot.fatal("Exception when initializing metrics server:\n     %s\nExitting.", e.what());
+			exit(EXIT_FAILURE);
+		}
+	}
 
 	//****GETTING READY FOR CAPTURING
 
 	char errbuf[PCAP_ERRBUF_SIZE];
 	//try open source as a file first
 	m_isOffline = true;
-	m_handle = pcap_open_offline(ProgramProperties::getSource().c_str(), errbuf);
+	m_isPipe = false;
+	m_fileMerger = NULL;
+	m_isFileReadBroken = false;
+	m_interfaceId = 0;
+	//the files of a directory or a glob pattern are replayed as one stream
+	std::vector<std::string> sourceFiles = PcapFileMerger::expandSource(ProgramProperties::getSource());
+	//libpcap would merge the interfaces of a pcapng file into one, so its blocks are parsed here,
+	//it can't read a compressed file at all and reads a pipe with small stdio reads;
+	//a pipe is checked first, as peeking at it would take its bytes away
+	if (sourceFiles.empty() && (OfflinePcapReader::isPipe(ProgramProperties::getSource()) ||
+									OfflinePcapReader::isPcapng(ProgramProperties::getSource()) ||
+									PcapInputStream::isCompressed(ProgramProperties::getSource()))) {
+		if (OfflinePcapReader::isPipe(ProgramProperties::getSource())) {
+			logRoot.info("Waiting for the pcap stream from %s", ProgramProperties::getSource().c_str());
+			m_isPipe = true;
+		}
+		sourceFiles.push_back(ProgramProperties::getSource());
+	}
+	if (!sourceFiles.empty()) {
+		try {
+			m_fileMerger = new PcapFileMerger(sourceFiles);
+		} catch (std::exception& e) {
+			logRoot.fatal("Exception when opening %s:\n     %s\nExitting.", ProgramProperties::getSource().c_str(), e.what());
+			exit(EXIT_FAILURE);
+		}
+		if (m_fileMerger->getFilesCount() > 1) {
+			logRoot.info("%zu files of %s are merged by the packet time", m_fileMerger->getFilesCount(), ProgramProperties::getSource().c_str());
+		}
+		//the handle only compiles the filter for the link type of the first file
+		m_handle = pcap_open_dead(m_fileMerger->getLinkType(), MAX_PACKET_LEN);
+	} else {
+		m_handle = pcap_open_offline(ProgramProperties::getSource().c_str(), errbuf);
+	}
 	if (m_handle == NULL) {
 		// open source as inbound device for live capturing
 		// no promiscuous mode, read buffer timeout is 100ms
@@ -72,17 +123,44 @@ Sniffer::Sniffer() {
 			exit(EXIT_FAILURE);
 		}
 	}
+	m_filterExpression = ProgramProperties::getBpfExpression();
+	m_capturePrefilter = NULL;
+	m_kernelFilteredFrames = 0;
+	if (ProgramProperties::getKernelPrefilter() != CAPTURE_PREFILTER_OFF) {
+		try {
+			m_capturePrefilter = new CapturePrefilter(ProgramProperties::getKernelPrefilter(), ProgramProperties::getBpfExpression(),
+														pcap_datalink(m_handle) == DLT_EN10MB);
+		} catch (std::exception& e) {
+			logRoot.fatal("Exception when building the capture prefilter:\n     %s\nExitting.", e.what());
+			pcap_close(m_handle);
+			exit(EXIT_FAILURE);
+		}
+		m_filterExpression = m_capturePrefilter->getExpression();
+		if (!m_isOffline) m_capturePrefilter->attachInterface(ProgramProperties::getSource());
+	}
 	//compiling bpf filter string
-	if (pcap_compile(m_handle, &m_bpf, ProgramProperties::getBpfExpression().c_str(), 1, PCAP_NETMASK_UNKNOWN) == PCAP_ERROR) {
+	if (pcap_compile(m_handle, &m_bpf, m_filterExpression.c_str(), 1, PCAP_NETMASK_UNKNOWN) == PCAP_ERROR) {
 		logRoot.fatal("Couldn't parse filter %s: %s\n",
-						ProgramProperties::getBpfExpression().c_str(), pcap_geterr(m_handle));
+						m_filterExpression.c_str(), pcap_geterr(m_handle));
 		pcap_close(m_handle);
 		exit(EXIT_FAILURE);
 	}
-	//applying the filter
-	if (pcap_setfilter(m_handle, &m_bpf) == PCAP_ERROR) {
+	if (m_capturePrefilter != NULL) {
+		logRoot.info("Capture filter of %u instructions: %s", m_bpf.bf_len, m_filterExpression.c_str());
+	}
+	//applying the filter, the readers of the files compile it for the link type of every interface
+	if (m_fileMerger != NULL) {
+		try {
+			m_fileMerger->setFilter(m_filterExpression);
+		} catch (std::exception& e) {
+			logRoot.fatal("Couldn't install filter %s: %s\n", m_filterExpression.c_str(), e.what());
+			pcap_freecode(&m_bpf);
+			pcap_close(m_handle);
+			exit(EXIT_FAILURE);
+		}
+	} else if (pcap_setfilter(m_handle, &m_bpf) == PCAP_ERROR) {
 		logRoot.fatal("Couldn't install filter %s: %s\n",
-				ProgramProperties::getBpfExpression().c_str(), pcap_geterr(m_handle));
+				m_filterExpression.c_str(), pcap_geterr(m_handle));
 		pcap_freecode(&m_bpf);
 		pcap_close(m_handle);
 		exit(EXIT_FAILURE);
@@ -95,14 +173,32 @@ Sniffer::Sniffer() {
 		pcap_close(m_handle);
 		exit(EXIT_FAILURE);
 	}
+	m_flowOffload = NULL;
+	m_kernelAggregatedPackets = 0;
+	if (ProgramProperties::getKernelPreaggregationFlows() > 0) {
+		if (m_isOffline) {
+			logRoot.info("kernelPreaggregationFlows is ignored for a pcap file");
+		} else {
+			try {
+				m_flowOffload = new FlowOffload(m_handle, m_linkType, m_filterExpression,
+												ProgramProperties::getKernelPreaggregationFlows(),
+												ProgramProperties::getKernelPreaggregationSampling());
+				logRoot.info("Up to %lu TCP flows are pre-aggregated in the kernel, 1 of %lu of their pure ACKs is captured",
+								ProgramProperties::getKernelPreaggregationFlows(), ProgramProperties::getKernelPreaggregationSampling());
+			} catch (std::exception& e) {
+				//the filter of pcap is still attached, so the capture goes on as usual
+				logRoot.warn("Kernel pre-aggregation is disabled: %s", e.what());
+			}
+		}
+	}
 
 	m_pcapStat = (pcap_stat*) malloc(sizeof(struct pcap_stat));
 
 	//****INITIALIZING OTHER MEMEBERS****
 
-	m_knownPorts = new KnownPorts();
 	try {
-		m_localSubnets = new LocalSubnets();
+		//service ports and local subnets are read by the packet path through this snapshot
+		RuntimeSettings::publish(new RuntimeSettings(NULL));
 	} catch (std::exception& e) {
 		logRoot.fatal("Exception when initializing local subnets:\n     %s\nExitting.", e.what());
 		pcap_freecode(&m_bpf);
@@ -112,52 +208,120 @@ Sniffer::Sniffer() {
 	m_sessionsStatQueue = new SafeQueue<StatRecord>();
 	m_tcpSessions = new TcpSessions(m_sessionsStatQueue);
 	m_udpSessions = new UdpSessions(m_sessionsStatQueue);
-	m_debugPacketInfo = new char[256];
-	log4cpp::Category& logPacket = log4cpp::Category::getInstance(std::string("packetLog"));
-	if (logPacket.getPriority() == log4cpp::Priority::DEBUG) {
-		logRoot.warn("Debug mode for each packet is set on 'packetLog' logger, processing will take additional time");
-		m_isDebugPacketOn = true;
-	} else {
-		m_isDebugPacketOn = false;
+	m_serviceLatencies = NULL;
+	if (ProgramProperties::getServiceLatencyMaxServices() > 0) {
+		m_tcpSessions->swapServiceLatencies(new ServiceLatencies(ProgramProperties::getServiceLatencyMaxServices()));
+		m_serviceLatencies = new ServiceLatencies(ProgramProperties::getServiceLatencyMaxServices());
+	}
+	m_packetTrace = NULL;
+	if (!ProgramProperties::getPacketTraceFile().empty()) {
+		//the constructor runs on the capture thread, which is the only writer of the ring
+		try {
+			m_packetTrace = new PacketTrace(ProgramProperties::getPacketTraceFile(), ProgramProperties::getPacketTraceRecords());
+		} catch (std::exception& e) {
+			logRoot.fatal("Exception when initializing packet trace:\n     %s\nExitting.", e.what());
+			exit(EXIT_FAILURE);
+		}
+	}
+	m_traceControlServer = NULL;
+	if (!ProgramProperties::getTraceControlSocket().empty()) {
+		if (m_packetTrace == NULL) {
+			logRoot.warn("traceControlSocket is ignored without packetTraceFile");
+		} else {
+			try {
+				m_traceControlServer = new TraceControlServer(ProgramProperties::getTraceControlSocket());
+			} catch (std::exception& e) {
+				logRoot.fatal("Exception when initializing trace control:\n     %s\nExitting.", e.what());
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+	m_newestPacketSec = 0;
+	m_nextIdleCheckSec = 0;
+	m_pipeClockPacketSec = 0;
+	m_pipeQuietSince = 0;
+	m_parallelIngest = NULL;
+	if (ProgramProperties::getOfflineWorkers() > 1) {
+		if (!m_isOffline) {
+			logRoot.info("offlineWorkers is ignored for a live capture");
+		} else if (m_fileMerger != NULL && m_fileMerger->getFilesCount() > 1) {
+			logRoot.info("offlineWorkers is ignored for several files, they are merged on a single thread");
+		} else if (m_serviceLatencies != NULL || m_packetTrace != NULL) {
+			//both are written by a single thread of capturing
+			logRoot.warn("offlineWorkers is ignored with serviceLatencyMaxServices or packetTraceFile, the file is read on a single thread");
+		} else {
+			try {
+				m_parallelIngest = new ParallelIngest(ProgramProperties::getSource(), m_filterExpression, m_linkType,
+														ProgramProperties::getOfflineWorkers(), m_sessionsStatQueue);
+				logRoot.info("The pcap file is mapped into memory and analyzed by %lu workers", ProgramProperties::getOfflineWorkers());
+			} catch (std::exception& e) {
+				logRoot.warn("The pcap file is read on a single thread: %s", e.what());
+			}
+		}
 	}
-	m_identifiedSequenceGap = new TcpSequenceGap(0, 0);
 	//m_packetDedupRingQueue = new PacketDedupRingQueue(t_dedupMaxSize);
 	//self monitoring statistics
-	m_pktProcessingCyclesSubTotal = 0;
-	m_pktsProcessedSubTotal = 0;
-	m_tcpPktDebugCpuCyclesSubTotal0 = 0;
-	m_tcpPktDebugedSubTotal0 = 0;
-	m_tcpPktDebugCpuCyclesSubTotal1 = 0;
-	m_tcpPktDebugedSubTotal1 = 0;
-	m_tcpPktDebugCpuCyclesSubTotal2 = 0;
-	m_tcpPktDebugedSubTotal2 = 0;
+	//the constructor runs on the thread that later runs pcap_loop()
+	if (ProgramProperties::doPerfCounters() && !m_selfMonitor.openPerfCounters(PerfThread::CAPTURE)) {
+		logRoot.warn("Hardware performance counters of the capture thread are not available");
+	}
 	m_ps_drop_prev = 0;
+	m_ps_recv_prev = 0;
+	//drops of a pcap file can't happen, so sampling is never needed there
+	m_overloadController = new OverloadController(m_isOffline ? 1 : ProgramProperties::getMaxSamplingRate());
+	clock_gettime(CLOCK_MONOTONIC, &m_lastSnapshotTime);
 	m_snifferEndReason = 0;
+	//what is used by now is not accounted by components, the pcap buffer will be filled up later
+	uint64_t baselineKb = m_selfMonitor.getPhysicalMemoryKb();
+	if (!m_isOffline) baselineKb += ProgramProperties::getPcapBufferSize() / 1024;
+	//the mapped pages of the file being analyzed
+	if (m_parallelIngest != NULL) baselineKb += PARALLEL_INGEST_WINDOW_BYTES / 1024;
+	else if (m_fileMerger != NULL) baselineKb += (OFFLINE_PCAP_RELEASE_STEP + PCAP_FILE_MERGER_PREFETCH_BYTES * 2 +
+													PCAP_INPUT_STREAM_RING_SIZE * m_fileMerger->getMaxActiveStreams()) / 1024;
+	m_memoryBudget = new MemoryBudget(ProgramProperties::getMaxMemoryUsageKb(), baselineKb);
+	m_evictedSessions = 0;
+	logRoot.info("Memory budget is %" PRIu32 "Kb with the baseline of %" PRIu64 "Kb", ProgramProperties::getMaxMemoryUsageKb(), baselineKb);
+	m_lastSessionSnapshot = std::time(nullptr);
+	//sessions of a live interface survive a restart, a pcap file is always analyzed from its beginning
+	if (!m_isOffline && !ProgramProperties::getSessionSnapshotFile().empty()) {
+		loadSessionSnapshot();
+	}
 }
 
 Sniffer::~Sniffer() {
 	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 
+	delete m_metricsServer;
+
 	if (m_handle != NULL ) {
 		pcap_freecode(&m_bpf);
 		pcap_close(m_handle);
 	} else logRoot.warn("PCAP handle is NULL, can't close it");
+	delete m_flowOffload;
+	delete m_capturePrefilter;
 
 	logRoot.info("Sniffer has been gracefully shut");
-	if (m_isDebugPacketOn) {
-		log4cpp::Category& logPacket = log4cpp::Category::getInstance(std::string("packetLog"));
-		logPacket.info("Alright then");
-		logPacket.info("***********************************************************");
+	if (m_packetTrace != NULL) {
+		logRoot.info("%" PRIu64 " packets have been traced to %s", m_packetTrace->getWrittenRecords(),
+						ProgramProperties::getPacketTraceFile().c_str());
 	}
 
-	delete m_localSubnets;
 	delete m_statWriter;
-	delete m_knownPorts;
+	delete m_statFeed;
+	delete m_parallelIngest;
+	delete m_fileMerger;
+	if (m_serviceLatencies != NULL) {
+		delete m_tcpSessions->swapServiceLatencies(NULL);
+		delete m_serviceLatencies;
+	}
 	delete m_tcpSessions;
 	delete m_udpSessions;
 	delete m_sessionsStatQueue;
-	delete[] m_debugPacketInfo;
-	delete m_identifiedSequenceGap;
+	delete m_traceControlServer;
+	delete m_packetTrace;
+	delete m_memoryBudget;
+	delete m_overloadController;
+	RuntimeSettings::release();
 }
 
 /*
@@ -168,44 +332,53 @@ Sniffer::~Sniffer() {
  */
 void gotPacket(u_char* t_user, const struct pcap_pkthdr *t_header, const u_char *t_packet) {
 	//this method is invoked every time new packet captured with the main thread
-	u_int64_t startCycles, endCycles, gotPacketCycles;
+	u_int64_t startCycles, parsedCycles;
 	PacketProcessingResultEnum packetProcessingResultEnum;
 	TcpSessionUpdateResult tcpSessionUpdateResult;
 	UdpSessionUpdateResultEnum  udpSessionUpdateResultEnum = UdpSessionUpdateResultEnum::VOID;
 
 
-	startCycles = SelfMonitor::getCpuTicks();
-
 	Sniffer *sniffer=reinterpret_cast<Sniffer *>(t_user);
+	//the kernel filter of pcap is replaced by the flow offload, so bpfExpression is applied here
+	if (sniffer->m_flowOffload != NULL && !sniffer->m_flowOffload->isAccepted(t_header, t_packet)) return;
+
+	RuntimeSettings::enterPacket();
+	if (sniffer->m_isOffline) {
+		//the merged files and a pipe are one stream, so their sessions expire by its packet time rather than the wall clock
+		int64_t newestPacketSec = sniffer->m_newestPacketSec.load(std::memory_order_relaxed);
+		if (t_header->ts.tv_sec > newestPacketSec) {
+			//the only writer, the control thread reads it for a quiet pipe
+			newestPacketSec = t_header->ts.tv_sec;
+			sniffer->m_newestPacketSec.store(newestPacketSec, std::memory_order_relaxed);
+		}
+		if (newestPacketSec >= sniffer->m_nextIdleCheckSec) {
+			sniffer->cleanIdleSessions(newestPacketSec);
+			sniffer->m_nextIdleCheckSec = newestPacketSec + RuntimeSettings::get()->getGranularity();
+		}
+	}
+	startCycles = SelfMonitor::getCpuTicks();
 
-	packetProcessingResultEnum = sniffer->m_newPacket.setPacketFromRaw(t_header, t_packet, sniffer->m_linkType);
+	packetProcessingResultEnum = sniffer->m_newPacket.setPacketFromRaw(t_header, t_packet, sniffer->m_linkType, sniffer->m_interfaceId);
+	parsedCycles = SelfMonitor::getCpuTicks();
+	sniffer->m_stageLatencies.record(LatencyStage::PARSE, parsedCycles - startCycles);
+	sniffer->m_metrics.countPacket(packetProcessingResultEnum);
 
 	switch (packetProcessingResultEnum) {
 		case PacketProcessingResultEnum::GOOD_TCP:
 			tcpSessionUpdateResult = sniffer->m_tcpSessions->update(&sniffer->m_newPacket);
 			//updating m_tcpSessions map: update existing TCP session or create a new one
 			//in tcpSessionUpdateResult it updates only those fields, that couldn't be obtained here
-			//!DEBUG
-			{
-				std::lock_guard<std::mutex> guard(sniffer->m_processingPerformanceMutex);
-				if(tcpSessionUpdateResult.debugCpuCycles0 > 0) { //check if the observable procedure happened
-					sniffer->m_tcpPktDebugedSubTotal0++;
-					sniffer->m_tcpPktDebugCpuCyclesSubTotal0 += tcpSessionUpdateResult.debugCpuCycles0;
-				}
-				if(tcpSessionUpdateResult.debugCpuCycles1 > 0) { //check if the observable procedure happened
-					sniffer->m_tcpPktDebugedSubTotal1++;
-					sniffer->m_tcpPktDebugCpuCyclesSubTotal1 += tcpSessionUpdateResult.debugCpuCycles1;
-				}
-				if(tcpSessionUpdateResult.debugCpuCycles2 > 0) { //check if the observable procedure happened
-					sniffer->m_tcpPktDebugedSubTotal2++;
-					sniffer->m_tcpPktDebugCpuCyclesSubTotal2 += tcpSessionUpdateResult.debugCpuCycles2;
-				}
+			sniffer->m_metrics.countTcpPacket(tcpSessionUpdateResult.tcpSessionProcessingResultEnum);
+			sniffer->m_stageLatencies.record(LatencyStage::SESSION_LOOKUP, tcpSessionUpdateResult.lookupCycles);
+			sniffer->m_stageLatencies.record(LatencyStage::SESSION_UPDATE, tcpSessionUpdateResult.updateCycles);
+			if (tcpSessionUpdateResult.gapCycles > 0) { //only packets of known sessions pass the gap analysis
+				sniffer->m_stageLatencies.record(LatencyStage::GAP_HANDLING, tcpSessionUpdateResult.gapCycles);
 			}
-			//------
 			break;
 		case PacketProcessingResultEnum::GOOD_UDP:
 			udpSessionUpdateResultEnum = sniffer->m_udpSessions->update(&sniffer->m_newPacket);
 			//updating m_udpSessions map: update existing UDP session or create a new one
+			sniffer->m_metrics.countUdpPacket(udpSessionUpdateResultEnum);
 			break;
 		default:
 			tcpSessionUpdateResult.tcpSessionProcessingResultEnum = TcpSessionProcessingResultEnum::VOID;
@@ -214,24 +387,14 @@ void gotPacket(u_char* t_user, const struct pcap_pkthdr *t_header, const u_char
 			break;
 	}
 
-	if (sniffer->m_isDebugPacketOn) {
-
-		PacketStatRecord packetStatRecord(sniffer->m_newPacket, packetProcessingResultEnum, tcpSessionUpdateResult, udpSessionUpdateResultEnum);
-		sniffer->m_packetStatQueue.enqueue(packetStatRecord);
-		//DEBUG
-		//if (sniffer->m_pktsProcessedSubTotal == 10) {
-		//	printf("stop");
-		//}
-	}
-
-	endCycles = SelfMonitor::getCpuTicks();
-	gotPacketCycles = endCycles - startCycles;
-	{
-		std::lock_guard<std::mutex> guard(sniffer->m_processingPerformanceMutex);
-		sniffer->m_pktsProcessedSubTotal++;
-		sniffer->m_pktProcessingCyclesSubTotal += gotPacketCycles;//duration_nsec;
+	if (sniffer->m_packetTrace != NULL && MemoryBudget::getLevel() == SheddingLevel::NONE &&
+			(sniffer->m_traceControlServer == NULL ||
+				TraceSelectors::match(sniffer->m_newPacket, packetProcessingResultEnum, tcpSessionUpdateResult.sessionErrorCode))) {
+		sniffer->m_packetTrace->trace(sniffer->m_newPacket, packetProcessingResultEnum, tcpSessionUpdateResult, udpSessionUpdateResultEnum);
 	}
 
+	RuntimeSettings::exitPacket();
+	sniffer->m_stageLatencies.record(LatencyStage::PACKET, SelfMonitor::getCpuTicks() - startCycles);
 }
 
 void Sniffer::startCapture() {
@@ -240,23 +403,60 @@ void Sniffer::startCapture() {
 
 	//log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 	//starting capture
-	pcap_res = pcap_loop(m_handle, 0, gotPacket, reinterpret_cast<u_char *>(this));
+	if (m_parallelIngest != NULL) {
+		pcap_res = m_parallelIngest->run();
+	} else if (m_fileMerger != NULL) {
+		pcap_res = readFiles();
+	} else {
+		pcap_res = pcap_loop(m_handle, 0, gotPacket, reinterpret_cast<u_char *>(this));
+	}
 	if (m_snifferEndReason == 0) m_snifferEndReason = pcap_res;
 }
 
+int Sniffer::readFiles() {
+	struct pcap_pkthdr header;
+	const u_char* packet;
+
+	//the packet data is passed to gotPacket() right from the mapping of the file
+	while (m_fileMerger->next(header, packet, m_linkType, m_interfaceId)) {
+		if (m_isFileReadBroken.load(std::memory_order_relaxed)) return PCAP_ERROR_BREAK;
+		gotPacket(reinterpret_cast<u_char *>(this), &header, packet);
+	}
+	//an interrupted pipe ends next() as well
+	if (m_isFileReadBroken.load(std::memory_order_relaxed)) return PCAP_ERROR_BREAK;
+	//the last file of a rotation is usually cut, which doesn't spoil the others
+	if (m_fileMerger->getFilesCount() == 1 && m_fileMerger->getTruncatedFiles() > 0) return PCAP_ERROR;
+	return 0;
+}
+
 void Sniffer::stopCapture() {
 
 	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 
-	std::size_t numberOfTcpSessions = m_tcpSessions->size();
-	std::size_t numberOfUdpSessions = m_udpSessions->size();
+	//the workers are stopped before their sessions are aggregated
+	if (m_parallelIngest != NULL) m_parallelIngest->stop();
+	std::size_t numberOfTcpSessions = (m_parallelIngest != NULL) ? m_parallelIngest->getTcpSessionsCount() : m_tcpSessions->size();
+	std::size_t numberOfUdpSessions = (m_parallelIngest != NULL) ? m_parallelIngest->getUdpSessionsCount() : m_udpSessions->size();
 	logRoot.info("Stopping capture with %d TCP sessions and %d UDP on monitoring", numberOfTcpSessions, numberOfUdpSessions);
 
-	//write stat records accumulated in _statQueue to the log
-	uint32_t aggregatedTcpSessions = m_tcpSessions->finalStatCalculation();
-	uint32_t aggregatedUdpSessions = m_udpSessions->finalStatCalculation();
-	logRoot.info("%d idle TCP sessions were aggregated and erased", aggregatedTcpSessions);
-	logRoot.info("%d idle UDP sessions were aggregated and erased", aggregatedUdpSessions);
+	if (m_parallelIngest != NULL) {
+		uint32_t aggregatedTcpSessions, aggregatedUdpSessions;
+		m_parallelIngest->finalStatCalculation(aggregatedTcpSessions, aggregatedUdpSessions);
+		logRoot.info("%d idle TCP sessions were aggregated and erased", aggregatedTcpSessions);
+		logRoot.info("%d idle UDP sessions were aggregated and erased", aggregatedUdpSessions);
+	} else if (!m_isOffline && !ProgramProperties::getSessionSnapshotFile().empty() &&
+			saveSessionSnapshot(SESSION_SNAPSHOT_SHUTDOWN)) {
+		//the sessions go on after the restart, their current interval will be reported by the next instance
+		uint32_t releasedTcpSessions = m_tcpSessions->releaseSessions();
+		uint32_t releasedUdpSessions = m_udpSessions->releaseSessions();
+		logRoot.info("%" PRIu32 " TCP and %" PRIu32 " UDP sessions were kept in the snapshot", releasedTcpSessions, releasedUdpSessions);
+	} else {
+		//write stat records accumulated in _statQueue to the log
+		uint32_t aggregatedTcpSessions = m_tcpSessions->finalStatCalculation();
+		uint32_t aggregatedUdpSessions = m_udpSessions->finalStatCalculation();
+		logRoot.info("%d idle TCP sessions were aggregated and erased", aggregatedTcpSessions);
+		logRoot.info("%d idle UDP sessions were aggregated and erased", aggregatedUdpSessions);
+	}
 	writeStatLog();
 
 	if (!m_isOffline) {
@@ -265,6 +465,9 @@ void Sniffer::stopCapture() {
 		logRoot.info("%" PRIu32 " packets were dropped at the interface", m_pcapStat->ps_ifdrop);
 		logRoot.info("%" PRIu32 " packets were dropped at the OS buffer", m_pcapStat->ps_drop);
 	}
+	m_isFileReadBroken = true;
+	//the capture thread may wait for a pipe that has nothing to read
+	if (m_fileMerger != NULL) m_fileMerger->interrupt();
 	if (m_handle != NULL ) {
 		pcap_breakloop(m_handle);
 	} else logRoot.warn("PCAP handle is NULL, can't stop it");
@@ -274,106 +477,384 @@ void Sniffer::stopCapture() {
 
 }
 
+void Sniffer::attachControlThread() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	if (ProgramProperties::doPerfCounters() && !m_selfMonitor.openPerfCounters(PerfThread::CONTROL)) {
+		logRoot.warn("Hardware performance counters of the control thread are not available");
+	}
+}
+
+void Sniffer::reportPerfCounters(const PerfThread t_thread, const uint64_t t_packets) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	PerfEventSample delta;
+	char report[512];
+	int reportLen = 0;
+
+	if (!m_selfMonitor.readPerfCounters(t_thread, delta)) return;
+	m_metrics.setPerfCounters(t_thread, delta, t_packets);
+	for (int i = 0; i < PERF_EVENTS && reportLen < (int) sizeof(report); i++) {
+		if (!delta.valid[i]) continue;
+		if (t_packets > 0) {
+			reportLen += snprintf(report + reportLen, sizeof(report) - reportLen, ", %s %" PRIu64 " (%.2f per packet)",
+									PerfEventGroup::getEventName(i), delta.values[i], (double) delta.values[i] / t_packets);
+		} else {
+			reportLen += snprintf(report + reportLen, sizeof(report) - reportLen, ", %s %" PRIu64,
+									PerfEventGroup::getEventName(i), delta.values[i]);
+		}
+	}
+	if (reportLen == 0) return; //the group wasn't scheduled during the interval
+	double ipc = 0;
+	if (delta.valid[(int) PerfEvent::CYCLES] && delta.valid[(int) PerfEvent::INSTRUCTIONS] && delta.values[(int) PerfEvent::CYCLES] > 0) {
+		ipc = (double) delta.values[(int) PerfEvent::INSTRUCTIONS] / delta.values[(int) PerfEvent::CYCLES];
+	}
+	logRoot.info("%s thread performance counters: IPC %.2f%s", (t_thread == PerfThread::CAPTURE) ? "Capture" : "Control", ipc, report);
+}
+
+bool Sniffer::controlOverload(const LatencySnapshot& t_packetLatency, const uint64_t t_intervalNs,
+								const uint32_t t_receivedPackets, const uint32_t t_droppedPackets) {
+	//invoked from the control thread once per interval
+	//libpcap doesn't tell how full the ring is, so its occupancy is judged by the packets the kernel has
+	//accepted but the capture thread hasn't processed yet and by the share of time gotPacket() was running
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	uint32_t previousRate = OverloadController::getSamplingRate();
+	uint32_t busyPct = (t_intervalNs > 0) ? std::min<uint64_t>(100, t_packetLatency.sum * 100 / t_intervalNs) : 0;
+	uint64_t backlog = (t_receivedPackets > t_packetLatency.count + t_droppedPackets) ?
+						t_receivedPackets - t_packetLatency.count - t_droppedPackets : 0;
+
+	uint32_t samplingRate = m_isOffline ? 1 : m_overloadController->evaluate(t_receivedPackets, t_packetLatency.count,
+																				t_droppedPackets, busyPct);
+	if (samplingRate > previousRate) {
+		logRoot.warn("Capture is overloaded (%" PRIu32 "%% busy, %" PRIu64 " packets behind, %" PRIu32 " dropped), "
+						"new flows are sampled 1:%" PRIu32, busyPct, backlog, t_droppedPackets, samplingRate);
+	} else if (samplingRate < previousRate) {
+		logRoot.info("Capture load decreased (%" PRIu32 "%% busy), new flows are sampled 1:%" PRIu32, busyPct, samplingRate);
+	}
+	m_metrics.setOverload(samplingRate, busyPct, backlog);
+	return m_overloadController->isSaturated();
+}
+
+void Sniffer::loadSessionSnapshot() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	SessionSnapshotReader reader;
+	timespec startTime, endTime;
+	uint64_t restoredTcp = 0, restoredUdp = 0, brokenRecords = 0;
+	uint8_t ipProtocol;
+
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	if (!reader.open(ProgramProperties::getSessionSnapshotFile())) return;
+	const SessionSnapshotHeader& header = reader.getHeader();
+	//a periodic snapshot's interval counters were most likely reported already, a shutdown one's were not
+	bool keepIntervalCounters = (header.kind == SESSION_SNAPSHOT_SHUTDOWN);
+	if (std::time(nullptr) - header.createdEpoch > (int64_t) ProgramProperties::getIdleTcpSessionTimeout()) {
+		logRoot.info("Session snapshot %s is older than idleTcpSessionTimeout, ignoring it", ProgramProperties::getSessionSnapshotFile().c_str());
+	} else {
+		while (reader.nextRecord(ipProtocol)) {
+			bool isRestored = false;
+			if (ipProtocol == IPPROTO_TCP) {
+				isRestored = m_tcpSessions->restoreSession(reader, keepIntervalCounters);
+				if (isRestored) restoredTcp++;
+			} else if (ipProtocol == IPPROTO_UDP) {
+				isRestored = m_udpSessions->restoreSession(reader, keepIntervalCounters);
+				if (isRestored) restoredUdp++;
+			}
+			if (!isRestored) brokenRecords++;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		timespec loadTime = SelfMonitor::tsDiff(endTime, startTime);
+		logRoot.info("%" PRIu64 " of %" PRIu64 " TCP and %" PRIu64 " of %" PRIu64 " UDP sessions were read from the %s session snapshot "
+						"of %" PRIu64 " bytes in %" PRIu64 "ms, %" PRIu64 " TCP and %" PRIu64 " UDP sessions are active",
+						restoredTcp, header.tcpSessions, restoredUdp, header.udpSessions,
+						keepIntervalCounters ? "shutdown" : "periodic", header.dataSize,
+						(uint64_t) (loadTime.tv_sec * 1000 + loadTime.tv_nsec / 1000000),
+						(uint64_t) m_tcpSessions->size(), (uint64_t) m_udpSessions->size());
+		if (brokenRecords > 0) logRoot.warn("%" PRIu64 " records of the session snapshot are broken", brokenRecords);
+	}
+	reader.close();
+	//the sessions belong to this instance now, restoring them once more after a crash would duplicate their stat
+	if (unlink(ProgramProperties::getSessionSnapshotFile().c_str()) != 0) {
+		logRoot.warn("Can't remove session snapshot %s: %s", ProgramProperties::getSessionSnapshotFile().c_str(), strerror(errno));
+	}
+}
+
+bool Sniffer::saveSessionSnapshot(const uint32_t t_kind) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	timespec startTime, endTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	try {
+		SessionSnapshotWriter writer(ProgramProperties::getSessionSnapshotFile());
+		uint32_t savedTcp = m_tcpSessions->saveSnapshot(writer);
+		uint32_t savedUdp = m_udpSessions->saveSnapshot(writer);
+		if (!writer.commit(t_kind, savedTcp, savedUdp)) return false;
+		clock_gettime(CLOCK_MONOTONIC, &endTime);
+		timespec saveTime = SelfMonitor::tsDiff(endTime, startTime);
+		logRoot.info("%" PRIu32 " TCP and %" PRIu32 " UDP sessions were saved to %s, %" PRIu64 " bytes in %" PRIu64 "ms",
+						savedTcp, savedUdp, ProgramProperties::getSessionSnapshotFile().c_str(), writer.getSize(),
+						(uint64_t) (saveTime.tv_sec * 1000 + saveTime.tv_nsec / 1000000));
+	} catch (std::exception& e) {
+		logRoot.error("Exception when writing session snapshot:\n     %s", e.what());
+		return false;
+	}
+	return true;
+}
+
+void Sniffer::cleanIdleSessions(const int64_t t_nowSec) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	uint32_t erasedSessions = m_tcpSessions->cleanIdleSessions(t_nowSec);
+	logRoot.info("%d idle TCP sessions were aggregated and erased", erasedSessions);
+	erasedSessions = m_udpSessions->cleanIdleSessions(t_nowSec);
+	logRoot.info("%d idle UDP sessions were aggregated and erased", erasedSessions);
+}
+
+void Sniffer::manageMemory(const uint32_t t_physicalMemoryKb) {
+	//invoked from snifferControl thread once per interval
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	MemoryUsage usage;
+
+	memset(&usage, 0, sizeof(usage));
+	m_tcpSessions->accountMemory(usage);
+	m_udpSessions->accountMemory(usage);
+	if (m_parallelIngest != NULL) m_parallelIngest->accountMemory(usage);
+	usage.statQueueBytes = (m_sessionsStatQueue->size() + m_statBatch.capacity()) * sizeof(StatRecord);
+	usage.packetTraceBytes = m_packetTrace != NULL ? m_packetTrace->getResidentBytes() : 0;
+
+	SheddingLevel previousLevel = MemoryBudget::getLevel();
+	SheddingLevel level = m_memoryBudget->evaluate(usage, t_physicalMemoryKb);
+	if (level != previousLevel) {
+		logRoot.warn("Memory shedding level changed from %s to %s, estimated usage is %" PRIu64 " of %" PRIu64 " bytes, RSS is %" PRIu32 "Kb",
+						MemoryBudget::getLevelName(previousLevel), MemoryBudget::getLevelName(level),
+						m_memoryBudget->getEstimatedBytes(usage), m_memoryBudget->getBudgetBytes(), t_physicalMemoryKb);
+	}
+	if (level >= SheddingLevel::PACKET_TRACE_STOPPED && previousLevel < SheddingLevel::PACKET_TRACE_STOPPED && m_packetTrace != NULL) {
+		//the capture thread checks the level itself, the ring just stops touching new pages
+		logRoot.warn("Packet trace is stopped to save memory after %" PRIu64 " records", m_packetTrace->getWrittenRecords());
+	}
+	if (level >= SheddingLevel::DEDUP_DISABLED) {
+		//sessions without packets wouldn't shed anything themselves
+		m_tcpSessions->shedMemory();
+		if (m_parallelIngest != NULL) m_parallelIngest->shedMemory();
+	}
+	if (level == SheddingLevel::SESSIONS_EVICTED) {
+		uint64_t evictionBytes = m_memoryBudget->getEvictionBytes(usage, t_physicalMemoryKb);
+		uint64_t sessions = usage.tcpSessions + usage.udpSessions;
+		if (evictionBytes > 0 && sessions > 0) {
+			uint64_t bytesPerSession = usage.getSessionsBytes() / sessions + 1;
+			uint64_t sessionsToEvict = std::min(evictionBytes / bytesPerSession + 1, sessions);
+			uint64_t tcpToEvict = sessionsToEvict * usage.tcpSessions / sessions;
+			uint32_t evictedTcp, evictedUdp;
+			if (m_parallelIngest != NULL) {
+				evictedTcp = m_parallelIngest->evictOldestTcpSessions(tcpToEvict);
+				evictedUdp = m_parallelIngest->evictOldestUdpSessions(sessionsToEvict - tcpToEvict);
+			} else {
+				evictedTcp = m_tcpSessions->evictOldestSessions(tcpToEvict);
+				evictedUdp = m_udpSessions->evictOldestSessions(sessionsToEvict - tcpToEvict);
+			}
+			m_evictedSessions += evictedTcp + evictedUdp;
+			//freed session nodes stay in the heap otherwise and RSS would never go down
+			malloc_trim(0);
+			logRoot.warn("%" PRIu32 " TCP and %" PRIu32 " UDP least recently active sessions were aggregated and evicted to free %" PRIu64 " bytes",
+							evictedTcp, evictedUdp, evictionBytes);
+		}
+	}
+	logRoot.debug("Estimated memory: TCP sessions %" PRIu64 ", UDP sessions %" PRIu64 ", gaps %" PRIu64 ", dedup %" PRIu64
+					", stat queue %" PRIu64 ", packet trace %" PRIu64 " bytes",
+					usage.tcpTableBytes, usage.udpTableBytes, usage.gapBytes, usage.dedupBytes, usage.statQueueBytes, usage.packetTraceBytes);
+	m_metrics.setMemoryUsage(usage, m_memoryBudget->getEstimatedBytes(usage), m_memoryBudget->getBudgetBytes(), level, m_evictedSessions);
+
+	if (m_memoryBudget->isExhausted(t_physicalMemoryKb)) {
+		m_snifferEndReason = 167;
+		logRoot.info("Stopping capture due to high memory usage, shedding didn't help");
+		kill(getpid(),SIGINT);
+	}
+}
+
+void Sniffer::mergeOffloadedFlows() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	std::vector<FlowOffloadEntry> entries;
+	std::vector<FlowOffloadKey> staleKeys, newKeys;
+
+	//the kernel map is read and changed outside of the sessions mutex
+	m_flowOffload->readEntries(entries);
+	uint64_t mergedPackets = m_tcpSessions->mergeOffloadedFlows(entries, m_flowOffload->getCapacity(), staleKeys, newKeys);
+	m_flowOffload->updateEntries(staleKeys, newKeys);
+	m_kernelAggregatedPackets += mergedPackets;
+	uint64_t offloadedFlows = entries.size() - staleKeys.size() + newKeys.size();
+	m_metrics.setKernelAggregation(offloadedFlows, m_kernelAggregatedPackets);
+	logRoot.info("%" PRIu64 " TCP flows are pre-aggregated in the kernel, %" PRIu64 " of their packets were counted there, "
+					"%zu flows are released and %zu are added, %" PRIu64 " additions have failed so far",
+					offloadedFlows, mergedPackets, staleKeys.size(), newKeys.size(), m_flowOffload->getInsertFailures());
+}
+
 void Sniffer::aggregateSessions() {
 	//this method is invoked from snifferControl thread running in parallel with main thread that capturing the packets
 
 	//performance self assessment
-	u_int64_t startCycles, endCycles, aggrCycles;
+	u_int64_t startCycles, endCycles;
 	u_int64_t avgPktProcessingCycles = 0;
-	u_int64_t pktsProcessedSubTotal;
-	u_int64_t avgTcpPktDebug0Cycles = 0;
-	u_int64_t tcpPktDebuggedSubTotal0;
-	u_int64_t avgTcpPktDebug1Cycles = 0;
-	u_int64_t tcpPktDebuggedSubTotal1;
-	u_int64_t avgTcpPktDebug2Cycles = 0;
-	u_int64_t tcpPktDebuggedSubTotal2;
 	u_int32_t droppedByOS = 0;
+	u_int32_t receivedByOS = 0;
 
 	startCycles = SelfMonitor::getCpuTicksStart();
 
 	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 
-	{
-		std::lock_guard<std::mutex> guard(m_processingPerformanceMutex);
-		//!DEBUG
-		tcpPktDebuggedSubTotal0 = m_tcpPktDebugedSubTotal0;
-		if (m_tcpPktDebugedSubTotal0 > 0)
-			avgTcpPktDebug0Cycles = m_tcpPktDebugCpuCyclesSubTotal0 / m_tcpPktDebugedSubTotal0;
-		m_tcpPktDebugCpuCyclesSubTotal0 = 0;
-		m_tcpPktDebugedSubTotal0 = 0;
-
-		tcpPktDebuggedSubTotal1 = m_tcpPktDebugedSubTotal1;
-		if (m_tcpPktDebugedSubTotal1 > 0)
-			avgTcpPktDebug1Cycles = m_tcpPktDebugCpuCyclesSubTotal1 / m_tcpPktDebugedSubTotal1;
-		m_tcpPktDebugCpuCyclesSubTotal1 = 0;
-		m_tcpPktDebugedSubTotal1 = 0;
-
-		tcpPktDebuggedSubTotal2 = m_tcpPktDebugedSubTotal2;
-		if (m_tcpPktDebugedSubTotal2 > 0)
-			avgTcpPktDebug2Cycles = m_tcpPktDebugCpuCyclesSubTotal2 / m_tcpPktDebugedSubTotal2;
-		m_tcpPktDebugCpuCyclesSubTotal2 = 0;
-		m_tcpPktDebugedSubTotal2 = 0;
-		//-------
-		pktsProcessedSubTotal = m_pktsProcessedSubTotal;
-		if (m_pktsProcessedSubTotal > 0)
-			avgPktProcessingCycles = m_pktProcessingCyclesSubTotal / m_pktsProcessedSubTotal;
-		m_pktProcessingCyclesSubTotal = 0;
-		m_pktsProcessedSubTotal = 0;
-	}
-
-	if (m_tcpSessions->size() >= ProgramProperties::getMaxTcpSessions()) {
+	//the previous aggregation is recorded at its very end, so it is reported in this interval
+	m_stageLatencies.takeIntervalSnapshots(m_metrics);
+	timespec snapshotTime, intervalTime;
+	clock_gettime(CLOCK_MONOTONIC, &snapshotTime);
+	intervalTime = SelfMonitor::tsDiff(snapshotTime, m_lastSnapshotTime);
+	m_lastSnapshotTime = snapshotTime;
+	uint64_t intervalNs = intervalTime.tv_sec * 1000000000ULL + intervalTime.tv_nsec;
+	const LatencySnapshot& packetLatency = m_stageLatencies.getSnapshot(LatencyStage::PACKET);
+	if (packetLatency.count > 0) {
+		avgPktProcessingCycles = m_stageLatencies.getIntervalTicksSum(LatencyStage::PACKET) / packetLatency.count;
+	}
+
+	std::size_t tcpSessions = (m_parallelIngest != NULL) ? m_parallelIngest->getTcpSessionsCount() : m_tcpSessions->size();
+	std::size_t udpSessions = (m_parallelIngest != NULL) ? m_parallelIngest->getUdpSessionsCount() : m_udpSessions->size();
+	if (m_parallelIngest == NULL && tcpSessions >= ProgramProperties::getMaxTcpSessions()) {
 		logRoot.warn("Maximum of %" PRIu64 " simultaneously monitored TCP Sessions "
 				"has been reached during last interval! New sessions can't be monitored.", ProgramProperties::getMaxTcpSessions());
 	}
 	logRoot.info("Active TCP Sessions count is %" PRIu64 ", active UDP Sessions count is %" PRIu64
-					", average cycles packet processing is %" PRIu64 ", %" PRIu64 " packets were analyzed",
-						m_tcpSessions->size(), m_udpSessions->size(), avgPktProcessingCycles, pktsProcessedSubTotal);
-	//!DEBUG
+					", packet processing p50 %" PRIu64 "ns, p99 %" PRIu64 "ns, p99.9 %" PRIu64 "ns, max %" PRIu64 "ns, %" PRIu64 " packets were analyzed",
+						tcpSessions, udpSessions, packetLatency.p50, packetLatency.p99, packetLatency.p999,
+						packetLatency.max, packetLatency.count);
+	if (m_parallelIngest != NULL) {
+		//the workers don't take the per packet latencies, they would need a histogram each
+		logRoot.info("%" PRIu64 " packets were analyzed by the offline workers", m_parallelIngest->takeProcessedPackets());
+	}
 	logRoot.debug("Statistical records to write: %" PRIu64, m_sessionsStatQueue->size());
-	logRoot.debug("Average TCP packet debug0 cycles is %" PRIu64 ", %" PRIu64 " packets were analyzed", avgTcpPktDebug0Cycles, tcpPktDebuggedSubTotal0);
-	logRoot.debug("Average TCP packet debug1 cycles is %" PRIu64 ", %" PRIu64 " packets were analyzed", avgTcpPktDebug1Cycles, tcpPktDebuggedSubTotal1);
-	logRoot.debug("Average TCP packet debug2 cycles is %" PRIu64 ", %" PRIu64 " packets were analyzed", avgTcpPktDebug2Cycles, tcpPktDebuggedSubTotal2);
-	//------
+	//CPU usage is measured since the previous call, so it is taken only once per interval
+	double cpuUsage = m_selfMonitor.getCpuUsagePecentage();
+	u_int32_t virtualMemoryKb = m_selfMonitor.getVirtualMemoryKb();
+	u_int32_t physicalMemoryKb = m_selfMonitor.getPhysicalMemoryKb();
 	logRoot.info("CPU usage %f\%, Virtual Memory Usage %dKb, Physical Memory Usage %" PRIu32 "Kb",
-					m_selfMonitor.getCpuUsagePecentage(), m_selfMonitor.getVirtualMemoryKb(), m_selfMonitor.getPhysicalMemoryKb());
+					cpuUsage, virtualMemoryKb, physicalMemoryKb);
+	m_metrics.setSelfUsage(cpuUsage, virtualMemoryKb, physicalMemoryKb, avgPktProcessingCycles);
+	reportPerfCounters(PerfThread::CAPTURE, packetLatency.count);
+	reportPerfCounters(PerfThread::CONTROL, 0);
+	m_metrics.setSessions(tcpSessions, udpSessions);
+	TcpSessionStates tcpSessionStates;
+	memset(&tcpSessionStates, 0, sizeof(tcpSessionStates));
+	m_tcpSessions->countStates(tcpSessionStates);
+	if (m_parallelIngest != NULL) m_parallelIngest->countTcpSessionStates(tcpSessionStates);
+	m_metrics.setTcpSessionStates(tcpSessionStates.established, tcpSessionStates.halfOpen, tcpSessionStates.closing);
+	m_metrics.setQueueDepths(m_sessionsStatQueue->size());
+	if (m_packetTrace != NULL) m_metrics.setTracedPackets(m_packetTrace->getWrittenRecords());
 	if (!m_isOffline) {
 		pcap_stats(m_handle, m_pcapStat);
+		m_metrics.setCaptureDrops(m_pcapStat->ps_drop, m_pcapStat->ps_ifdrop);
 		droppedByOS = m_pcapStat->ps_drop - m_ps_drop_prev;
+		receivedByOS = m_pcapStat->ps_recv - m_ps_recv_prev;
 		logRoot.info("In total libpcap captured %" PRIu32 " packets, %" PRIu32
 						" packets were dropped at the interface, %" PRIu32 " packets were dropped at the OS buffer",
 					m_pcapStat->ps_recv, m_pcapStat->ps_ifdrop, droppedByOS);
-		uint32_t erasedSessions = m_tcpSessions->cleanIdleSessions();
-		logRoot.info("%d idle TCP sessions were aggregated and erased", erasedSessions);
-		erasedSessions = m_udpSessions->cleanIdleSessions();
-		logRoot.info("%d idle UDP sessions were aggregated and erased", erasedSessions);
+		uint64_t interfaceFrames;
+		if (m_capturePrefilter != NULL && m_capturePrefilter->takeInterfaceFrames(interfaceFrames)) {
+			//the frames that haven't reached the capture ring were rejected by the kernel filter
+			uint64_t filteredFrames = interfaceFrames > receivedByOS ? interfaceFrames - receivedByOS : 0;
+			m_kernelFilteredFrames += filteredFrames;
+			m_metrics.setKernelFilteredFrames(m_kernelFilteredFrames);
+			logRoot.info("%" PRIu64 " of %" PRIu64 " frames of the interface were filtered out by the kernel",
+							filteredFrames, interfaceFrames);
+		}
+		//the sessions get their kernel counters before the idle ones are aggregated
+		if (m_flowOffload != NULL) mergeOffloadedFlows();
+		cleanIdleSessions(std::time(nullptr));
 		m_ps_drop_prev = m_pcapStat->ps_drop;
+		m_ps_recv_prev = m_pcapStat->ps_recv;
+	} else if (m_isPipe) {
+		//a quiet pipe gives no packets to move its clock on, so the wall clock does it since the newest packet
+		int64_t newestPacketSec = m_newestPacketSec.load(std::memory_order_relaxed);
+		if (newestPacketSec != m_pipeClockPacketSec) {
+			m_pipeClockPacketSec = newestPacketSec;
+			m_pipeQuietSince = std::time(nullptr);
+		} else if (newestPacketSec > 0) {
+			cleanIdleSessions(newestPacketSec + (std::time(nullptr) - m_pipeQuietSince));
+		}
 	}
+	bool isSaturated = controlOverload(packetLatency, intervalNs, receivedByOS, droppedByOS);
 
-	if (m_selfMonitor.getPhysicalMemoryKb() >= ProgramProperties::getMaxMemoryUsageKb()) {
-		m_snifferEndReason = 167;
-		logRoot.info("Stopping capture due to high memory usage");
-		kill(getpid(),SIGINT);
-	}
+	manageMemory(physicalMemoryKb);
+	//the capture thread might have been inside a packet when the settings were reloaded
+	RuntimeSettings::reclaim();
 
 	writeStatLog();
 
-	if (ProgramProperties::doRestartOnDrops() && (droppedByOS > 0)) {
+	if (!m_isOffline && !ProgramProperties::getSessionSnapshotFile().empty() && ProgramProperties::getSessionSnapshotInterval() > 0 &&
+			(unsigned long)(std::time(nullptr) - m_lastSessionSnapshot) >= ProgramProperties::getSessionSnapshotInterval()) {
+		saveSessionSnapshot(SESSION_SNAPSHOT_PERIODIC);
+		m_lastSessionSnapshot = std::time(nullptr);
+	}
+
+	//sampling is the first line of defence, restart is the last one
+	if (ProgramProperties::doRestartOnDrops() && (droppedByOS > 0) && isSaturated) {
 		m_snifferEndReason = 166;
-		logRoot.info("Stopping capture due to high OS drops");
+		logRoot.info("Stopping capture due to high OS drops at 1:%" PRIu32 " flow sampling", OverloadController::getSamplingRate());
 		kill(getpid(),SIGINT);
 	}
 
 	endCycles = SelfMonitor::getCpuTicksEnd();
-	aggrCycles = endCycles - startCycles;
-	logRoot.debug("Aggregation completed in %" PRIu64 " cycles", aggrCycles);
+	m_stageLatencies.record(LatencyStage::AGGREGATION, endCycles - startCycles);
+	logRoot.debug("Aggregation completed in %" PRIu64 " cycles", endCycles - startCycles);
+}
+
+void Sniffer::reloadConfiguration() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+
+	try {
+		ProgramProperties::reload();
+	} catch (std::exception& e) {
+		logRoot.error("Exception when reloading configuration, nothing is changed:\n     %s", e.what());
+		return;
+	}
+	RuntimeSettings::publish(new RuntimeSettings(RuntimeSettings::get()));
+	//the statistics writer is used by this thread only, so it is simply replaced
+	try {
+		StatWriter* statWriter = new StatWriter();
+		//the current file or segment is closed by the old writer
+		delete m_statWriter;
+		m_statWriter = statWriter;
+	} catch (std::exception& e) {
+		logRoot.error("Exception when reinitializing statistics writer, the previous statistics output is kept:\n     %s", e.what());
+	}
+	logRoot.info("Configuration reloaded: granularity %" PRIu64 " seconds, idle timeout %" PRIu64 " seconds, deduplication buffer %" PRIu64
+					" packets and timeout %" PRIu64 " milliseconds, service ports '%s', local subnets '%s', statistics format %s. "
+					"Other settings need a restart",
+					(uint64_t) ProgramProperties::getGranularity(), (uint64_t) ProgramProperties::getIdleTcpSessionTimeout(),
+					(uint64_t) ProgramProperties::getDeduplicationBufferSize(), (uint64_t) ProgramProperties::getDeduplicationTimeout(),
+					ProgramProperties::getServicePortsStr().c_str(), ProgramProperties::getLocalSubnetsStr().c_str(),
+					ProgramProperties::getStatisticsFormat().c_str());
 }
 
 void Sniffer::writeStatLog() {
 	//write stat records accumulated in _statQueue to the log
-	m_statWriter->writeStat(m_sessionsStatQueue);
-	if (m_isDebugPacketOn) {
-		m_pcktStatRecordLogger.logPacketStatRecords(m_packetStatQueue);
+	StatRecord statRecord;
+	timespec startTime, endTime;
+	clock_gettime(CLOCK_MONOTONIC, &startTime);
+	m_statBatch.clear();
+	while (m_sessionsStatQueue->dequeue(statRecord)) {
+		m_statBatch.push_back(statRecord);
+	}
+	//the feed goes first, it never blocks and local consumers are waiting for it
+	if (m_statFeed != NULL) {
+		m_statFeed->publish(m_statBatch);
+	}
+	m_statWriter->writeStat(m_statBatch);
+	if (m_serviceLatencies != NULL) {
+		//the histograms of the interval are taken away from the sessions, the empty ones replace them
+		m_serviceLatencies = m_tcpSessions->swapServiceLatencies(m_serviceLatencies);
+		m_statWriter->writeServiceLatencies(*m_serviceLatencies);
+		m_serviceLatencies->clear();
 	}
+	clock_gettime(CLOCK_MONOTONIC, &endTime);
+	timespec writeTime = SelfMonitor::tsDiff(endTime, startTime);
+	m_metrics.observeStatWrite(writeTime.tv_sec * 1000000 + writeTime.tv_nsec / 1000, m_statBatch.size());
+	m_metrics.setOutputDrops(m_statFeed != NULL ? m_statFeed->getOverwrittenBatches() : 0,
+								m_statWriter->getIpfixDroppedMessages());
 }
 
 size_t Sniffer::hash_c_string(const char* p, const size_t s, const size_t prime) {
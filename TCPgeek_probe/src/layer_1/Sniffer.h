@@ -2,7 +2,7 @@
  *	Sniffer.h
  *
  *  Created on: Mar 28, 2022
- *	Last modified on: Mar 28, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -30,20 +30,36 @@
 #include <stdint.h>
 #include <string>
 #include <unistd.h>
+#include <malloc.h> // for malloc_trim() after eviction of sessions
+#include <algorithm>
+#include <atomic>
 
 #include "ProgramProperties.h"
 #include "layer_1/sessions/TCP/TcpSequenceGap.h" // for logging session gaps and retransmits
 #include "layer_1/sessions/TCP/TcpSessions.h" // for TcpSessions *_tcpSessions;
 #include "layer_1/sessions/UDP/UdpSessions.h"
 #include "layer_1/sessions/TCP/TcpSessionUpdateResult.h"
-#include "layer_1/PacketStatRecordLogger.h"
+#include "layer_1/PacketTrace.h"
+#include "layer_1/FlowOffload.h"
+#include "layer_1/CapturePrefilter.h"
+#include "layer_1/ParallelIngest.h"
+#include "layer_1/OfflinePcapReader.h"
+#include "layer_1/PcapFileMerger.h"
 #include "layer_1/Packet.h" // for TcpPacket *_newPacket;
 #include "layer_1/PacketProcessingResultEnum.h"
-#include "layer_1/KnownPorts.h"
 #include "layer_1/networkHeaders.h" // for TCP and IP network headers format and related constants
-#include "layer_1/LocalSubnets.h"
+#include "layer_1/RuntimeSettings.h"
 #include "SelfMonitor.h"
+#include "ProbeMetrics.h"
+#include "StageLatencies.h"
+#include "MetricsServer.h"
+#include "TraceControlServer.h"
 #include "layer_1/StatWriter.h"
+#include "layer_1/StatFeed.h"
+#include "layer_1/MemoryBudget.h"
+#include "layer_1/OverloadController.h"
+#include "layer_1/SessionSnapshotWriter.h"
+#include "layer_1/SessionSnapshotReader.h"
 
 class Sniffer {
 private:
@@ -52,10 +68,26 @@ private:
 	pcap_t *m_handle; //packet capture handle
 	struct bpf_program m_bpf; //to store compiled packet filter
 	struct pcap_stat* m_pcapStat; //this is where general statistics of capturing would be put at the end of capture
-	int m_linkType; //DLT_EN10MB, DLT_LINUX_SLL or unknown
+	int m_linkType; //DLT_EN10MB, DLT_LINUX_SLL or unknown, of the packet being processed for m_fileMerger
+	PcapFileMerger* m_fileMerger; //NULL unless the source is a directory, a glob pattern or a pcapng file, read without libpcap then
+	std::atomic<bool> m_isFileReadBroken; //pcap_breakloop() of m_fileMerger
+	uint32_t m_interfaceId; //of the packet being processed, always 0 unless the source is a pcapng file
+	std::string m_filterExpression; //bpfExpression combined with the prefilter, if any
+	CapturePrefilter* m_capturePrefilter; //NULL unless kernelPrefilter is configured
+	uint64_t m_kernelFilteredFrames;
+	FlowOffload* m_flowOffload; //NULL unless kernelPreaggregationFlows is configured for a live capture and the kernel allows it
+	uint64_t m_kernelAggregatedPackets;
+	ParallelIngest* m_parallelIngest; //NULL unless offlineWorkers is configured for a pcap file
+	std::atomic<int64_t> m_newestPacketSec; //of an offline source, its sessions are idle by the packet time
+	int64_t m_nextIdleCheckSec; //the packet time the idle sessions of an offline source are looked for next time
+	bool m_isPipe; //the offline source is stdin or a FIFO, it may give no packets for long
+	int64_t m_pipeClockPacketSec, m_pipeQuietSince; //the newest packet time the control thread has seen and since when
 
 
 	StatWriter* m_statWriter;
+	StatFeed* m_statFeed; //NULL unless statFeedFile is configured
+	std::vector<StatRecord> m_statBatch;
+	//records harvested from m_sessionsStatQueue for one interval, shared by StatWriter and StatFeed
 	Packet m_newPacket;
 	//every time the sniffer processes a new packet within gotPacket() it fills m_newPacket properties accordingly
 	//m_newPacket instantiated in a constructor only once per process lifetime
@@ -69,45 +101,53 @@ private:
 	//unordered_map based collection of active TCP sessions
 	UdpSessions *m_udpSessions;
 	//unordered_map based collection of active UDP sessions
+	ServiceLatencies* m_serviceLatencies;
+	//per service histograms of the previous interval, the TCP sessions record into another instance meanwhile
+	//NULL if serviceLatencyMaxServices is 0
 
-	const KnownPorts* m_knownPorts;
-	//set of known ports for simple distinguishing requests and responses
-	LocalSubnets* m_localSubnets;
-
-	//****PACKET DEBUG/STATISTICS PROPERTIES****
-	//defines if we going to spend time on debugging of each packet, depends on packetLog level
-	bool m_isDebugPacketOn;
-	//this is where detailed information would be stored for the m_newPacket, only if m_isDebugPacketOn == true
-	char *m_debugPacketInfo;
-	//this property represents additional details about TCP sequence gap if it was detected during TCP session update
-	//this way I can reflect them in packetStatRecord if m_isDebugPacketOn == true
-	TcpSequenceGap *m_identifiedSequenceGap;
-	//single packet info record
-	PacketStatRecord m_pcktStatRecord;
-	//thread safe queue of TCP packets statistics records: enqueued with packet capturing thread, dequeued with control thread
-	SafeQueue<PacketStatRecord> m_packetStatQueue;
-	//this is the object to write packet statistics on disk
-	PacketStatRecordLogger m_pcktStatRecordLogger;
+	//****PACKET DEBUG PROPERTIES****
+	//binary trace of the packets written by the capture thread, NULL unless packetTraceFile is configured
+	PacketTrace* m_packetTrace;
+	//installs trace selectors at runtime, NULL unless traceControlSocket is configured, every packet is traced then
+	TraceControlServer* m_traceControlServer;
 
 	//****SELF MONITOR****
 	//to understand CPU and memory used by this program
 	SelfMonitor m_selfMonitor;
-	mutable std::mutex m_processingPerformanceMutex;
+	//lock-free self-metrics, served over HTTP by m_metricsServer if metricsPort is configured
+	ProbeMetrics m_metrics;
+	MetricsServer* m_metricsServer;
 	u_int32_t m_ps_drop_prev;
-	//to understand processing time details
-	u_int64_t m_pktProcessingCyclesSubTotal;
-	u_int64_t m_pktsProcessedSubTotal;
-	u_int64_t m_tcpPktDebugCpuCyclesSubTotal0;
-	u_int64_t m_tcpPktDebugedSubTotal0;
-	u_int64_t m_tcpPktDebugCpuCyclesSubTotal1;
-	u_int64_t m_tcpPktDebugedSubTotal1;
-	u_int64_t m_tcpPktDebugCpuCyclesSubTotal2;
-	u_int64_t m_tcpPktDebugedSubTotal2;
+	u_int32_t m_ps_recv_prev;
+	//adaptive sampling of new flows when the capture thread can't keep up
+	OverloadController* m_overloadController;
+	timespec m_lastSnapshotTime; //when the stage latencies were taken the last time
+	//graduated memory shedding within maxMemoryUsageKB
+	MemoryBudget* m_memoryBudget;
+	uint64_t m_evictedSessions;
+	//to understand processing time details, every stage histogram has a single writer thread
+	StageLatencies m_stageLatencies;
+	time_t m_lastSessionSnapshot; //when the periodic session snapshot was taken the last time
 
 	// gotPacket() is a callback function of pcap_loop()
 	// user - is a pointer to Sniffer object reinterpreted as u_char*
 	// header and packet comes from libpcap
 	friend void gotPacket(u_char* t_user, const struct pcap_pkthdr* t_header, const u_char* t_packet);
+	int readFiles();
+	//invoked from startCapture() instead of pcap_loop() for m_fileMerger, returns what pcap_loop() would
+	void cleanIdleSessions(const int64_t t_nowSec);
+	//aggregates and erases the sessions idle by t_nowSec, invoked from the control thread for a live capture
+	//and from the capture thread for an offline source
+	void manageMemory(const uint32_t t_physicalMemoryKb);
+	void mergeOffloadedFlows();
+	//merges the flows counted in the kernel into the TCP sessions and chooses the next ones to offload
+	bool controlOverload(const LatencySnapshot& t_packetLatency, const uint64_t t_intervalNs,
+							const uint32_t t_receivedPackets, const uint32_t t_droppedPackets);
+	void reportPerfCounters(const PerfThread t_thread, const uint64_t t_packets);
+	void loadSessionSnapshot();
+	//restores the sessions saved by the previous instance of the probe, invoked from the constructor
+	bool saveSessionSnapshot(const uint32_t t_kind);
+	//returns false if the snapshot couldn't be written, the previous one is kept then
 	size_t hash_c_string(const char* p, const size_t s, const size_t prime);
 	int m_snifferEndReason;
 public:
@@ -117,7 +157,11 @@ public:
 
 	void startCapture();
 	void stopCapture();
+	void attachControlThread();
+	// must be invoked from the control thread before the first aggregateSessions()
 	void aggregateSessions();
+	void reloadConfiguration();
+	//invoked from the control thread on SIGHUP, applies the settings that don't need a restart
 	void writeStatLog();
 	int getSnifferEndReason() const;
 };
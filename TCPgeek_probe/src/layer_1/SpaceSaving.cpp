@@ -0,0 +1,84 @@
+/*
+ *	SpaceSaving.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <algorithm>
+
+#include "layer_1/SpaceSaving.h"
+
+SpaceSaving::SpaceSaving(const std::size_t t_capacity) : m_capacity {t_capacity} {
+	m_heap.reserve(m_capacity);
+	m_positions.reserve(m_capacity);
+}
+
+void SpaceSaving::swapCounters(const std::size_t t_a, const std::size_t t_b) {
+	std::swap(m_heap[t_a], m_heap[t_b]);
+	m_positions[m_heap[t_a].key] = t_a;
+	m_positions[m_heap[t_b].key] = t_b;
+}
+
+void SpaceSaving::siftDown(std::size_t t_position) {
+	//counts only grow, so a counter can only move down the min-heap
+	for (;;) {
+		std::size_t smallest = t_position;
+		std::size_t left = 2 * t_position + 1;
+		std::size_t right = left + 1;
+		if (left < m_heap.size() && m_heap[left].count < m_heap[smallest].count) smallest = left;
+		if (right < m_heap.size() && m_heap[right].count < m_heap[smallest].count) smallest = right;
+		if (smallest == t_position) return;
+		swapCounters(t_position, smallest);
+		t_position = smallest;
+	}
+}
+
+void SpaceSaving::add(const uint64_t t_key, const uint64_t t_weight) {
+	if (t_weight == 0 || m_capacity == 0) return;
+	std::unordered_map<uint64_t, std::size_t>::iterator positionIterator = m_positions.find(t_key);
+	if (positionIterator != m_positions.end()) {
+		std::size_t position = positionIterator->second;
+		m_heap[position].count += t_weight;
+		siftDown(position);
+		return;
+	}
+	if (m_heap.size() < m_capacity) {
+		//a new counter with the smallest possible count goes up to its place
+		SpaceSavingCounter counter = {t_key, t_weight, 0};
+		std::size_t position = m_heap.size();
+		m_heap.push_back(counter);
+		m_positions[t_key] = position;
+		while (position > 0 && m_heap[(position - 1) / 2].count > m_heap[position].count) {
+			swapCounters(position, (position - 1) / 2);
+			position = (position - 1) / 2;
+		}
+		return;
+	}
+	//the smallest counter is taken over by the new key
+	m_positions.erase(m_heap[0].key);
+	m_heap[0].key = t_key;
+	m_heap[0].error = m_heap[0].count;
+	m_heap[0].count += t_weight;
+	m_positions[t_key] = 0;
+	siftDown(0);
+}
+
+void SpaceSaving::getTop(const std::size_t t_k, std::vector<SpaceSavingCounter>& t_top) const {
+	t_top = m_heap;
+	std::size_t k = std::min(t_k, t_top.size());
+	std::partial_sort(t_top.begin(), t_top.begin() + k, t_top.end(), [](const SpaceSavingCounter& a, const SpaceSavingCounter& b) {
+		return a.count > b.count;
+	});
+	t_top.resize(k);
+}
+
+void SpaceSaving::clear() {
+	m_heap.clear();
+	m_positions.clear();
+}
@@ -0,0 +1,49 @@
+/*
+ *	SpaceSaving.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : SpaceSaving - weighted space-saving sketch of heavy hitters (Metwally et al.).
+ *					It keeps at most m counters in a min-heap, a new key takes over the smallest
+ *					counter and inherits its value as the possible overestimation. Every key with
+ *					a total above N/m is guaranteed to be kept, N is the sum of all the weights,
+ *					and its counter is never less than its true total.
+ */
+
+#ifndef SPACESAVING_H_
+#define SPACESAVING_H_
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+struct SpaceSavingCounter {
+	uint64_t key;
+	uint64_t count; //upper bound of the key's total
+	uint64_t error; //the counter might be overestimated by this much
+};
+
+class SpaceSaving {
+private:
+	std::vector<SpaceSavingCounter> m_heap; //min-heap by count
+	std::unordered_map<uint64_t, std::size_t> m_positions; //key -> index in m_heap
+	std::size_t m_capacity;
+
+	void siftDown(std::size_t t_position);
+	void swapCounters(const std::size_t t_a, const std::size_t t_b);
+
+public:
+	SpaceSaving(const std::size_t t_capacity);
+
+	void add(const uint64_t t_key, const uint64_t t_weight);
+	void getTop(const std::size_t t_k, std::vector<SpaceSavingCounter>& t_top) const;
+	//t_top is replaced by the t_k biggest counters in descending order
+	void clear();
+};
+
+#endif /* SPACESAVING_H_ */
@@ -0,0 +1,175 @@
+/*
+ *	StatFeed.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sstream>
+#include <stdexcept>
+#include <ctime>
+#include <algorithm>
+#include <inttypes.h>
+#include <sys/mman.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "layer_1/StatFeed.h"
+
+StatFeed::StatFeed(const std::string& t_fileName, const uint64_t t_capacity, const std::string& t_ownership) :
+					m_fileName {t_fileName},
+					m_fd {-1},
+					m_mappedSize {0},
+					m_header {NULL},
+					m_records {NULL} {
+	if (t_capacity == 0) {
+		throw std::runtime_error("statFeedCapacity must be greater than 0");
+	}
+	//consumers of the previous run keep their mapping of the unlinked file, so they are never cut off by SIGBUS
+	if (unlink(m_fileName.c_str()) != 0 && errno != ENOENT) {
+		throw std::runtime_error("Can't remove the old statistics feed " + m_fileName + ": " + strerror(errno));
+	}
+	m_fd = open(m_fileName.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0660);
+	if (m_fd == -1) {
+		throw std::runtime_error("Can't create the statistics feed " + m_fileName + ": " + strerror(errno));
+	}
+	m_mappedSize = sizeof(StatFeedHeader) + t_capacity * sizeof(StatFeedRecord);
+	if (ftruncate(m_fd, m_mappedSize) != 0) {
+		close(m_fd);
+		throw std::runtime_error("Can't allocate the statistics feed " + m_fileName + ": " + strerror(errno));
+	}
+	void* mapping = mmap(NULL, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if (mapping == MAP_FAILED) {
+		close(m_fd);
+		throw std::runtime_error("Can't map the statistics feed " + m_fileName + ": " + strerror(errno));
+	}
+	setOwnership(t_ownership);
+
+	//ftruncate has zeroed everything, so all slots have seq == 0
+	m_header = (StatFeedHeader*) mapping;
+	m_records = (StatFeedRecord*) ((char*) mapping + sizeof(StatFeedHeader));
+	m_header->version = STAT_FEED_VERSION;
+	m_header->headerSize = sizeof(StatFeedHeader);
+	m_header->recordSize = sizeof(StatFeedRecord);
+	m_header->capacity = t_capacity;
+	m_header->startEpoch = std::time(nullptr);
+	memcpy(m_header->magic, STAT_FEED_MAGIC, sizeof(m_header->magic));
+	__atomic_store_n(&m_header->state, STAT_FEED_STATE_ACTIVE, __ATOMIC_RELEASE);
+
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.info("Statistics are published to %s, %" PRIu64 " records of %zu bytes",
+					m_fileName.c_str(), t_capacity, sizeof(StatFeedRecord));
+}
+
+StatFeed::~StatFeed() {
+	if (m_header != NULL) {
+		__atomic_store_n(&m_header->state, STAT_FEED_STATE_CLOSED, __ATOMIC_RELEASE);
+		munmap(m_header, m_mappedSize);
+	}
+	if (m_fd != -1) close(m_fd);
+}
+
+void StatFeed::setOwnership(const std::string& t_ownership) {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	std::string user, group;
+	std::stringstream ss(t_ownership);
+	std::getline(ss, user, ':');
+	std::getline(ss, group, ':');
+	struct passwd* pwd = getpwnam(user.c_str());
+	struct group* grp = getgrnam(group.c_str());
+	if (pwd == NULL || grp == NULL) {
+		logRoot.warn("Can't resolve %s, the statistics feed stays owned by the probe", t_ownership.c_str());
+		return;
+	}
+	if (fchown(m_fd, pwd->pw_uid, grp->gr_gid) != 0) {
+		logRoot.warn("Failed to chown the statistics feed %s: %s", m_fileName.c_str(), strerror(errno));
+	}
+}
+
+void StatFeed::fillRecord(StatFeedRecord& t_slot, const StatRecord& t_statRecord, const uint64_t t_batchSeq) {
+	const TcpUdpSessionKey& sessionKey = t_statRecord.getTcpUdpSessionKey();
+	t_slot.batchSeq = t_batchSeq;
+	t_slot.timestampUs = t_statRecord.getTimestampEpoch();
+	t_slot.clientIp = sessionKey.m_clientIpRaw.s_addr;
+	t_slot.serverIp = sessionKey.m_serverIpRaw.s_addr;
+	t_slot.clientPort = sessionKey.m_clientPort;
+	t_slot.serverPort = sessionKey.m_serverPort;
+	t_slot.ipProtocol = t_statRecord.getIpProtocol();
+	t_slot.topology = t_statRecord.getTopology();
+	t_slot.interfaceId = sessionKey.m_interfaceId;
+	t_slot.errorCode = t_statRecord.getSessionErrorCode();
+	t_slot.samplingRate = t_statRecord.getSamplingRate();
+	t_slot.clientTag = t_statRecord.getClientTag();
+	t_slot.serverTag = t_statRecord.getServerTag();
+	t_slot.clientPackets = t_statRecord.getClientPackets();
+	t_slot.serverPackets = t_statRecord.getServerPackets();
+	t_slot.clientBytes = t_statRecord.getClientBytes();
+	t_slot.serverBytes = t_statRecord.getServerBytes();
+	t_slot.clientEfficientBytes = t_statRecord.getClientEfficientBytes();
+	t_slot.serverEfficientBytes = t_statRecord.getServerEfficientBytes();
+	t_slot.clientDuplicates = t_statRecord.getClientDuplicatesCounter();
+	t_slot.serverDuplicates = t_statRecord.getServerDuplicatesCounter();
+	t_slot.clientOutOfOrder = t_statRecord.getClientOutOfOrderCounter();
+	t_slot.serverOutOfOrder = t_statRecord.getServerOutOfOrderCounter();
+	t_slot.clientActiveGaps = t_statRecord.getClientActiveSequenceGaps();
+	t_slot.serverActiveGaps = t_statRecord.getServerActiveSequenceGaps();
+	t_slot.clientRetransmits = t_statRecord.getClientRetransmits();
+	t_slot.serverRetransmits = t_statRecord.getServerRetransmits();
+	t_slot.operations = t_statRecord.getOperations();
+	t_slot.clientIdleTimeUs = t_statRecord.getClientIdleTime();
+	t_slot.requestTimeUs = t_statRecord.getRequestTime();
+	t_slot.serverThinkTimeUs = t_statRecord.getServerThinkTime();
+	t_slot.responseTimeUs = t_statRecord.getResponseTime();
+	t_slot.totalSessionIdleTimeUs = t_statRecord.getTotalSessionIdleTime();
+	t_slot.rttUs = t_statRecord.getRtt();
+}
+
+void StatFeed::publish(const std::vector<StatRecord>& t_batch) {
+	uint64_t capacity = m_header->capacity;
+	uint64_t writeSeq = m_header->writeSeq; //only this thread writes it
+	uint64_t batchSeq = m_header->batchSeq + 1;
+	uint64_t newWriteSeq = writeSeq + t_batch.size();
+	uint64_t oldestKept = newWriteSeq > capacity ? newWriteSeq - capacity : 0;
+	uint64_t consumerSeq = __atomic_load_n(&m_header->consumerSeq, __ATOMIC_ACQUIRE);
+	uint64_t overwrittenBatches = m_header->overwrittenBatches;
+
+	if (!t_batch.empty()) m_publishedBatches.push_back(std::make_pair(writeSeq, newWriteSeq));
+	while (!m_publishedBatches.empty() && m_publishedBatches.front().first < oldestKept) {
+		if (m_publishedBatches.front().second > consumerSeq) overwrittenBatches++;
+		m_publishedBatches.pop_front();
+	}
+
+	//a batch larger than the ring keeps only its newest records
+	for (uint64_t seq = std::max(writeSeq, oldestKept); seq < newWriteSeq; seq++) {
+		StatFeedRecord& slot = m_records[seq % capacity];
+		__atomic_store_n(&slot.seq, 0, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		fillRecord(slot, t_batch[seq - writeSeq], batchSeq);
+		__atomic_store_n(&slot.seq, seq + 1, __ATOMIC_RELEASE);
+	}
+	__atomic_store_n(&m_header->writeSeq, newWriteSeq, __ATOMIC_RELEASE);
+	__atomic_store_n(&m_header->batchSeq, batchSeq, __ATOMIC_RELEASE);
+	if (overwrittenBatches != m_header->overwrittenBatches) {
+		//without confirmations from a consumer every wrapped batch is counted, that is not worth a warning
+		if (consumerSeq > 0) {
+			log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+			logRoot.warn("%" PRIu64 " batches of the statistics feed were overwritten before being read",
+							overwrittenBatches - m_header->overwrittenBatches);
+		}
+		__atomic_store_n(&m_header->overwrittenBatches, overwrittenBatches, __ATOMIC_RELEASE);
+	}
+}
+
+uint64_t StatFeed::getOverwrittenBatches() const {
+	return m_header->overwrittenBatches;
+}
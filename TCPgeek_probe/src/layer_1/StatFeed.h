@@ -0,0 +1,52 @@
+/*
+ *	StatFeed.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : StatFeed - publishes every harvested batch of StatRecord to the shared memory
+ *					ring described in StatFeedLayout.h, so local consumers can mmap the file and
+ *					read the records without file I/O or parsing. Publishing never blocks:
+ *					when consumers lag behind, the oldest records are overwritten and counted.
+ */
+
+#ifndef STATFEED_H_
+#define STATFEED_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+#include "layer_1/StatFeedLayout.h"
+#include "layer_1/StatRecord.h"
+
+class StatFeed {
+private:
+	std::string m_fileName;
+	int m_fd;
+	std::size_t m_mappedSize;
+	StatFeedHeader* m_header;
+	StatFeedRecord* m_records;
+	std::deque<std::pair<uint64_t, uint64_t> > m_publishedBatches;
+	//[first record, last record + 1) of the batches still present in the ring
+
+	void setOwnership(const std::string& t_ownership);
+	void fillRecord(StatFeedRecord& t_slot, const StatRecord& t_statRecord, const uint64_t t_batchSeq);
+
+public:
+	StatFeed(const std::string& t_fileName, const uint64_t t_capacity, const std::string& t_ownership);
+	//throws exceptions if the file can't be created or mapped
+	~StatFeed();
+
+	void publish(const std::vector<StatRecord>& t_batch);
+	//might be invoked only from the control thread
+	uint64_t getOverwrittenBatches() const;
+};
+
+#endif /* STATFEED_H_ */
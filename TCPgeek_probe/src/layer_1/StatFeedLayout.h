@@ -0,0 +1,91 @@
+/*
+ *	StatFeedLayout.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : Binary layout of the shared memory statistics feed (statFeedFile, normally
+ *					under /dev/shm). The header is followed by StatFeedHeader::capacity slots of
+ *					StatFeedRecord. Integers are in host byte order except IP addresses, which
+ *					stay in network byte order as in in_addr. The header has no dependencies,
+ *					so consumers can include it as is.
+ *
+ *	Producer (the probe), for every harvested batch:
+ *		for each record n = writeSeq, writeSeq + 1, ...:
+ *			slot = n % capacity
+ *			slot.seq = 0; release fence; fill the slot; slot.seq = n + 1 (release store)
+ *		writeSeq += batch size (release store), batchSeq += 1
+ *	The producer never waits for consumers. Records older than writeSeq - capacity are overwritten,
+ *	and every batch that is overwritten before consumerSeq passed it increments overwrittenBatches.
+ *
+ *	Consumer, for record n where readSeq <= n < writeSeq (acquire load):
+ *		s1 = slot.seq (acquire load); copy the slot; acquire fence; s2 = slot.seq
+ *		the copy is valid if s1 == s2 == n + 1, otherwise the record has been overwritten,
+ *		and the consumer should continue from writeSeq - capacity
+ *	A consumer may store the number of records it has read to consumerSeq, then the producer can
+ *	tell overwritten unread batches from the read ones. Without it every wrapped batch is counted.
+ *
+ *	The file is recreated on every probe start (startEpoch changes) and state becomes
+ *	STAT_FEED_STATE_CLOSED on a graceful stop. A consumer seeing either should reopen the file.
+ */
+
+#ifndef STATFEEDLAYOUT_H_
+#define STATFEEDLAYOUT_H_
+
+#include <stdint.h>
+
+#define STAT_FEED_MAGIC "TGFEED01"
+#define STAT_FEED_VERSION 3
+#define STAT_FEED_STATE_ACTIVE 1
+#define STAT_FEED_STATE_CLOSED 2
+
+struct StatFeedHeader {
+	char		magic[8];				//STAT_FEED_MAGIC
+	uint32_t	version;				//STAT_FEED_VERSION
+	uint32_t	headerSize;				//sizeof(StatFeedHeader), the first slot starts here
+	uint32_t	recordSize;				//sizeof(StatFeedRecord)
+	uint32_t	state;					//STAT_FEED_STATE_ACTIVE or STAT_FEED_STATE_CLOSED
+	uint64_t	capacity;				//number of record slots
+	int64_t		startEpoch;				//when the probe created the feed, seconds
+	uint64_t	writeSeq;				//records published so far, written by the producer
+	uint64_t	batchSeq;				//batches (statistics intervals) published so far
+	uint64_t	overwrittenBatches;		//batches overwritten before the consumer confirmed them
+	uint64_t	consumerSeq;			//records read, written by the consumer, optional
+	uint8_t		reserved[56];
+};
+
+struct StatFeedRecord {
+	uint64_t	seq;					//record number + 1 when the slot is consistent, 0 while it is written
+	uint64_t	batchSeq;				//number of the batch the record belongs to, starting with 1
+	uint64_t	timestampUs;			//epoch microseconds
+	uint32_t	clientIp;				//network byte order
+	uint32_t	serverIp;				//network byte order
+	uint16_t	clientPort;
+	uint16_t	serverPort;
+	uint8_t		ipProtocol;
+	char		topology;				//'i', 'o', 'n' or 'b' as in the TSV format
+	uint16_t	interfaceId;			//interface of a pcapng file, 0 for other sources
+	uint32_t	errorCode;
+	uint32_t	samplingRate;			//the session was admitted by 1:N flow sampling, 1 - not sampled
+	uint32_t	clientTag, serverTag;	//tags of the local subnets of the endpoints, 0 - outside or no tag
+	uint64_t	clientPackets, serverPackets;
+	uint64_t	clientBytes, serverBytes;
+	uint64_t	clientEfficientBytes, serverEfficientBytes;
+	uint64_t	clientDuplicates, serverDuplicates;
+	uint64_t	clientOutOfOrder, serverOutOfOrder;
+	uint64_t	clientActiveGaps, serverActiveGaps;
+	uint64_t	clientRetransmits, serverRetransmits;
+	uint64_t	operations;
+	uint64_t	clientIdleTimeUs, requestTimeUs, serverThinkTimeUs, responseTimeUs;
+	uint64_t	totalSessionIdleTimeUs;
+	uint64_t	rttUs;
+};
+
+static_assert(sizeof(StatFeedHeader) == 128, "StatFeedHeader layout changed");
+static_assert(sizeof(StatFeedRecord) == 224, "StatFeedRecord layout changed");
+
+#endif /* STATFEEDLAYOUT_H_ */
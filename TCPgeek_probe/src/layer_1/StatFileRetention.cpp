@@ -0,0 +1,163 @@
+/*
+ *	StatFileRetention.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "layer_1/StatFileRetention.h"
+
+StatFileRetention::StatFileRetention(const std::string& t_directory, const std::string& t_prefix, const std::string& t_suffix,
+										const time_t t_retentionSec, const uint64_t t_quotaBytes) :
+										m_directory {t_directory},
+										m_prefix {t_prefix},
+										m_suffixes {t_suffix},
+										m_totalBytes {0},
+										m_retentionSec {t_retentionSec},
+										m_quotaBytes {t_quotaBytes} {
+	m_dirFd = open(m_directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (m_dirFd == -1) {
+		throw std::runtime_error("Can't open statistics directory " + m_directory + ": " + strerror(errno));
+	}
+}
+
+StatFileRetention::~StatFileRetention() {
+	if (m_dirFd != -1) close(m_dirFd);
+}
+
+bool StatFileRetention::isOwnFile(const char* t_name) const {
+	std::size_t nameLen = strlen(t_name);
+	if (strncmp(t_name, m_prefix.c_str(), m_prefix.size()) != 0) return false;
+	for (std::size_t i = 0; i < m_suffixes.size(); i++) {
+		const std::string& suffix = m_suffixes[i];
+		if (nameLen >= m_prefix.size() + suffix.size() &&
+				strcmp(t_name + nameLen - suffix.size(), suffix.c_str()) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void StatFileRetention::addSuffix(const std::string& t_suffix) {
+	m_suffixes.push_back(t_suffix);
+}
+
+void StatFileRetention::insertSorted(const StatFileEntry& t_entry) {
+	//new files are almost always the newest ones, so searching from the back
+	std::deque<StatFileEntry>::iterator it = m_files.end();
+	while (it != m_files.begin() && (it - 1)->mtime > t_entry.mtime) {
+		--it;
+	}
+	m_files.insert(it, t_entry);
+	m_totalBytes += t_entry.size;
+}
+
+void StatFileRetention::scanDirectory() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	struct dirent* dirEntry;
+	struct stat fileStat;
+
+	m_files.clear();
+	m_totalBytes = 0;
+	//fdopendir takes ownership of the descriptor, so giving it a duplicate
+	int scanFd = dup(m_dirFd);
+	if (scanFd == -1) {
+		logRoot.error("Can't duplicate descriptor of %s: %s", m_directory.c_str(), strerror(errno));
+		return;
+	}
+	DIR* dir = fdopendir(scanFd);
+	if (dir == NULL) {
+		logRoot.error("Can't scan %s: %s", m_directory.c_str(), strerror(errno));
+		close(scanFd);
+		return;
+	}
+	rewinddir(dir);
+	while ((dirEntry = readdir(dir)) != NULL) {
+		if (!isOwnFile(dirEntry->d_name)) continue;
+		if (fstatat(m_dirFd, dirEntry->d_name, &fileStat, AT_SYMLINK_NOFOLLOW) != 0) continue;
+		if (!S_ISREG(fileStat.st_mode)) continue;
+		StatFileEntry entry;
+		entry.name = dirEntry->d_name;
+		entry.mtime = fileStat.st_mtime;
+		entry.size = fileStat.st_size;
+		insertSorted(entry);
+	}
+	closedir(dir);
+	logRoot.info("%zu statistics files of %" PRIu64 " bytes found in %s", m_files.size(), m_totalBytes, m_directory.c_str());
+}
+
+void StatFileRetention::registerFile(const std::string& t_fileName) {
+	struct stat fileStat;
+	if (fstatat(m_dirFd, t_fileName.c_str(), &fileStat, AT_SYMLINK_NOFOLLOW) != 0) {
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.warn("Can't stat statistics file %s: %s", t_fileName.c_str(), strerror(errno));
+		return;
+	}
+	StatFileEntry entry;
+	entry.name = t_fileName;
+	entry.mtime = fileStat.st_mtime;
+	entry.size = fileStat.st_size;
+	insertSorted(entry);
+}
+
+bool StatFileRetention::removeOldest() {
+	if (m_files.empty()) return false;
+	const StatFileEntry& oldest = m_files.front();
+	//ENOENT means somebody else removed it, so just forgetting it
+	if (unlinkat(m_dirFd, oldest.name.c_str(), 0) != 0 && errno != ENOENT) {
+		//the file still takes its space, it is tried again on the next interval
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.error("Can't remove statistics file %s: %s", oldest.name.c_str(), strerror(errno));
+		return false;
+	}
+	m_totalBytes -= oldest.size;
+	m_files.pop_front();
+	return true;
+}
+
+uint32_t StatFileRetention::prune() {
+	uint32_t removedFiles = 0;
+
+	if (m_retentionSec > 0) {
+		time_t oldestAllowed = std::time(nullptr) - m_retentionSec;
+		while (!m_files.empty() && m_files.front().mtime < oldestAllowed) {
+			if (!removeOldest()) return removedFiles;
+			removedFiles++;
+		}
+	}
+	if (m_quotaBytes > 0) {
+		//the newest file is never removed, otherwise a single huge interval would wipe itself out
+		while (m_files.size() > 1 && m_totalBytes > m_quotaBytes) {
+			if (!removeOldest()) return removedFiles;
+			removedFiles++;
+		}
+	}
+	return removedFiles;
+}
+
+int StatFileRetention::getDirFd() const {
+	return m_dirFd;
+}
+
+uint64_t StatFileRetention::getTotalBytes() const {
+	return m_totalBytes;
+}
+
+std::size_t StatFileRetention::getFilesCount() const {
+	return m_files.size();
+}
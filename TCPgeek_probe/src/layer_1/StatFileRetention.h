@@ -0,0 +1,70 @@
+/*
+ *	StatFileRetention.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : StatFileRetention - keeps the list of statistics files produced by the probe
+ *					in the statistics directory and removes the oldest of them when they exceed
+ *					the retention period or the disk quota. The files of every kind the probe writes
+ *					share the one list, so the quota is the byte budget of the whole directory. Works in-process with openat/unlinkat
+ *					on a directory descriptor, so no shell is spawned on the control thread.
+ */
+
+#ifndef STATFILERETENTION_H_
+#define STATFILERETENTION_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <stdint.h>
+#include <sys/types.h>
+
+struct StatFileEntry {
+	std::string name;	//file name relative to the statistics directory
+	time_t		mtime;	//last modification time
+	uint64_t	size;	//size in bytes
+};
+
+class StatFileRetention {
+private:
+	int m_dirFd;
+	std::string m_directory;
+	std::string m_prefix;
+	std::vector<std::string> m_suffixes; //our files are <m_prefix>*<one of m_suffixes>
+	std::deque<StatFileEntry> m_files; //ordered by modification time, the oldest first
+	uint64_t m_totalBytes;
+	time_t m_retentionSec; //0 - keep forever
+	uint64_t m_quotaBytes; //0 - no quota
+
+	bool isOwnFile(const char* t_name) const;
+	void insertSorted(const StatFileEntry& t_entry);
+	bool removeOldest();
+	//returns false if there is no file or it can't be removed, the file is kept in the list then
+
+public:
+	StatFileRetention(const std::string& t_directory, const std::string& t_prefix, const std::string& t_suffix,
+						const time_t t_retentionSec, const uint64_t t_quotaBytes);
+	//throws exceptions if the directory can't be opened
+	~StatFileRetention();
+
+	void addSuffix(const std::string& t_suffix);
+	//one more kind of our files, to be added before scanDirectory()
+	void scanDirectory();
+	//rebuilds the list of our files from the directory content, used once at start up
+	void registerFile(const std::string& t_fileName);
+	//adds a freshly written file to the list, the file name is relative to the directory
+	uint32_t prune();
+	//removes files older than retention period and the oldest files while the quota is exceeded
+	//stops at the first file that can't be removed, returns number of removed files
+	int getDirFd() const;
+	uint64_t getTotalBytes() const;
+	std::size_t getFilesCount() const;
+};
+
+#endif /* STATFILERETENTION_H_ */
@@ -13,7 +13,7 @@
  *	StatRecord.cpp
  *
  *  Created on: Mar 28, 2022
- *	Last modified on: Mar 22, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -49,7 +49,10 @@ StatRecord::StatRecord() :
 				m_responseTime {0},
 				m_totalSessionIdleTime {0},
 				m_sessionErrorCode {0},
-				m_rtt {0} {
+				m_rtt {0},
+				m_samplingRate {1} {
+	memset(&m_location, 0, sizeof(m_location));
+	m_location.topology = 'n';
 
 }
 
@@ -66,7 +69,7 @@ void StatRecord::setStatRecord(const uint64_t t_timestampEpoch, const TcpUdpSess
 								const uint64_t t_operations, const uint64_t t_clientIdleTime, const uint64_t t_requestTime,
 								const uint64_t t_serverThinkTime, const uint64_t t_responseTime,
 								const uint64_t t_totalSessionIdleTime, const uint64_t t_sessionErrorCode,
-								const uint64_t t_rtt) {
+								const uint64_t t_rtt, const uint32_t t_samplingRate, const SessionLocation& t_location) {
 	m_timestampEpoch = t_timestampEpoch;
 	m_tcpUdpSessionKey = t_tcpSessionKey;
 	m_ipProtocol = t_ipProtocol;
@@ -96,6 +99,28 @@ void StatRecord::setStatRecord(const uint64_t t_timestampEpoch, const TcpUdpSess
 	m_totalSessionIdleTime = t_totalSessionIdleTime;
 	m_sessionErrorCode = t_sessionErrorCode;
 	m_rtt = t_rtt;
+	m_samplingRate = t_samplingRate;
+	m_location = t_location;
+}
+
+uint32_t StatRecord::getSamplingRate() const {
+	return m_samplingRate;
+}
+
+char StatRecord::getTopology() const {
+	return m_location.topology;
+}
+
+uint32_t StatRecord::getClientTag() const {
+	return m_location.clientTag;
+}
+
+uint32_t StatRecord::getServerTag() const {
+	return m_location.serverTag;
+}
+
+const SessionLocation& StatRecord::getLocation() const {
+	return m_location;
 }
 
 uint64_t StatRecord::getClientPackets() const {
@@ -2,7 +2,7 @@
  *	StatRecord.h
  *
  *  Created on: Mar 28, 2022
- *	Last modified on: Mar 22, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -16,6 +16,7 @@
 #define STATRECORD_H_
 
 #include "layer_1/sessions/TcpUdpSessionKey.h"
+#include "layer_1/LocalSubnets.h"
 
 class StatRecord {
 private:
@@ -39,6 +40,8 @@ private:
 	uint64_t m_totalSessionIdleTime;
 	u_int32_t m_sessionErrorCode;
 	uint64_t m_rtt;
+	uint32_t m_samplingRate; //1:N flow sampling the session was admitted with, 1 - not sampled
+	SessionLocation m_location; //local subnets of the client and the server
 
 public:
 	StatRecord();
@@ -56,11 +59,12 @@ public:
 						const uint64_t t_operations, const uint64_t t_clientIdleTime, const uint64_t t_requestTime,
 						const uint64_t t_serverThinkTime, const uint64_t t_responseTime,
 						const uint64_t t_totalUnexplainedTime, const uint64_t t_totalExplainedTime,
-						const uint64_t t_rtt);
+						const uint64_t t_rtt, const uint32_t t_samplingRate, const SessionLocation& t_location);
 	//might be invoked only from the main thread of capturing
 	//updates single node of std::list that will be put to the SafeQueue<StatRecord> _statQueue
 	//and then stored in the log file during tcp sessions aggregation
 
+	StatRecord(const StatRecord& other) = default;
 	StatRecord& operator = (const StatRecord other)
 	{
 		m_timestampEpoch = other.m_timestampEpoch;
@@ -92,6 +96,8 @@ public:
 		m_totalSessionIdleTime = other.m_totalSessionIdleTime;
 		m_sessionErrorCode  = other.m_sessionErrorCode;
 		m_rtt = other.m_rtt;
+		m_samplingRate = other.m_samplingRate;
+		m_location = other.m_location;
 		return *this;
 	}
 
@@ -113,6 +119,11 @@ public:
 	uint64_t getServerThinkTime() const;
 	u_int32_t getSessionErrorCode() const;
 	uint64_t getTotalSessionIdleTime() const;
+	uint32_t getSamplingRate() const;
+	char getTopology() const;
+	uint32_t getClientTag() const;
+	uint32_t getServerTag() const;
+	const SessionLocation& getLocation() const;
 
 	const TcpUdpSessionKey& getTcpUdpSessionKey() const;
 	uint64_t getClientBytes() const;
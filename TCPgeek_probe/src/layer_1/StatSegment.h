@@ -0,0 +1,84 @@
+/*
+ *	StatSegment.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : On-disk layout of the hourly statistics segment files written when
+ *					statisticsFormat = segment. All integers are in host byte order
+ *					(little-endian on x86), all structures are 8 byte aligned.
+ *
+ *	<template>_YYYYMMDD-HH[_N].seg, the hour is in local time as for the other statistics files
+ *	+----------------------------+
+ *	| StatSegmentHeader          |  once, at offset 0
+ *	+----------------------------+
+ *	| StatSegmentBlockHeader     |  one block per writeStat() call (statistics interval)
+ *	| payload: TSV lines         |  exactly the lines of the plain TSV format
+ *	+----------------------------+
+ *	| ...                        |
+ *	+----------------------------+
+ *	| StatSegmentIndexEntry[n]   |  footer, written when the hour is over or the probe stops
+ *	| bloom filter bits          |  server IP/port filter of the whole segment
+ *	| StatSegmentTrailer         |  always the last sizeof(StatSegmentTrailer) bytes
+ *	+----------------------------+
+ *
+ *	A segment without a valid trailer is still being written (or the probe crashed),
+ *	its blocks can be read sequentially by following payloadSize of each block header.
+ */
+
+#ifndef STATSEGMENT_H_
+#define STATSEGMENT_H_
+
+#include <stdint.h>
+
+#define STAT_SEGMENT_MAGIC "TGSEG001"
+#define STAT_SEGMENT_TRAILER_MAGIC "TGSEGEND"
+#define STAT_SEGMENT_BLOCK_MAGIC 0x42494754 // "TGIB"
+#define STAT_SEGMENT_VERSION 1
+#define STAT_SEGMENT_EXT "seg"
+
+struct StatSegmentHeader {
+	char		magic[8];			//STAT_SEGMENT_MAGIC
+	uint32_t	version;			//STAT_SEGMENT_VERSION
+	uint32_t	headerSize;			//sizeof(StatSegmentHeader)
+	int64_t		hourStartEpoch;		//epoch seconds of the start of the local time hour in the file name
+	uint64_t	reserved;
+};
+
+struct StatSegmentBlockHeader {
+	uint32_t	magic;				//STAT_SEGMENT_BLOCK_MAGIC
+	uint32_t	recordCount;		//number of TSV lines in the payload
+	int64_t		intervalEpoch;		//UTC epoch seconds when the interval was written
+	uint64_t	payloadSize;		//bytes of payload that follow the header
+	uint64_t	reserved;
+};
+
+struct StatSegmentIndexEntry {
+	int64_t		intervalEpoch;		//same as in the block header
+	int64_t		minRecordEpoch;		//the oldest record timestamp in the block, seconds
+	int64_t		maxRecordEpoch;		//the newest record timestamp in the block, seconds
+	uint64_t	blockOffset;		//offset of StatSegmentBlockHeader from the file start
+	uint64_t	payloadSize;
+	uint32_t	recordCount;
+	uint32_t	reserved;
+};
+
+struct StatSegmentTrailer {
+	uint64_t	indexOffset;		//offset of the first StatSegmentIndexEntry
+	uint32_t	indexCount;			//number of StatSegmentIndexEntry records
+	uint32_t	bloomBytes;			//size of the bloom filter that follows the index
+	uint32_t	bloomHashes;		//number of hash functions of the bloom filter
+	uint32_t	reserved;
+	char		magic[8];			//STAT_SEGMENT_TRAILER_MAGIC
+};
+
+static_assert(sizeof(StatSegmentHeader) == 32, "StatSegmentHeader layout changed");
+static_assert(sizeof(StatSegmentBlockHeader) == 32, "StatSegmentBlockHeader layout changed");
+static_assert(sizeof(StatSegmentIndexEntry) == 48, "StatSegmentIndexEntry layout changed");
+static_assert(sizeof(StatSegmentTrailer) == 32, "StatSegmentTrailer layout changed");
+
+#endif /* STATSEGMENT_H_ */
@@ -0,0 +1,152 @@
+/*
+ *	StatSegmentReader.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "layer_1/StatSegmentReader.h"
+
+StatSegmentReader::StatSegmentReader() : m_fd {-1}, m_fileSize {0}, m_dataEnd {0}, m_sealed {false} {
+	memset(&m_header, 0, sizeof(m_header));
+}
+
+StatSegmentReader::~StatSegmentReader() {
+	close();
+}
+
+void StatSegmentReader::close() {
+	if (m_fd != -1) ::close(m_fd);
+	m_fd = -1;
+	m_index.clear();
+	m_sealed = false;
+}
+
+bool StatSegmentReader::readExactly(void* t_buffer, const uint64_t t_size, const uint64_t t_offset) const {
+	uint64_t done = 0;
+	while (done < t_size) {
+		ssize_t res = pread(m_fd, (char*) t_buffer + done, t_size - done, t_offset + done);
+		if (res <= 0) return false;
+		done += res;
+	}
+	return true;
+}
+
+bool StatSegmentReader::open(const int t_dirFd, const char* t_fileName) {
+	struct stat fileStat;
+
+	close();
+	m_fd = openat(t_dirFd, t_fileName, O_RDONLY | O_CLOEXEC);
+	if (m_fd == -1) return false;
+	if (fstat(m_fd, &fileStat) != 0) {
+		close();
+		return false;
+	}
+	m_fileSize = fileStat.st_size;
+	if (m_fileSize < sizeof(StatSegmentHeader) || !readExactly(&m_header, sizeof(m_header), 0) ||
+			memcmp(m_header.magic, STAT_SEGMENT_MAGIC, sizeof(m_header.magic)) != 0 ||
+			m_header.version != STAT_SEGMENT_VERSION) {
+		close();
+		return false;
+	}
+	m_sealed = readFooter();
+	if (!m_sealed) scanBlocks();
+	return true;
+}
+
+bool StatSegmentReader::readFooter() {
+	StatSegmentTrailer trailer;
+
+	if (m_fileSize < sizeof(StatSegmentHeader) + sizeof(StatSegmentTrailer)) return false;
+	if (!readExactly(&trailer, sizeof(trailer), m_fileSize - sizeof(trailer))) return false;
+	if (memcmp(trailer.magic, STAT_SEGMENT_TRAILER_MAGIC, sizeof(trailer.magic)) != 0) return false;
+	uint64_t footerSize = (uint64_t) trailer.indexCount * sizeof(StatSegmentIndexEntry) + trailer.bloomBytes + sizeof(trailer);
+	if (trailer.indexOffset + footerSize != m_fileSize) return false;
+
+	m_index.resize(trailer.indexCount);
+	if (trailer.indexCount > 0 &&
+			!readExactly(&m_index[0], trailer.indexCount * sizeof(StatSegmentIndexEntry), trailer.indexOffset)) {
+		m_index.clear();
+		return false;
+	}
+	std::vector<uint8_t> bloomBits(trailer.bloomBytes);
+	if (trailer.bloomBytes > 0 &&
+			!readExactly(&bloomBits[0], trailer.bloomBytes, trailer.indexOffset + trailer.indexCount * sizeof(StatSegmentIndexEntry))) {
+		m_index.clear();
+		return false;
+	}
+	m_bloomFilter = ServiceBloomFilter(bloomBits, trailer.bloomHashes);
+	m_dataEnd = trailer.indexOffset;
+	return true;
+}
+
+void StatSegmentReader::scanBlocks() {
+	StatSegmentBlockHeader blockHeader;
+	uint64_t offset = sizeof(StatSegmentHeader);
+
+	m_index.clear();
+	while (offset + sizeof(blockHeader) <= m_fileSize) {
+		if (!readExactly(&blockHeader, sizeof(blockHeader), offset)) break;
+		if (blockHeader.magic != STAT_SEGMENT_BLOCK_MAGIC) break;
+		if (offset + sizeof(blockHeader) + blockHeader.payloadSize > m_fileSize) break; //torn write
+		StatSegmentIndexEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.intervalEpoch = blockHeader.intervalEpoch;
+		//record timestamps are not known without parsing, so the interval covers everything before it
+		entry.minRecordEpoch = 0;
+		entry.maxRecordEpoch = blockHeader.intervalEpoch;
+		entry.blockOffset = offset;
+		entry.payloadSize = blockHeader.payloadSize;
+		entry.recordCount = blockHeader.recordCount;
+		m_index.push_back(entry);
+		offset += sizeof(blockHeader) + blockHeader.payloadSize;
+	}
+	m_dataEnd = offset;
+}
+
+bool StatSegmentReader::isSealed() const {
+	return m_sealed;
+}
+
+int64_t StatSegmentReader::getHourStartEpoch() const {
+	return m_header.hourStartEpoch;
+}
+
+uint64_t StatSegmentReader::getDataEnd() const {
+	return m_dataEnd;
+}
+
+const std::vector<StatSegmentIndexEntry>& StatSegmentReader::getIndex() const {
+	return m_index;
+}
+
+bool StatSegmentReader::mayContainService(const in_addr t_serverIpRaw, const u_short t_serverPort) const {
+	if (!m_sealed) return true;
+	return m_bloomFilter.mayContain(ServiceBloomFilter::serviceKey(t_serverIpRaw, t_serverPort));
+}
+
+std::vector<StatSegmentIndexEntry> StatSegmentReader::findIntervals(const int64_t t_fromEpoch, const int64_t t_toEpoch) const {
+	std::vector<StatSegmentIndexEntry> result;
+	for (std::size_t i = 0; i < m_index.size(); i++) {
+		if (m_index[i].maxRecordEpoch >= t_fromEpoch && m_index[i].minRecordEpoch <= t_toEpoch) {
+			result.push_back(m_index[i]);
+		}
+	}
+	return result;
+}
+
+bool StatSegmentReader::readInterval(const StatSegmentIndexEntry& t_entry, std::string& t_payload) const {
+	t_payload.resize(t_entry.payloadSize);
+	if (t_entry.payloadSize == 0) return true;
+	return readExactly(&t_payload[0], t_entry.payloadSize, t_entry.blockOffset + sizeof(StatSegmentBlockHeader));
+}
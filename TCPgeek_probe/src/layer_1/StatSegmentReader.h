@@ -0,0 +1,61 @@
+/*
+ *	StatSegmentReader.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : StatSegmentReader - reads the footer of a statistics segment, so a consumer
+ *					can check the bloom filter and seek straight to the intervals it needs.
+ *					Segments without a footer (open or orphaned) are indexed by a sequential
+ *					scan of their block headers.
+ */
+
+#ifndef STATSEGMENTREADER_H_
+#define STATSEGMENTREADER_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+#include "layer_1/StatSegment.h"
+#include "layer_1/ServiceBloomFilter.h"
+
+class StatSegmentReader {
+private:
+	int m_fd;
+	uint64_t m_fileSize;
+	uint64_t m_dataEnd; //offset right after the last complete block
+	StatSegmentHeader m_header;
+	std::vector<StatSegmentIndexEntry> m_index;
+	ServiceBloomFilter m_bloomFilter;
+	bool m_sealed;
+
+	bool readFooter();
+	void scanBlocks();
+	bool readExactly(void* t_buffer, const uint64_t t_size, const uint64_t t_offset) const;
+public:
+	StatSegmentReader();
+	~StatSegmentReader();
+
+	bool open(const int t_dirFd, const char* t_fileName);
+	//returns false if the file is not a statistics segment
+	void close();
+	bool isSealed() const;
+	//true if the segment has a valid footer
+	int64_t getHourStartEpoch() const;
+	uint64_t getDataEnd() const;
+	const std::vector<StatSegmentIndexEntry>& getIndex() const;
+	bool mayContainService(const in_addr t_serverIpRaw, const u_short t_serverPort) const;
+	//false means the segment surely has no records of the service
+	std::vector<StatSegmentIndexEntry> findIntervals(const int64_t t_fromEpoch, const int64_t t_toEpoch) const;
+	//intervals having records with timestamps within [t_fromEpoch, t_toEpoch]
+	bool readInterval(const StatSegmentIndexEntry& t_entry, std::string& t_payload) const;
+	//reads TSV lines of the interval
+};
+
+#endif /* STATSEGMENTREADER_H_ */
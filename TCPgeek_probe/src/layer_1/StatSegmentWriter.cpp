@@ -0,0 +1,278 @@
+/*
+ *	StatSegmentWriter.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sstream>
+#include <algorithm>
+#include <sys/uio.h>
+#include <log4cpp/Category.hh> // for logging capabilities
+
+#include "layer_1/StatSegmentWriter.h"
+#include "layer_1/StatSegmentReader.h"
+#include "layer_1/ServiceBloomFilter.h"
+
+StatSegmentWriter::StatSegmentWriter(const int t_dirFd, const std::string& t_prefix) :
+										m_dirFd {t_dirFd},
+										m_prefix {t_prefix},
+										m_fd {-1},
+										m_hourStartEpoch {0},
+										m_offset {0} {
+}
+
+StatSegmentWriter::~StatSegmentWriter() {
+	closeSegment();
+}
+
+int64_t StatSegmentWriter::getHourStart(const time_t t_time) {
+	struct tm timeinfo;
+	localtime_r(&t_time, &timeinfo);
+	timeinfo.tm_min = 0;
+	timeinfo.tm_sec = 0;
+	return (int64_t) mktime(&timeinfo);
+}
+
+bool StatSegmentWriter::writeAll(const int t_fd, const void* t_buffer, const uint64_t t_size, const uint64_t t_offset) {
+	uint64_t done = 0;
+	while (done < t_size) {
+		ssize_t res = pwrite(t_fd, (const char*) t_buffer + done, t_size - done, t_offset + done);
+		if (res < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+		done += res;
+	}
+	return true;
+}
+
+bool StatSegmentWriter::openSegment(const int64_t t_hourStartEpoch) {
+	char timeStr[32];
+	time_t hourStart = t_hourStartEpoch;
+	struct tm timeinfo;
+	StatSegmentHeader header;
+
+	localtime_r(&hourStart, &timeinfo);
+	strftime(timeStr, sizeof timeStr, "%Y%m%d-%H", &timeinfo);
+	//a segment of this hour might be left by a previous run, never appending to foreign files
+	for (int i = 0; m_fd == -1; i++) {
+		m_fileName = m_prefix + "_" + timeStr + (i == 0 ? "" : "_" + std::to_string(i)) + "." + STAT_SEGMENT_EXT;
+		m_fd = openat(m_dirFd, m_fileName.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+		if (m_fd == -1 && errno != EEXIST) {
+			log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+			logRoot.error("Can't create statistics segment %s: %s", m_fileName.c_str(), strerror(errno));
+			m_fileName.clear();
+			return false;
+		}
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, STAT_SEGMENT_MAGIC, sizeof(header.magic));
+	header.version = STAT_SEGMENT_VERSION;
+	header.headerSize = sizeof(header);
+	header.hourStartEpoch = t_hourStartEpoch;
+	if (!writeAll(m_fd, &header, sizeof(header), 0)) {
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.error("Can't write statistics segment %s: %s", m_fileName.c_str(), strerror(errno));
+		close(m_fd);
+		m_fd = -1;
+		m_fileName.clear();
+		return false;
+	}
+	m_hourStartEpoch = t_hourStartEpoch;
+	m_offset = sizeof(header);
+	m_index.clear();
+	m_serviceKeys.clear();
+	return true;
+}
+
+bool StatSegmentWriter::isOpen() const {
+	return m_fd != -1;
+}
+
+bool StatSegmentWriter::isRotationDue(const time_t t_now) const {
+	return (m_fd != -1) && (getHourStart(t_now) != m_hourStartEpoch);
+}
+
+bool StatSegmentWriter::appendInterval(const time_t t_now, const std::vector<StatRecord>& t_batch, const std::string& t_payload) {
+	StatSegmentBlockHeader blockHeader;
+	StatSegmentIndexEntry entry;
+
+	if (m_fd == -1 && !openSegment(getHourStart(t_now))) return false;
+
+	memset(&entry, 0, sizeof(entry));
+	entry.intervalEpoch = t_now;
+	entry.minRecordEpoch = INT64_MAX;
+	entry.maxRecordEpoch = 0;
+	entry.blockOffset = m_offset;
+	entry.payloadSize = t_payload.size();
+	entry.recordCount = t_batch.size();
+	for (std::size_t i = 0; i < t_batch.size(); i++) {
+		int64_t recordEpoch = t_batch[i].getTimestampEpoch()/1000000;
+		if (recordEpoch < entry.minRecordEpoch) entry.minRecordEpoch = recordEpoch;
+		if (recordEpoch > entry.maxRecordEpoch) entry.maxRecordEpoch = recordEpoch;
+		m_serviceKeys.insert(ServiceBloomFilter::serviceKey(t_batch[i].getTcpUdpSessionKey().m_serverIpRaw,
+															t_batch[i].getTcpUdpSessionKey().m_serverPort));
+	}
+	if (t_batch.empty()) entry.minRecordEpoch = 0;
+
+	memset(&blockHeader, 0, sizeof(blockHeader));
+	blockHeader.magic = STAT_SEGMENT_BLOCK_MAGIC;
+	blockHeader.recordCount = entry.recordCount;
+	blockHeader.intervalEpoch = entry.intervalEpoch;
+	blockHeader.payloadSize = entry.payloadSize;
+
+	//header and payload go in one system call, so a reader never sees a header without its payload
+	struct iovec iov[2];
+	iov[0].iov_base = &blockHeader;
+	iov[0].iov_len = sizeof(blockHeader);
+	iov[1].iov_base = (void*) t_payload.data();
+	iov[1].iov_len = t_payload.size();
+	ssize_t expected = sizeof(blockHeader) + t_payload.size();
+	ssize_t written = pwritev(m_fd, iov, 2, m_offset);
+	if (written != expected) {
+		//a short write may stop inside the header, so its rest goes first and the payload follows it
+		std::size_t headerDone = (written < 0) ? 0 : std::min((std::size_t) written, sizeof(blockHeader));
+		std::size_t payloadDone = (written < 0) ? 0 : written - headerDone;
+		if (written < 0 ||
+				!writeAll(m_fd, (const char*) &blockHeader + headerDone, sizeof(blockHeader) - headerDone, m_offset + headerDone) ||
+				!writeAll(m_fd, t_payload.data() + payloadDone, t_payload.size() - payloadDone,
+						m_offset + sizeof(blockHeader) + payloadDone)) {
+			log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+			logRoot.error("Can't append interval to statistics segment %s: %s", m_fileName.c_str(), strerror(errno));
+			return false;
+		}
+	}
+	m_offset += expected;
+	m_index.push_back(entry);
+	return true;
+}
+
+bool StatSegmentWriter::writeFooter(const int t_fd, const uint64_t t_offset, const std::vector<StatSegmentIndexEntry>& t_index,
+									const std::unordered_set<uint64_t>& t_serviceKeys) {
+	ServiceBloomFilter bloomFilter(t_serviceKeys);
+	StatSegmentTrailer trailer;
+	std::string footer;
+
+	memset(&trailer, 0, sizeof(trailer));
+	trailer.indexOffset = t_offset;
+	trailer.indexCount = t_index.size();
+	trailer.bloomBytes = bloomFilter.getBits().size();
+	trailer.bloomHashes = bloomFilter.getHashes();
+	memcpy(trailer.magic, STAT_SEGMENT_TRAILER_MAGIC, sizeof(trailer.magic));
+
+	footer.reserve(t_index.size() * sizeof(StatSegmentIndexEntry) + trailer.bloomBytes + sizeof(trailer));
+	if (!t_index.empty()) footer.append((const char*) &t_index[0], t_index.size() * sizeof(StatSegmentIndexEntry));
+	footer.append((const char*) &bloomFilter.getBits()[0], trailer.bloomBytes);
+	footer.append((const char*) &trailer, sizeof(trailer));
+	if (!writeAll(t_fd, footer.data(), footer.size(), t_offset)) return false;
+	//drops a torn tail of a crashed run, if there was one after t_offset
+	return ftruncate(t_fd, t_offset + footer.size()) == 0;
+}
+
+std::string StatSegmentWriter::closeSegment() {
+	std::string closedFileName;
+
+	if (m_fd == -1) return closedFileName;
+	if (!writeFooter(m_fd, m_offset, m_index, m_serviceKeys)) {
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.error("Can't write the footer of statistics segment %s: %s", m_fileName.c_str(), strerror(errno));
+	}
+	close(m_fd);
+	m_fd = -1;
+	closedFileName = m_fileName;
+	m_fileName.clear();
+	m_index.clear();
+	m_serviceKeys.clear();
+	return closedFileName;
+}
+
+const std::string& StatSegmentWriter::getFileName() const {
+	return m_fileName;
+}
+
+void StatSegmentWriter::parsePayload(const std::string& t_payload, StatSegmentIndexEntry& t_entry,
+										std::unordered_set<uint64_t>& t_serviceKeys) {
+	//Timestamp, IP Protocol, Client IP, Client Port, Server IP, Server Port, ...
+	std::istringstream lines(t_payload);
+	std::string line;
+	t_entry.minRecordEpoch = INT64_MAX;
+	t_entry.maxRecordEpoch = 0;
+	while (std::getline(lines, line)) {
+		std::string fields[6];
+		std::istringstream lineStream(line);
+		int i = 0;
+		while (i < 6 && std::getline(lineStream, fields[i], '\t')) i++;
+		if (i < 6) continue;
+		struct tm timestampTm;
+		memset(&timestampTm, 0, sizeof(timestampTm));
+		if (strptime(fields[0].c_str(), "%Y-%m-%d %H:%M:%S", &timestampTm) != NULL) {
+			int64_t recordEpoch = timegm(&timestampTm);
+			if (recordEpoch < t_entry.minRecordEpoch) t_entry.minRecordEpoch = recordEpoch;
+			if (recordEpoch > t_entry.maxRecordEpoch) t_entry.maxRecordEpoch = recordEpoch;
+		}
+		in_addr serverIpRaw;
+		if (inet_pton(AF_INET, fields[4].c_str(), &serverIpRaw) == 1) {
+			t_serviceKeys.insert(ServiceBloomFilter::serviceKey(serverIpRaw, (u_short) strtoul(fields[5].c_str(), NULL, 10)));
+		}
+	}
+	if (t_entry.minRecordEpoch == INT64_MAX) t_entry.minRecordEpoch = 0;
+}
+
+uint32_t StatSegmentWriter::sealOrphans() {
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	std::string suffix = std::string(".") + STAT_SEGMENT_EXT;
+	std::vector<std::string> orphans;
+	struct dirent* dirEntry;
+	uint32_t sealed = 0;
+
+	int scanFd = dup(m_dirFd);
+	if (scanFd == -1) return 0;
+	DIR* dir = fdopendir(scanFd);
+	if (dir == NULL) {
+		close(scanFd);
+		return 0;
+	}
+	rewinddir(dir);
+	while ((dirEntry = readdir(dir)) != NULL) {
+		std::string name = dirEntry->d_name;
+		if (name.compare(0, m_prefix.size(), m_prefix) != 0) continue;
+		if (name.size() < suffix.size() || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+		if (name == m_fileName) continue;
+		orphans.push_back(name);
+	}
+	closedir(dir);
+
+	for (std::size_t i = 0; i < orphans.size(); i++) {
+		StatSegmentReader reader;
+		if (!reader.open(m_dirFd, orphans[i].c_str()) || reader.isSealed()) continue;
+		std::vector<StatSegmentIndexEntry> index = reader.getIndex();
+		std::unordered_set<uint64_t> serviceKeys;
+		std::string payload;
+		for (std::size_t j = 0; j < index.size(); j++) {
+			if (reader.readInterval(index[j], payload)) parsePayload(payload, index[j], serviceKeys);
+		}
+		int fd = openat(m_dirFd, orphans[i].c_str(), O_WRONLY | O_CLOEXEC);
+		if (fd == -1) continue;
+		if (writeFooter(fd, reader.getDataEnd(), index, serviceKeys)) {
+			logRoot.info("Statistics segment %s left by the previous run was sealed with %zu intervals",
+							orphans[i].c_str(), index.size());
+			sealed++;
+		} else {
+			logRoot.error("Can't seal statistics segment %s: %s", orphans[i].c_str(), strerror(errno));
+		}
+		close(fd);
+	}
+	return sealed;
+}
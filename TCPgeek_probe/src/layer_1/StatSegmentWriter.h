@@ -0,0 +1,65 @@
+/*
+ *	StatSegmentWriter.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : StatSegmentWriter - appends statistics intervals to the hourly segment file
+ *					(see StatSegment.h for the layout). The file is opened once per hour and
+ *					sealed with the index and the server IP/port bloom filter when the hour
+ *					is over or when the probe stops.
+ */
+
+#ifndef STATSEGMENTWRITER_H_
+#define STATSEGMENTWRITER_H_
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <ctime>
+#include <stdint.h>
+
+#include "layer_1/StatSegment.h"
+#include "layer_1/StatRecord.h"
+
+class StatSegmentWriter {
+private:
+	int m_dirFd;
+	std::string m_prefix;
+	int m_fd;
+	std::string m_fileName; //relative to the statistics directory, empty if no segment is open
+	int64_t m_hourStartEpoch;
+	uint64_t m_offset;
+	std::vector<StatSegmentIndexEntry> m_index;
+	std::unordered_set<uint64_t> m_serviceKeys;
+
+	bool openSegment(const int64_t t_hourStartEpoch);
+	static int64_t getHourStart(const time_t t_time);
+	static bool writeAll(const int t_fd, const void* t_buffer, const uint64_t t_size, const uint64_t t_offset);
+	static bool writeFooter(const int t_fd, const uint64_t t_offset, const std::vector<StatSegmentIndexEntry>& t_index,
+							const std::unordered_set<uint64_t>& t_serviceKeys);
+	static void parsePayload(const std::string& t_payload, StatSegmentIndexEntry& t_entry,
+								std::unordered_set<uint64_t>& t_serviceKeys);
+	//restores record time range and services of an interval from its TSV lines
+
+public:
+	StatSegmentWriter(const int t_dirFd, const std::string& t_prefix);
+	~StatSegmentWriter();
+
+	bool isOpen() const;
+	bool isRotationDue(const time_t t_now) const;
+	//true if the open segment belongs to another hour
+	bool appendInterval(const time_t t_now, const std::vector<StatRecord>& t_batch, const std::string& t_payload);
+	//opens the segment of the current hour if needed and appends one block with a single write
+	std::string closeSegment();
+	//writes the footer and closes the segment, returns its file name
+	const std::string& getFileName() const;
+	uint32_t sealOrphans();
+	//seals segments left without the footer by a previous run, returns their number
+};
+
+#endif /* STATSEGMENTWRITER_H_ */
@@ -2,7 +2,7 @@
  *	StatWriter.cpp
  *
  *	Created on: Oct 12, 2023
- *	Last modified on: March 22, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -21,16 +21,21 @@ StatWriter::StatWriter() { //throws exceptions
 			throw std::runtime_error("Can't use the directory specified in statisticsFileNameTemplate parameter of the configuration");
 		}
 	} else {
-		m_directory = "";
+		m_directory = ".";
 	}
 	m_fileNameTemplate = ProgramProperties::getStatisticsLogFile().substr(fileNamePos + 1);
 	std::size_t fileExtPos = m_fileNameTemplate.find_last_of(".");
 	if (fileExtPos != std::string::npos) {
 		m_fileExt  = m_fileNameTemplate.substr(fileExtPos + 1);
 	} else {
-		m_fileExt = "";
+		m_fileExt = "log";
 	}
 	m_fileNameTemplate = m_fileNameTemplate.substr(0, fileExtPos);
+	m_arrowEncoder = NULL;
+	if (ProgramProperties::getStatisticsFormat() == "arrow") {
+		m_arrowEncoder = new ArrowStatEncoder();
+		m_fileExt = "arrow";
+	}
 	if (m_fileNameTemplate == "") {
 		throw std::runtime_error("No statisticsFileNameTemplate is specified in the configuration");
 	}
@@ -40,128 +45,261 @@ StatWriter::StatWriter() { //throws exceptions
 	std::getline(ss, m_oUser, ':');
 	std::getline(ss, m_oGroup, ':');
 	logRoot.info("Statistics Files will be owned by " + m_oUser + ':' + m_oGroup);
+
+	bool isSegmentFormat = (ProgramProperties::getStatisticsFormat() == "segment");
+	m_retention = new StatFileRetention(m_directory, m_fileNameTemplate,
+										isSegmentFormat ? std::string(".") + STAT_SEGMENT_EXT : "." + m_fileExt,
+										ProgramProperties::getStatisticsRetentionPeriodH()*3600,
+										(uint64_t) ProgramProperties::getStatisticsQuotaMB()*1024*1024);
+	m_segmentWriter = NULL;
+	if (isSegmentFormat) {
+		m_segmentWriter = new StatSegmentWriter(m_retention->getDirFd(), m_fileNameTemplate);
+		m_segmentWriter->sealOrphans();
+		logRoot.info("Statistics are written to hourly segments " + m_directory + "/" + m_fileNameTemplate + "_YYYYMMDD-HH." + STAT_SEGMENT_EXT);
+	}
+	m_ipfixExporter = NULL;
+	if (!ProgramProperties::getIpfixCollector().empty()) {
+		m_ipfixExporter = new IpfixExporter(ProgramProperties::getIpfixCollector(), ProgramProperties::getIpfixMtu(),
+											ProgramProperties::getIpfixObservationDomainId(),
+											ProgramProperties::getIpfixEnterpriseNumber());
+	}
+	//every kind of files shares the quota, the oldest file of any kind is removed first
+	m_trafficMatrix = NULL;
+	if (ProgramProperties::doTrafficMatrix()) {
+		m_trafficMatrix = new TrafficMatrix();
+		m_retention->addSuffix(std::string(".") + TRAFFIC_MATRIX_EXT);
+		logRoot.info("Traffic matrix is written to " + m_directory + "/" + m_fileNameTemplate + "_<time>." + TRAFFIC_MATRIX_EXT);
+	}
+	m_topTalkers = NULL;
+	if (ProgramProperties::getTopTalkers() > 0) {
+		m_topTalkers = new TopTalkers(ProgramProperties::getTopTalkers());
+		m_retention->addSuffix(std::string(".") + TOP_TALKERS_EXT);
+	}
+	if (ProgramProperties::getServiceLatencyMaxServices() > 0) {
+		m_retention->addSuffix(std::string(".") + SERVICE_LATENCIES_EXT);
+	}
+	m_retention->scanDirectory();
 	removeOldStat();
 }
 
-bool StatWriter::validateDirectory(const char* pzPath) {
-	if ( pzPath == NULL) return false;
-	DIR *pDir;
-	bool success = false;
-
-	pDir = opendir (pzPath);
-	if (pDir != NULL) {
-		success = true;
-		(void) closedir (pDir);
-	} else {
-		std::string command = pzPath;
-		command = "mkdir -m 644 -p " + command;
-		const int err = std::system(command.c_str());
-		if (err == -1) {
-			success = false;
-		} else {
-			success = true;
-		}
+StatWriter::~StatWriter() {
+	if (m_segmentWriter != NULL) {
+		closeSegment();
+		delete m_segmentWriter;
 	}
-	return success;
+	delete m_arrowEncoder;
+	delete m_ipfixExporter;
+	delete m_trafficMatrix;
+	delete m_topTalkers;
+	delete m_retention;
 }
 
-bool StatWriter::removeOldStat() {
-	bool success = false;
-	std::string command;
-	unsigned int retentionInMinutes = ProgramProperties::getStatisticsRetentionPeriodH()*60;
-	if (retentionInMinutes == 0) {
-		//keep forever
-		return true;
+bool StatWriter::validateDirectory(const char* pzPath) {
+	//creates every missing component of the path like 'mkdir -p' does, but without spawning a shell
+	if ( pzPath == NULL || *pzPath == '\0') return false;
+	std::string path = pzPath;
+	struct stat pathStat;
+
+	for (std::size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+		std::string component = path.substr(0, pos);
+		if (mkdir(component.c_str(), 0755) != 0 && errno != EEXIST) {
+			log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+			logRoot.error("Can't create directory %s: %s", component.c_str(), strerror(errno));
+			return false;
+		}
+		if (pos == std::string::npos) break;
 	}
-	command = "find \"" + m_directory + "\" -iregex \".*"
-					+ m_fileNameTemplate + ".*\\."
-					+ m_fileExt + "\" -mmin +" + std::to_string(retentionInMinutes)
-					+ " -exec rm -f '{}' \\;";
+	if (stat(path.c_str(), &pathStat) != 0 || !S_ISDIR(pathStat.st_mode)) {
+		return false;
+	}
+	return true;
+}
 
-	const int err = std::system(command.c_str());
-	if (err == -1) {
-		success = false;
-	} else {
-		success = true;
+void StatWriter::removeOldStat() {
+	uint32_t removedFiles = m_retention->prune();
+	if (removedFiles > 0) {
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.info("%" PRIu32 " old statistics files were removed, %zu files of %" PRIu64 " bytes are kept",
+						removedFiles, m_retention->getFilesCount(), m_retention->getTotalBytes());
 	}
-	return success;
 }
 
-void StatWriter::writeStat(SafeQueue<StatRecord>* m_sessionsStatQueue) {
-	StatRecord statRecord;
+void StatWriter::formatStatRecord(const StatRecord& statRecord, char* statString) {
 	char clientIpStr[INET_ADDRSTRLEN];
 	char serverIpStr[INET_ADDRSTRLEN];
 	char timestamp_str[TIMESTAMP_STR_MAX_SIZE];
 	char sessionKeyStr[SESSION_KEY_STR_MAX_SIZE];
 	long int timestampEpoch;
-	struct tm *timestamp_tm;
-	char sessionTopology;
-	char statString[512];
-	std::ofstream statFileHandler;
-	std::string tmpFileName = m_directory + "/" + m_fileNameTemplate + ".tmp";
-
-	statFileHandler.open(tmpFileName.c_str(), std::ios_base::app);
-	while (m_sessionsStatQueue->dequeue(statRecord)) {
-		inet_ntop(AF_INET, &(statRecord.getTcpUdpSessionKey().m_clientIpRaw), clientIpStr, INET_ADDRSTRLEN);
-		inet_ntop(AF_INET, &(statRecord.getTcpUdpSessionKey().m_serverIpRaw), serverIpStr, INET_ADDRSTRLEN);
-		timestampEpoch = (long int) statRecord.getTimestampEpoch()/1000000;
-		timestamp_tm = gmtime(&timestampEpoch);
-		strftime(timestamp_str, sizeof timestamp_str, "%Y-%m-%d %H:%M:%S", timestamp_tm);
-
-		sessionTopology = LocalSubnets::getConnectionTopology(statRecord.getTcpUdpSessionKey().m_serverIpRaw, statRecord.getTcpUdpSessionKey().m_clientIpRaw);
-
-		sprintf(sessionKeyStr, "%s	%" PRIu16 "	%s	%" PRIu16, clientIpStr, statRecord.getTcpUdpSessionKey().m_clientPort,
-				serverIpStr, statRecord.getTcpUdpSessionKey().m_serverPort);
-
-		sprintf(statString, "%s	%" PRIu8  // Timestamp, IP Protocol
-				"	%s	%c"	  				  // Client IP, client	port, Server IP, server	port, connectionTopology
-				"	%" PRIu64 "	%" PRIu64 // Packets
-				"	%" PRIu64 "	%" PRIu64 // Bytes
-				"	%" PRIu64 "	%" PRIu64 // Efficient Bytes
-				"	%" PRIu64 "	%" PRIu64 // Duplicates
-				"	%" PRIu64 "	%" PRIu64 // Out-Of-Order
-				"	%" PRIu64 "	%" PRIu64 // ActiveGaps
-				"	%" PRIu64 "	%" PRIu64 // Retransmits
-				"	%" PRIu64 // Operations
-				"	%" PRIu64 "	%" PRIu64 "	%" PRIu64 "	%" PRIu64 //Client Idle Time, Request Time, Server Think Time, Response Time in milliseconds
-				"	%" PRIu64 "	%" PRIu32 // Total Session Idle Time in milliseconds, Error Code
-				"	%" PRIu64, // RTT
-				timestamp_str, statRecord.getIpProtocol(),
-				sessionKeyStr, sessionTopology,
-				statRecord.getClientPackets(), statRecord.getServerPackets(), statRecord.getClientBytes(), statRecord.getServerBytes(),
-				statRecord.getClientEfficientBytes(), statRecord.getServerEfficientBytes(),
-				statRecord.getClientDuplicatesCounter(), statRecord.getServerDuplicatesCounter(),
-				statRecord.getClientOutOfOrderCounter(), statRecord.getServerOutOfOrderCounter(),
-				statRecord.getClientActiveSequenceGaps(), statRecord.getServerActiveSequenceGaps(),
-				statRecord.getClientRetransmits(), statRecord.getServerRetransmits(),
-				statRecord.getOperations(),
-				statRecord.getClientIdleTime()/1000, statRecord.getRequestTime()/1000, statRecord.getServerThinkTime()/1000, statRecord.getResponseTime()/1000,
-				statRecord.getTotalSessionIdleTime()/1000, statRecord.getSessionErrorCode(),
-				statRecord.getRtt());
-		statFileHandler << statString << std::endl;
+	struct tm timestamp_tm;
+
+	inet_ntop(AF_INET, &(statRecord.getTcpUdpSessionKey().m_clientIpRaw), clientIpStr, INET_ADDRSTRLEN);
+	inet_ntop(AF_INET, &(statRecord.getTcpUdpSessionKey().m_serverIpRaw), serverIpStr, INET_ADDRSTRLEN);
+	timestampEpoch = (long int) statRecord.getTimestampEpoch()/1000000;
+	gmtime_r(&timestampEpoch, &timestamp_tm);
+	strftime(timestamp_str, sizeof timestamp_str, "%Y-%m-%d %H:%M:%S", &timestamp_tm);
+
+	snprintf(sessionKeyStr, sizeof sessionKeyStr, "%s	%" PRIu16 "	%s	%" PRIu16, clientIpStr, statRecord.getTcpUdpSessionKey().m_clientPort,
+			serverIpStr, statRecord.getTcpUdpSessionKey().m_serverPort);
+
+	snprintf(statString, STAT_STRING_MAX_SIZE, "%s	%" PRIu8  // Timestamp, IP Protocol
+			"	%s	%c"	  				  // Client IP, client	port, Server IP, server	port, connectionTopology
+			"	%" PRIu64 "	%" PRIu64 // Packets
+			"	%" PRIu64 "	%" PRIu64 // Bytes
+			"	%" PRIu64 "	%" PRIu64 // Efficient Bytes
+			"	%" PRIu64 "	%" PRIu64 // Duplicates
+			"	%" PRIu64 "	%" PRIu64 // Out-Of-Order
+			"	%" PRIu64 "	%" PRIu64 // ActiveGaps
+			"	%" PRIu64 "	%" PRIu64 // Retransmits
+			"	%" PRIu64 // Operations
+			"	%" PRIu64 "	%" PRIu64 "	%" PRIu64 "	%" PRIu64 //Client Idle Time, Request Time, Server Think Time, Response Time in milliseconds
+			"	%" PRIu64 "	%" PRIu32 // Total Session Idle Time in milliseconds, Error Code
+			"	%" PRIu64 // RTT
+			"	%" PRIu32 // Sampling Rate, 1:N of new flows
+			"	%" PRIu32 "	%" PRIu32 // Client subnet tag, server subnet tag
+			"	%" PRIu32, // Interface of a pcapng file
+			timestamp_str, statRecord.getIpProtocol(),
+			sessionKeyStr, statRecord.getTopology(),
+			statRecord.getClientPackets(), statRecord.getServerPackets(), statRecord.getClientBytes(), statRecord.getServerBytes(),
+			statRecord.getClientEfficientBytes(), statRecord.getServerEfficientBytes(),
+			statRecord.getClientDuplicatesCounter(), statRecord.getServerDuplicatesCounter(),
+			statRecord.getClientOutOfOrderCounter(), statRecord.getServerOutOfOrderCounter(),
+			statRecord.getClientActiveSequenceGaps(), statRecord.getServerActiveSequenceGaps(),
+			statRecord.getClientRetransmits(), statRecord.getServerRetransmits(),
+			statRecord.getOperations(),
+			statRecord.getClientIdleTime()/1000, statRecord.getRequestTime()/1000, statRecord.getServerThinkTime()/1000, statRecord.getResponseTime()/1000,
+			statRecord.getTotalSessionIdleTime()/1000, statRecord.getSessionErrorCode(),
+			statRecord.getRtt(), statRecord.getSamplingRate(),
+			statRecord.getClientTag(), statRecord.getServerTag(),
+			statRecord.getTcpUdpSessionKey().m_interfaceId);
+}
+
+void StatWriter::writeStat(const std::vector<StatRecord>& t_batch) {
+	char statString[STAT_STRING_MAX_SIZE];
+
+	//the totals are taken from all the records, the rest might be limited to the top talkers
+	if (m_trafficMatrix != NULL) {
+		writeTrafficMatrix(t_batch);
+	}
+	const std::vector<StatRecord>& sessionBatch = (m_topTalkers != NULL) ? writeTopTalkers(t_batch) : t_batch;
+	if (m_ipfixExporter != NULL) {
+		m_ipfixExporter->exportBatch(sessionBatch);
+	}
+	m_payload.clear();
+	for (std::size_t i = 0; i < sessionBatch.size(); i++) {
+		const StatRecord& statRecord = sessionBatch[i];
+		if (m_arrowEncoder == NULL) {
+			formatStatRecord(statRecord, statString);
+			m_payload.append(statString);
+			m_payload.push_back('\n');
+		}
 		//!DEBUG
 		if ((statRecord.getServerActiveSequenceGaps() > 1000) || (statRecord.getClientActiveSequenceGaps() > 1000)) {
+			if (m_arrowEncoder != NULL) formatStatRecord(statRecord, statString);
 			log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 			logRoot.warn("Inadequate active sequence gaps identified for %s", statString);
 		}
 		//------
 	}
+	if (m_arrowEncoder != NULL) {
+		//columns are built from the records, the text is never produced
+		m_arrowEncoder->encode(sessionBatch, m_payload);
+	}
+	if (m_segmentWriter != NULL) {
+		writeSegment(sessionBatch);
+	} else {
+		writeIntervalFile(m_payload, m_fileExt);
+	}
+	removeOldStat();
+	return;
+}
+
+uint64_t StatWriter::getIpfixDroppedMessages() const {
+	return (m_ipfixExporter != NULL) ? m_ipfixExporter->getDroppedMessages() : 0;
+}
+
+void StatWriter::writeTrafficMatrix(const std::vector<StatRecord>& t_batch) {
+	//the control thread may read the current settings at any time, it is the only one replacing them
+	const RuntimeSettings* settings = RuntimeSettings::get();
+	m_trafficMatrix->build(t_batch, settings);
+	m_payload.clear();
+	m_trafficMatrix->format(std::time(nullptr), settings, m_payload);
+	writeIntervalFile(m_payload, TRAFFIC_MATRIX_EXT);
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.debug("Traffic matrix of %zu cells is built from %zu statistics records", m_trafficMatrix->size(), t_batch.size());
+}
+
+const std::vector<StatRecord>& StatWriter::writeTopTalkers(const std::vector<StatRecord>& t_batch) {
+	m_topTalkers->build(t_batch);
+	m_payload.clear();
+	m_topTalkers->format(std::time(nullptr), m_payload);
+	writeIntervalFile(m_payload, TOP_TALKERS_EXT);
+	if (!ProgramProperties::doTopTalkersSessionsOnly()) return t_batch;
+	m_topBatch.clear();
+	for (std::size_t i = 0; i < t_batch.size(); i++) {
+		if (m_topTalkers->isTopRecord(t_batch[i])) m_topBatch.push_back(t_batch[i]);
+	}
+	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	logRoot.debug("%zu of %zu session records belong to the top talkers", m_topBatch.size(), t_batch.size());
+	return m_topBatch;
+}
+
+void StatWriter::writeServiceLatencies(const ServiceLatencies& t_serviceLatencies) {
+	if (ProgramProperties::getServiceLatencyMaxServices() == 0) return;
+	m_payload.clear();
+	t_serviceLatencies.format(std::time(nullptr), m_payload);
+	writeIntervalFile(m_payload, SERVICE_LATENCIES_EXT);
+	removeOldStat();
+}
+
+void StatWriter::writeIntervalFile(const std::string& t_payload, const std::string& t_fileExt) {
+	std::ofstream statFileHandler;
+	std::string tmpFileName = m_directory + "/" + m_fileNameTemplate + "." + t_fileExt + ".tmp";
+
+	statFileHandler.open(tmpFileName.c_str(), std::ios_base::app | std::ios_base::binary);
+	statFileHandler.write(t_payload.data(), t_payload.size());
 	statFileHandler.close();
 	char *timeStr = getCurrentTime();
-	std::string statFileName = m_directory + "/" + m_fileNameTemplate + "_" + timeStr +".log";
+	std::string statFileBaseName = m_fileNameTemplate + "_" + timeStr + "." + t_fileExt;
+	std::string statFileName = m_directory + "/" + statFileBaseName;
 	int i = 0;
 	while (access(statFileName.c_str(), F_OK) == 0) {
-		statFileName = m_directory + "/" + m_fileNameTemplate + std::to_string(i) + "_"+ timeStr +".log";
+		statFileBaseName = m_fileNameTemplate + std::to_string(i) + "_"+ timeStr + "." + t_fileExt;
+		statFileName = m_directory + "/" + statFileBaseName;
 		i++;
 	}
 	if (rename(tmpFileName.c_str(), statFileName.c_str()) != 0) {
 		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 		logRoot.fatal("Error renaming temp file to statistics file " + statFileName);
+	} else {
+		setStatFileOwner(statFileName);
+		m_retention->registerFile(statFileBaseName);
 	}
-	setStatFileOwner(statFileName);
 	free(timeStr);
-	removeOldStat();
-	return;
+}
+
+void StatWriter::writeSegment(const std::vector<StatRecord>& t_batch) {
+	time_t now = std::time(nullptr);
+
+	if (m_segmentWriter->isRotationDue(now)) {
+		closeSegment();
+	}
+	bool isNewSegment = !m_segmentWriter->isOpen();
+	if (!m_segmentWriter->appendInterval(now, t_batch, m_payload)) {
+		log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+		logRoot.error("%zu statistics records of the interval are lost", t_batch.size());
+		return;
+	}
+	if (isNewSegment) {
+		setStatFileOwner(m_directory + "/" + m_segmentWriter->getFileName());
+	}
+}
+
+void StatWriter::closeSegment() {
+	//segments are registered for the clean up only when sealed, the open one is never removed
+	std::string closedFileName = m_segmentWriter->closeSegment();
+	if (!closedFileName.empty()) {
+		m_retention->registerFile(closedFileName);
+	}
 }
 
 size_t StatWriter::hash_c_string(const char* p, const size_t s,	const size_t prime) {
@@ -2,7 +2,7 @@
  *	StatWriter.h
  *
  *	Created on: Oct 12, 2023
- *	Last modified on: March 22, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -16,6 +16,7 @@
 
 #define TIMESTAMP_STR_MAX_SIZE 64
 #define SESSION_KEY_STR_MAX_SIZE 44
+#define STAT_STRING_MAX_SIZE 640 //565 characters of a line with every counter at its widest
 
 #include <dirent.h>
 #include <cstdlib>
@@ -28,27 +29,55 @@
 #include <unistd.h>
 #include <pwd.h>
 #include <grp.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #include "ProgramProperties.h"
-#include "SafeQueue.h"
+#include <vector>
 #include "layer_1/StatRecord.h"
-#include "layer_1/LocalSubnets.h"
+#include "layer_1/RuntimeSettings.h"
+#include "layer_1/StatFileRetention.h"
+#include "layer_1/StatSegmentWriter.h"
+#include "layer_1/ArrowStatEncoder.h"
+#include "layer_1/IpfixExporter.h"
+#include "layer_1/TrafficMatrix.h"
+#include "layer_1/ServiceLatencies.h"
+#include "layer_1/TopTalkers.h"
 
 class StatWriter {
 private:
 	std::string m_directory, m_fileNameTemplate, m_fileExt;
 	std::string m_oUser;
 	std::string m_oGroup;
+	StatFileRetention* m_retention; //list of our statistics files of all kinds for in-process clean up
+	StatSegmentWriter* m_segmentWriter; //NULL unless statisticsFormat = segment
+	ArrowStatEncoder* m_arrowEncoder; //NULL unless statisticsFormat = arrow
+	IpfixExporter* m_ipfixExporter; //NULL unless ipfixCollector is configured
+	TrafficMatrix* m_trafficMatrix; //NULL unless trafficMatrix is enabled
+	TopTalkers* m_topTalkers; //NULL unless topTalkers is configured
+	std::vector<StatRecord> m_topBatch; //records of the top talkers when topTalkersSessionsOnly is set
+	std::string m_payload; //TSV lines or Arrow IPC stream of the batch being written
 
 	bool validateDirectory(const char* pzPath);
-	bool removeOldStat();
+	void removeOldStat();
 	size_t hash_c_string(const char* p, const size_t s, const size_t prime);
 	char* getCurrentTime();
 	void setStatFileOwner(std::string fileName);
+	void formatStatRecord(const StatRecord& t_statRecord, char* t_statString);
+	//t_statString must hold STAT_STRING_MAX_SIZE characters
+	void writeIntervalFile(const std::string& t_payload, const std::string& t_fileExt);
+	void writeTrafficMatrix(const std::vector<StatRecord>& t_batch);
+	const std::vector<StatRecord>& writeTopTalkers(const std::vector<StatRecord>& t_batch);
+	//returns the records to be written as sessions: t_batch or only the records of the top talkers
+	void writeSegment(const std::vector<StatRecord>& t_batch);
+	void closeSegment();
 
 public:
 	StatWriter();
-	void writeStat(SafeQueue<StatRecord>* m_sessionsStatQueue);
+	~StatWriter();
+	void writeStat(const std::vector<StatRecord>& t_batch);
+	void writeServiceLatencies(const ServiceLatencies& t_serviceLatencies);
+	uint64_t getIpfixDroppedMessages() const;
 };
 
 #endif /* STATWRITER_H_ */
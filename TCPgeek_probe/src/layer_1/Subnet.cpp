@@ -2,7 +2,7 @@
  *	Subnet.cpp
  *
  *	Created on: Oct 9, 2023
- *	Last modified on: Oct 9, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -10,32 +10,50 @@
  *
  */
 
+#include <ctype.h>
+
 #include "layer_1/Subnet.h"
 
-Subnet::Subnet(const char* t_localSubnetStr) {
-	char *prefixStr = strdup(t_localSubnetStr);
-	char *maskStr;
+Subnet::Subnet(const char* t_localSubnetStr) : m_prefix {0}, m_mask {0}, m_prefixLength {0}, m_tag {0}, m_isValid {false} {
+	char *prefixStr, *maskStr, *tagStr, *endPtr;
 	struct in_addr addr;
 
-	if (t_localSubnetStr != NULL) {
-		strtok_r(prefixStr, "/", &maskStr);
-		trim(prefixStr);
+	if (t_localSubnetStr == NULL) return;
+	prefixStr = strdup(t_localSubnetStr);
+	tagStr = strchr(prefixStr, ':');
+	if (tagStr != NULL) {
+		*tagStr = '\0';
+		tagStr++;
+	}
+	maskStr = strchr(prefixStr, '/');
+	if (maskStr != NULL) {
+		*maskStr = '\0';
+		maskStr++;
+	}
+	trim(prefixStr);
+	m_isValid = inet_pton(AF_INET, prefixStr, &addr) == 1;
+	m_prefixLength = 32;
+	if (m_isValid && maskStr != NULL) {
 		trim(maskStr);
-		if (inet_pton(AF_INET, prefixStr, &addr)) {
-			m_prefix = ntohl(addr.s_addr);
-		} else {
-			m_prefix = 0;
-		}
-		m_mask = (u_int32_t) strtoul(maskStr, NULL, 10);
-		m_mask = -1 << (32 - m_mask);
+		m_prefixLength = (u_int32_t) strtoul(maskStr, &endPtr, 10);
+		m_isValid = (endPtr != maskStr) && (*endPtr == '\0') && (m_prefixLength <= 32);
+	}
+	if (m_isValid && tagStr != NULL) {
+		trim(tagStr);
+		m_tag = (u_int32_t) strtoul(tagStr, &endPtr, 10);
+		m_isValid = (endPtr != tagStr) && (*endPtr == '\0');
+	}
+	if (m_isValid) {
+		//shifting by 32 is undefined, so /0 is a special case
+		m_mask = (m_prefixLength == 0) ? 0 : (u_int32_t) -1 << (32 - m_prefixLength);
+		m_prefix = ntohl(addr.s_addr) & m_mask;
 	} else {
-		m_prefix = 0;
-		m_mask = 0;
+		m_prefixLength = 0;
 	}
 	free(prefixStr);
 }
 
-bool Subnet::isIpInSubnet(const in_addr t_addr) {
+bool Subnet::isIpInSubnet(const in_addr t_addr) const {
 	u_int32_t addrInt = ntohl(t_addr.s_addr);
 	if (m_prefix ==  (addrInt & m_mask)) return true;
 	else return false;
@@ -47,7 +65,8 @@ void Subnet::trim(char *str)
 
     //Trim leading white spaces
     index = 0;
-    while(str[index] == ' ' || str[index] == '\t' || str[index] == '\n') {
+    //isspace() takes the \r of a config file edited on Windows as well
+    while(isspace((unsigned char) str[index])) {
         index++;
     }
     //Shift all trailing characters to its left
@@ -61,7 +80,7 @@ void Subnet::trim(char *str)
     i = 0;
     index = -1;
     while(str[i] != '\0') {
-        if(str[i] != ' ' && str[i] != '\t' && str[i] != '\n') {
+        if(!isspace((unsigned char) str[i])) {
             index = i;
         }
         i++;
@@ -78,4 +97,14 @@ u_int32_t Subnet::getPrefix() const {
 	return m_prefix;
 }
 
+u_int32_t Subnet::getPrefixLength() const {
+	return m_prefixLength;
+}
+
+u_int32_t Subnet::getTag() const {
+	return m_tag;
+}
 
+bool Subnet::isValid() const {
+	return m_isValid;
+}
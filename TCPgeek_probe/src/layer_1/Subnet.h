@@ -2,7 +2,7 @@
  *	Subnet.h
  *
  *	Created on: Oct 9, 2023
- *	Last modified on: Oct 9, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -21,12 +21,20 @@ class Subnet {
 private:
 	u_int32_t m_prefix;
 	u_int32_t m_mask;
+	u_int32_t m_prefixLength;
+	u_int32_t m_tag; //site or zone number from the optional ':tag' suffix, 0 if there is none
+	bool m_isValid;
 	void trim(char * str);
 public:
 	Subnet(const char* t_localSubnetStr);
-	bool isIpInSubnet(const in_addr addr);
+	//t_localSubnetStr is 'a.b.c.d/len' or 'a.b.c.d/len:tag', a single address without '/len' is a /32
+	bool isIpInSubnet(const in_addr addr) const;
 	u_int32_t getMask() const;
 	u_int32_t getPrefix() const;
+	//host byte order, the host bits are cleared
+	u_int32_t getPrefixLength() const;
+	u_int32_t getTag() const;
+	bool isValid() const;
 };
 
 #endif /* SUBNET_H_ */
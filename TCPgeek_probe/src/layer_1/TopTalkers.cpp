@@ -0,0 +1,119 @@
+/*
+ *	TopTalkers.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <cstdio>
+#include <inttypes.h>
+#include <arpa/inet.h>
+
+#include "layer_1/TopTalkers.h"
+
+TopTalkers::TopTalkers(const std::size_t t_k) : m_k {t_k},
+												m_sketches((int) TalkerKind::COUNT * (int) TalkerRanking::COUNT,
+															SpaceSaving(t_k * TOP_TALKERS_CAPACITY_FACTOR)),
+												m_top((int) TalkerKind::COUNT * (int) TalkerRanking::COUNT) {
+}
+
+uint64_t TopTalkers::getKey(const TalkerKind t_kind, const StatRecord& t_statRecord) {
+	//the addresses are kept in network byte order, the port is 0 for hosts
+	const TcpUdpSessionKey& sessionKey = t_statRecord.getTcpUdpSessionKey();
+	switch (t_kind) {
+		case TalkerKind::CLIENT: return (uint64_t) sessionKey.m_clientIpRaw.s_addr << 16;
+		case TalkerKind::SERVER: return (uint64_t) sessionKey.m_serverIpRaw.s_addr << 16;
+		default: return ((uint64_t) sessionKey.m_serverIpRaw.s_addr << 16) | sessionKey.m_serverPort;
+	}
+}
+
+uint64_t TopTalkers::getWeight(const TalkerRanking t_ranking, const StatRecord& t_statRecord) {
+	uint64_t weight;
+	switch (t_ranking) {
+		case TalkerRanking::BYTES: weight = t_statRecord.getClientBytes() + t_statRecord.getServerBytes(); break;
+		case TalkerRanking::PACKETS: weight = t_statRecord.getClientPackets() + t_statRecord.getServerPackets(); break;
+		case TalkerRanking::RETRANSMITS: weight = t_statRecord.getClientRetransmits() + t_statRecord.getServerRetransmits(); break;
+		default: weight = t_statRecord.getOperations();
+	}
+	//a session taken at 1:N flow sampling stands for N of them
+	return weight * t_statRecord.getSamplingRate();
+}
+
+const char* TopTalkers::getKindName(const int t_kind) {
+	switch ((TalkerKind) t_kind) {
+		case TalkerKind::CLIENT: return "client";
+		case TalkerKind::SERVER: return "server";
+		default: return "service";
+	}
+}
+
+const char* TopTalkers::getRankingName(const int t_ranking) {
+	switch ((TalkerRanking) t_ranking) {
+		case TalkerRanking::BYTES: return "bytes";
+		case TalkerRanking::PACKETS: return "packets";
+		case TalkerRanking::RETRANSMITS: return "retransmits";
+		default: return "operations";
+	}
+}
+
+void TopTalkers::build(const std::vector<StatRecord>& t_batch) {
+	for (std::size_t i = 0; i < m_sketches.size(); i++) {
+		m_sketches[i].clear();
+	}
+	for (std::size_t i = 0; i < t_batch.size(); i++) {
+		for (int kind = 0; kind < (int) TalkerKind::COUNT; kind++) {
+			uint64_t key = getKey((TalkerKind) kind, t_batch[i]);
+			for (int ranking = 0; ranking < (int) TalkerRanking::COUNT; ranking++) {
+				m_sketches[kind * (int) TalkerRanking::COUNT + ranking].add(key, getWeight((TalkerRanking) ranking, t_batch[i]));
+			}
+		}
+	}
+	for (int kind = 0; kind < (int) TalkerKind::COUNT; kind++) {
+		m_topKeys[kind].clear();
+		for (int ranking = 0; ranking < (int) TalkerRanking::COUNT; ranking++) {
+			std::size_t sketch = kind * (int) TalkerRanking::COUNT + ranking;
+			m_sketches[sketch].getTop(m_k, m_top[sketch]);
+			for (std::size_t i = 0; i < m_top[sketch].size(); i++) {
+				m_topKeys[kind].insert(m_top[sketch][i].key);
+			}
+		}
+	}
+}
+
+bool TopTalkers::isTopRecord(const StatRecord& t_statRecord) const {
+	for (int kind = 0; kind < (int) TalkerKind::COUNT; kind++) {
+		if (m_topKeys[kind].count(getKey((TalkerKind) kind, t_statRecord)) > 0) return true;
+	}
+	return false;
+}
+
+void TopTalkers::format(const time_t t_intervalEpoch, std::string& t_payload) const {
+	char timestampStr[64];
+	char ipStr[INET_ADDRSTRLEN];
+	char rowStr[TOP_TALKERS_ROW_MAX_SIZE];
+	struct tm timestamp_tm;
+	in_addr ip;
+
+	gmtime_r(&t_intervalEpoch, &timestamp_tm);
+	strftime(timestampStr, sizeof timestampStr, "%Y-%m-%d %H:%M:%S", &timestamp_tm);
+	for (int kind = 0; kind < (int) TalkerKind::COUNT; kind++) {
+		for (int ranking = 0; ranking < (int) TalkerRanking::COUNT; ranking++) {
+			const std::vector<SpaceSavingCounter>& top = m_top[kind * (int) TalkerRanking::COUNT + ranking];
+			for (std::size_t i = 0; i < top.size(); i++) {
+				ip.s_addr = (uint32_t) (top[i].key >> 16);
+				inet_ntop(AF_INET, &ip, ipStr, INET_ADDRSTRLEN);
+				snprintf(rowStr, sizeof rowStr, "%s	%s	%s	%zu" // Timestamp, client/server/service, ranking, rank from 1
+						"	%s	%" PRIu16					// IP, server port (0 for clients and servers)
+						"	%" PRIu64 "	%" PRIu64 "\n",	// Value (upper bound), possible overestimation
+						timestampStr, getKindName(kind), getRankingName(ranking), i + 1,
+						ipStr, (uint16_t) (top[i].key & 0xFFFF), top[i].count, top[i].error);
+				t_payload.append(rowStr);
+			}
+		}
+	}
+}
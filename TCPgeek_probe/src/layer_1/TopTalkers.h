@@ -0,0 +1,72 @@
+/*
+ *	TopTalkers.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : TopTalkers - the top K clients, servers and services (server IP and port) of the
+ *					interval by bytes, packets, retransmits and operations of their sessions. It is
+ *					built from the harvested statistics records with a space-saving sketch per ranking
+ *					of TOP_TALKERS_CAPACITY_FACTOR * K counters, so memory doesn't depend on the number
+ *					of sessions and a counter is overestimated by at most 1/(4K) of the interval total.
+ */
+
+#ifndef TOPTALKERS_H_
+#define TOPTALKERS_H_
+
+#define TOP_TALKERS_EXT "topk"
+#define TOP_TALKERS_CAPACITY_FACTOR 4
+#define TOP_TALKERS_ROW_MAX_SIZE 192
+
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <ctime>
+#include <stdint.h>
+
+#include "layer_1/StatRecord.h"
+#include "layer_1/SpaceSaving.h"
+
+enum class TalkerKind : uint8_t {
+	CLIENT = 0,
+	SERVER,
+	SERVICE,
+	COUNT
+};
+
+enum class TalkerRanking : uint8_t {
+	BYTES = 0,
+	PACKETS,
+	RETRANSMITS,
+	OPERATIONS,
+	COUNT
+};
+
+class TopTalkers {
+private:
+	std::size_t m_k;
+	std::vector<SpaceSaving> m_sketches; //TalkerKind::COUNT * TalkerRanking::COUNT of them
+	std::vector<std::vector<SpaceSavingCounter>> m_top; //the top K of every sketch
+	std::unordered_set<uint64_t> m_topKeys[(int) TalkerKind::COUNT]; //union of the top K of every ranking
+
+	static uint64_t getKey(const TalkerKind t_kind, const StatRecord& t_statRecord);
+	static uint64_t getWeight(const TalkerRanking t_ranking, const StatRecord& t_statRecord);
+	static const char* getKindName(const int t_kind);
+	static const char* getRankingName(const int t_ranking);
+
+public:
+	TopTalkers(const std::size_t t_k);
+
+	void build(const std::vector<StatRecord>& t_batch);
+	//replaces the rankings with the ones of t_batch
+	bool isTopRecord(const StatRecord& t_statRecord) const;
+	//true if the client, the server or the service of the record is in the top K of any ranking
+	void format(const time_t t_intervalEpoch, std::string& t_payload) const;
+	//appends a TSV line per ranked talker to t_payload
+};
+
+#endif /* TOPTALKERS_H_ */
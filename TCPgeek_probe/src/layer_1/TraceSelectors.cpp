@@ -0,0 +1,211 @@
+/*
+ *	TraceSelectors.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "layer_1/TraceSelectors.h"
+#include "layer_1/Subnet.h"
+
+TraceSelectors::Slot TraceSelectors::s_slots[TRACE_SELECTORS_MAX];
+std::atomic<uint64_t> TraceSelectors::s_matchedPackets[TRACE_SELECTORS_MAX];
+uint64_t TraceSelectors::s_matchedBase[TRACE_SELECTORS_MAX];
+std::atomic<uint32_t> TraceSelectors::s_activeSelectors {0};
+
+bool TraceSelectors::isMatching(const TraceSelector& t_selector, const Packet& t_packet,
+								const PacketProcessingResultEnum t_packetProcessingResult, const uint32_t t_sessionErrorCode) {
+	uint32_t srcIp = ntohl(t_packet.getSrcIpRaw().s_addr);
+	uint32_t dstIp = ntohl(t_packet.getDstIpRaw().s_addr);
+
+	switch (t_selector.kind) {
+		case TraceSelectorKind::FLOW:
+			if (t_selector.protocol != 0 && t_selector.protocol != t_packet.getIpProtocol()) return false;
+			return (srcIp == t_selector.ipA && t_packet.getSrcPort() == t_selector.portA &&
+						dstIp == t_selector.ipB && t_packet.getDstPort() == t_selector.portB) ||
+					(srcIp == t_selector.ipB && t_packet.getSrcPort() == t_selector.portB &&
+						dstIp == t_selector.ipA && t_packet.getDstPort() == t_selector.portA);
+		case TraceSelectorKind::SUBNET:
+			return (srcIp & t_selector.maskA) == t_selector.ipA || (dstIp & t_selector.maskA) == t_selector.ipA;
+		case TraceSelectorKind::PORT:
+			return t_packet.getSrcPort() == t_selector.portA || t_packet.getDstPort() == t_selector.portA;
+		case TraceSelectorKind::ERROR:
+			return t_packetProcessingResult == PacketProcessingResultEnum::GOOD_TCP && (t_sessionErrorCode & t_selector.errorMask) != 0;
+		default:
+			return false;
+	}
+}
+
+bool TraceSelectors::matchSlots(const Packet& t_packet, const PacketProcessingResultEnum t_packetProcessingResult,
+								const uint32_t t_sessionErrorCode) {
+	//layer 3 and 4 fields are meaningless for the packets that couldn't be parsed
+	if (t_packetProcessingResult != PacketProcessingResultEnum::GOOD_TCP &&
+			t_packetProcessingResult != PacketProcessingResultEnum::GOOD_UDP) return false;
+	for (int i = 0; i < TRACE_SELECTORS_MAX; i++) {
+		uint32_t versionBefore = s_slots[i].version.load(std::memory_order_acquire);
+		if (versionBefore & 1) continue;
+		TraceSelector selector = s_slots[i].selector;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (s_slots[i].version.load(std::memory_order_relaxed) != versionBefore) continue;
+		if (selector.kind == TraceSelectorKind::FREE) continue;
+		if (isMatching(selector, t_packet, t_packetProcessingResult, t_sessionErrorCode)) {
+			s_matchedPackets[i].store(s_matchedPackets[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TraceSelectors::store(const int t_slot, const TraceSelector& t_selector) {
+	uint32_t version = s_slots[t_slot].version.load(std::memory_order_relaxed);
+	s_slots[t_slot].version.store(version + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	s_slots[t_slot].selector = t_selector;
+	s_slots[t_slot].version.store(version + 2, std::memory_order_release);
+}
+
+int TraceSelectors::install(const TraceSelector& t_selector) {
+	for (int i = 0; i < TRACE_SELECTORS_MAX; i++) {
+		if (s_slots[i].selector.kind != TraceSelectorKind::FREE) continue;
+		s_matchedBase[i] = s_matchedPackets[i].load(std::memory_order_relaxed);
+		store(i, t_selector);
+		s_activeSelectors.fetch_add(1, std::memory_order_release);
+		return i;
+	}
+	return -1;
+}
+
+bool TraceSelectors::remove(const int t_slot) {
+	if (t_slot < 0 || t_slot >= TRACE_SELECTORS_MAX || s_slots[t_slot].selector.kind == TraceSelectorKind::FREE) return false;
+	TraceSelector freeSelector = TraceSelector();
+	freeSelector.kind = TraceSelectorKind::FREE;
+	store(t_slot, freeSelector);
+	s_activeSelectors.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void TraceSelectors::clear() {
+	for (int i = 0; i < TRACE_SELECTORS_MAX; i++) {
+		remove(i);
+	}
+}
+
+bool TraceSelectors::describe(const int t_slot, std::string& t_description) {
+	char description[128];
+	char ipAStr[INET_ADDRSTRLEN], ipBStr[INET_ADDRSTRLEN];
+	if (t_slot < 0 || t_slot >= TRACE_SELECTORS_MAX) return false;
+	const TraceSelector& selector = s_slots[t_slot].selector;
+	in_addr ipA, ipB;
+	ipA.s_addr = htonl(selector.ipA);
+	ipB.s_addr = htonl(selector.ipB);
+	inet_ntop(AF_INET, &ipA, ipAStr, INET_ADDRSTRLEN);
+	inet_ntop(AF_INET, &ipB, ipBStr, INET_ADDRSTRLEN);
+
+	switch (selector.kind) {
+		case TraceSelectorKind::FLOW:
+			snprintf(description, sizeof description, "flow %s:%u %s:%u %s", ipAStr, selector.portA, ipBStr, selector.portB,
+						selector.protocol == IPPROTO_TCP ? "tcp" : (selector.protocol == IPPROTO_UDP ? "udp" : "any"));
+			break;
+		case TraceSelectorKind::SUBNET:
+			snprintf(description, sizeof description, "subnet %s/%d", ipAStr, __builtin_popcount(selector.maskA));
+			break;
+		case TraceSelectorKind::PORT:
+			snprintf(description, sizeof description, "port %u", selector.portA);
+			break;
+		case TraceSelectorKind::ERROR:
+			snprintf(description, sizeof description, "error %" PRIu32, selector.errorMask);
+			break;
+		default:
+			return false;
+	}
+	t_description = description;
+	t_description += "; matched " + std::to_string(s_matchedPackets[t_slot].load(std::memory_order_relaxed) - s_matchedBase[t_slot]);
+	return true;
+}
+
+static bool parseEndpoint(const std::string& t_endpointStr, uint32_t& t_ip, uint16_t& t_port) {
+	std::size_t colon = t_endpointStr.rfind(':');
+	in_addr ip;
+	if (colon == std::string::npos || inet_pton(AF_INET, t_endpointStr.substr(0, colon).c_str(), &ip) != 1) return false;
+	char* end;
+	unsigned long port = strtoul(t_endpointStr.c_str() + colon + 1, &end, 10);
+	if (*end != '\0' || end == t_endpointStr.c_str() + colon + 1 || port > 65535) return false;
+	t_ip = ntohl(ip.s_addr);
+	t_port = port;
+	return true;
+}
+
+bool TraceSelectors::parse(const std::string& t_selectorStr, TraceSelector& t_selector, std::string& t_error) {
+	std::istringstream ss(t_selectorStr);
+	std::string kind, first, second, third, extra;
+	ss >> kind >> first >> second >> third >> extra;
+
+	t_selector = TraceSelector();
+	if (kind == "flow") {
+		t_selector.kind = TraceSelectorKind::FLOW;
+		if (!parseEndpoint(first, t_selector.ipA, t_selector.portA) || !parseEndpoint(second, t_selector.ipB, t_selector.portB)) {
+			t_error = "flow needs two a.b.c.d:port endpoints";
+			return false;
+		}
+		if (third == "tcp") {
+			t_selector.protocol = IPPROTO_TCP;
+		} else if (third == "udp") {
+			t_selector.protocol = IPPROTO_UDP;
+		} else if (!third.empty()) {
+			t_error = "flow protocol is tcp or udp";
+			return false;
+		}
+		third.clear();
+	} else if (kind == "subnet") {
+		t_selector.kind = TraceSelectorKind::SUBNET;
+		if (first.empty()) {
+			t_error = "subnet needs a.b.c.d/len";
+			return false;
+		}
+		Subnet subnet(first.c_str());
+		if (!subnet.isValid()) {
+			t_error = "subnet needs a.b.c.d/len";
+			return false;
+		}
+		t_selector.ipA = subnet.getPrefix();
+		t_selector.maskA = subnet.getMask();
+	} else if (kind == "port") {
+		t_selector.kind = TraceSelectorKind::PORT;
+		char* end;
+		unsigned long port = strtoul(first.c_str(), &end, 10);
+		if (first.empty() || *end != '\0' || port > 65535) {
+			t_error = "port needs a number up to 65535";
+			return false;
+		}
+		t_selector.portA = port;
+	} else if (kind == "error") {
+		t_selector.kind = TraceSelectorKind::ERROR;
+		char* end;
+		unsigned long errorMask = strtoul(first.c_str(), &end, 0);
+		if (first.empty() || *end != '\0' || errorMask == 0 || errorMask > UINT32_MAX) {
+			t_error = "error needs a non-zero mask of the session error bits";
+			return false;
+		}
+		t_selector.errorMask = errorMask;
+	} else {
+		t_error = "selector is flow, subnet, port or error";
+		return false;
+	}
+	if ((kind != "flow" && !second.empty()) || !third.empty() || !extra.empty()) {
+		t_error = "unexpected words after the " + kind + " selector";
+		return false;
+	}
+	return true;
+}
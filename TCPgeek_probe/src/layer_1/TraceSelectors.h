@@ -0,0 +1,87 @@
+/*
+ *	TraceSelectors.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : TraceSelectors - the packets to trace when packetTraceFile and traceControlSocket
+ *					are both configured. The selectors are installed and removed at runtime by
+ *					TraceControlServer and read by the capture thread without locks.
+ *
+ *	The selectors live in TRACE_SELECTORS_MAX static slots, each guarded by its own sequence
+ *	counter: the writer makes the counter odd, fills the slot and makes it even again, the reader
+ *	takes the slot only if the counter was even and hasn't changed while the slot was copied.
+ *	A packet that races with the change of a slot is just not matched by it. s_activeSelectors is
+ *	0 most of the time, so the capture thread pays one predictable branch when nothing is selected.
+ */
+
+#ifndef TRACESELECTORS_H_
+#define TRACESELECTORS_H_
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+#include "layer_1/Packet.h"
+#include "layer_1/PacketProcessingResultEnum.h"
+
+#define TRACE_SELECTORS_MAX 16
+
+enum class TraceSelectorKind : uint32_t {
+			FREE,
+			FLOW,		//both endpoints and the protocol, either direction
+			SUBNET,		//either endpoint belongs to the subnet
+			PORT,		//either port
+			ERROR		//TCP packets of the sessions with any of the error bits, see TcpSession::m_sessionErrorCode
+};
+
+struct TraceSelector {
+	TraceSelectorKind kind;
+	uint32_t	ipA, ipB;			//host byte order, ipA with maskA is the subnet of SUBNET
+	uint32_t	maskA;
+	uint16_t	portA, portB;
+	uint8_t		protocol;			//IPPROTO_TCP or IPPROTO_UDP of FLOW, 0 - any
+	uint32_t	errorMask;			//error bits of ERROR
+};
+
+class TraceSelectors {
+private:
+	struct Slot {
+		std::atomic<uint32_t> version; //odd while the slot is written
+		TraceSelector selector;
+	};
+	static Slot s_slots[TRACE_SELECTORS_MAX];
+	static std::atomic<uint64_t> s_matchedPackets[TRACE_SELECTORS_MAX]; //written by the capture thread only
+	static uint64_t s_matchedBase[TRACE_SELECTORS_MAX]; //s_matchedPackets when the selector was installed
+	static std::atomic<uint32_t> s_activeSelectors;
+
+	static bool isMatching(const TraceSelector& t_selector, const Packet& t_packet,
+							const PacketProcessingResultEnum t_packetProcessingResult, const uint32_t t_sessionErrorCode);
+	static void store(const int t_slot, const TraceSelector& t_selector);
+
+public:
+	static bool match(const Packet& t_packet, const PacketProcessingResultEnum t_packetProcessingResult,
+						const uint32_t t_sessionErrorCode) {
+		//invoked from the main thread of capturing for every packet when the tracing is selective
+		if (s_activeSelectors.load(std::memory_order_relaxed) == 0) return false;
+		return matchSlots(t_packet, t_packetProcessingResult, t_sessionErrorCode);
+	}
+	static bool matchSlots(const Packet& t_packet, const PacketProcessingResultEnum t_packetProcessingResult,
+							const uint32_t t_sessionErrorCode);
+
+	//the rest might be invoked only from the single thread managing the selectors
+	static int install(const TraceSelector& t_selector);
+	//returns the slot of the new selector, -1 if all of them are taken
+	static bool remove(const int t_slot);
+	static void clear();
+	static bool describe(const int t_slot, std::string& t_description);
+	//false if the slot is free
+	static bool parse(const std::string& t_selectorStr, TraceSelector& t_selector, std::string& t_error);
+	//'flow a.b.c.d:port a.b.c.d:port [tcp|udp]', 'subnet a.b.c.d/len', 'port N' or 'error mask'
+};
+
+#endif /* TRACESELECTORS_H_ */
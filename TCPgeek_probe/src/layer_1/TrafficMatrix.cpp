@@ -0,0 +1,144 @@
+/*
+ *	TrafficMatrix.cpp
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "layer_1/TrafficMatrix.h"
+
+TrafficMatrix::TrafficMatrix() : m_dimension {0} {
+}
+
+uint64_t TrafficMatrix::getIndexKey(const u_char t_ipProtocol, const uint32_t t_clientSubnetId, const uint32_t t_serverSubnetId) const {
+	uint64_t protocolSlot = (t_ipProtocol == IPPROTO_UDP) ? 1 : 0;
+	return (protocolSlot * m_dimension + t_clientSubnetId) * m_dimension + t_serverSubnetId;
+}
+
+void TrafficMatrix::resize(const uint32_t t_dimension) {
+	m_dimension = t_dimension;
+	m_sparseIndex.clear();
+	std::vector<uint32_t>().swap(m_denseIndex);
+	if ((uint64_t) m_dimension * m_dimension * 2 <= TRAFFIC_MATRIX_MAX_DENSE_INDEX) {
+		m_denseIndex.assign((std::size_t) m_dimension * m_dimension * 2, 0);
+	}
+}
+
+TrafficMatrixCell& TrafficMatrix::getCell(const u_char t_ipProtocol, const uint32_t t_clientSubnetId, const uint32_t t_serverSubnetId) {
+	uint64_t key = getIndexKey(t_ipProtocol, t_clientSubnetId, t_serverSubnetId);
+	uint32_t* cellNumber;
+	if (!m_denseIndex.empty()) {
+		cellNumber = &m_denseIndex[key];
+	} else {
+		cellNumber = &m_sparseIndex[key];
+	}
+	if (*cellNumber == 0) {
+		TrafficMatrixCell cell;
+		memset(&cell, 0, sizeof(cell));
+		cell.clientSubnetId = t_clientSubnetId;
+		cell.serverSubnetId = t_serverSubnetId;
+		cell.ipProtocol = t_ipProtocol;
+		m_cells.push_back(cell);
+		*cellNumber = m_cells.size();
+	}
+	return m_cells[*cellNumber - 1];
+}
+
+void TrafficMatrix::build(const std::vector<StatRecord>& t_batch, const RuntimeSettings* t_settings) {
+	//only the touched entries of the index are cleared, the index itself is kept between intervals
+	for (std::size_t i = 0; i < m_cells.size(); i++) {
+		if (!m_denseIndex.empty()) {
+			m_denseIndex[getIndexKey(m_cells[i].ipProtocol, m_cells[i].clientSubnetId, m_cells[i].serverSubnetId)] = 0;
+		}
+	}
+	m_sparseIndex.clear();
+	m_cells.clear();
+	if (t_settings->getLocalSubnetsCount() + 1 != m_dimension) {
+		resize(t_settings->getLocalSubnetsCount() + 1);
+	}
+
+	for (std::size_t i = 0; i < t_batch.size(); i++) {
+		const StatRecord& statRecord = t_batch[i];
+		SessionLocation location = statRecord.getLocation();
+		if (location.generation != t_settings->getGeneration()) {
+			location = t_settings->locateSession(statRecord.getTcpUdpSessionKey().m_serverIpRaw,
+													statRecord.getTcpUdpSessionKey().m_clientIpRaw);
+		}
+		TrafficMatrixCell& cell = getCell(statRecord.getIpProtocol(), location.clientSubnetId, location.serverSubnetId);
+		//a session taken at 1:N flow sampling stands for N of them, the ratios between the totals stay the same
+		uint64_t samplingRate = statRecord.getSamplingRate();
+		cell.sessions += samplingRate;
+		cell.clientPackets += statRecord.getClientPackets() * samplingRate;
+		cell.serverPackets += statRecord.getServerPackets() * samplingRate;
+		cell.clientBytes += statRecord.getClientBytes() * samplingRate;
+		cell.serverBytes += statRecord.getServerBytes() * samplingRate;
+		cell.clientRetransmits += statRecord.getClientRetransmits() * samplingRate;
+		cell.serverRetransmits += statRecord.getServerRetransmits() * samplingRate;
+		cell.operations += statRecord.getOperations() * samplingRate;
+		cell.responseTime += statRecord.getResponseTime() * samplingRate;
+	}
+}
+
+void TrafficMatrix::formatSubnet(const RuntimeSettings* t_settings, const uint32_t t_subnetId, char* t_subnetStr) const {
+	const Subnet* subnet = t_settings->getLocalSubnet(t_subnetId);
+	if (subnet == NULL) {
+		strcpy(t_subnetStr, "*	0");
+		return;
+	}
+	char prefixStr[INET_ADDRSTRLEN];
+	in_addr prefix;
+	prefix.s_addr = htonl(subnet->getPrefix());
+	inet_ntop(AF_INET, &prefix, prefixStr, INET_ADDRSTRLEN);
+	sprintf(t_subnetStr, "%s/%" PRIu32 "	%" PRIu32, prefixStr, subnet->getPrefixLength(), subnet->getTag());
+}
+
+void TrafficMatrix::format(const time_t t_intervalEpoch, const RuntimeSettings* t_settings, std::string& t_payload) const {
+	char timestampStr[64];
+	char clientSubnetStr[INET_ADDRSTRLEN + 16];
+	char serverSubnetStr[INET_ADDRSTRLEN + 16];
+	char rowStr[TRAFFIC_MATRIX_ROW_MAX_SIZE];
+	struct tm timestamp_tm;
+
+	gmtime_r(&t_intervalEpoch, &timestamp_tm);
+	strftime(timestampStr, sizeof timestampStr, "%Y-%m-%d %H:%M:%S", &timestamp_tm);
+	//the cells are in the order of appearance, sorting keeps the files comparable between intervals
+	std::vector<const TrafficMatrixCell*> cells(m_cells.size());
+	for (std::size_t i = 0; i < m_cells.size(); i++) cells[i] = &m_cells[i];
+	std::sort(cells.begin(), cells.end(), [](const TrafficMatrixCell* a, const TrafficMatrixCell* b) {
+		if (a->ipProtocol != b->ipProtocol) return a->ipProtocol < b->ipProtocol;
+		if (a->clientSubnetId != b->clientSubnetId) return a->clientSubnetId < b->clientSubnetId;
+		return a->serverSubnetId < b->serverSubnetId;
+	});
+	for (std::size_t i = 0; i < cells.size(); i++) {
+		const TrafficMatrixCell& cell = *cells[i];
+		formatSubnet(t_settings, cell.clientSubnetId, clientSubnetStr);
+		formatSubnet(t_settings, cell.serverSubnetId, serverSubnetStr);
+		snprintf(rowStr, sizeof rowStr, "%s	%" PRIu8 // Timestamp, IP Protocol
+				"	%s	%s"					// Client subnet and tag, server subnet and tag ('*' - outside, without a tag)
+				"	%" PRIu64				// Sessions
+				"	%" PRIu64 "	%" PRIu64	// Packets
+				"	%" PRIu64 "	%" PRIu64	// Bytes
+				"	%" PRIu64 "	%" PRIu64	// Retransmits
+				"	%" PRIu64 "	%" PRIu64 "\n", // Operations, sum of Response Times in milliseconds
+				timestampStr, cell.ipProtocol, clientSubnetStr, serverSubnetStr, cell.sessions,
+				cell.clientPackets, cell.serverPackets, cell.clientBytes, cell.serverBytes,
+				cell.clientRetransmits, cell.serverRetransmits, cell.operations, cell.responseTime/1000);
+		t_payload.append(rowStr);
+	}
+}
+
+std::size_t TrafficMatrix::size() const {
+	return m_cells.size();
+}
@@ -0,0 +1,69 @@
+/*
+ *	TrafficMatrix.h
+ *
+ *	Created on: Oct 19, 2026
+ *	Last modified on: Oct 19, 2026
+ *
+ *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
+ *
+ *	See the COPYING file for the terms of usage and distribution.
+ *
+ *	Description : TrafficMatrix - per interval totals of the sessions between every pair of local
+ *					subnets (client subnet, server subnet, IP protocol), the outside is subnet 0.
+ *					It is built by the control thread from the harvested statistics records, so the
+ *					packet path isn't touched at all. Cells are addressed through a dense index of
+ *					(local subnets + 1)^2 * 2 entries, a hash map is used instead when there are too
+ *					many subnets for it. Only the cells touched in the interval are written out.
+ */
+
+#ifndef TRAFFICMATRIX_H_
+#define TRAFFICMATRIX_H_
+
+#define TRAFFIC_MATRIX_EXT "matrix"
+#define TRAFFIC_MATRIX_MAX_DENSE_INDEX (1 << 22) //16Mb of index, about 1400 local subnets
+#define TRAFFIC_MATRIX_ROW_MAX_SIZE 384
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <ctime>
+#include <stdint.h>
+
+#include "layer_1/StatRecord.h"
+#include "layer_1/RuntimeSettings.h"
+
+struct TrafficMatrixCell {
+	uint32_t clientSubnetId, serverSubnetId; //0 - outside of the local subnets
+	u_char ipProtocol;
+	uint64_t sessions; //statistics records of the interval, i.e. sessions active in it, scaled up by the flow sampling rate
+	uint64_t clientPackets, serverPackets;
+	uint64_t clientBytes, serverBytes;
+	uint64_t clientRetransmits, serverRetransmits;
+	uint64_t operations;
+	uint64_t responseTime; //sum of the response times in microseconds, divide by operations for the mean
+};
+
+class TrafficMatrix {
+private:
+	uint32_t m_dimension; //local subnets + 1 for the outside
+	std::vector<uint32_t> m_denseIndex; //cell number + 1 by getIndexKey(), 0 - not touched yet, empty if m_dimension is too big
+	std::unordered_map<uint64_t, uint32_t> m_sparseIndex; //the same when m_denseIndex can't be used
+	std::vector<TrafficMatrixCell> m_cells; //cells touched in the interval
+
+	uint64_t getIndexKey(const u_char t_ipProtocol, const uint32_t t_clientSubnetId, const uint32_t t_serverSubnetId) const;
+	TrafficMatrixCell& getCell(const u_char t_ipProtocol, const uint32_t t_clientSubnetId, const uint32_t t_serverSubnetId);
+	void resize(const uint32_t t_dimension);
+	void formatSubnet(const RuntimeSettings* t_settings, const uint32_t t_subnetId, char* t_subnetStr) const;
+
+public:
+	TrafficMatrix();
+
+	void build(const std::vector<StatRecord>& t_batch, const RuntimeSettings* t_settings);
+	//replaces the matrix with the totals of t_batch, records located with another snapshot of the
+	//settings (before SIGHUP) are located again with t_settings, so the subnet ids are consistent
+	void format(const time_t t_intervalEpoch, const RuntimeSettings* t_settings, std::string& t_payload) const;
+	//appends a TSV line per touched cell to t_payload
+	std::size_t size() const;
+};
+
+#endif /* TRAFFICMATRIX_H_ */
@@ -2,7 +2,7 @@
  *	IpSession.cpp
  *
  *	Created on: Aug 10, 2023
- *	Last modified on: Aug 10, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -12,12 +12,31 @@
 
 #include "layer_1/sessions/IpSession.h"
 
-IpSession::IpSession(const unsigned char t_ipProtocol):	m_totalBytes {0}, m_ipProtocol {t_ipProtocol} {
+IpSession::IpSession(const unsigned char t_ipProtocol, const uint32_t t_samplingRate):	m_totalBytes {0}, m_ipProtocol {t_ipProtocol},
+															m_samplingRate {t_samplingRate} {
+	memset(&m_location, 0, sizeof(m_location));
+	m_location.topology = 'n';
 }
 
 void IpSession::update(const Packet* t_packet) {
 	m_totalBytes += t_packet->getTotalLen();
 }
 
-IpSession::IpSession() : m_totalBytes {0}, m_ipProtocol {0} {
+IpSession::IpSession() : m_totalBytes {0}, m_ipProtocol {0}, m_samplingRate {1} {
+	memset(&m_location, 0, sizeof(m_location));
+	m_location.topology = 'n';
+}
+
+void IpSession::locate(const TcpUdpSessionKey& t_sessionKey) {
+	m_location = RuntimeSettings::get()->locateSession(t_sessionKey.m_serverIpRaw, t_sessionKey.m_clientIpRaw);
+}
+
+void IpSession::saveState(SessionSnapshotWriter& t_writer) const {
+	t_writer.put(m_totalBytes);
+	t_writer.put(m_ipProtocol);
+	t_writer.put(m_samplingRate);
+}
+
+bool IpSession::loadState(SessionSnapshotReader& t_reader) {
+	return t_reader.get(m_totalBytes) && t_reader.get(m_ipProtocol) && t_reader.get(m_samplingRate);
 }
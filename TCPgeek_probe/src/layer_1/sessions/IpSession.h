@@ -2,7 +2,7 @@
  *	IpSession.h
  *
  *	Created on: Aug 10, 2023
- *	Last modified on: Aug 10, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -16,6 +16,10 @@
 #include <stdint.h>
 
 #include "layer_1/Packet.h"
+#include "layer_1/SessionSnapshotWriter.h"
+#include "layer_1/SessionSnapshotReader.h"
+#include "layer_1/RuntimeSettings.h"
+#include "layer_1/sessions/TcpUdpSessionKey.h"
 
 class IpSession {
 protected:
@@ -25,10 +29,17 @@ protected:
 
 	//DIMENSIONS
 	unsigned char m_ipProtocol;
+	uint32_t m_samplingRate; //1:N flow sampling the session was admitted with
+	SessionLocation m_location; //local subnets of the endpoints, looked up once per session
+
+	void locate(const TcpUdpSessionKey& t_sessionKey);
+	//must be invoked once the client and the server are known
 public:
 	IpSession();
-	IpSession(const unsigned char t_ipProtocol);
+	IpSession(const unsigned char t_ipProtocol, const uint32_t t_samplingRate);
 	void update(const Packet* t_packet);
+	void saveState(SessionSnapshotWriter& t_writer) const;
+	bool loadState(SessionSnapshotReader& t_reader);
 
 };
 
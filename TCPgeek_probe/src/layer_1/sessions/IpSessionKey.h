@@ -2,7 +2,7 @@
  *	IpSessionKey.h
  *
  *	Created on: Aug 10, 2023
- *	Last modified on: Aug 10, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -33,6 +33,7 @@ public:
 	bool operator == (const IpSessionKey &other) const {
 		return (m_ipProtocol == other.m_ipProtocol);
 	}
+	IpSessionKey(const IpSessionKey& other) = default;
 	IpSessionKey& operator = (const IpSessionKey other)
 	{
 		m_ipProtocol = other.m_ipProtocol;
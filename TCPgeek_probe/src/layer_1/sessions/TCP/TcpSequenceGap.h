@@ -2,7 +2,7 @@
  *	TcpSequenceGap.h
  *
  *	Created on: Mar 28, 2022
- *	Last modified on: Mar 28, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -30,6 +30,7 @@ public:
 	void setSeqGapEnd(uint32_t t_seqGapEnd);
 	void setSeqGapStart(uint32_t t_seqGapStart);
 
+	TcpSequenceGap(const TcpSequenceGap& other) = default;
 	TcpSequenceGap& operator = (const TcpSequenceGap other);
 };
 
@@ -2,7 +2,7 @@
  *	TcpSequenceGaps.cpp
  *
  *	Created on: Mar 28, 2022
- *	Last modified on: Mar 28, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -126,6 +126,40 @@ size_t TcpSequenceGaps::size() {
 	return m_tcpSequenceGapList.size();
 }
 
+size_t TcpSequenceGaps::capSize(const size_t t_maxGaps) {
+	size_t forgottenGaps = 0;
+	//new gaps are added to the back, so the oldest ones are in front
+	while (m_tcpSequenceGapList.size() > t_maxGaps) {
+		m_tcpSequenceGapList.pop_front();
+		forgottenGaps++;
+	}
+	return forgottenGaps;
+}
+
+uint64_t TcpSequenceGaps::getMemoryBytes() const {
+	//every list node holds two pointers and the gap, plus malloc overhead
+	return m_tcpSequenceGapList.size() * (sizeof(TcpSequenceGap) + 2 * sizeof(void*) + 16);
+}
+
+void TcpSequenceGaps::saveState(SessionSnapshotWriter& t_writer) const {
+	t_writer.put((uint32_t) m_tcpSequenceGapList.size());
+	for (std::list<TcpSequenceGap>::const_iterator it = m_tcpSequenceGapList.begin(); it != m_tcpSequenceGapList.end(); ++it) {
+		t_writer.put(it->getSeqGapStart());
+		t_writer.put(it->getSeqGapEnd());
+	}
+}
+
+bool TcpSequenceGaps::loadState(SessionSnapshotReader& t_reader) {
+	uint32_t gaps, seqGapStart, seqGapEnd;
+	m_tcpSequenceGapList.clear();
+	if (!t_reader.get(gaps)) return false;
+	for (uint32_t i = 0; i < gaps; i++) {
+		if (!t_reader.get(seqGapStart) || !t_reader.get(seqGapEnd)) return false;
+		m_tcpSequenceGapList.push_back(TcpSequenceGap(seqGapStart, seqGapEnd));
+	}
+	return true;
+}
+
 void TcpSequenceGaps::printGaps() {
 	log4cpp::Category& logRoot = log4cpp::Category::getRoot();
 	std::list<TcpSequenceGap>::iterator it;
@@ -2,7 +2,7 @@
  *	TcpSequenceGaps.h
  *
  *	Created on: Mar 28, 2022
- *	Last modified on: Mar 28, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -22,6 +22,8 @@
 #include <log4cpp/Category.hh>
 
 #include "layer_1/sessions/TCP/TcpSequenceGap.h"
+#include "layer_1/SessionSnapshotWriter.h"
+#include "layer_1/SessionSnapshotReader.h"
 
 class TcpSequenceGaps {
 private:
@@ -36,6 +38,11 @@ public:
 	void addNewGap(const uint32_t t_seqStart, const uint32_t t_seqEnd);
 	//might be invoked only from the main thread of capturing
 	size_t size();
+	size_t capSize(const size_t t_maxGaps);
+	//forgets the oldest gaps above t_maxGaps, returns number of forgotten gaps
+	uint64_t getMemoryBytes() const;
+	void saveState(SessionSnapshotWriter& t_writer) const;
+	bool loadState(SessionSnapshotReader& t_reader);
 	void printGaps();
 };
 
@@ -2,7 +2,7 @@
  *	TcpSession.cpp
  *
  *	Created on: Mar 30, 2022
- *	Last modified on: May 14, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -15,8 +15,21 @@
 
 #include "layer_1/sessions/TCP/TcpSession.h"
 
-TcpSession::TcpSession(const Packet* t_packet) :
-						IpSession(t_packet->getIpProtocol()),
+TcpSession::TcpSession() : IpSession(),
+						m_operationStartTimestamp_usec {0},
+						m_clientSeqResync {false},
+						m_serverSeqResync {false},
+						m_isConnecting {false},
+						m_isOffloaded {false},
+						m_offloadedClientPackets {0},
+						m_offloadedServerPackets {0},
+						m_offloadedClientBytes {0},
+						m_offloadedServerBytes {0} {
+	//the rest is set by loadState(), the kernel map of the previous instance is gone
+}
+
+TcpSession::TcpSession(const Packet* t_packet, const uint32_t t_samplingRate) :
+						IpSession(t_packet->getIpProtocol(), t_samplingRate),
 						m_clientRetransmits {0},
 						m_serverRetransmits {0},
 						m_clientOutOfOrderCounter {0},
@@ -38,6 +51,7 @@ TcpSession::TcpSession(const Packet* t_packet) :
 						m_sessionErrorCode {0},
 						m_requestStartTimestamp_usec {0},
 						m_responseStartTimestamp_usec {0},
+						m_operationStartTimestamp_usec {0},
 						m_firstTimestamp_usec {t_packet->getTimestampUsecFull()},
 						m_lastTimestamp_usec {t_packet->getTimestampUsecFull()},
 						m_firstClientPacketTimestamp_usec {0},
@@ -45,7 +59,15 @@ TcpSession::TcpSession(const Packet* t_packet) :
 						m_lastSavedTimestamp_sec {t_packet->getTs().tv_sec},
 						m_clientEndedSession {0},
 						m_noDuplicatesFromClient {0},
-						m_noDuplicatesFromServer {0} {
+						m_noDuplicatesFromServer {0},
+						m_clientSeqResync {false},
+						m_serverSeqResync {false},
+						m_isConnecting {t_packet->isSynFlag() && !t_packet->isAckFlag()},
+						m_isOffloaded {false},
+						m_offloadedClientPackets {0},
+						m_offloadedServerPackets {0},
+						m_offloadedClientBytes {0},
+						m_offloadedServerBytes {0} {
 
 	if (t_packet->isSynFlag() && (t_packet->isFinFlag() || t_packet->isRstFlag())) return;
 	//SYN+FIN and SYN+RST protection
@@ -54,7 +76,7 @@ TcpSession::TcpSession(const Packet* t_packet) :
 	Packet* newTcpPacket = new Packet;
 	bool isRequestPacket = true;
 
-	m_packetDedupRingQueue.setMaxSize(ProgramProperties::getDeduplicationBufferSize());
+	m_packetDedupRingQueue.setMaxSize(RuntimeSettings::get()->getDeduplicationBufferSize());
 	m_packetDedupRingQueue.isDuplicatePacket(t_packet->getDupId());
 
 	//determining the service port
@@ -62,37 +84,38 @@ TcpSession::TcpSession(const Packet* t_packet) :
 	if (t_packet->isSynFlag()) {
 		if (!t_packet->isAckFlag()) {
 			//this is the first packet of the TCP session
-			m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol);
+			m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 			isRequestPacket = true;
 		} else {
 			//this is the second packet of the TCP session
-			m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol);
+			m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 			isRequestPacket = false;
 		}
-	} else if (KnownPorts::isKnownPort(t_packet->getDstPort())) {
+	} else if (RuntimeSettings::get()->isKnownPort(t_packet->getDstPort())) {
 		//destination port is in the list of known service ports
-		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol);
+		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = true;
-	} else if (KnownPorts::isKnownPort(t_packet->getSrcPort())) {
+	} else if (RuntimeSettings::get()->isKnownPort(t_packet->getSrcPort())) {
 		//source port is in the list of known service ports
-		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol);
+		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = false;
 	} else if (t_packet->getDstPort() < 1024) {
 		//destination port is in well known port range
-		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol);
+		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = true;
 	} else if (t_packet->getSrcPort() < 1024) {
 		//source port is in well known port range
-		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol);
+		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = false;
 	} else if (t_packet->getSrcPort() > t_packet->getDstPort()) {
-		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol);
+		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = true;
 	} else {
-		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol);
+		m_tcpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = false;
 	}
 
+	locate(m_tcpSessionKey);
 	if (isRequestPacket) {
 		m_serverBytesCounter = 0;
 		m_serverPayloadBytesCounter = 0;
@@ -152,8 +175,12 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 
 	TcpSessionUpdateResult result;
 	u_int64_t measuredServerThinkTime, measuredClientIdleTime;
+	u_int64_t gapStartCycles;
 
 	IpSession::update(t_packet);
+	if (MemoryBudget::getLevel() >= SheddingLevel::DEDUP_DISABLED) {
+		applyMemoryShedding();
+	}
 
 	//this won't change if neither duplicate, out-of-sequence nor retransmit is detected
 	m_gapFound.setSeqGapStart(0);
@@ -170,7 +197,9 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 			m_clientDuplicatesTotal++;
 		} else {
 			m_clientPacketsCounter++;
+			gapStartCycles = SelfMonitor::getCpuTicks();
 			result.tcpSessionProcessingResultEnum = updateSeqGapAndRetransmits(t_packet, &m_gapFound, true);
+			result.gapCycles = SelfMonitor::getCpuTicks() - gapStartCycles;
 			if (result.tcpSessionProcessingResultEnum != TcpSessionProcessingResultEnum::RETRANSMIT) {
 				m_clientPayloadBytesCounter += t_packet->getPayloadlen();
 			}
@@ -198,6 +227,8 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 						//Finishing operation and starting the new one
 						m_operations++;
 						m_responseTime += m_lastServerPacketWithPayload.getTimestampUsecFull() - m_responseStartTimestamp_usec;
+						recordOperationTime();
+						m_operationStartTimestamp_usec = t_packet->getTimestampUsecFull();
 						measuredClientIdleTime = t_packet->getTimestampUsecFull() - m_lastServerPacketWithPayload.getTimestampUsecFull();
 						if (measuredClientIdleTime >= m_clientRtt) {
 							m_clientIdleTime += measuredClientIdleTime - m_clientRtt;
@@ -215,7 +246,7 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 			}
 			m_lastClientPacket = *t_packet;
 			if (!m_noDuplicatesFromClient && (m_clientDuplicatesTotal == 0) &&
-					(t_packet->getTimestampUsecFull() - m_firstClientPacketTimestamp_usec > ProgramProperties::getDeduplicationTimeout()*1000)) {
+					(t_packet->getTimestampUsecFull() - m_firstClientPacketTimestamp_usec > RuntimeSettings::get()->getDeduplicationTimeout()*1000)) {
 			//if (!m_noDuplicatesFromClient && (m_clientDuplicatesTotal == 0) && m_clientPacketsCounter >= t_dedupMaxSize) {
 				m_noDuplicatesFromClient = true;
 			}
@@ -242,8 +273,15 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 				}
 			}
 			m_serverPacketsCounter++;
+			if (m_isConnecting && t_packet->isSynFlag() && t_packet->isAckFlag()) {
+				//SYN retransmissions are included, so it is what the client waited for the connection
+				ServiceLatencies::record(m_tcpSessionKey, ServiceMetric::CONNECT_TIME, t_packet->getTimestampUsecFull() - m_firstTimestamp_usec);
+				m_isConnecting = false;
+			}
 
+			gapStartCycles = SelfMonitor::getCpuTicks();
 			result.tcpSessionProcessingResultEnum = updateSeqGapAndRetransmits(t_packet, &m_gapFound, false);
+			result.gapCycles = SelfMonitor::getCpuTicks() - gapStartCycles;
 			if (result.tcpSessionProcessingResultEnum != TcpSessionProcessingResultEnum::RETRANSMIT) {
 				m_serverPayloadBytesCounter += t_packet->getPayloadlen();
 			}
@@ -255,6 +293,8 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 					//Stopping request timer on the last client packet with payload
 					m_requestTime += m_lastClientPacketWithPayload.getTimestampUsecFull() - m_requestStartTimestamp_usec;
 					measuredServerThinkTime = t_packet->getTimestampUsecFull() - m_lastClientPacketWithPayload.getTimestampUsecFull();
+					ServiceLatencies::record(m_tcpSessionKey, ServiceMetric::SERVER_THINK_TIME,
+												(measuredServerThinkTime >= m_serverRtt) ? measuredServerThinkTime - m_serverRtt : 0);
 					if (measuredServerThinkTime >= m_serverRtt) {
 						m_serverThinkTime += measuredServerThinkTime - m_serverRtt;
 						m_requestTime += m_serverRtt/2;
@@ -271,14 +311,14 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 			m_lastServerPacket = *t_packet;
 		}
 		if (!m_noDuplicatesFromServer && (m_serverDuplicatesTotal == 0) &&
-				(t_packet->getTimestampUsecFull() - m_firstServerPacketTimestamp_usec > ProgramProperties::getDeduplicationTimeout()*1000)) {
+				(t_packet->getTimestampUsecFull() - m_firstServerPacketTimestamp_usec > RuntimeSettings::get()->getDeduplicationTimeout()*1000)) {
 		//if (!m_noDuplicatesFromServer && (m_serverDuplicatesTotal == 0) && m_serverPacketsCounter >= t_dedupMaxSize) {
 			m_noDuplicatesFromServer = true;
 		}
 	}
 	m_lastTimestamp_usec = t_packet->getTimestampUsecFull();
 
-	if((unsigned long)(t_packet->getTs().tv_sec - m_lastSavedTimestamp_sec) >= ProgramProperties::getGranularity()) {
+	if((unsigned long)(t_packet->getTs().tv_sec - m_lastSavedTimestamp_sec) >= RuntimeSettings::get()->getGranularity()) {
 		//m_otherTime = m_lastTimestamp_usec - m_firstTimestamp_usec - m_localTime - m_remoteIdleTime - m_networkTime - m_remoteTime;
 		aggregateSessionStat(t_statQueue, m_lastSavedTimestamp_sec, t_packet->getTs().tv_sec, t_packet->getTs().tv_usec);
 		m_lastSavedTimestamp_sec = t_packet->getTs().tv_sec;
@@ -286,9 +326,22 @@ TcpSessionUpdateResult TcpSession::update(const Packet* t_packet, SafeQueue<Stat
 	result.seqGapStart = m_gapFound.getSeqGapStart();
 	result.seqGapEnd = m_gapFound.getSeqGapEnd();
 	result.operationStatus = m_operationStatus;
+	result.sessionErrorCode = m_sessionErrorCode;
 	return result;
 }
 
+void TcpSession::applyMemoryShedding() {
+	if (!m_noDuplicatesFromClient || !m_noDuplicatesFromServer) {
+		m_noDuplicatesFromClient = true;
+		m_noDuplicatesFromServer = true;
+		m_packetDedupRingQueue.release();
+	}
+	if (MemoryBudget::getLevel() >= SheddingLevel::GAPS_CAPPED) {
+		m_clientTcpSequenceGaps.capSize(MEMORY_MAX_GAPS_PER_DIRECTION);
+		m_serverTcpSequenceGaps.capSize(MEMORY_MAX_GAPS_PER_DIRECTION);
+	}
+}
+
 void TcpSession::initTimingForRequestPacket(const Packet* t_packet) {
 	u_int64_t measuredClientIdleTime;
 
@@ -309,6 +362,15 @@ void TcpSession::initTimingForRequestPacket(const Packet* t_packet) {
 	m_requestTime += m_clientRtt/2;
 	m_operationStatus = OperationStatusEnum::REQUEST_STARTED;
 	m_requestStartTimestamp_usec = t_packet->getTimestampUsecFull();
+	m_operationStartTimestamp_usec = t_packet->getTimestampUsecFull();
+}
+
+void TcpSession::recordOperationTime() {
+	//a session restored from a snapshot doesn't know when its current operation started
+	if (m_operationStartTimestamp_usec != 0 && m_lastServerPacketWithPayload.getTimestampUsecFull() >= m_operationStartTimestamp_usec) {
+		ServiceLatencies::record(m_tcpSessionKey, ServiceMetric::OPERATION,
+									m_lastServerPacketWithPayload.getTimestampUsecFull() - m_operationStartTimestamp_usec);
+	}
 }
 
 void TcpSession::finalizeOperations() {
@@ -316,6 +378,7 @@ void TcpSession::finalizeOperations() {
 		m_operations++;
 		m_responseTime += m_lastServerPacketWithPayload.getTimestampUsecFull() - m_responseStartTimestamp_usec;
 		m_responseTime += m_clientRtt/2;
+		recordOperationTime();
 	} else if (m_sessionErrorCode == 0) {
 		if (m_operationStatus == OperationStatusEnum::NOT_STARTED) {
 			if (m_lastClientPacket.isSynFlag() && !m_lastServerPacket.isSynFlag()) {
@@ -345,6 +408,7 @@ void TcpSession::defineRTT(const Packet* t_packet) {
 			//the previous packet has SYN flag
 			m_serverRtt = m_lastServerPacket.getTimestampUsecFull() - m_lastClientPacket.getTimestampUsecFull();
 			m_clientRtt = t_packet->getTimestampUsecFull() - m_lastServerPacket.getTimestampUsecFull();
+			ServiceLatencies::record(m_tcpSessionKey, ServiceMetric::RTT, m_serverRtt + m_clientRtt);
 	}
 }
 
@@ -353,6 +417,7 @@ TcpSessionProcessingResultEnum TcpSession::updateSeqGapAndRetransmits(const Pack
 	int64_t seqDiff;
 	uint32_t *lastSeqNumberPtr, *expectedNextSeqNumberPtr, *acknoledgedSeqNumberPtr;
 	uint64_t *outOfOrderCounterPtr, *retransmitsPtr;
+	bool *seqResyncPtr;
 	TcpSequenceGaps *tcpSequenceGaps;
 
 	if (t_isRequest) {
@@ -361,6 +426,7 @@ TcpSessionProcessingResultEnum TcpSession::updateSeqGapAndRetransmits(const Pack
 		acknoledgedSeqNumberPtr = &m_acknoledgedSeqNumberForResponses;
 		outOfOrderCounterPtr = &m_clientOutOfOrderCounter;
 		retransmitsPtr = &m_clientRetransmits;
+		seqResyncPtr = &m_clientSeqResync;
 		tcpSequenceGaps = &m_clientTcpSequenceGaps;
 	} else {
 		lastSeqNumberPtr = &m_lastServerSeqNumber;
@@ -368,12 +434,15 @@ TcpSessionProcessingResultEnum TcpSession::updateSeqGapAndRetransmits(const Pack
 		acknoledgedSeqNumberPtr = &m_acknoledgedSeqNumberForRequests;
 		outOfOrderCounterPtr = &m_serverOutOfOrderCounter;
 		retransmitsPtr = &m_serverRetransmits;
+		seqResyncPtr = &m_serverSeqResync;
 		tcpSequenceGaps = &m_serverTcpSequenceGaps;
 	}
 
 
 	if (t_packet->isRstFlag()) return TcpSessionProcessingResultEnum::GOOD_KNOWN;
-	if (t_packet->isSynFlag()) {
+	if (t_packet->isSynFlag() || *seqResyncPtr) {
+		//after a restart the packets missed by the probe are not a gap in the sequence
+		*seqResyncPtr = false;
 		*lastSeqNumberPtr = t_packet->getSequenceNumber();
 		*expectedNextSeqNumberPtr = t_packet->getNextSequenceNumber();
 		*acknoledgedSeqNumberPtr = t_packet->getAckNumber();
@@ -465,8 +534,19 @@ void TcpSession::aggregateSessionStat(SafeQueue<StatRecord>* t_statQueue, const
 								m_clientRetransmits, m_serverRetransmits,
 								m_operations, m_clientIdleTime, m_requestTime, m_serverThinkTime, m_responseTime,
 								m_totalSessionIdleTime, m_sessionErrorCode,
-								m_serverRtt + m_clientRtt);
+								m_serverRtt + m_clientRtt, m_samplingRate, m_location);
 	t_statQueue->enqueue(m_statRecord);
+	resetIntervalCounters();
+	//DEBUG
+	//log4cpp::Category& logRoot = log4cpp::Category::getRoot();
+	//logRoot.debug("ClientTcpSequenceGaps are:");
+	//m_clientTcpSequenceGaps.printGaps();
+	//logRoot.debug("ServerTcpSequenceGaps are:");
+	//m_serverTcpSequenceGaps.printGaps();
+	//!DEBUG
+}
+
+void TcpSession::resetIntervalCounters() {
 	m_clientPacketsCounter = 0;
 	m_serverPacketsCounter = 0;
 	m_clientBytesCounter = 0;
@@ -484,13 +564,6 @@ void TcpSession::aggregateSessionStat(SafeQueue<StatRecord>* t_statQueue, const
 	m_requestTime = 0;
 	m_serverThinkTime = 0;
 	m_responseTime = 0;
-	//DEBUG
-	//log4cpp::Category& logRoot = log4cpp::Category::getRoot();
-	//logRoot.debug("ClientTcpSequenceGaps are:");
-	//m_clientTcpSequenceGaps.printGaps();
-	//logRoot.debug("ServerTcpSequenceGaps are:");
-	//m_serverTcpSequenceGaps.printGaps();
-	//!DEBUG
 }
 
 const Packet& TcpSession::getLastClientPacket() const {
@@ -525,4 +598,164 @@ int64_t TcpSession::getLastSavedTimestampSec() const {
 	return m_lastSavedTimestamp_sec;
 }
 
+uint64_t TcpSession::getGapMemoryBytes() const {
+	return m_clientTcpSequenceGaps.getMemoryBytes() + m_serverTcpSequenceGaps.getMemoryBytes();
+}
+
+uint64_t TcpSession::getDedupMemoryBytes() const {
+	return m_packetDedupRingQueue.getMemoryBytes();
+}
+
+void TcpSession::countState(TcpSessionStates& t_states) const {
+	if (m_clientEndedSession) {
+		t_states.closing++;
+	} else if (m_isConnecting) {
+		t_states.halfOpen++;
+	} else {
+		t_states.established++;
+	}
+}
+
+bool TcpSession::isOffloadCandidate(const uint64_t t_minPackets) const {
+	return !m_isOffloaded && !m_isConnecting && !m_clientEndedSession &&
+			m_clientPacketsCounter + m_serverPacketsCounter >= t_minPackets;
+}
+
+void TcpSession::startOffload() {
+	m_isOffloaded = true;
+	m_offloadedClientPackets = 0;
+	m_offloadedServerPackets = 0;
+	m_offloadedClientBytes = 0;
+	m_offloadedServerBytes = 0;
+}
+
+uint64_t TcpSession::mergeOffloadedCounters(const uint64_t t_clientPackets, const uint64_t t_clientBytes,
+											const uint64_t t_serverPackets, const uint64_t t_serverBytes) {
+	uint64_t newPackets = 0;
+	//an entry this session hasn't started was left by the previous session of the same endpoints,
+	//what it has counted belongs to that session, so only the increments from now on are taken
+	if (m_isOffloaded) {
+		uint64_t clientBytes = t_clientBytes - m_offloadedClientBytes;
+		uint64_t serverBytes = t_serverBytes - m_offloadedServerBytes;
+		newPackets = (t_clientPackets - m_offloadedClientPackets) + (t_serverPackets - m_offloadedServerPackets);
+		m_clientPacketsCounter += t_clientPackets - m_offloadedClientPackets;
+		m_serverPacketsCounter += t_serverPackets - m_offloadedServerPackets;
+		m_clientBytesCounter += clientBytes;
+		m_serverBytesCounter += serverBytes;
+		m_totalBytes += clientBytes + serverBytes;
+	}
+	m_isOffloaded = true;
+	m_offloadedClientPackets = t_clientPackets;
+	m_offloadedServerPackets = t_serverPackets;
+	m_offloadedClientBytes = t_clientBytes;
+	m_offloadedServerBytes = t_serverBytes;
+	return newPackets;
+}
+
+void TcpSession::saveState(SessionSnapshotWriter& t_writer) const {
+	IpSession::saveState(t_writer);
+	t_writer.put(m_tcpSessionKey.m_clientIpRaw.s_addr);
+	t_writer.put(m_tcpSessionKey.m_serverIpRaw.s_addr);
+	t_writer.put(m_tcpSessionKey.m_clientPort);
+	t_writer.put(m_tcpSessionKey.m_serverPort);
+	t_writer.put(m_clientRetransmits);
+	t_writer.put(m_serverRetransmits);
+	t_writer.put(m_clientOutOfOrderCounter);
+	t_writer.put(m_serverOutOfOrderCounter);
+	t_writer.put(m_clientRtt);
+	t_writer.put(m_serverRtt);
+	t_writer.put(m_clientBytesCounter);
+	t_writer.put(m_serverBytesCounter);
+	t_writer.put(m_clientPayloadBytesCounter);
+	t_writer.put(m_serverPayloadBytesCounter);
+	t_writer.put(m_clientPacketsCounter);
+	t_writer.put(m_serverPacketsCounter);
+	t_writer.put(m_clientDuplicatesCounter);
+	t_writer.put(m_serverDuplicatesCounter);
+	t_writer.put(m_clientDuplicatesTotal);
+	t_writer.put(m_serverDuplicatesTotal);
+	t_writer.put((uint8_t) m_operationStatus);
+	t_writer.put(m_operations);
+	t_writer.put(m_clientIdleTime);
+	t_writer.put(m_requestTime);
+	t_writer.put(m_serverThinkTime);
+	t_writer.put(m_responseTime);
+	t_writer.put(m_totalExplainedTime);
+	t_writer.put(m_totalSessionIdleTime);
+	t_writer.put(m_sessionErrorCode);
+	t_writer.put(m_requestStartTimestamp_usec);
+	t_writer.put(m_responseStartTimestamp_usec);
+	t_writer.put(m_firstTimestamp_usec);
+	t_writer.put(m_lastTimestamp_usec);
+	t_writer.put(m_firstClientPacketTimestamp_usec);
+	t_writer.put(m_firstServerPacketTimestamp_usec);
+	t_writer.put(m_lastSavedTimestamp_sec);
+	t_writer.put(m_lastClientSeqNumber);
+	t_writer.put(m_lastServerSeqNumber);
+	t_writer.put(m_nextClientSeqNumber);
+	t_writer.put(m_nextServerSeqNumber);
+	t_writer.put(m_acknoledgedSeqNumberForRequests);
+	t_writer.put(m_acknoledgedSeqNumberForResponses);
+	t_writer.put((uint8_t) m_clientEndedSession);
+	t_writer.put((uint8_t) m_noDuplicatesFromClient);
+	t_writer.put((uint8_t) m_noDuplicatesFromServer);
+	m_lastClientPacket.saveState(t_writer);
+	m_lastServerPacket.saveState(t_writer);
+	m_lastClientPacketWithPayload.saveState(t_writer);
+	m_lastServerPacketWithPayload.saveState(t_writer);
+	m_clientTcpSequenceGaps.saveState(t_writer);
+	m_serverTcpSequenceGaps.saveState(t_writer);
+	//the dedup ring is not saved, it only matters within deduplicationTimeout
+}
 
+bool TcpSession::loadState(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters) {
+	uint8_t operationStatus, clientEndedSession, noDuplicatesFromClient, noDuplicatesFromServer;
+
+	if (!(IpSession::loadState(t_reader) &&
+			t_reader.get(m_tcpSessionKey.m_clientIpRaw.s_addr) && t_reader.get(m_tcpSessionKey.m_serverIpRaw.s_addr) &&
+			t_reader.get(m_tcpSessionKey.m_clientPort) && t_reader.get(m_tcpSessionKey.m_serverPort) &&
+			t_reader.get(m_clientRetransmits) && t_reader.get(m_serverRetransmits) &&
+			t_reader.get(m_clientOutOfOrderCounter) && t_reader.get(m_serverOutOfOrderCounter) &&
+			t_reader.get(m_clientRtt) && t_reader.get(m_serverRtt) &&
+			t_reader.get(m_clientBytesCounter) && t_reader.get(m_serverBytesCounter) &&
+			t_reader.get(m_clientPayloadBytesCounter) && t_reader.get(m_serverPayloadBytesCounter) &&
+			t_reader.get(m_clientPacketsCounter) && t_reader.get(m_serverPacketsCounter) &&
+			t_reader.get(m_clientDuplicatesCounter) && t_reader.get(m_serverDuplicatesCounter) &&
+			t_reader.get(m_clientDuplicatesTotal) && t_reader.get(m_serverDuplicatesTotal) &&
+			t_reader.get(operationStatus) && t_reader.get(m_operations) &&
+			t_reader.get(m_clientIdleTime) && t_reader.get(m_requestTime) &&
+			t_reader.get(m_serverThinkTime) && t_reader.get(m_responseTime) &&
+			t_reader.get(m_totalExplainedTime) && t_reader.get(m_totalSessionIdleTime) &&
+			t_reader.get(m_sessionErrorCode) &&
+			t_reader.get(m_requestStartTimestamp_usec) && t_reader.get(m_responseStartTimestamp_usec) &&
+			t_reader.get(m_firstTimestamp_usec) && t_reader.get(m_lastTimestamp_usec) &&
+			t_reader.get(m_firstClientPacketTimestamp_usec) && t_reader.get(m_firstServerPacketTimestamp_usec) &&
+			t_reader.get(m_lastSavedTimestamp_sec) &&
+			t_reader.get(m_lastClientSeqNumber) && t_reader.get(m_lastServerSeqNumber) &&
+			t_reader.get(m_nextClientSeqNumber) && t_reader.get(m_nextServerSeqNumber) &&
+			t_reader.get(m_acknoledgedSeqNumberForRequests) && t_reader.get(m_acknoledgedSeqNumberForResponses) &&
+			t_reader.get(clientEndedSession) && t_reader.get(noDuplicatesFromClient) && t_reader.get(noDuplicatesFromServer) &&
+			m_lastClientPacket.loadState(t_reader) && m_lastServerPacket.loadState(t_reader) &&
+			m_lastClientPacketWithPayload.loadState(t_reader) && m_lastServerPacketWithPayload.loadState(t_reader) &&
+			m_clientTcpSequenceGaps.loadState(t_reader) && m_serverTcpSequenceGaps.loadState(t_reader))) {
+		return false;
+	}
+	if (operationStatus > (uint8_t) OperationStatusEnum::RESPONSE_STARTED) return false;
+	m_tcpSessionKey.m_ipSessionKey.updateIpSessionKey(m_ipProtocol);
+	//the subnets might have been changed since the snapshot
+	locate(m_tcpSessionKey);
+	m_operationStatus = (OperationStatusEnum) operationStatus;
+	m_clientEndedSession = clientEndedSession;
+	m_noDuplicatesFromClient = noDuplicatesFromClient;
+	m_noDuplicatesFromServer = noDuplicatesFromServer;
+	m_packetDedupRingQueue.setMaxSize(RuntimeSettings::get()->getDeduplicationBufferSize());
+	m_gapFound.setSeqGapStart(0);
+	m_gapFound.setSeqGapEnd(0);
+	m_clientSeqResync = true;
+	m_serverSeqResync = true;
+	if (!t_keepIntervalCounters) {
+		resetIntervalCounters();
+		m_lastSavedTimestamp_sec = std::time(nullptr);
+	}
+	return true;
+}
@@ -2,7 +2,7 @@
  *	TcpSession.h
  *
  *	Created on: Mar 30, 2022
- *	Last modified on: Mar 30, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -27,17 +27,26 @@
 #include <unordered_set>
 
 #include "ProgramProperties.h"
-#include "layer_1/KnownPorts.h"
+#include "SelfMonitor.h"
+#include "layer_1/RuntimeSettings.h"
 #include "layer_1/sessions/TcpUdpSessionKey.h"
 #include "layer_1/sessions/IpSession.h"
 #include "layer_1/StatRecord.h"
 #include "layer_1/Packet.h"
 #include "layer_1/PacketDedupRingQueue.h"
+#include "layer_1/MemoryBudget.h"
 #include "layer_1/OperationStatusEnum.h"
+#include "layer_1/ServiceLatencies.h"
 #include "layer_1/sessions/TCP/TcpSequenceGaps.h"
 #include "layer_1/sessions/TCP/TcpSessionUpdateResult.h"
 #include "SafeQueue.h" // for statistic records queuing
 
+struct TcpSessionStates {
+	uint64_t established;	//the handshake is done or wasn't seen, the client hasn't ended the session
+	uint64_t halfOpen;		//the client SYN is seen, the SYN/ACK isn't yet
+	uint64_t closing;		//the client has sent FIN or RST
+};
+
 class TcpSession: protected IpSession {
 private:
 
@@ -68,6 +77,7 @@ private:
 	// 2^3 - Server Not Responding Error
 	uint64_t m_requestStartTimestamp_usec;
 	uint64_t m_responseStartTimestamp_usec;
+	uint64_t m_operationStartTimestamp_usec; //the first request packet of the current operation, 0 - unknown
 	//general session control
 	uint64_t m_firstTimestamp_usec, m_lastTimestamp_usec;  //in microseconds
 	uint64_t m_firstClientPacketTimestamp_usec;  //in microseconds
@@ -78,6 +88,11 @@ private:
 	u_int32_t m_acknoledgedSeqNumberForRequests, m_acknoledgedSeqNumberForResponses;
 	bool m_clientEndedSession;
 	bool m_noDuplicatesFromClient, m_noDuplicatesFromServer; // Prevents excessive verification for duplicates
+	bool m_clientSeqResync, m_serverSeqResync; //the session was restored from a snapshot, the packets sent meanwhile are unknown
+	bool m_isConnecting; //the session started with the client SYN and no SYN/ACK is seen yet
+	bool m_isOffloaded; //its in-order pure ACKs are counted by FlowOffload in the kernel
+	uint64_t m_offloadedClientPackets, m_offloadedServerPackets; //the totals of its kernel map entry merged so far
+	uint64_t m_offloadedClientBytes, m_offloadedServerBytes;
 	Packet m_lastClientPacket, m_lastServerPacket;
 	Packet m_lastClientPacketWithPayload, m_lastServerPacketWithPayload;
 	TcpSequenceGaps m_clientTcpSequenceGaps; //list of TCP sequence gaps in outbound direction
@@ -97,12 +112,15 @@ private:
 
 	void defineRTT(const Packet* t_packet);
 	void initTimingForRequestPacket(const Packet* t_packet);
+	void recordOperationTime();
+	void resetIntervalCounters();
 
 
 
 public:
 	TcpSession();
-	TcpSession(const Packet* t_packet);
+	//an empty session to be restored with loadState()
+	TcpSession(const Packet* t_packet, const uint32_t t_samplingRate);
 
 	TcpSessionUpdateResult update(const Packet* t_packet, SafeQueue<StatRecord>* t_statQueue);
 	//updates TcpSession object fields and statQueue nodes according to the captured packet
@@ -112,6 +130,9 @@ public:
 	//aggregates statistics of TCP session in the main thread of capturing and updates statQueue - queue of stat records
 	//might be invoked from snifferControl thread with protection of _tcpSessionsMutex when session is terminated as idle
 	void finalizeOperations();
+	void applyMemoryShedding();
+	//disables dedup and caps the gap lists as MemoryBudget demands
+	//might be invoked from snifferControl thread with protection of _tcpSessionsMutex
 	const Packet& getLastClientPacket() const;
 	const Packet& getLastServerPacket() const;
 	uint64_t getLastTimestampUsec() const;
@@ -120,6 +141,23 @@ public:
 	const Packet& getLastServerPacketWithPayload() const;
 	const TcpUdpSessionKey& getTcpSessionKey() const;
 	int64_t getLastSavedTimestampSec() const;
+	uint64_t getGapMemoryBytes() const;
+	uint64_t getDedupMemoryBytes() const;
+	void countState(TcpSessionStates& t_states) const;
+	//adds the session to the counter of its state
+	bool isOffloadCandidate(const uint64_t t_minPackets) const;
+	//true if the session is established, isn't offloaded yet and has sent t_minPackets in the current interval
+	void startOffload();
+	//the kernel map entry of the session is created with zero counters
+	uint64_t mergeOffloadedCounters(const uint64_t t_clientPackets, const uint64_t t_clientBytes,
+									const uint64_t t_serverPackets, const uint64_t t_serverBytes);
+	//t_* are the totals of the kernel map entry, adds what is new to the current interval and returns the new packets
+	//might be invoked from snifferControl thread with protection of _tcpSessionsMutex
+	void saveState(SessionSnapshotWriter& t_writer) const;
+	//might be invoked from snifferControl thread with protection of _tcpSessionsMutex
+	bool loadState(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters);
+	//restores the session saved by saveState(), the counters of the current interval are kept only if
+	//they weren't reported by the previous instance of the probe
 };
 
 #endif /* TCPSESSION_H_ */
@@ -2,7 +2,7 @@
  *	TcpSessionProcessingResult.h
  *
  *	Created on: May 12, 2023
- *	Last modified on: May 12, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -25,18 +25,20 @@ enum class TcpSessionProcessingResultEnum {
 			RETRANSMIT,
 			KEEPALIVE,
 			DUPLICATE,
-			VOID
+			VOID,
+			SAMPLED_OUT		//the packet of a new flow not taken by the overload sampling
 };
 
 struct TcpSessionUpdateResult
 {
-	TcpSessionProcessingResultEnum tcpSessionProcessingResultEnum;
-	uint32_t	seqGapStart;
-	uint32_t	seqGapEnd;
-	uint64_t	debugCpuCycles0 = 0;
-	uint64_t	debugCpuCycles1 = 0;
-	uint64_t	debugCpuCycles2 = 0;
-	OperationStatusEnum operationStatus;
+	TcpSessionProcessingResultEnum tcpSessionProcessingResultEnum = TcpSessionProcessingResultEnum::VOID;
+	uint32_t	seqGapStart = 0;
+	uint32_t	seqGapEnd = 0;
+	uint64_t	lookupCycles = 0;	//TSC ticks spent searching the session in the map
+	uint64_t	updateCycles = 0;	//TSC ticks spent updating the known session or creating a new one
+	uint64_t	gapCycles = 0;		//TSC ticks spent in the sequence gap analysis, a part of updateCycles
+	OperationStatusEnum operationStatus = OperationStatusEnum::NOT_STARTED;
+	uint32_t	sessionErrorCode = 0;	//error bits of the session after the packet, see TcpSession::m_sessionErrorCode
 
 };
 
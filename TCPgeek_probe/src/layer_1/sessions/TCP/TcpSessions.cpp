@@ -2,7 +2,7 @@
  *	TcpSessions.cpp
  *
  *	Created on: Mar 30, 2022
- *	Last modified on: May 14, 2024
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -32,40 +32,37 @@ const std::size_t TcpSessions::size() const {
 
 TcpSessionUpdateResult TcpSessions::update(const Packet* t_packet) {
 
-	//!DEBUG
-		u_int64_t startCycles, endCycles;
-		startCycles = SelfMonitor::getCpuTicks();
-	//------
-
 	TcpSessionUpdateResult result;
+	u_int64_t lookupStartCycles, updateStartCycles;
 	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
 	TcpUdpSessionKey* clientPacketTcpSessionKey;
 	TcpUdpSessionKey* serverPacketTcpSessionKey;
 
 	result.tcpSessionProcessingResultEnum = TcpSessionProcessingResultEnum::VOID;
 	result.operationStatus = OperationStatusEnum::NOT_STARTED;
-	result.debugCpuCycles0 = 0;
-	result.debugCpuCycles1 = 0;
-	result.debugCpuCycles2 = 0;
 
 	//at this moment we don't know if this is a request or response, so considering both options
 	clientPacketTcpSessionKey = new TcpUdpSessionKey(t_packet->getSrcPort(), //client port
 													t_packet->getDstPort(), //server port
 													t_packet->getSrcIpRaw(), //client IP
 													t_packet->getDstIpRaw(),
-													t_packet->getIpProtocol()); //server IP
+													t_packet->getIpProtocol(), //server IP
+													t_packet->getInterfaceId());
 	serverPacketTcpSessionKey = new TcpUdpSessionKey(t_packet->getDstPort(), //client port
 													t_packet->getSrcPort(), //server port
 													t_packet->getDstIpRaw(), //client IP
 													t_packet->getSrcIpRaw(), //server IP
-													t_packet->getIpProtocol());
+													t_packet->getIpProtocol(),
+													t_packet->getInterfaceId());
 	{
 		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex); //preventing control thread from reading in the same time
 
+		lookupStartCycles = SelfMonitor::getCpuTicks();
 		sessionsIterator = m_tcpSessionsMap.find(*clientPacketTcpSessionKey);
 		if (sessionsIterator == m_tcpSessionsMap.end()) {
 			sessionsIterator = m_tcpSessionsMap.find(*serverPacketTcpSessionKey);
 		}
+		updateStartCycles = SelfMonitor::getCpuTicks();
 
 		if (t_packet->isSynFlag() && !t_packet->isAckFlag() && (sessionsIterator != m_tcpSessionsMap.end())) {
 			//there can be SYN packet of new session, while the session with the same TcpSessionKey persists in the m_tcpSessionsMap
@@ -80,8 +77,10 @@ TcpSessionUpdateResult TcpSessions::update(const Packet* t_packet) {
 		}
 		if (sessionsIterator == m_tcpSessionsMap.end()) {
 			//this packet doesn't belong to any known TCP session, hence this is a new session
-			if (!t_packet->isRstFlag() && (m_tcpSessionsMap.size() < ProgramProperties::getMaxTcpSessions())) {
-				TcpSession* newSession = new TcpSession(t_packet);
+			if (!OverloadController::isFlowSampled(t_packet)) {
+				result.tcpSessionProcessingResultEnum = TcpSessionProcessingResultEnum::SAMPLED_OUT;
+			} else if (!t_packet->isRstFlag() && (m_tcpSessionsMap.size() < ProgramProperties::getMaxTcpSessions())) {
+				TcpSession* newSession = new TcpSession(t_packet, OverloadController::getSamplingRate());
 				m_tcpSessionsMap.insert(std::make_pair(newSession->getTcpSessionKey(),*newSession));
 				delete newSession;
 				result.tcpSessionProcessingResultEnum = TcpSessionProcessingResultEnum::GOOD_NEW;
@@ -90,20 +89,17 @@ TcpSessionUpdateResult TcpSessions::update(const Packet* t_packet) {
 			//this packet updates known TCP session
 			result = sessionsIterator->second.update(t_packet, m_statQueue);
 		}
-
+		//gapCycles come from the session's result
+		result.lookupCycles = updateStartCycles - lookupStartCycles;
+		result.updateCycles = SelfMonitor::getCpuTicks() - updateStartCycles;
 	}
 	delete clientPacketTcpSessionKey;
 	delete serverPacketTcpSessionKey;
 
-	//!DEBUG
-		endCycles = SelfMonitor::getCpuTicks();
-		result.debugCpuCycles0 = endCycles - startCycles;
-	//------
-
 	return result;
 }
 
-uint32_t TcpSessions::cleanIdleSessions() {
+uint32_t TcpSessions::cleanIdleSessions(const int64_t t_nowSec) {
 
 	uint32_t erasedSessions = 0;
 	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
@@ -111,7 +107,7 @@ uint32_t TcpSessions::cleanIdleSessions() {
 		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
 		sessionsIterator = m_tcpSessionsMap.begin();
 		while (sessionsIterator != m_tcpSessionsMap.end()) {
-			if (std::time(nullptr) - sessionsIterator->second.getLastTimestampSec()  > ProgramProperties::getIdleTcpSessionTimeout()) {
+			if (t_nowSec - (int64_t) sessionsIterator->second.getLastTimestampSec() > (int64_t) ProgramProperties::getIdleTcpSessionTimeout()) {
 			//this session is idle, so removing it from the map
 
 				sessionsIterator->second.finalizeOperations();
@@ -127,20 +123,174 @@ uint32_t TcpSessions::cleanIdleSessions() {
 }
 
 uint32_t TcpSessions::finalStatCalculation() {
+	std::vector<TcpUdpSessionKey> sessionKeys;
+	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
+	{
+		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+		sessionKeys.reserve(m_tcpSessionsMap.size());
+		for (sessionsIterator = m_tcpSessionsMap.begin(); sessionsIterator != m_tcpSessionsMap.end(); ++sessionsIterator) {
+			sessionKeys.push_back(sessionsIterator->first);
+		}
+		//the last records don't depend on the layout of the hash table, so two runs over a pcap file give the same output
+		std::sort(sessionKeys.begin(), sessionKeys.end(), TcpUdpSessionKeyLess());
+		for (std::size_t i = 0; i < sessionKeys.size(); i++) {
+			sessionsIterator = m_tcpSessionsMap.find(sessionKeys[i]);
+			sessionsIterator->second.finalizeOperations();
+			sessionsIterator->second.aggregateSessionStat(m_statQueue, sessionsIterator->second.getLastSavedTimestampSec(),
+														sessionsIterator->second.getLastTimestampSec(), sessionsIterator->second.getLastTimestampUsec() % 1000000);
+			m_tcpSessionsMap.erase(sessionsIterator);
+		}
+	}
+	return sessionKeys.size();
+}
 
-	uint32_t erasedSessions {0};
+void TcpSessions::accountMemory(MemoryUsage& t_usage) const {
+	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::const_iterator sessionsIterator;
+	{
+		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+		//every node holds the key, the session, the next pointer and the cached hash
+		t_usage.tcpSessions += m_tcpSessionsMap.size();
+		t_usage.tcpTableBytes += m_tcpSessionsMap.size() * (sizeof(std::pair<const TcpUdpSessionKey, TcpSession>) + sizeof(void*) + sizeof(std::size_t) + 16) +
+									m_tcpSessionsMap.bucket_count() * sizeof(void*);
+		for (sessionsIterator = m_tcpSessionsMap.begin(); sessionsIterator != m_tcpSessionsMap.end(); ++sessionsIterator) {
+			t_usage.gapBytes += sessionsIterator->second.getGapMemoryBytes();
+			t_usage.dedupBytes += sessionsIterator->second.getDedupMemoryBytes();
+		}
+	}
+}
+
+void TcpSessions::countStates(TcpSessionStates& t_states) const {
+	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::const_iterator sessionsIterator;
+	std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+	for (sessionsIterator = m_tcpSessionsMap.begin(); sessionsIterator != m_tcpSessionsMap.end(); ++sessionsIterator) {
+		sessionsIterator->second.countState(t_states);
+	}
+}
+
+void TcpSessions::shedMemory() {
+	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
+	{
+		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+		for (sessionsIterator = m_tcpSessionsMap.begin(); sessionsIterator != m_tcpSessionsMap.end(); ++sessionsIterator) {
+			sessionsIterator->second.applyMemoryShedding();
+		}
+	}
+}
+
+uint32_t TcpSessions::evictOldestSessions(const uint32_t t_sessions) {
+	uint32_t erasedSessions = 0;
+	std::vector<std::pair<uint64_t, TcpUdpSessionKey>> lastActivity;
 	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
 
-	sessionsIterator = m_tcpSessionsMap.begin();
-	while (sessionsIterator != m_tcpSessionsMap.end()) {
-		{
-			std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+	if (t_sessions == 0) return 0;
+	{
+		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+		lastActivity.reserve(m_tcpSessionsMap.size());
+		for (sessionsIterator = m_tcpSessionsMap.begin(); sessionsIterator != m_tcpSessionsMap.end(); ++sessionsIterator) {
+			lastActivity.emplace_back(sessionsIterator->second.getLastTimestampUsec(), sessionsIterator->first);
+		}
+		if (t_sessions < lastActivity.size()) {
+			//only the t_sessions oldest are needed, their order doesn't matter
+			std::nth_element(lastActivity.begin(), lastActivity.begin() + t_sessions, lastActivity.end(),
+								[](const std::pair<uint64_t, TcpUdpSessionKey>& a, const std::pair<uint64_t, TcpUdpSessionKey>& b) {
+									return a.first < b.first;
+								});
+			lastActivity.erase(lastActivity.begin() + t_sessions, lastActivity.end());
+		}
+		for (std::size_t i = 0; i < lastActivity.size(); i++) {
+			sessionsIterator = m_tcpSessionsMap.find(lastActivity[i].second);
+			if (sessionsIterator == m_tcpSessionsMap.end()) continue;
 			sessionsIterator->second.finalizeOperations();
 			sessionsIterator->second.aggregateSessionStat(m_statQueue, sessionsIterator->second.getLastSavedTimestampSec(),
-														sessionsIterator->second.getLastTimestampSec(), sessionsIterator->second.getLastTimestampUsec() % 1000000);
-			sessionsIterator = m_tcpSessionsMap.erase(sessionsIterator);
+															sessionsIterator->second.getLastTimestampSec(), sessionsIterator->second.getLastTimestampUsec() % 1000000);
+			m_tcpSessionsMap.erase(sessionsIterator);
+			erasedSessions++;
 		}
-		erasedSessions++;
 	}
 	return erasedSessions;
 }
+
+uint32_t TcpSessions::saveSnapshot(SessionSnapshotWriter& t_writer) const {
+	uint32_t savedSessions = 0;
+	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::const_iterator sessionsIterator;
+	{
+		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+		for (sessionsIterator = m_tcpSessionsMap.begin(); sessionsIterator != m_tcpSessionsMap.end(); ++sessionsIterator) {
+			t_writer.beginRecord(IPPROTO_TCP);
+			sessionsIterator->second.saveState(t_writer);
+			t_writer.endRecord();
+			savedSessions++;
+		}
+	}
+	return savedSessions;
+}
+
+bool TcpSessions::restoreSession(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters) {
+	TcpSession session;
+
+	if (!session.loadState(t_reader, t_keepIntervalCounters)) return false;
+	if (std::time(nullptr) - session.getLastTimestampSec() > ProgramProperties::getIdleTcpSessionTimeout()) return true;
+	{
+		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+		if (m_tcpSessionsMap.size() < ProgramProperties::getMaxTcpSessions()) {
+			m_tcpSessionsMap.insert(std::make_pair(session.getTcpSessionKey(), session));
+		}
+	}
+	return true;
+}
+
+ServiceLatencies* TcpSessions::swapServiceLatencies(ServiceLatencies* t_next) {
+	std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+	return ServiceLatencies::swapRecording(t_next);
+}
+
+uint32_t TcpSessions::releaseSessions() {
+	uint32_t erasedSessions;
+	{
+		std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+		erasedSessions = m_tcpSessionsMap.size();
+		m_tcpSessionsMap.clear();
+	}
+	return erasedSessions;
+}
+
+uint64_t TcpSessions::mergeOffloadedFlows(const std::vector<FlowOffloadEntry>& t_entries, const uint32_t t_capacity,
+											std::vector<FlowOffloadKey>& t_staleKeys, std::vector<FlowOffloadKey>& t_newKeys) {
+	uint64_t mergedPackets = 0;
+	std::unordered_map<TcpUdpSessionKey, TcpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
+	in_addr ipLo, ipHi;
+	t_staleKeys.clear();
+	t_newKeys.clear();
+
+	std::lock_guard<std::mutex> guard(m_tcpSessionsMutex);
+	for (std::size_t i = 0; i < t_entries.size(); i++) {
+		const FlowOffloadKey& key = t_entries[i].key;
+		const FlowOffloadValue& value = t_entries[i].value;
+		ipLo.s_addr = htonl(key.ipLo);
+		ipHi.s_addr = htonl(key.ipHi);
+		//the client is either end of the key
+		sessionsIterator = m_tcpSessionsMap.find(TcpUdpSessionKey(key.portLo, key.portHi, ipLo, ipHi, IPPROTO_TCP));
+		if (sessionsIterator != m_tcpSessionsMap.end()) {
+			mergedPackets += sessionsIterator->second.mergeOffloadedCounters(value.packets[0], value.bytes[0], value.packets[1], value.bytes[1]);
+			continue;
+		}
+		sessionsIterator = m_tcpSessionsMap.find(TcpUdpSessionKey(key.portHi, key.portLo, ipHi, ipLo, IPPROTO_TCP));
+		if (sessionsIterator != m_tcpSessionsMap.end()) {
+			mergedPackets += sessionsIterator->second.mergeOffloadedCounters(value.packets[1], value.bytes[1], value.packets[0], value.bytes[0]);
+			continue;
+		}
+		t_staleKeys.push_back(key);
+	}
+
+	std::size_t offloadedFlows = t_entries.size() - t_staleKeys.size();
+	bool isClientLo;
+	for (sessionsIterator = m_tcpSessionsMap.begin(); sessionsIterator != m_tcpSessionsMap.end() && offloadedFlows < t_capacity; sessionsIterator++) {
+		if (!sessionsIterator->second.isOffloadCandidate(FLOW_OFFLOAD_MIN_PACKETS)) continue;
+		const TcpUdpSessionKey& sessionKey = sessionsIterator->second.getTcpSessionKey();
+		t_newKeys.push_back(FlowOffload::makeKey(ntohl(sessionKey.m_clientIpRaw.s_addr), sessionKey.m_clientPort,
+													ntohl(sessionKey.m_serverIpRaw.s_addr), sessionKey.m_serverPort, isClientLo));
+		sessionsIterator->second.startOffload();
+		offloadedFlows++;
+	}
+	return mergedPackets;
+}
@@ -2,7 +2,7 @@
  *	TcpSessions.h
  *
  *	Created on: Mar 30, 2022
- *	Last modified on: Mar 30, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -20,15 +20,20 @@
 
 #include <mutex>  // For std::unique_lock
 #include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <cstdlib>
 
 #include <log4cpp/Category.hh>
 #include "ProgramProperties.h"
 #include "SelfMonitor.h"
-#include "layer_1/KnownPorts.h"
+#include "layer_1/RuntimeSettings.h"
 #include "layer_1/sessions/TcpUdpSessionKey.h"
 #include "layer_1/sessions/TCP/TcpSession.h"
 #include "layer_1/sessions/TCP/TcpSessionUpdateResult.h"
+#include "layer_1/MemoryBudget.h"
+#include "layer_1/OverloadController.h"
+#include "layer_1/FlowOffload.h"
 
 
 
@@ -51,10 +56,32 @@ public:
 	//every new captured and successfully parsed packet updates the map
 	TcpSessionUpdateResult update(const Packet* t_packet);
 	uint32_t finalStatCalculation();
-	uint32_t cleanIdleSessions();
-	//invoked from snifferControl thread with protection of _tcpSessionsMutex
+	uint32_t cleanIdleSessions(const int64_t t_nowSec);
+	//invoked from snifferControl thread, or from the capture thread for an offline source, with protection of _tcpSessionsMutex
 	//iterates thought all the sessions in the map identifying idle ones
 	//aggregates their stat and removes them from the map
+	//t_nowSec is the wall clock of a live capture or the newest packet time of an offline source
+	void accountMemory(MemoryUsage& t_usage) const;
+	//invoked from snifferControl thread, adds the estimate of the sessions' memory to t_usage
+	void countStates(TcpSessionStates& t_states) const;
+	//invoked from snifferControl thread, adds the sessions to the counters of their states
+	void shedMemory();
+	//invoked from snifferControl thread, applies the current shedding level to every session
+	uint32_t evictOldestSessions(const uint32_t t_sessions);
+	//invoked from snifferControl thread, aggregates and removes t_sessions least recently active sessions
+	uint32_t saveSnapshot(SessionSnapshotWriter& t_writer) const;
+	//invoked from snifferControl thread, appends every session to the snapshot, returns number of sessions
+	bool restoreSession(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters);
+	//restores the current record of the snapshot, returns false if the record is broken
+	//sessions that became idle while the probe was down are dropped silently
+	uint32_t releaseSessions();
+	//removes all the sessions without aggregating their stat, used when they are kept in the shutdown snapshot
+	ServiceLatencies* swapServiceLatencies(ServiceLatencies* t_next);
+	uint64_t mergeOffloadedFlows(const std::vector<FlowOffloadEntry>& t_entries, const uint32_t t_capacity,
+									std::vector<FlowOffloadKey>& t_staleKeys, std::vector<FlowOffloadKey>& t_newKeys);
+	//invoked from snifferControl thread, merges the kernel map into the sessions and returns the packets merged
+	//t_staleKeys get the entries without a session, t_newKeys the busy sessions to offload within t_capacity
+	//invoked from snifferControl thread, the sessions record into t_next from now on, returns the previous histograms
 };
 
 #endif /* TCPSESSIONS_H_ */
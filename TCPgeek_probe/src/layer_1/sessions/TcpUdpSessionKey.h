@@ -2,7 +2,7 @@
  *	TcpUdpSessionKey.h
  *
  *	Created on: Mar 28, 2022
- *	Last modified on: Mar 28, 2022
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -10,7 +10,8 @@
  *
  *	Description : TcpSessionKey - Describes unique identifier of the session
  *				  defines '==' operator and hashing function for further usage in
- *				  std::unordered_map<TcpSessionKey, TcpSession, HashFn>
+ *				  std::unordered_map<TcpSessionKey, TcpSession, HashFn> and a strict order
+ *				  for the places where the sessions are walked in a reproducible order
  *				Layer 1 - raw data nutrition and its transformation to the
  *				  universal data objects that can be used for further analysis.
  */
@@ -20,6 +21,7 @@
 
 #include <arpa/inet.h> // for inet_ntop
 #include <unordered_map>
+#include <stdint.h>
 
 #include "layer_1/sessions/IpSessionKey.h"
 
@@ -30,41 +32,49 @@ public:
 	IpSessionKey m_ipSessionKey;
 	in_addr 	m_clientIpRaw, m_serverIpRaw; //32 bits or u_int32_t
 	u_short 	m_clientPort, m_serverPort; //16 bits
+	uint32_t	m_interfaceId; //interface of a pcapng file the packets came from, 0 otherwise
 
 	TcpUdpSessionKey() : m_ipSessionKey(),
 						 m_clientPort {0},
-						 m_serverPort {0} {
+						 m_serverPort {0},
+						 m_interfaceId {0} {
 				m_clientIpRaw.s_addr = 0;
 				m_serverIpRaw.s_addr = 0;
 			}
-	TcpUdpSessionKey(const u_short t_cPort, const u_short t_sPort, const in_addr t_cIpRaw, const in_addr t_sIpRaw, const IpSessionKey t_ipSessionKey) {
+	TcpUdpSessionKey(const u_short t_cPort, const u_short t_sPort, const in_addr t_cIpRaw, const in_addr t_sIpRaw, const IpSessionKey t_ipSessionKey,
+						const uint32_t t_interfaceId = 0) {
 			m_ipSessionKey = t_ipSessionKey;
 			m_clientIpRaw = t_cIpRaw;
 			m_serverIpRaw = t_sIpRaw;
 			m_clientPort = t_cPort;
 			m_serverPort = t_sPort;
+			m_interfaceId = t_interfaceId;
 	}
 	void updateTcpUdpSessionKey(const u_short t_cPort, const u_short t_sPort, const in_addr t_cIpRaw,
-								const in_addr t_sIpRaw, const IpSessionKey t_ipSessionKey) {
+								const in_addr t_sIpRaw, const IpSessionKey t_ipSessionKey, const uint32_t t_interfaceId = 0) {
 		m_ipSessionKey = t_ipSessionKey;
 		m_clientIpRaw = t_cIpRaw;
 		m_serverIpRaw = t_sIpRaw;
 		m_clientPort = t_cPort;
 		m_serverPort = t_sPort;
+		m_interfaceId = t_interfaceId;
 	}
 	bool operator == (const TcpUdpSessionKey &other) const {
 		return (m_serverPort == other.m_serverPort &&
 	             m_clientPort == other.m_clientPort &&
 				 m_clientIpRaw.s_addr == other.m_clientIpRaw.s_addr &&
 				 m_serverIpRaw.s_addr == other.m_serverIpRaw.s_addr &&
+				 m_interfaceId == other.m_interfaceId &&
 				 m_ipSessionKey == other.m_ipSessionKey);
 	}
+	TcpUdpSessionKey(const TcpUdpSessionKey& other) = default;
 	TcpUdpSessionKey& operator = (const TcpUdpSessionKey other)
 	{
 		m_clientIpRaw = other.m_clientIpRaw;
 		m_serverIpRaw = other.m_serverIpRaw;
 		m_clientPort = other.m_clientPort;
 		m_serverPort = other.m_serverPort;
+		m_interfaceId = other.m_interfaceId;
 		m_ipSessionKey = other.m_ipSessionKey;
 		return *this;
 	}
@@ -83,11 +93,26 @@ public:
 		res ^= hash_u_int32_t(k.m_serverIpRaw.s_addr);// + 0x9e3779b9 + (res << 6) + (res >> 2);
 		res ^= hash_u_short(k.m_serverPort);// + 0x9e3779b9 + (res << 6) + (res >> 2);
 		res ^= hash_u_short(k.m_clientPort);// + 0x9e3779b9 + (res << 6) + (res >> 2);
+		//the same stream seen by several taps differs only here, the ports keep it from cancelling out
+		res ^= hash_u_int32_t(k.m_interfaceId) << 1;
 		return res;
 	}
 };
 
-
+class TcpUdpSessionKeyLess {
+public:
+	bool operator()(const TcpUdpSessionKey& a, const TcpUdpSessionKey& b) const
+	{
+		if (a.m_ipSessionKey.m_ipProtocol != b.m_ipSessionKey.m_ipProtocol) {
+			return a.m_ipSessionKey.m_ipProtocol < b.m_ipSessionKey.m_ipProtocol;
+		}
+		if (a.m_serverIpRaw.s_addr != b.m_serverIpRaw.s_addr) return ntohl(a.m_serverIpRaw.s_addr) < ntohl(b.m_serverIpRaw.s_addr);
+		if (a.m_serverPort != b.m_serverPort) return a.m_serverPort < b.m_serverPort;
+		if (a.m_clientIpRaw.s_addr != b.m_clientIpRaw.s_addr) return ntohl(a.m_clientIpRaw.s_addr) < ntohl(b.m_clientIpRaw.s_addr);
+		if (a.m_clientPort != b.m_clientPort) return a.m_clientPort < b.m_clientPort;
+		return a.m_interfaceId < b.m_interfaceId;
+	}
+};
 
 
 #endif /* TCPUDPSESSIONKEY_H_ */
@@ -2,7 +2,7 @@
  *	UdpSession.cpp
  *
  *	Created on: Aug 14, 2023
- *	Last modified on: Aug 14, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -12,8 +12,12 @@
 
 #include "layer_1/sessions/UDP/UdpSession.h"
 
-UdpSession::UdpSession(const Packet* t_packet) :
-										IpSession(t_packet->getIpProtocol()),
+UdpSession::UdpSession() : IpSession() {
+	//the rest is set by loadState()
+}
+
+UdpSession::UdpSession(const Packet* t_packet, const uint32_t t_samplingRate) :
+										IpSession(t_packet->getIpProtocol(), t_samplingRate),
 										m_clientDuplicatesCounter {0},
 										m_serverDuplicatesCounter {0},
 										m_clientDuplicatesTotal {0},
@@ -27,32 +31,33 @@ UdpSession::UdpSession(const Packet* t_packet) :
 
 	bool isRequestPacket = true;
 
-	m_packetDedupRingQueue.setMaxSize(ProgramProperties::getDeduplicationBufferSize());
+	m_packetDedupRingQueue.setMaxSize(RuntimeSettings::get()->getDeduplicationBufferSize());
 	m_packetDedupRingQueue.isDuplicatePacket(t_packet->getDupId());
 
-	if (KnownPorts::isKnownPort(t_packet->getDstPort())) {
+	if (RuntimeSettings::get()->isKnownPort(t_packet->getDstPort())) {
 		//destination port is in the list of known service ports
-		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol);
+		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = true;
-	} else if (KnownPorts::isKnownPort(t_packet->getSrcPort())) {
+	} else if (RuntimeSettings::get()->isKnownPort(t_packet->getSrcPort())) {
 		//source port is in the list of known service ports
-		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol);
+		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = false;
 	} else if (t_packet->getDstPort() < 1024) {
 		//destination port is in well known port range
-		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol);
+		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = true;
 	} else if (t_packet->getSrcPort() < 1024) {
 		//source port is in well known port range
-		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol);
+		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = false;
 	} else if (t_packet->getSrcPort() > t_packet->getDstPort()) {
-		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol);
+		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getSrcPort(), t_packet->getDstPort(), t_packet->getSrcIpRaw(), t_packet->getDstIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = true;
 	} else {
-		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol);
+		m_udpSessionKey.updateTcpUdpSessionKey(t_packet->getDstPort(), t_packet->getSrcPort(), t_packet->getDstIpRaw(), t_packet->getSrcIpRaw(), m_ipProtocol, t_packet->getInterfaceId());
 		isRequestPacket = false;
 	}
+	locate(m_udpSessionKey);
 	if (isRequestPacket) {
 		m_serverBytesCounter = 0;
 		m_serverPayloadBytesCounter = 0;
@@ -74,6 +79,11 @@ UdpSessionUpdateResultEnum UdpSession::update(const Packet* t_packet, SafeQueue<
 
 	IpSession::update(t_packet);
 	UdpSessionUpdateResultEnum result = UdpSessionUpdateResultEnum::VOID;
+	if ((!m_noDuplicatesFromClient || !m_noDuplicatesFromServer) && MemoryBudget::getLevel() >= SheddingLevel::DEDUP_DISABLED) {
+		m_noDuplicatesFromClient = true;
+		m_noDuplicatesFromServer = true;
+		m_packetDedupRingQueue.release();
+	}
 
 	if ((t_packet->getDstPort() == m_udpSessionKey.m_serverPort) && (t_packet->getDstIpRaw().s_addr == m_udpSessionKey.m_serverIpRaw.s_addr)) { //this is a request
 		if (m_firstClientPacketTimestamp_usec == 0) {
@@ -90,7 +100,7 @@ UdpSessionUpdateResultEnum UdpSession::update(const Packet* t_packet, SafeQueue<
 			m_clientPayloadBytesCounter += t_packet->getPayloadlen();
 		}
 		if (!m_noDuplicatesFromClient && (m_clientDuplicatesTotal == 0) &&
-			(t_packet->getTimestampUsecFull() - m_firstClientPacketTimestamp_usec > ProgramProperties::getDeduplicationTimeout()*1000)) {
+			(t_packet->getTimestampUsecFull() - m_firstClientPacketTimestamp_usec > RuntimeSettings::get()->getDeduplicationTimeout()*1000)) {
 			//if (!m_noDuplicatesFromClient && (m_clientDuplicatesTotal == 0) && m_clientPacketsCounter >= t_dedupMaxSize) {
 			m_noDuplicatesFromClient = true;
 		}
@@ -109,13 +119,13 @@ UdpSessionUpdateResultEnum UdpSession::update(const Packet* t_packet, SafeQueue<
 			m_serverPayloadBytesCounter += t_packet->getPayloadlen();
 		}
 		if (!m_noDuplicatesFromClient && (m_clientDuplicatesTotal == 0) &&
-			(t_packet->getTimestampUsecFull() - m_firstClientPacketTimestamp_usec > ProgramProperties::getDeduplicationTimeout()*1000)) {
+			(t_packet->getTimestampUsecFull() - m_firstClientPacketTimestamp_usec > RuntimeSettings::get()->getDeduplicationTimeout()*1000)) {
 			//if (!m_noDuplicatesFromClient && (m_clientDuplicatesTotal == 0) && m_clientPacketsCounter >= t_dedupMaxSize) {
 			m_noDuplicatesFromServer = true;
 		}
 	}
 	m_lastTimestamp_usec = t_packet->getTimestampUsecFull();
-	if((unsigned long)(t_packet->getTs().tv_sec - m_lastSavedTimestamp_sec) >= ProgramProperties::getGranularity()) {
+	if((unsigned long)(t_packet->getTs().tv_sec - m_lastSavedTimestamp_sec) >= RuntimeSettings::get()->getGranularity()) {
 		//m_otherTime = m_lastTimestamp_usec - m_firstTimestamp_usec - m_localTime - m_remoteIdleTime - m_networkTime - m_remoteTime;
 		aggregateSessionStat(t_statQueue, m_lastSavedTimestamp_sec, t_packet->getTs().tv_sec, t_packet->getTs().tv_usec);
 		m_lastSavedTimestamp_sec = t_packet->getTs().tv_sec;
@@ -154,8 +164,12 @@ void UdpSession::aggregateSessionStat(SafeQueue<StatRecord>* t_statQueue,
 							    m_clientPayloadBytesCounter, m_serverPayloadBytesCounter, m_clientPacketsCounter, m_serverPacketsCounter,
 								//currentClientSpeed, currentServerSpeed, currentClientEfficientSpeed, currentServerEfficientSpeed,
 								m_clientDuplicatesCounter, m_serverDuplicatesCounter,
-								0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+								0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, m_samplingRate, m_location);
 	t_statQueue->enqueue(m_statRecord);
+	resetIntervalCounters();
+}
+
+void UdpSession::resetIntervalCounters() {
 	m_clientPacketsCounter = 0;
 	m_serverPacketsCounter = 0;
 	m_clientBytesCounter = 0;
@@ -177,3 +191,60 @@ uint64_t UdpSession::getLastTimestampSec() const {
 uint64_t UdpSession::getLastTimestampUsec() const {
 	return m_lastTimestamp_usec;
 }
+
+uint64_t UdpSession::getDedupMemoryBytes() const {
+	return m_packetDedupRingQueue.getMemoryBytes();
+}
+
+void UdpSession::saveState(SessionSnapshotWriter& t_writer) const {
+	IpSession::saveState(t_writer);
+	t_writer.put(m_udpSessionKey.m_clientIpRaw.s_addr);
+	t_writer.put(m_udpSessionKey.m_serverIpRaw.s_addr);
+	t_writer.put(m_udpSessionKey.m_clientPort);
+	t_writer.put(m_udpSessionKey.m_serverPort);
+	t_writer.put(m_clientBytesCounter);
+	t_writer.put(m_serverBytesCounter);
+	t_writer.put(m_clientPayloadBytesCounter);
+	t_writer.put(m_serverPayloadBytesCounter);
+	t_writer.put(m_clientPacketsCounter);
+	t_writer.put(m_serverPacketsCounter);
+	t_writer.put(m_clientDuplicatesCounter);
+	t_writer.put(m_serverDuplicatesCounter);
+	t_writer.put(m_clientDuplicatesTotal);
+	t_writer.put(m_serverDuplicatesTotal);
+	t_writer.put((uint8_t) m_noDuplicatesFromClient);
+	t_writer.put((uint8_t) m_noDuplicatesFromServer);
+	t_writer.put(m_firstClientPacketTimestamp_usec);
+	t_writer.put(m_firstServerPacketTimestamp_usec);
+	t_writer.put(m_lastSavedTimestamp_sec);
+	t_writer.put(m_lastTimestamp_usec);
+}
+
+bool UdpSession::loadState(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters) {
+	uint8_t noDuplicatesFromClient, noDuplicatesFromServer;
+
+	if (!(IpSession::loadState(t_reader) &&
+			t_reader.get(m_udpSessionKey.m_clientIpRaw.s_addr) && t_reader.get(m_udpSessionKey.m_serverIpRaw.s_addr) &&
+			t_reader.get(m_udpSessionKey.m_clientPort) && t_reader.get(m_udpSessionKey.m_serverPort) &&
+			t_reader.get(m_clientBytesCounter) && t_reader.get(m_serverBytesCounter) &&
+			t_reader.get(m_clientPayloadBytesCounter) && t_reader.get(m_serverPayloadBytesCounter) &&
+			t_reader.get(m_clientPacketsCounter) && t_reader.get(m_serverPacketsCounter) &&
+			t_reader.get(m_clientDuplicatesCounter) && t_reader.get(m_serverDuplicatesCounter) &&
+			t_reader.get(m_clientDuplicatesTotal) && t_reader.get(m_serverDuplicatesTotal) &&
+			t_reader.get(noDuplicatesFromClient) && t_reader.get(noDuplicatesFromServer) &&
+			t_reader.get(m_firstClientPacketTimestamp_usec) && t_reader.get(m_firstServerPacketTimestamp_usec) &&
+			t_reader.get(m_lastSavedTimestamp_sec) && t_reader.get(m_lastTimestamp_usec))) {
+		return false;
+	}
+	m_udpSessionKey.m_ipSessionKey.updateIpSessionKey(m_ipProtocol);
+	//the subnets might have been changed since the snapshot
+	locate(m_udpSessionKey);
+	m_noDuplicatesFromClient = noDuplicatesFromClient;
+	m_noDuplicatesFromServer = noDuplicatesFromServer;
+	m_packetDedupRingQueue.setMaxSize(RuntimeSettings::get()->getDeduplicationBufferSize());
+	if (!t_keepIntervalCounters) {
+		resetIntervalCounters();
+		m_lastSavedTimestamp_sec = std::time(nullptr);
+	}
+	return true;
+}
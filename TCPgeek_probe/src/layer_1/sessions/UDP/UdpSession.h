@@ -2,7 +2,7 @@
  *	UdpSession.h
  *
  *	Created on: Aug 14, 2023
- *	Last modified on: Aug 14, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -17,12 +17,13 @@
 #include <stdint.h>
 
 #include "ProgramProperties.h"
-#include "layer_1/KnownPorts.h"
+#include "layer_1/RuntimeSettings.h"
 #include "layer_1/sessions/UDP/UdpSessionUpdateResultEnum.h"
 #include "layer_1/sessions/TcpUdpSessionKey.h"
 #include "layer_1/sessions/IpSession.h"
 #include "layer_1/Packet.h"
 #include "layer_1/PacketDedupRingQueue.h"
+#include "layer_1/MemoryBudget.h"
 #include "layer_1/StatRecord.h"
 #include "SafeQueue.h" // for statistic records queuing
 
@@ -43,9 +44,13 @@ private:
 	TcpUdpSessionKey m_udpSessionKey; //contains local and remote IPs' and TCP ports
 	StatRecord m_statRecord;
 
+	void resetIntervalCounters();
+
 public:
 
-	UdpSession(const Packet* t_packet);
+	UdpSession();
+	//an empty session to be restored with loadState()
+	UdpSession(const Packet* t_packet, const uint32_t t_samplingRate);
 	UdpSessionUpdateResultEnum update(const Packet* t_packet, SafeQueue<StatRecord>* t_statQueue);
 	//updates TcpSession object fields and statQueue nodes according to the captured packet
 	//invoked only from the main thread of capturing
@@ -58,5 +63,11 @@ public:
 	uint64_t getLastTimestampSec() const;
 	int64_t getLastSavedTimestampSec() const;
 	uint64_t getLastTimestampUsec() const;
+	uint64_t getDedupMemoryBytes() const;
+	void saveState(SessionSnapshotWriter& t_writer) const;
+	//might be invoked from snifferControl thread with protection of _udpSessionsMutex
+	bool loadState(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters);
+	//restores the session saved by saveState(), the counters of the current interval are kept only if
+	//they weren't reported by the previous instance of the probe
 };
 #endif /* UDPSESSION_H_ */
@@ -2,7 +2,7 @@
  *	UdpSessionUpdateResultEnum.h
  *
  *	Created on: Aug 14, 2023
- *	Last modified on: Aug 14, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -17,7 +17,8 @@ enum class UdpSessionUpdateResultEnum {
 			GOOD_NEW,
 			GOOD_KNOWN,
 			DUPLICATE,
-			VOID
+			VOID,
+			SAMPLED_OUT		//the packet of a new flow not taken by the overload sampling
 } ;
 
 
@@ -2,7 +2,7 @@
  *	UdpSessions.cpp
  *
  *	Created on: Aug 14, 2023
- *	Last modified on: Aug 14, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -36,12 +36,14 @@ UdpSessionUpdateResultEnum UdpSessions::update(const Packet* t_packet) {
 														t_packet->getDstPort(), //server port
 														t_packet->getSrcIpRaw(), //client IP
 														t_packet->getDstIpRaw(),
-														t_packet->getIpProtocol()); //server IP
+														t_packet->getIpProtocol(), //server IP
+														t_packet->getInterfaceId());
 	serverPacketSessionKey = new TcpUdpSessionKey(t_packet->getDstPort(), //client port
 														t_packet->getSrcPort(), //server port
 														t_packet->getDstIpRaw(), //client IP
 														t_packet->getSrcIpRaw(), //server IP
-														t_packet->getIpProtocol());
+														t_packet->getIpProtocol(),
+														t_packet->getInterfaceId());
 	{
 		std::lock_guard<std::mutex> guard(m_udpSessionsMutex); //preventing control thread from reading in the same time
 		sessionsIterator = m_udpSessionsMap.find(*clientPacketSessionKey);
@@ -51,8 +53,10 @@ UdpSessionUpdateResultEnum UdpSessions::update(const Packet* t_packet) {
 
 		if (sessionsIterator == m_udpSessionsMap.end()) {
 			//this packet doesn't belong to any known UDP session, hence this is a new session
-			if (m_udpSessionsMap.size() < ProgramProperties::getMaxTcpSessions()) {
-				UdpSession* newSession = new UdpSession(t_packet);
+			if (!OverloadController::isFlowSampled(t_packet)) {
+				result = UdpSessionUpdateResultEnum::SAMPLED_OUT;
+			} else if (m_udpSessionsMap.size() < ProgramProperties::getMaxTcpSessions()) {
+				UdpSession* newSession = new UdpSession(t_packet, OverloadController::getSamplingRate());
 				m_udpSessionsMap.insert(std::make_pair(newSession->getUdpSessionKey(),*newSession));
 					delete newSession;
 					result = UdpSessionUpdateResultEnum::GOOD_NEW;
@@ -70,14 +74,14 @@ UdpSessionUpdateResultEnum UdpSessions::update(const Packet* t_packet) {
 	return result;
 }
 
-uint32_t UdpSessions::cleanIdleSessions() {
+uint32_t UdpSessions::cleanIdleSessions(const int64_t t_nowSec) {
 	uint32_t erasedSessions = 0;
 	std::unordered_map<TcpUdpSessionKey, UdpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
 	{
 		std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
 		sessionsIterator = m_udpSessionsMap.begin();
 		while (sessionsIterator != m_udpSessionsMap.end()) {
-			if (std::time(nullptr) - sessionsIterator->second.getLastTimestampSec()  > ProgramProperties::getIdleTcpSessionTimeout()) {
+			if (t_nowSec - (int64_t) sessionsIterator->second.getLastTimestampSec() > (int64_t) ProgramProperties::getIdleTcpSessionTimeout()) {
 				//this session is idle, so removing it from the map
 				sessionsIterator->second.aggregateSessionStat(m_statQueue, sessionsIterator->second.getLastSavedTimestampSec(),
 															sessionsIterator->second.getLastTimestampSec(), sessionsIterator->second.getLastTimestampUsec() % 1000000);
@@ -91,18 +95,107 @@ uint32_t UdpSessions::cleanIdleSessions() {
 }
 
 uint32_t UdpSessions::finalStatCalculation() {
-	uint32_t erasedSessions {0};
+	std::vector<TcpUdpSessionKey> sessionKeys;
 	std::unordered_map<TcpUdpSessionKey, UdpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
-
-	sessionsIterator = m_udpSessionsMap.begin();
-	while (sessionsIterator != m_udpSessionsMap.end()) {
-		{
-			std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
+	{
+		std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
+		sessionKeys.reserve(m_udpSessionsMap.size());
+		for (sessionsIterator = m_udpSessionsMap.begin(); sessionsIterator != m_udpSessionsMap.end(); ++sessionsIterator) {
+			sessionKeys.push_back(sessionsIterator->first);
+		}
+		//in the same order as TcpSessions::finalStatCalculation() does it
+		std::sort(sessionKeys.begin(), sessionKeys.end(), TcpUdpSessionKeyLess());
+		for (std::size_t i = 0; i < sessionKeys.size(); i++) {
+			sessionsIterator = m_udpSessionsMap.find(sessionKeys[i]);
 			sessionsIterator->second.aggregateSessionStat(m_statQueue, sessionsIterator->second.getLastSavedTimestampSec(),
 														sessionsIterator->second.getLastTimestampSec(), sessionsIterator->second.getLastTimestampUsec() % 1000000);
-			sessionsIterator = m_udpSessionsMap.erase(sessionsIterator);
+			m_udpSessionsMap.erase(sessionsIterator);
+		}
+	}
+	return sessionKeys.size();
+}
+
+void UdpSessions::accountMemory(MemoryUsage& t_usage) const {
+	std::unordered_map<TcpUdpSessionKey, UdpSession, TcpUdpSessionHashFn>::const_iterator sessionsIterator;
+	{
+		std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
+		//every node holds the key, the session, the next pointer and the cached hash
+		t_usage.udpSessions += m_udpSessionsMap.size();
+		t_usage.udpTableBytes += m_udpSessionsMap.size() * (sizeof(std::pair<const TcpUdpSessionKey, UdpSession>) + sizeof(void*) + sizeof(std::size_t) + 16) +
+									m_udpSessionsMap.bucket_count() * sizeof(void*);
+		for (sessionsIterator = m_udpSessionsMap.begin(); sessionsIterator != m_udpSessionsMap.end(); ++sessionsIterator) {
+			t_usage.dedupBytes += sessionsIterator->second.getDedupMemoryBytes();
+		}
+	}
+}
+
+uint32_t UdpSessions::evictOldestSessions(const uint32_t t_sessions) {
+	uint32_t erasedSessions = 0;
+	std::vector<std::pair<uint64_t, TcpUdpSessionKey>> lastActivity;
+	std::unordered_map<TcpUdpSessionKey, UdpSession, TcpUdpSessionHashFn>::iterator sessionsIterator;
+
+	if (t_sessions == 0) return 0;
+	{
+		std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
+		lastActivity.reserve(m_udpSessionsMap.size());
+		for (sessionsIterator = m_udpSessionsMap.begin(); sessionsIterator != m_udpSessionsMap.end(); ++sessionsIterator) {
+			lastActivity.emplace_back(sessionsIterator->second.getLastTimestampUsec(), sessionsIterator->first);
+		}
+		if (t_sessions < lastActivity.size()) {
+			//only the t_sessions oldest are needed, their order doesn't matter
+			std::nth_element(lastActivity.begin(), lastActivity.begin() + t_sessions, lastActivity.end(),
+								[](const std::pair<uint64_t, TcpUdpSessionKey>& a, const std::pair<uint64_t, TcpUdpSessionKey>& b) {
+									return a.first < b.first;
+								});
+			lastActivity.erase(lastActivity.begin() + t_sessions, lastActivity.end());
+		}
+		for (std::size_t i = 0; i < lastActivity.size(); i++) {
+			sessionsIterator = m_udpSessionsMap.find(lastActivity[i].second);
+			if (sessionsIterator == m_udpSessionsMap.end()) continue;
+			sessionsIterator->second.aggregateSessionStat(m_statQueue, sessionsIterator->second.getLastSavedTimestampSec(),
+															sessionsIterator->second.getLastTimestampSec(), sessionsIterator->second.getLastTimestampUsec() % 1000000);
+			m_udpSessionsMap.erase(sessionsIterator);
+			erasedSessions++;
 		}
-		erasedSessions++;
+	}
+	return erasedSessions;
+}
+
+uint32_t UdpSessions::saveSnapshot(SessionSnapshotWriter& t_writer) const {
+	uint32_t savedSessions = 0;
+	std::unordered_map<TcpUdpSessionKey, UdpSession, TcpUdpSessionHashFn>::const_iterator sessionsIterator;
+	{
+		std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
+		for (sessionsIterator = m_udpSessionsMap.begin(); sessionsIterator != m_udpSessionsMap.end(); ++sessionsIterator) {
+			t_writer.beginRecord(IPPROTO_UDP);
+			sessionsIterator->second.saveState(t_writer);
+			t_writer.endRecord();
+			savedSessions++;
+		}
+	}
+	return savedSessions;
+}
+
+bool UdpSessions::restoreSession(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters) {
+	UdpSession session;
+
+	if (!session.loadState(t_reader, t_keepIntervalCounters)) return false;
+	if (std::time(nullptr) - session.getLastTimestampSec() > ProgramProperties::getIdleTcpSessionTimeout()) return true;
+	{
+		std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
+		if (m_udpSessionsMap.size() < ProgramProperties::getMaxTcpSessions()) {
+			m_udpSessionsMap.insert(std::make_pair(session.getUdpSessionKey(), session));
+		}
+	}
+	return true;
+}
+
+uint32_t UdpSessions::releaseSessions() {
+	uint32_t erasedSessions;
+	{
+		std::lock_guard<std::mutex> guard(m_udpSessionsMutex);
+		erasedSessions = m_udpSessionsMap.size();
+		m_udpSessionsMap.clear();
 	}
 	return erasedSessions;
 }
@@ -2,7 +2,7 @@
  *	UdpSessions.h
  *
  *	Created on: Aug 14, 2023
- *	Last modified on: Aug 14, 2023
+ *	Last modified on: Oct 19, 2026
  *
  *	Copyright (C) 2024  Daniil Kochetov (unixguide@narod.ru)
  *
@@ -15,14 +15,18 @@
 
 #include <mutex>  // For std::unique_lock
 #include <unordered_map>
+#include <vector>
+#include <algorithm>
 #include <cstdlib>
 #include <log4cpp/Category.hh>
 
 #include "ProgramProperties.h"
-#include "layer_1/KnownPorts.h"
+#include "layer_1/RuntimeSettings.h"
 #include "layer_1/sessions/UDP/UdpSession.h"
 #include "layer_1/sessions/TcpUdpSessionKey.h"
 #include "layer_1/StatRecord.h"
+#include "layer_1/MemoryBudget.h"
+#include "layer_1/OverloadController.h"
 #include "SafeQueue.h"
 
 
@@ -49,10 +53,22 @@ public:
 	//every new captured and successfully parsed packet updates the map
 	uint32_t finalStatCalculation();
 
-	uint32_t cleanIdleSessions();
-	//invoked from snifferControl thread with protection of m_udpSessionsMutex
+	uint32_t cleanIdleSessions(const int64_t t_nowSec);
+	//invoked from snifferControl thread, or from the capture thread for an offline source, with protection of m_udpSessionsMutex
 	//iterates thought all the sessions in the map identifying idle ones
 	//aggregates their stat and removes them from the map
+	//t_nowSec is the wall clock of a live capture or the newest packet time of an offline source
+	void accountMemory(MemoryUsage& t_usage) const;
+	//invoked from snifferControl thread, adds the estimate of the sessions' memory to t_usage
+	uint32_t evictOldestSessions(const uint32_t t_sessions);
+	//invoked from snifferControl thread, aggregates and removes t_sessions least recently active sessions
+	uint32_t saveSnapshot(SessionSnapshotWriter& t_writer) const;
+	//invoked from snifferControl thread, appends every session to the snapshot, returns number of sessions
+	bool restoreSession(SessionSnapshotReader& t_reader, const bool t_keepIntervalCounters);
+	//restores the current record of the snapshot, returns false if the record is broken
+	//sessions that became idle while the probe was down are dropped silently
+	uint32_t releaseSessions();
+	//removes all the sessions without aggregating their stat, used when they are kept in the shutdown snapshot
 };
 
 #endif /* UDPSESSIONS_H_ */